@@ -6,6 +6,10 @@ volatile fnCode_type G_LcdStateMachine;
 
 static u32 Lcd_u32Timer;
 
+/* Sent from flash in front of or as LCD data */
+static const u8 Lcd_au8ControlData[] = {LCD_CONTROL_DATA};
+static const u8 Lcd_au8Spaces[LCD_MAX_MESSAGE_SIZE] = "                                        ";
+
 /*------------------------------------------------------------------------------
 Function LCDCommand
 
@@ -50,26 +54,31 @@ Requires:
 
 Promises:
   - Message to set cursor address in the LCD is queued, then message data 
-    is queued to the LCD to be displayed. 
+    is queued to the LCD to be displayed: the control byte from flash and 
+    the text copied straight from u8Message_ as one write
 */
 void LCDMessage(u8 u8Address_, u8 *u8Message_)
 { 
-  u8 u8Index; 
-  static u8 au8LCDMessage[LCD_MESSAGE_OVERHEAD_SIZE + LCD_MAX_MESSAGE_SIZE] = 
-                           {LCD_CONTROL_DATA};
+  MessageSegmentType asSegments[2];
+  u8 u8Length = 0; 
   
   /* Set the cursor to the correct address */
   LCDCommand(LCD_ADDRESS_CMD | u8Address_);
   
-  /* Fill the message */
-  u8Index = 1;
-  while(*u8Message_ != '\0')
+  /* Measure the message */
+  while(u8Message_[u8Length] != '\0')
   {
-    au8LCDMessage[u8Index++] = *u8Message_++;
+    u8Length++;
   }
     
-  /* Queue the message */
-  TWI0WriteData(LCD_ADDRESS, u8Index, au8LCDMessage, STOP);
+  /* Queue the control byte and the message */
+  asSegments[0].pu8Data = Lcd_au8ControlData;
+  asSegments[0].u32Size = LCD_MESSAGE_OVERHEAD_SIZE;
+  asSegments[0].bCopy   = FALSE;
+  asSegments[1].pu8Data = u8Message_;
+  asSegments[1].u32Size = u8Length;
+  asSegments[1].bCopy   = TRUE;
+  TWI0WriteSegments(LCD_ADDRESS, asSegments, 2, STOP);
 
 } /* end LCDMessage() */
 
@@ -89,26 +98,29 @@ Requires:
 
 Promises:
   - Message to set cursor address in the LCD is queued, then message data 
-    consisting of all ' ' characters is queued to the LCD to be displayed. 
+    consisting of all ' ' characters is queued to the LCD to be displayed
+    (both sent from flash). 
 */
 void LCDClearChars(u8 u8Address_, u8 u8CharactersToClear_)
 { 
-  /* $$$$ Add this function */
-  u8 u8Index; 
-  static u8 au8LCDMessage[LCD_MESSAGE_OVERHEAD_SIZE + LCD_MAX_MESSAGE_SIZE] = 
-                           {LCD_CONTROL_DATA};
+  MessageSegmentType asSegments[2];
   
   /* Set the cursor to the correct address */
   LCDCommand(LCD_ADDRESS_CMD | u8Address_);
   
-  /* $$$$ Fill the message characters with ' ' */
-  for(u8Index = 0; u8Index < u8CharactersToClear_; u8Index++)
+  if(u8CharactersToClear_ > LCD_MAX_MESSAGE_SIZE)
   {
-    au8LCDMessage[u8Index + 1] = ' ';
+    u8CharactersToClear_ = LCD_MAX_MESSAGE_SIZE;
   }
-      
-  /* Queue the message */
-  TWI0WriteData(LCD_ADDRESS, u8Index, au8LCDMessage, STOP);
+  
+  /* Queue the control byte and the ' ' characters */
+  asSegments[0].pu8Data = Lcd_au8ControlData;
+  asSegments[0].u32Size = LCD_MESSAGE_OVERHEAD_SIZE;
+  asSegments[0].bCopy   = FALSE;
+  asSegments[1].pu8Data = Lcd_au8Spaces;
+  asSegments[1].u32Size = u8CharactersToClear_;
+  asSegments[1].bCopy   = FALSE;
+  TWI0WriteSegments(LCD_ADDRESS, asSegments, 2, STOP);
       	
 } /* end LCDClearChars() */
 
@@ -133,7 +145,7 @@ void LcdInitialize(void)
     LCD_CONTRAST_CMD, LCD_DISPLAY_SET_CMD, LCD_FOLLOWER_CMD 
   };
   
-  u8 au8Welcome[] = "PARTY TIME!!!         ";
+  static const u8 au8Welcome[] = "PARTY TIME!!!         ";
   
   /* State to Idle */
   G_LcdStateMachine = LcdSM_Idle;
@@ -171,7 +183,7 @@ void LcdInitialize(void)
   LedOn(RED);
   
   TWI0WriteByte(LCD_ADDRESS, LCD_CONTROL_DATA, NO_STOP);
-  TWI0WriteData(LCD_ADDRESS, 20, &au8Welcome[0], STOP);
+  TWI0WriteDataNoCopy(LCD_ADDRESS, LCD_MAX_LINE_DISPLAY_SIZE, &au8Welcome[0], STOP, NULL);
   
   Lcd_u32Timer = G_u32SystemTime1ms;
   while( !IsTimeUp(&Lcd_u32Timer, LCD_INIT_MSG_DISP_TIME) );
@@ -181,6 +193,44 @@ void LcdInitialize(void)
 }
 
 
+/*------------------------------------------------------------------------------
+Function: LcdMarqueeLine
+
+Description:
+Shows a line of text rotated right by u8Rotation_ characters.  The rotated line
+is the last u8Rotation_ characters of the message followed by the rest, so it is
+sent as two segments straight from the const message without building a copy.
+
+Requires:
+  - LCD is initialized
+  - pu8Message_ is const and at least LCD_MAX_LINE_DISPLAY_SIZE chars long
+  - u8Rotation_ is less than LCD_MAX_LINE_DISPLAY_SIZE
+
+Promises:
+  - The cursor address is queued, then the data control byte and the two 
+    segments are queued to the LCD as one write
+*/
+static void LcdMarqueeLine(u8 u8Address_, const u8* pu8Message_, u8 u8Rotation_)
+{
+  MessageSegmentType asSegments[3];
+  
+  LCDCommand(LCD_ADDRESS_CMD | u8Address_);
+  
+  /* An empty first segment (no rotation) is skipped */
+  asSegments[0].pu8Data = Lcd_au8ControlData;
+  asSegments[0].u32Size = LCD_MESSAGE_OVERHEAD_SIZE;
+  asSegments[0].bCopy   = FALSE;
+  asSegments[1].pu8Data = &pu8Message_[LCD_MAX_LINE_DISPLAY_SIZE - u8Rotation_];
+  asSegments[1].u32Size = u8Rotation_;
+  asSegments[1].bCopy   = FALSE;
+  asSegments[2].pu8Data = pu8Message_;
+  asSegments[2].u32Size = LCD_MAX_LINE_DISPLAY_SIZE - u8Rotation_;
+  asSegments[2].bCopy   = FALSE;
+  TWI0WriteSegments(LCD_ADDRESS, asSegments, 3, STOP);
+  
+} /* end LcdMarqueeLine() */
+
+
 /*------------------------------------------------------------------------------
 Function: LcdSM_Idle
 
@@ -198,39 +248,16 @@ void LcdSM_Idle(void)
   /* Msgs */
   static const u8 au8Eng[] = "BUTTON2:Little lamb    ";
   static const u8 au8MPG[] = "BUTTON3:Fur Elise      ";
-  u8 au8Temp[20];
   
   /* Indexes */
   static u8 u8ResetIndex = 0;
-  static u8 u8Index = 0;
   
   
   if(IsTimeUp(&Lcd_u32Timer, 500))
   {
-    
-    u8Index = u8ResetIndex;
-    for(u8 i = 0; i < 20; i++, u8Index++)
-    { 
-      if( u8Index == 20)
-      {
-        u8Index = 0; 
-      }
-      au8Temp[u8Index] = au8Eng[i];
-    }
-    
-    LCDMessage(LINE1_START_ADDR, au8Temp);
-    
-    u8Index = u8ResetIndex;
-    for(u8 i = 0; i < 20; i++, u8Index++)
-    { 
-      if( u8Index == 20)
-      {
-        u8Index = 0; 
-      }
-      au8Temp[u8Index] = au8MPG[i];
-    }
-    
-    LCDMessage(LINE2_START_ADDR, au8Temp);
+    /* Both lines go out straight from flash */
+    LcdMarqueeLine(LINE1_START_ADDR, au8Eng, u8ResetIndex);
+    LcdMarqueeLine(LINE2_START_ADDR, au8MPG, u8ResetIndex);
     u8ResetIndex++;
     
     if(u8ResetIndex == 20)
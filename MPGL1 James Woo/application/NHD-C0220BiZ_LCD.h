@@ -111,6 +111,7 @@ void LcdInitialize(void);
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
+static void LcdMarqueeLine(u8 u8Address_, const u8* pu8Message_, u8 u8Rotation_);
 
 
 /***********************************************************************************************************************
@@ -19,6 +19,7 @@ The terminal program used to interface to the debugger should be set to:
 ***********************************************************************************************************************/
 
 #include "configuration.h"
+#include "music.h"
 
 /***********************************************************************************************************************
 Global variable definitions with scope across entire project.
@@ -63,16 +64,24 @@ static u16 Debug_u16CommandSize;                         /* Number of characters
 
 static u8 Debug_u8Command;                               /* A validated command number */
 
+#ifdef PWM_AUDIO_TRACE
+static u16 Debug_u16TraceIndex;                          /* Next PWM trace entry to print */
+static PwmAudioTraceType Debug_sTraceStart;              /* First PWM trace entry (time 0 of the dump) */
+#endif /* PWM_AUDIO_TRACE */
+
+static MessagingSnapshotType Debug_sMsgSnapshot;         /* Messaging statistics being printed */
+static u16 Debug_u16ReportLine;                          /* Next line of the messaging report */
+
 /* Add commands by updating debug.h in the Command-Specific Definitions section, then update this list
 with the function name to call for the corresponding command: */
 DebugCommandType Debug_au8Commands[DEBUG_COMMANDS] = { {DEBUG_CMD_NAME00, DebugCommandPrepareList},
                                                        {DEBUG_CMD_NAME01, DebugCommandDummy},
-                                                       {DEBUG_CMD_NAME02, DebugCommandDummy},
-                                                       {DEBUG_CMD_NAME03, DebugCommandDummy},
-                                                       {DEBUG_CMD_NAME04, DebugCommandDummy},
-                                                       {DEBUG_CMD_NAME05, DebugCommandDummy},
-                                                       {DEBUG_CMD_NAME06, DebugCommandDummy},
-                                                       {DEBUG_CMD_NAME07, DebugCommandDummy} 
+                                                       {DEBUG_CMD_NAME02, DebugCommandMusicTempoFaster},
+                                                       {DEBUG_CMD_NAME03, DebugCommandMusicTempoSlower},
+                                                       {DEBUG_CMD_NAME04, DebugCommandMusicTransposeUp},
+                                                       {DEBUG_CMD_NAME05, DebugCommandMusicTransposeDown},
+                                                       {DEBUG_CMD_NAME06, DebugCommandPwmTraceDump},
+                                                       {DEBUG_CMD_NAME07, DebugCommandMessagingStats} 
                                                      };
 
 
@@ -127,9 +136,9 @@ Promises:
 */
 void DebugLineFeed(void)
 {
-  u8 au8Linefeed[] = {ASCII_LINEFEED, ASCII_CARRIAGE_RETURN};
+  static const u8 au8Linefeed[] = {ASCII_LINEFEED, ASCII_CARRIAGE_RETURN};
   
-  UartWriteData(Debug_Uart, sizeof(au8Linefeed), &au8Linefeed[0]);
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8Linefeed), &au8Linefeed[0], NULL);
 
 } /* end DebugLineFeed() */
 
@@ -141,58 +150,19 @@ Description:
 Formats a long into an ASCII string and queues to print
 
 Requires:
-  - Enough space is available on the heap to temporarily store the number array
+  - 
 
 Promises:
-  - The number is converted to an array of ascii without leading zeros and sent to UART
+  - The number is converted to an array of ascii without leading zeros and sent to UART (the digits are copied
+    into the message straight from the stack, so no heap buffer is needed)
 */
 void DebugPrintNumber(u32 u32Number_)
 {
-  bool bFoundDigit = FALSE;
-  u8 au8AsciiNumber[10];
-  u8 u8CharCount = 0;
-  u32 u32Temp, u32Divider = 1000000000;
-  u8 *pu8Data;
-
-  /* Parse out all the digits, start counting after leading zeros */
-  for(u8 index = 0; index < 10; index++)
-  {
-    au8AsciiNumber[index] = (u32Number_ / u32Divider) + 0x30;
-    if(au8AsciiNumber[index] != '0')
-    {
-      bFoundDigit = TRUE;
-    }
-    if(bFoundDigit)
-    {
-      u8CharCount++;
-    }
-    u32Number_ %= u32Divider;
-    u32Divider /= 10;
-  }
-  
-  /* Handle special case where u32Number == 0 */
-  if(!bFoundDigit)
-  {
-    u8CharCount = 1;
-  }
-  
-  /* Allocate memory for the right number and copy the array */
-  pu8Data = malloc(u8CharCount);
-  if (pu8Data == NULL)
-  {
-    Debug_u8ErrorCode = DEBUG_ERROR_MALLOC;
-    G_DebugStateMachine = DebugSM_Error;
-  }
-  
-  u32Temp = 9;
-  for(u8 index = u8CharCount; index != 0; index--)
-  {
-    pu8Data[index - 1] = au8AsciiNumber[u32Temp--];
-  }
-    
-  /* Print the ascii string and free the memory */
-  UartWriteData(Debug_Uart, u8CharCount, pu8Data);
-  free(pu8Data);
+  u8 au8AsciiNumber[11];
+  u8 u8CharCount;
+
+  u8CharCount = NumberToAscii(u32Number_, &au8AsciiNumber[0]);
+  UartWriteData(Debug_Uart, u8CharCount, &au8AsciiNumber[0]);
   
 } /* end DebugDebugPrintNumber() */
 
@@ -333,17 +303,18 @@ Promises:
 */
 static void DebugCommandPrepareList(void)
 {
-  u8 au8ListHeading[] = "\n\n\rAvailable commands:\n\r";
-  u8 au8CommandLine[DEBUG_CMD_PREFIX_LENGTH + DEBUG_CMD_NAME_LENGTH + DEBUG_CMD_POSTFIX_LENGTH];
+  static const u8 au8ListHeading[] = "\n\n\rAvailable commands:";
+  u8 au8CommandLine[DEBUG_CMD_POSTFIX_LENGTH + DEBUG_CMD_PREFIX_LENGTH];
   
-  /* Write static characters to command list line */
-  au8CommandLine[2] = ':';
-  au8CommandLine[3] = ' ';
-  au8CommandLine[DEBUG_CMD_PREFIX_LENGTH + DEBUG_CMD_NAME_LENGTH] = '\n';
-  au8CommandLine[DEBUG_CMD_PREFIX_LENGTH + DEBUG_CMD_NAME_LENGTH + 1] = '\r';
+  /* Each line is "<CR><LF>00: " copied to the queue followed by the command name sent from flash; the postfix of
+  one line is the start of the next so every line takes two messages */
+  au8CommandLine[0] = '\n';
+  au8CommandLine[1] = '\r';
+  au8CommandLine[4] = ':';
+  au8CommandLine[5] = ' ';
 
   /* Prepare a nicely formatted list of commands */
-  UartWriteData(Debug_Uart, sizeof(au8ListHeading) - 1, &au8ListHeading[0]);
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8ListHeading) - 1, &au8ListHeading[0], NULL);
   
   /* Loop through the array of commands parsing out the command number
   and printing it along with the command name. */  
@@ -352,26 +323,22 @@ static void DebugCommandPrepareList(void)
     /* Get the command number in ASCII */
     if(i >= 10)
     {
-      au8CommandLine[0] = (i / 10) + 0x30;
+      au8CommandLine[2] = (i / 10) + 0x30;
     }
     else
     {
-      au8CommandLine[0] = 0x30;
+      au8CommandLine[2] = 0x30;
     }
     
-    au8CommandLine[1] = (i % 10) + 0x30;
+    au8CommandLine[3] = (i % 10) + 0x30;
     
-    /* Read the command name */
-    for(u8 j = 0; j < DEBUG_CMD_NAME_LENGTH; j++)
-    {
-      au8CommandLine[DEBUG_CMD_PREFIX_LENGTH + j] = Debug_au8Commands[i].pu8CommandName[j];
-    }
-    
-    /* Queue the command name to the UART */
+    /* Queue the number and then the command name (a string constant) to the UART */
     UartWriteData(Debug_Uart, sizeof(au8CommandLine), &au8CommandLine[0]);
+    UartWriteDataNoCopy(Debug_Uart, DEBUG_CMD_NAME_LENGTH, Debug_au8Commands[i].pu8CommandName, NULL);
   }
 
   DebugLineFeed();
+  DebugLineFeed();
   
 } /* end DebugCommand0PrepareList() */
 
@@ -385,13 +352,179 @@ A command place-holder.
 */
 static void DebugCommandDummy(void)
 {
-  u8 au8DummyCommand[] = "\n\rDummy!\n\n\r";
+  static const u8 au8DummyCommand[] = "\n\rDummy!\n\n\r";
   
-  UartWriteData(Debug_Uart, sizeof(au8DummyCommand) - 1, &au8DummyCommand[0]);
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8DummyCommand) - 1, &au8DummyCommand[0], NULL);
   
 } /* end DebugCommandDummy() */
 
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCommandMusicTempoFaster
+
+Description:
+Moves the music player to the next faster tempo step and reports the new setting.  Takes effect from the next note.
+*/
+static void DebugCommandMusicTempoFaster(void)
+{
+  if( MusicGetTempo() < (MUSIC_TEMPO_STEPS - 1) )
+  {
+    MusicSetTempo(MusicGetTempo() + 1);
+  }
+
+  DebugMusicReport();
+  
+} /* end DebugCommandMusicTempoFaster() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCommandMusicTempoSlower
+
+Description:
+Moves the music player to the next slower tempo step and reports the new setting.  Takes effect from the next note.
+*/
+static void DebugCommandMusicTempoSlower(void)
+{
+  if( MusicGetTempo() > 0 )
+  {
+    MusicSetTempo(MusicGetTempo() - 1);
+  }
+
+  DebugMusicReport();
+  
+} /* end DebugCommandMusicTempoSlower() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCommandMusicTransposeUp
+
+Description:
+Transposes the music player up one semitone (up to MUSIC_TRANSPOSE_MAX) and reports the new setting.
+*/
+static void DebugCommandMusicTransposeUp(void)
+{
+  MusicSetTranspose(MusicGetTranspose() + 1);
+  DebugMusicReport();
+  
+} /* end DebugCommandMusicTransposeUp() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCommandMusicTransposeDown
+
+Description:
+Transposes the music player down one semitone (down to -MUSIC_TRANSPOSE_MAX) and reports the new setting.
+*/
+static void DebugCommandMusicTransposeDown(void)
+{
+  MusicSetTranspose(MusicGetTranspose() - 1);
+  DebugMusicReport();
+  
+} /* end DebugCommandMusicTransposeDown() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugMusicReport
+
+Description:
+Prints the music player tempo and transpose, e.g. "Tempo 200%  Transpose +3".
+*/
+static void DebugMusicReport(void)
+{
+  static const u8 au8Tempo[] = "\n\rTempo ";
+  static const u8 au8Transpose[] = "%  Transpose ";
+  u8 au8Sign[] = "+";
+  s8 s8Transpose = MusicGetTranspose();
+  
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8Tempo) - 1, &au8Tempo[0], NULL);
+  DebugPrintNumber( (u32)MusicGetTempoPercent() );
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8Transpose) - 1, &au8Transpose[0], NULL);
+
+  if(s8Transpose < 0)
+  {
+    au8Sign[0] = '-';
+    s8Transpose = -s8Transpose;
+  }
+  
+  UartWriteData(Debug_Uart, sizeof(au8Sign) - 1, &au8Sign[0]);
+  DebugPrintNumber( (u32)s8Transpose );
+  DebugLineFeed();
+  
+} /* end DebugMusicReport() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCommandPwmTraceDump
+
+Description:
+Prints the buzzer PWM trace as CSV, one change per line:
+time_us,channel,period,duty,enabled
+Times are from the first entry.  The lines are sent one at a time by DebugSM_PwmTraceDump so the message queue is
+never flooded.  Build with PWM_AUDIO_TRACE defined in configuration.h to record the trace.
+*/
+static void DebugCommandPwmTraceDump(void)
+{
+#ifdef PWM_AUDIO_TRACE
+  static const u8 au8Heading[] = "\n\rtime_us,channel,period,duty,enabled\n\r";
+
+  Debug_u32CurrentMessageToken = UartWriteDataNoCopy(Debug_Uart, sizeof(au8Heading) - 1, &au8Heading[0], NULL);
+  Debug_u16TraceIndex = 0;
+  PWMAudioTraceRead(0, &Debug_sTraceStart);
+  G_DebugStateMachine = DebugSM_PwmTraceDump;
+#else
+  static const u8 au8TraceOff[] = "\n\rPWM trace not built (define PWM_AUDIO_TRACE)\n\n\r";
+
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8TraceOff) - 1, &au8TraceOff[0], NULL);
+#endif /* PWM_AUDIO_TRACE */
+
+} /* end DebugCommandPwmTraceDump() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCommandMessagingStats
+
+Description:
+Takes a snapshot of the messaging statistics and prints it one line at a time from DebugSM_MessagingReport: the pool
+use, a line per registered queue (depth/peak, messages queued, writes refused because the pool was full and the
+number of messages per latency bucket) and then the raw snapshot as hex lines starting "SNAP " for a host tool.
+*/
+static void DebugCommandMessagingStats(void)
+{
+  MessagingSnapshot(&Debug_sMsgSnapshot);
+  Debug_u16ReportLine = 0;
+  Debug_u32CurrentMessageToken = 0;
+  G_DebugStateMachine = DebugSM_MessagingReport;
+
+} /* end DebugCommandMessagingStats() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DebugCopyString
+
+Description:
+Copies a string without its terminator.
+
+Requires:
+  - pu8Destination_ has room for the string
+
+Promises:
+  - The characters of pu8Source_ are written to pu8Destination_ and the number of characters is returned
+*/
+static u8 DebugCopyString(const u8* pu8Source_, u8* pu8Destination_)
+{
+  u8 u8Count = 0;
+
+  while(pu8Source_[u8Count] != '\0')
+  {
+    pu8Destination_[u8Count] = pu8Source_[u8Count];
+    u8Count++;
+  }
+
+  return(u8Count);
+
+} /* end DebugCopyString() */
+
+
 /***********************************************************************************************************************
 State Machine Function Declarations
 
@@ -414,8 +547,8 @@ void DebugSM_Idle(void)
 {
   bool bCommandFound = FALSE;
   u8 u8CurrentByte;
-  static u8 au8BackspaceSequence[] = {ASCII_BACKSPACE, ' ', ASCII_BACKSPACE};
-  static u8 au8CommandOverflow[] = "\r\n*** Command too long ***\r\n\n";
+  static const u8 au8BackspaceSequence[] = {ASCII_BACKSPACE, ' ', ASCII_BACKSPACE};
+  static const u8 au8CommandOverflow[] = "\r\n*** Command too long ***\r\n\n";
   
   /* Parse any new characters that have come in until no more chars or a command is found */
   while( (Debug_pu8RxBufferParser != *Debug_Uart->pu8RxNextByte) && (bCommandFound == FALSE) )
@@ -435,7 +568,7 @@ void DebugSM_Idle(void)
           Debug_u16CommandSize--;
         }
         
-        UartWriteData(Debug_Uart, sizeof(au8BackspaceSequence), &au8BackspaceSequence[0]);
+        UartWriteDataUrgent(Debug_Uart, sizeof(au8BackspaceSequence), &au8BackspaceSequence[0]);
         break;
       }
 
@@ -452,8 +585,9 @@ void DebugSM_Idle(void)
       /* Add to command buffer and echo */
       default: 
       {
-        /* Echo the character and place it in the command buffer */
-        UartWriteByte(Debug_Uart, u8CurrentByte);
+        /* Echo the character (ahead of any queued output so typing stays responsive) and place it in the command 
+        buffer */
+        UartWriteDataUrgent(Debug_Uart, 1, &u8CurrentByte);
         *Debug_pu8CmdBufferNextChar = u8CurrentByte;
         Debug_pu8CmdBufferNextChar++;
         Debug_u16CommandSize++;
@@ -466,7 +600,8 @@ void DebugSM_Idle(void)
           Debug_pu8CmdBufferNextChar = &Debug_au8CommandBuffer[0];
           Debug_u16CommandSize = 0;
 
-          Debug_u32CurrentMessageToken = UartWriteData(Debug_Uart, sizeof(au8CommandOverflow), au8CommandOverflow);
+          Debug_u32CurrentMessageToken = UartWriteDataNoCopy(Debug_Uart, sizeof(au8CommandOverflow), au8CommandOverflow, 
+                                                             NULL);
         }
         break;
       }
@@ -501,7 +636,7 @@ until the command is processed.
 void DebugSM_CheckCmd(void)        
 {
   static u8 au8CommandHeader[] = "en+c";
-  static u8 au8InvalidCommand[] = "\nInvalid command\n\n\r"; 
+  static const u8 au8InvalidCommand[] = "\nInvalid command\n\n\r"; 
   bool bGoodCommand = TRUE;
   u8 u8Index;
   s8 s8Temp;
@@ -554,7 +689,7 @@ void DebugSM_CheckCmd(void)
   /* Otherwise print an error message and return to Idle */
   else
   { 
-    UartWriteData(Debug_Uart, sizeof(au8InvalidCommand) - 1, &au8InvalidCommand[0]);
+    UartWriteDataNoCopy(Debug_Uart, sizeof(au8InvalidCommand) - 1, &au8InvalidCommand[0], NULL);
     G_DebugStateMachine = DebugSM_Idle;
   }
 
@@ -578,6 +713,167 @@ void DebugSM_ProcessCmd(void)
 } /* end DebugSM_ProcessCmd() */
 
 
+#ifdef PWM_AUDIO_TRACE
+/*----------------------------------------------------------------------------------------------------------------------
+Prints the next line of the PWM trace once the previous line has been sent, then returns to Idle after the last entry.
+*/
+void DebugSM_PwmTraceDump(void)
+{
+  PwmAudioTraceType sEntry;
+  MessageStateType eStatus;
+  u8 au8Line[5 * 11 + 2];
+  u8 u8Size;
+  u32 u32TimeUs;
+
+  /* Wait for the previous line to leave the queue */
+  if(Debug_u32CurrentMessageToken != 0)
+  {
+    eStatus = QueryMessageStatus(Debug_u32CurrentMessageToken);
+    if( (eStatus == WAITING) || (eStatus == SENDING) )
+    {
+      return;
+    }
+  }
+
+  if( !PWMAudioTraceRead(Debug_u16TraceIndex, &sEntry) )
+  {
+    DebugLineFeed();
+    Debug_u32CurrentMessageToken = 0;
+    G_DebugStateMachine = DebugSM_Idle;
+    return;
+  }
+
+  u32TimeUs = ((sEntry.u32Time - Debug_sTraceStart.u32Time) * 1000) +
+              (sEntry.u16SysTicks / SYSTICK_TICKS_PER_US) - (Debug_sTraceStart.u16SysTicks / SYSTICK_TICKS_PER_US);
+
+  /* The terminator NumberToAscii() writes after each number is overwritten by the next character */
+  u8Size = NumberToAscii(u32TimeUs, &au8Line[0]);
+  au8Line[u8Size++] = ',';
+  u8Size += NumberToAscii(sEntry.u8Channel, &au8Line[u8Size]);
+  au8Line[u8Size++] = ',';
+  u8Size += NumberToAscii(sEntry.u16Period, &au8Line[u8Size]);
+  au8Line[u8Size++] = ',';
+  u8Size += NumberToAscii(sEntry.u16Duty, &au8Line[u8Size]);
+  au8Line[u8Size++] = ',';
+  u8Size += NumberToAscii(sEntry.u8Enabled, &au8Line[u8Size]);
+  au8Line[u8Size++] = '\n';
+  au8Line[u8Size++] = '\r';
+
+  Debug_u32CurrentMessageToken = UartWriteData(Debug_Uart, u8Size, &au8Line[0]);
+  Debug_u16TraceIndex++;
+
+} /* end DebugSM_PwmTraceDump() */
+#endif /* PWM_AUDIO_TRACE */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Prints the next line of the messaging report once the previous line has been sent, then returns to Idle after the 
+last line of the snapshot.
+*/
+void DebugSM_MessagingReport(void)
+{
+  static const u8 au8Heading[] = "name depth/peak queued full | messages by latency ms: "
+                                 "0 1 2+ 4+ 8+ 16+ 32+ 64+ 128+ 256+ 512+ 1024+\n\r";
+  static const u8 au8Pool[] = "\n\rPool ";
+  static const u8 au8Peak[] = " peak ";
+  static const u8 au8BlocksPeak[] = " blocks peak";
+  static const u8 au8Snap[] = "SNAP ";
+  MessageStateType eStatus;
+  MessageQueueSnapshotType* psQueue;
+  u8 au8Line[DEBUG_MSG_LINE_SIZE];
+  u8 u8Size = 0;
+  u8* pu8Snapshot;
+  u16 u16Offset;
+
+  /* Wait for the previous line to leave the queue */
+  if(Debug_u32CurrentMessageToken != 0)
+  {
+    eStatus = QueryMessageStatus(Debug_u32CurrentMessageToken);
+    if( (eStatus == WAITING) || (eStatus == SENDING) )
+    {
+      return;
+    }
+  }
+
+  /* The terminator NumberToAscii() writes after each number is overwritten by the next character */
+  if(Debug_u16ReportLine == 0)
+  {
+    /* "<CR><LF>Pool 12/48 peak 30 blocks peak 10 5 2 1" */
+    u8Size += DebugCopyString(au8Pool, &au8Line[u8Size]);
+    u8Size += NumberToAscii(Debug_sMsgSnapshot.u8PoolUsed, &au8Line[u8Size]);
+    au8Line[u8Size++] = '/';
+    u8Size += NumberToAscii(Debug_sMsgSnapshot.u8PoolSize, &au8Line[u8Size]);
+    u8Size += DebugCopyString(au8Peak, &au8Line[u8Size]);
+    u8Size += NumberToAscii(Debug_sMsgSnapshot.u8PoolPeak, &au8Line[u8Size]);
+    u8Size += DebugCopyString(au8BlocksPeak, &au8Line[u8Size]);
+    for(u8 i = 0; i < MSG_PAYLOAD_CLASSES; i++)
+    {
+      au8Line[u8Size++] = ' ';
+      u8Size += NumberToAscii(Debug_sMsgSnapshot.au8BlocksPeak[i], &au8Line[u8Size]);
+    }
+    au8Line[u8Size++] = '\n';
+    au8Line[u8Size++] = '\r';
+    
+    UartWriteData(Debug_Uart, u8Size, &au8Line[0]);
+    Debug_u32CurrentMessageToken = UartWriteDataNoCopy(Debug_Uart, sizeof(au8Heading) - 1, &au8Heading[0], NULL);
+    Debug_u16ReportLine++;
+    return;
+  }
+  
+  if(Debug_u16ReportLine <= Debug_sMsgSnapshot.u8Queues)
+  {
+    /* "DBGU 0/9 1234 0 | 5 3 1 0 0 0 0 0 0 0 0 0" */
+    psQueue = &Debug_sMsgSnapshot.asQueues[Debug_u16ReportLine - 1];
+    for(u8 i = 0; i < MSG_QUEUE_NAME_SIZE; i++)
+    {
+      au8Line[u8Size++] = psQueue->au8Name[i];
+    }
+    au8Line[u8Size++] = ' ';
+    u8Size += NumberToAscii(psQueue->sStats.u32Depth, &au8Line[u8Size]);
+    au8Line[u8Size++] = '/';
+    u8Size += NumberToAscii(psQueue->sStats.u32PeakDepth, &au8Line[u8Size]);
+    au8Line[u8Size++] = ' ';
+    u8Size += NumberToAscii(psQueue->sStats.u32Queued, &au8Line[u8Size]);
+    au8Line[u8Size++] = ' ';
+    u8Size += NumberToAscii(psQueue->sStats.u32Rejected, &au8Line[u8Size]);
+    au8Line[u8Size++] = ' ';
+    au8Line[u8Size++] = '|';
+    for(u8 i = 0; i < MSG_LATENCY_BUCKETS; i++)
+    {
+      au8Line[u8Size++] = ' ';
+      u8Size += NumberToAscii(psQueue->sStats.au32Latency[i], &au8Line[u8Size]);
+    }
+  }
+  else
+  {
+    /* "SNAP 4D534753..." with DEBUG_MSG_HEX_BYTES bytes of the snapshot per line */
+    u16Offset = (Debug_u16ReportLine - 1 - Debug_sMsgSnapshot.u8Queues) * DEBUG_MSG_HEX_BYTES;
+    if(u16Offset >= sizeof(MessagingSnapshotType))
+    {
+      DebugLineFeed();
+      Debug_u32CurrentMessageToken = 0;
+      G_DebugStateMachine = DebugSM_Idle;
+      return;
+    }
+    
+    u8Size += DebugCopyString(au8Snap, &au8Line[u8Size]);
+    pu8Snapshot = (u8*)&Debug_sMsgSnapshot;
+    for(u16 i = u16Offset; (i < sizeof(MessagingSnapshotType)) && (i < u16Offset + DEBUG_MSG_HEX_BYTES); i++)
+    {
+      au8Line[u8Size++] = HexToASCIICharUpper(pu8Snapshot[i] >> 4);
+      au8Line[u8Size++] = HexToASCIICharUpper(pu8Snapshot[i] & 0x0F);
+    }
+  }
+  
+  au8Line[u8Size++] = '\n';
+  au8Line[u8Size++] = '\r';
+
+  Debug_u32CurrentMessageToken = UartWriteData(Debug_Uart, u8Size, &au8Line[0]);
+  Debug_u16ReportLine++;
+
+} /* end DebugSM_MessagingReport() */
+
+
 /*----------------------------------------------------------------------------------------------------------------------
 Error state 
 Attempt to print an error message (even though if the Debug UART has failed, then it obviously cannot print
@@ -585,11 +881,11 @@ a message to tell you that!)
 */
 void DebugSM_Error(void)         
 {
-  static u8 au8DebugErrorMsg[] = "\n\nDebug task error: ";
+  static const u8 au8DebugErrorMsg[] = "\n\nDebug task error: ";
   
   /* Flag an error and report it (if possible) */
   G_u32DebugFlags |= DEBUG_FLAG_ERROR;
-  UartWriteData(Debug_Uart, sizeof(au8DebugErrorMsg) - 1, au8DebugErrorMsg);
+  UartWriteDataNoCopy(Debug_Uart, sizeof(au8DebugErrorMsg) - 1, au8DebugErrorMsg, NULL);
   DebugPrintNumber( (u32)(Debug_u8ErrorCode) );
   DebugLineFeed();
   
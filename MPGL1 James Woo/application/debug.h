@@ -41,16 +41,19 @@ typedef struct
 /*                              "0123456789ABCDEF0123456789ABCDEF"  Character position reference */
 #define DEBUG_CMD_NAME00        "Show debug command list         "  /* Command 0: List all commands */
 #define DEBUG_CMD_NAME01        "Toggle LED test mode            "  /* Command 1: Toggle LED test mode on/off */
-#define DEBUG_CMD_NAME02        "Dummy2                          "  /* Command 2: */
-#define DEBUG_CMD_NAME03        "Dummy3                          "  /* Command 3: */
-#define DEBUG_CMD_NAME04        "Dummy4                          "  /* Command 4: */
-#define DEBUG_CMD_NAME05        "Dummy5                          "  /* Command 5: */
-#define DEBUG_CMD_NAME06        "Dummy6                          "  /* Command 6: */
-#define DEBUG_CMD_NAME07        "Dummy7                          "  /* Command 7: */
+#define DEBUG_CMD_NAME02        "Music tempo faster              "  /* Command 2: Next music tempo step */
+#define DEBUG_CMD_NAME03        "Music tempo slower              "  /* Command 3: Previous music tempo step */
+#define DEBUG_CMD_NAME04        "Music transpose up              "  /* Command 4: Transpose music up a semitone */
+#define DEBUG_CMD_NAME05        "Music transpose down            "  /* Command 5: Transpose music down a semitone */
+#define DEBUG_CMD_NAME06        "Dump PWM audio trace (CSV)      "  /* Command 6: Print the buzzer PWM trace */
+#define DEBUG_CMD_NAME07        "Show messaging statistics       "  /* Command 7: Print queue use and latencies */
 
 
 #define DEBUG_UART_TIMEOUT      (u32)2000                           /* Max time in ms for a command/message to be sent */
 
+#define DEBUG_MSG_LINE_SIZE     (u8)192                             /* Longest line of the messaging report */
+#define DEBUG_MSG_HEX_BYTES     (u8)32                              /* Snapshot bytes per "SNAP" line */
+
 /* Error codes */
 #define DEBUG_ERROR_NONE        (u8)0                               /* No error */
 #define DEBUG_ERROR_TIMEOUT     (u8)1                               /* Timeout error occured */
@@ -81,6 +84,14 @@ void DebugInitialize(void);
 /*--------------------------------------------------------------------------------------------------------------------*/
 static void DebugCommandPrepareList(void);           
 static void DebugCommandDummy(void);
+static void DebugCommandMusicTempoFaster(void);
+static void DebugCommandMusicTempoSlower(void);
+static void DebugCommandMusicTransposeUp(void);
+static void DebugCommandMusicTransposeDown(void);
+static void DebugCommandPwmTraceDump(void);
+static void DebugCommandMessagingStats(void);
+static void DebugMusicReport(void);
+static u8 DebugCopyString(const u8* pu8Source_, u8* pu8Destination_);
 
 
 /***********************************************************************************************************************
@@ -89,6 +100,10 @@ static void DebugCommandDummy(void);
 static void DebugSM_Idle(void);                       
 static void DebugSM_CheckCmd(void);                   
 static void DebugSM_ProcessCmd(void);                 
+#ifdef PWM_AUDIO_TRACE
+static void DebugSM_PwmTraceDump(void);
+#endif /* PWM_AUDIO_TRACE */
+static void DebugSM_MessagingReport(void);
 
 static void DebugSM_Error(void);
 
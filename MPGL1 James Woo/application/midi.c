@@ -0,0 +1,1137 @@
+/**********************************************************************************************************************
+File: midi.c
+
+Description:
+Standard MIDI File (SMF type 0 and 1) parser that feeds the music player.  The file is parsed incrementally as its
+bytes arrive (e.g. card blocks or UART data), with no dynamic memory: each byte advances a small parser state, note
+on/off events are turned into notes and rests for the two buzzer voices, and the notes wait in a short FIFO per voice
+until the player asks for them through MidiGetNote().
+
+Timing is all integer: the tempo (us per quarter note) and the file division are turned into a Q16 fixed-point ms per
+tick value whenever the tempo changes, and each delta time is added to the track time with one multiply and a shift.
+Tempo changes in the conductor track (track 0) of a type 1 file are kept in a small tempo map and applied at their
+tick while the note track is parsed.
+
+Keys are mapped onto the note table of music.h (C3 - B6); keys outside that range are moved by whole octaves.  A key
+starts on the first free voice; if both voices are sounding the key is dropped.  Channel 10 (percussion) is ignored.
+Notes and rests longer than MIDI_MAX_NOTE_TIME are split into several FIFO entries (a held note is struck again at
+each split).
+
+Only one note track is played: type 1 files play the first track that has notes.  Merging tracks would need the whole
+file in memory, so it is not supported.  When the note track ends its notes are complete (_MIDI_DONE) and the player
+finishes them, while the parser keeps reading the rest of the file: a note in any later track sets the error flag
+_MIDI_MULTI_TRACK and stops the parser there, so the application can report that part of the music was not played.
+
+------------------------------------------------------------------------------------------------------------------------
+API:
+
+Public:
+bool MidiStart(void)
+Resets the parser and starts the music player with MidiGetNote() as its note source.  MIDI times are real time, so
+the player tempo is set to MUSIC_TEMPO_NORMAL (it can still be changed while the file plays).
+
+u32 MidiFeed(const u8* pu8Data_, u32 u32Size_)
+Parses the next bytes of the file.  Returns the number of bytes used: at most MIDI_PARSE_BYTES_PER_CALL, and fewer if
+the note FIFOs are full.  The caller keeps the rest and offers them again on a later loop.
+
+void MidiEndOfData(void)
+Tells the parser no more bytes are coming (e.g. a truncated file).  Sounding notes end and the song finishes.
+
+MusicSourceStatusType MidiGetNote(u8 u8Voice_, MusicNoteType* psNote_)
+Note source given to MusicStartSource() (see MusicNoteSourceType).
+
+**********************************************************************************************************************/
+
+#include "configuration.h"
+#include "music.h"
+#include "midi.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/* New variables */
+volatile u32 G_u32MidiFlags;                           /* Global state flags */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile u32 G_u32SystemFlags;                  /* From main.c */
+extern volatile u32 G_u32ApplicationFlags;             /* From main.c */
+
+extern volatile u32 G_u32SystemTime1ms;                /* From board-specific source file */
+extern volatile u32 G_u32SystemTime1s;                 /* From board-specific source file */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Midi_" and be declared as static.
+***********************************************************************************************************************/
+static MidiParseStateType Midi_eState;                 /* What the next byte is */
+static MidiParseStateType Midi_eSkipNext;              /* State after the bytes being skipped */
+static u32 Midi_u32Value;                              /* Field or variable length quantity being collected */
+static u8 Midi_u8Count;                                /* Bytes collected in the current field */
+static u32 Midi_u32Skip;                               /* Bytes left to skip, or meta data bytes left */
+
+static u16 Midi_u16Format;                             /* SMF type from the header */
+static u16 Midi_u16Tracks;                             /* Number of tracks from the header */
+static u16 Midi_u16Division;                           /* Ticks per quarter note, or SMPTE timing */
+static u16 Midi_u16Track;                              /* Index of the track being parsed */
+static bool Midi_bInTrack;                             /* TRUE while bytes belong to a track chunk */
+static u32 Midi_u32TrackBytes;                         /* Bytes left in the current track chunk */
+static bool Midi_bNoteTrack;                           /* TRUE once the current track has played a note */
+static bool Midi_bScanning;                            /* TRUE after the note track: later tracks are only checked */
+static bool Midi_bEndOfData;                           /* TRUE once MidiEndOfData() is called */
+
+static u8 Midi_u8Status;                               /* Running status */
+static u8 Midi_u8MetaType;                             /* Meta event type being read */
+static u8 Midi_au8Data[MIDI_EVENT_DATA_SIZE];          /* Data bytes of the event being read */
+static u8 Midi_u8DataIndex;                            /* Data bytes collected */
+static u8 Midi_u8DataSize;                             /* Data bytes the event needs */
+
+static u32 Midi_u32Tick;                               /* Track time in ticks */
+static u32 Midi_u32Time;                               /* Track time in ms */
+static u32 Midi_u32TimeFraction;                       /* Fraction of a ms in Q16 */
+static u32 Midi_u32MsPerTick;                          /* Q16 ms per tick at the current tempo */
+static MidiTempoType Midi_asTempoMap[MIDI_TEMPO_MAP_SIZE]; /* Conductor track tempo changes */
+static u8 Midi_u8TempoCount;                           /* Entries in Midi_asTempoMap */
+static u8 Midi_u8TempoNext;                            /* Next tempo map entry to apply */
+
+static MidiVoiceType Midi_asVoices[MUSIC_VOICES];      /* Note FIFOs and key state of each voice */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiStart
+
+Description:
+Resets the parser for a new file and starts the music player on it.  The player waits until notes are parsed.
+
+Requires:
+  -
+
+Promises:
+  - The parser expects the "MThd" header next and the note FIFOs are empty
+  - The player tempo is MUSIC_TEMPO_NORMAL and the player is started with MidiGetNote() as its note source
+  - Returns the result of MusicStartSource()
+*/
+bool MidiStart(void)
+{
+  Midi_eState = MIDI_PARSE_HEADER;
+  Midi_u32Value = 0;
+  Midi_u8Count = 0;
+  Midi_bInTrack = FALSE;
+  Midi_u16Track = 0;
+  Midi_u8TempoCount = 0;
+  Midi_bScanning = FALSE;
+  Midi_bEndOfData = FALSE;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    Midi_asVoices[i].u8Head = 0;
+    Midi_asVoices[i].u8Tail = 0;
+    Midi_asVoices[i].u8Key = MIDI_NO_KEY;
+    Midi_asVoices[i].u32PendingTime = 0;
+    Midi_asVoices[i].u32EndTime = 0;
+  }
+
+  G_u32MidiFlags = _MIDI_PLAYING;
+
+  MusicSetTempo(MUSIC_TEMPO_NORMAL);
+  return( MusicStartSource(MidiGetNote) );
+
+} /* end MidiStart() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiFeed
+
+Description:
+Parses the next bytes of the MIDI file.  Parsing stops early if a note FIFO is full so the parser never runs more
+than MIDI_NOTE_FIFO_SIZE notes ahead of the player, and after MIDI_PARSE_BYTES_PER_CALL bytes so one call has a
+bounded run time.  Tracks after the note track add no notes, so they are checked without waiting for the player.
+
+Requires:
+  - MidiStart() was called for this file
+  - pu8Data_ points to the next u32Size_ bytes of the file
+
+Promises:
+  - Returns the number of bytes parsed; the caller offers the rest again later
+  - Once the file is done (or failed, or ended by MidiEndOfData()) every byte offered is accepted and ignored
+*/
+u32 MidiFeed(const u8* pu8Data_, u32 u32Size_)
+{
+  u32 u32Used = 0;
+
+  while( (u32Used < u32Size_) && (u32Used < MIDI_PARSE_BYTES_PER_CALL) )
+  {
+    if( (Midi_eState == MIDI_PARSE_DONE) || Midi_bEndOfData )
+    {
+      return(u32Size_);
+    }
+
+    if( !Midi_bScanning && !MidiHasRoom() )
+    {
+      break;
+    }
+
+    MidiParseByte(pu8Data_[u32Used]);
+    u32Used++;
+  }
+
+  if( (Midi_eState == MIDI_PARSE_DONE) || Midi_bEndOfData )
+  {
+    return(u32Size_);
+  }
+
+  return(u32Used);
+
+} /* end MidiFeed() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiEndOfData
+
+Description:
+Ends the file early: notes still sounding are given their length up to the current time.  Their notes need FIFO
+room, so if a FIFO is full the file is finished by MidiGetNote() once the player has taken a note.
+
+Requires:
+  -
+
+Promises:
+  - _MIDI_DONE is set now or on a later MidiGetNote(), and the player finishes with the notes already parsed
+*/
+void MidiEndOfData(void)
+{
+  if(Midi_eState == MIDI_PARSE_DONE)
+  {
+    return;
+  }
+
+  Midi_bEndOfData = TRUE;
+  if( MidiHasRoom() )
+  {
+    MidiFinish();
+  }
+
+} /* end MidiEndOfData() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiGetNote
+
+Description:
+Note source for the music player: hands over the next note or rest parsed for a voice.  The freed FIFO slots take
+the rest of a split note first.
+
+Requires:
+  - Called from the main loop by the music player (see MusicNoteSourceType)
+
+Promises:
+  - Returns MUSIC_SOURCE_NOTE with the next note in *psNote_, or MUSIC_SOURCE_LAST if it is the last one of the voice
+  - Returns MUSIC_SOURCE_WAIT if the parser has not reached the next note yet
+  - Returns MUSIC_SOURCE_END once the file is done and the voice FIFO is empty
+*/
+MusicSourceStatusType MidiGetNote(u8 u8Voice_, MusicNoteType* psNote_)
+{
+  MidiVoiceType* psVoice;
+
+  if(u8Voice_ >= MUSIC_VOICES)
+  {
+    return(MUSIC_SOURCE_END);
+  }
+
+  /* End of data waiting for FIFO room */
+  if( Midi_bEndOfData && (Midi_eState != MIDI_PARSE_DONE) && MidiHasRoom() )
+  {
+    MidiFinish();
+  }
+
+  psVoice = &Midi_asVoices[u8Voice_];
+  MidiFlushVoice(psVoice);
+  if(psVoice->u8Tail == psVoice->u8Head)
+  {
+    if(G_u32MidiFlags & _MIDI_DONE)
+    {
+      return(MUSIC_SOURCE_END);
+    }
+
+    return(MUSIC_SOURCE_WAIT);
+  }
+
+  *psNote_ = psVoice->asFifo[psVoice->u8Tail];
+  psVoice->u8Tail = (psVoice->u8Tail + 1) % MIDI_NOTE_FIFO_SIZE;
+  MidiFlushVoice(psVoice);
+
+  if( (G_u32MidiFlags & _MIDI_DONE) && (psVoice->u8Tail == psVoice->u8Head) )
+  {
+    return(MUSIC_SOURCE_LAST);
+  }
+
+  return(MUSIC_SOURCE_NOTE);
+
+} /* end MidiGetNote() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected functions                                                                                                */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiParseByte
+
+Description:
+Advances the parser by one byte of the file.  Fixed size header fields are big-endian; delta times and lengths are
+variable length quantities (7 bits per byte, high bit set on all but the last byte).
+
+Requires:
+  - Each FIFO has room for at least one more note (MidiHasRoom())
+
+Promises:
+  - The byte is consumed and any event it completes is applied
+  - A track whose chunk runs out without an End of Track event is ended anyway
+  - Parsing finishes at the first note of a second note track
+*/
+static void MidiParseByte(u8 u8Byte_)
+{
+  if(Midi_bInTrack)
+  {
+    Midi_u32TrackBytes--;
+  }
+
+  switch(Midi_eState)
+  {
+    case MIDI_PARSE_HEADER:
+    case MIDI_PARSE_HEADER_LENGTH:
+    case MIDI_PARSE_CHUNK:
+    case MIDI_PARSE_CHUNK_LENGTH:
+    {
+      /* 4-byte big-endian fields */
+      Midi_u32Value = (Midi_u32Value << 8) | u8Byte_;
+      if(++Midi_u8Count < 4)
+      {
+        break;
+      }
+
+      Midi_u8Count = 0;
+      if(Midi_eState == MIDI_PARSE_HEADER)
+      {
+        if(Midi_u32Value != MIDI_HEADER_ID)
+        {
+          G_u32MidiFlags |= _MIDI_ERROR;
+          MidiFinish();
+          break;
+        }
+
+        Midi_eState = MIDI_PARSE_HEADER_LENGTH;
+      }
+      else if(Midi_eState == MIDI_PARSE_HEADER_LENGTH)
+      {
+        if(Midi_u32Value < MIDI_HEADER_SIZE)
+        {
+          G_u32MidiFlags |= _MIDI_ERROR;
+          MidiFinish();
+          break;
+        }
+
+        /* Any header bytes past the standard six are skipped */
+        Midi_u32Skip = Midi_u32Value - MIDI_HEADER_SIZE;
+        Midi_u8DataIndex = 0;
+        Midi_eState = MIDI_PARSE_HEADER_DATA;
+      }
+      else if(Midi_eState == MIDI_PARSE_CHUNK)
+      {
+        /* Midi_u8MetaType remembers if this is a track chunk until its length is read */
+        Midi_u8MetaType = (u8)(Midi_u32Value == MIDI_TRACK_ID);
+        Midi_eState = MIDI_PARSE_CHUNK_LENGTH;
+      }
+      else
+      {
+        if(Midi_u8MetaType)
+        {
+          Midi_u32TrackBytes = Midi_u32Value;
+          MidiStartTrack();
+          if(Midi_u32TrackBytes == 0)
+          {
+            MidiEndTrack();
+          }
+        }
+        else if(Midi_u32Value != 0)
+        {
+          /* Unknown chunks are skipped */
+          Midi_u32Skip = Midi_u32Value;
+          Midi_eSkipNext = MIDI_PARSE_CHUNK;
+          Midi_eState = MIDI_PARSE_SKIP;
+        }
+        else
+        {
+          Midi_eState = MIDI_PARSE_CHUNK;
+        }
+      }
+
+      Midi_u32Value = 0;
+      break;
+    }
+
+    case MIDI_PARSE_HEADER_DATA:
+    {
+      /* Format, tracks and division: three 2-byte fields */
+      Midi_u32Value = (Midi_u32Value << 8) | u8Byte_;
+      Midi_u8DataIndex++;
+      if(Midi_u8DataIndex & 0x01)
+      {
+        break;
+      }
+
+      if(Midi_u8DataIndex == 2)
+      {
+        Midi_u16Format = (u16)Midi_u32Value;
+      }
+      else if(Midi_u8DataIndex == 4)
+      {
+        Midi_u16Tracks = (u16)Midi_u32Value;
+      }
+      else
+      {
+        Midi_u16Division = (u16)Midi_u32Value;
+      }
+
+      Midi_u32Value = 0;
+      if(Midi_u8DataIndex < MIDI_HEADER_SIZE)
+      {
+        break;
+      }
+
+      if( (Midi_u16Format > 1) || (Midi_u16Tracks == 0) || (Midi_u16Division == 0) )
+      {
+        G_u32MidiFlags |= _MIDI_ERROR;
+        MidiFinish();
+        break;
+      }
+
+      if(Midi_u32Skip != 0)
+      {
+        Midi_eSkipNext = MIDI_PARSE_CHUNK;
+        Midi_eState = MIDI_PARSE_SKIP;
+      }
+      else
+      {
+        Midi_eState = MIDI_PARSE_CHUNK;
+      }
+      break;
+    }
+
+    case MIDI_PARSE_DELTA:
+    case MIDI_PARSE_LENGTH:
+    {
+      /* Variable length quantities */
+      Midi_u32Value = (Midi_u32Value << 7) | (u8Byte_ & MIDI_DATA_MASK);
+      if( (u8Byte_ & MIDI_STATUS_BIT) && (++Midi_u8Count < MIDI_VLQ_MAX_BYTES) )
+      {
+        break;
+      }
+
+      Midi_u8Count = 0;
+      if(Midi_eState == MIDI_PARSE_DELTA)
+      {
+        MidiAdvance(Midi_u32Value);
+        Midi_eState = MIDI_PARSE_STATUS;
+      }
+      else
+      {
+        Midi_u32Skip = Midi_u32Value;
+        Midi_u8DataIndex = 0;
+        if(Midi_u8Status == MIDI_STATUS_META)
+        {
+          if(Midi_u32Skip == 0)
+          {
+            MidiMetaEvent();
+          }
+          else
+          {
+            Midi_eState = MIDI_PARSE_META_DATA;
+          }
+        }
+        else if(Midi_u32Skip != 0)
+        {
+          /* System exclusive data is not used */
+          Midi_eSkipNext = MIDI_PARSE_DELTA;
+          Midi_eState = MIDI_PARSE_SKIP;
+        }
+        else
+        {
+          Midi_eState = MIDI_PARSE_DELTA;
+        }
+      }
+
+      Midi_u32Value = 0;
+      break;
+    }
+
+    case MIDI_PARSE_STATUS:
+    {
+      MidiParseStatus(u8Byte_);
+      break;
+    }
+
+    case MIDI_PARSE_DATA:
+    {
+      Midi_au8Data[Midi_u8DataIndex++] = u8Byte_ & MIDI_DATA_MASK;
+      if(Midi_u8DataIndex == Midi_u8DataSize)
+      {
+        MidiChannelEvent();
+        Midi_eState = MIDI_PARSE_DELTA;
+      }
+      break;
+    }
+
+    case MIDI_PARSE_META_TYPE:
+    {
+      Midi_u8MetaType = u8Byte_;
+      Midi_eState = MIDI_PARSE_LENGTH;
+      break;
+    }
+
+    case MIDI_PARSE_META_DATA:
+    {
+      if(Midi_u8DataIndex < MIDI_EVENT_DATA_SIZE)
+      {
+        Midi_au8Data[Midi_u8DataIndex] = u8Byte_;
+      }
+      Midi_u8DataIndex++;
+
+      if(--Midi_u32Skip == 0)
+      {
+        MidiMetaEvent();
+      }
+      break;
+    }
+
+    case MIDI_PARSE_SKIP:
+    {
+      if(--Midi_u32Skip == 0)
+      {
+        Midi_eState = Midi_eSkipNext;
+      }
+      break;
+    }
+
+    default:
+    {
+      break;
+    }
+  } /* end switch(Midi_eState) */
+
+  /* The chunk length is the real end of a track */
+  if( Midi_bInTrack && (Midi_u32TrackBytes == 0) )
+  {
+    MidiEndTrack();
+  }
+
+  /* A second note track is not played: nothing more to look for */
+  if( (G_u32MidiFlags & _MIDI_MULTI_TRACK) && (Midi_eState != MIDI_PARSE_DONE) )
+  {
+    MidiFinish();
+  }
+
+} /* end MidiParseByte() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiParseStatus
+
+Description:
+Handles the byte after a delta time: a status byte, or the first data byte of an event that uses running status.
+
+Requires:
+  - Midi_eState is MIDI_PARSE_STATUS
+
+Promises:
+  - The parser moves to the data, meta or system exclusive states of the event
+*/
+static void MidiParseStatus(u8 u8Byte_)
+{
+  if( !(u8Byte_ & MIDI_STATUS_BIT) )
+  {
+    /* Running status: this is already the first data byte */
+    if( (Midi_u8Status == 0) || (Midi_u8Status >= MIDI_STATUS_SYSTEM) )
+    {
+      G_u32MidiFlags |= _MIDI_ERROR;
+      MidiFinish();
+      return;
+    }
+
+    Midi_u8DataIndex = 0;
+    Midi_eState = MIDI_PARSE_DATA;
+    Midi_au8Data[Midi_u8DataIndex++] = u8Byte_;
+    if(Midi_u8DataIndex == Midi_u8DataSize)
+    {
+      MidiChannelEvent();
+      Midi_eState = MIDI_PARSE_DELTA;
+    }
+    return;
+  }
+
+  Midi_u8Status = u8Byte_;
+  if(u8Byte_ == MIDI_STATUS_META)
+  {
+    Midi_eState = MIDI_PARSE_META_TYPE;
+  }
+  else if( (u8Byte_ == MIDI_STATUS_SYSEX) || (u8Byte_ == MIDI_STATUS_SYSEX_ESCAPE) )
+  {
+    Midi_eState = MIDI_PARSE_LENGTH;
+  }
+  else if(u8Byte_ >= MIDI_STATUS_SYSTEM)
+  {
+    /* Other system messages do not belong in a file */
+    G_u32MidiFlags |= _MIDI_ERROR;
+    MidiFinish();
+  }
+  else
+  {
+    Midi_u8DataSize = 2;
+    if( ((u8Byte_ & MIDI_STATUS_TYPE_MASK) == MIDI_STATUS_PROGRAM) ||
+        ((u8Byte_ & MIDI_STATUS_TYPE_MASK) == MIDI_STATUS_PRESSURE) )
+    {
+      Midi_u8DataSize = 1;
+    }
+
+    Midi_u8DataIndex = 0;
+    Midi_eState = MIDI_PARSE_DATA;
+  }
+
+} /* end MidiParseStatus() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiChannelEvent
+
+Description:
+Applies a complete channel event.  Only note on and note off are used; a note on with velocity 0 is a note off.
+
+Requires:
+  - Midi_u8Status and Midi_au8Data hold the event
+
+Promises:
+  - Note events outside the percussion channel start or end notes on the voices
+*/
+static void MidiChannelEvent(void)
+{
+  u8 u8Type = Midi_u8Status & MIDI_STATUS_TYPE_MASK;
+
+  if( (Midi_u8Status & MIDI_STATUS_CHANNEL_MASK) == MIDI_DRUM_CHANNEL )
+  {
+    return;
+  }
+
+  if( (u8Type == MIDI_STATUS_NOTE_ON) && (Midi_au8Data[1] != 0) )
+  {
+    MidiNoteOn(Midi_au8Data[0]);
+  }
+  else if( (u8Type == MIDI_STATUS_NOTE_ON) || (u8Type == MIDI_STATUS_NOTE_OFF) )
+  {
+    MidiNoteOff(Midi_au8Data[0]);
+  }
+
+} /* end MidiChannelEvent() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiMetaEvent
+
+Description:
+Applies a complete meta event.  Only tempo and End of Track are used.
+
+Requires:
+  - Midi_u8MetaType is the event type and Midi_au8Data holds its first data bytes
+
+Promises:
+  - A tempo event changes the tempo now, and is added to the tempo map if it is in a type 1 conductor track
+  - End of Track ends the track
+  - Otherwise the parser moves on to the next delta time
+*/
+static void MidiMetaEvent(void)
+{
+  u32 u32Tempo;
+
+  Midi_eState = MIDI_PARSE_DELTA;
+
+  if( (Midi_u8MetaType == MIDI_META_TEMPO) && (Midi_u8DataIndex == MIDI_META_TEMPO_SIZE) )
+  {
+    u32Tempo = ((u32)Midi_au8Data[0] << 16) | ((u32)Midi_au8Data[1] << 8) | Midi_au8Data[2];
+    MidiSetTempo(u32Tempo);
+
+    if( (Midi_u16Format == 1) && (Midi_u16Track == 0) && (Midi_u8TempoCount < MIDI_TEMPO_MAP_SIZE) )
+    {
+      Midi_asTempoMap[Midi_u8TempoCount].u32Tick = Midi_u32Tick;
+      Midi_asTempoMap[Midi_u8TempoCount].u32Tempo = u32Tempo;
+      Midi_u8TempoCount++;
+      Midi_u8TempoNext = Midi_u8TempoCount;
+    }
+  }
+  else if(Midi_u8MetaType == MIDI_META_END_OF_TRACK)
+  {
+    MidiEndTrack();
+  }
+
+} /* end MidiMetaEvent() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiStartTrack
+
+Description:
+Sets up the parser at the start of a track chunk.  Every track starts at time 0 with the default tempo; tracks after
+the conductor track pick up its tempo map as their time passes each change.
+
+Requires:
+  - Midi_u32TrackBytes is the track chunk length
+
+Promises:
+  - Track time, tempo, running status and note state are reset and the parser expects a delta time
+*/
+static void MidiStartTrack(void)
+{
+  Midi_bInTrack = TRUE;
+  Midi_bNoteTrack = FALSE;
+  Midi_u8Status = 0;
+  Midi_u32Tick = 0;
+  Midi_u32Time = 0;
+  Midi_u32TimeFraction = 0;
+  Midi_u8TempoNext = 0;
+  MidiSetTempo(MIDI_DEFAULT_TEMPO);
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    Midi_asVoices[i].u8Key = MIDI_NO_KEY;
+    Midi_asVoices[i].u32EndTime = 0;
+  }
+
+  Midi_eState = MIDI_PARSE_DELTA;
+
+} /* end MidiStartTrack() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiEndTrack
+
+Description:
+Ends the current track at End of Track or at the end of its chunk.  Any bytes of the chunk after End of Track are
+skipped.  The end of the note track completes the notes; the tracks after it are only checked for notes.
+
+Requires:
+  - Midi_bInTrack is TRUE
+  - Each FIFO has room for one more note
+
+Promises:
+  - The file is finished if this was the last track
+  - After the note track, its keys still down are released, _MIDI_DONE is set and the later tracks are scanned
+  - Otherwise the parser expects the next chunk
+*/
+static void MidiEndTrack(void)
+{
+  Midi_bInTrack = FALSE;
+  Midi_u16Track++;
+
+  if(Midi_u16Track >= Midi_u16Tracks)
+  {
+    MidiFinish();
+    return;
+  }
+
+  if(Midi_bNoteTrack && !Midi_bScanning)
+  {
+    MidiReleaseKeys();
+    G_u32MidiFlags |= _MIDI_DONE;
+    Midi_bScanning = TRUE;
+  }
+
+  Midi_u32Value = 0;
+  Midi_u8Count = 0;
+  if(Midi_u32TrackBytes != 0)
+  {
+    Midi_u32Skip = Midi_u32TrackBytes;
+    Midi_eSkipNext = MIDI_PARSE_CHUNK;
+    Midi_eState = MIDI_PARSE_SKIP;
+  }
+  else
+  {
+    Midi_eState = MIDI_PARSE_CHUNK;
+  }
+
+} /* end MidiEndTrack() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiFinish
+
+Description:
+Ends parsing: keys still down are released at the current time so their notes reach the player.
+
+Requires:
+  - Each FIFO has room for one more note
+
+Promises:
+  - _MIDI_DONE is set and the parser ignores any further bytes
+*/
+static void MidiFinish(void)
+{
+  MidiReleaseKeys();
+
+  Midi_bInTrack = FALSE;
+  Midi_eState = MIDI_PARSE_DONE;
+  G_u32MidiFlags |= _MIDI_DONE;
+  G_u32MidiFlags &= ~_MIDI_PLAYING;
+
+} /* end MidiFinish() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiReleaseKeys
+
+Description:
+Releases the keys still down at the current time so their notes reach the player.
+
+Requires:
+  - Each FIFO has room for one more note
+
+Promises:
+  - Every voice is free
+*/
+static void MidiReleaseKeys(void)
+{
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    if(Midi_asVoices[i].u8Key != MIDI_NO_KEY)
+    {
+      MidiNoteOff(Midi_asVoices[i].u8Key);
+    }
+  }
+
+} /* end MidiReleaseKeys() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiSetTempo
+
+Description:
+Converts a tempo to the Q16 ms per tick used to accumulate delta times.  This is the only division in the timing
+and it runs once per tempo change.  SMPTE timing does not depend on the tempo.
+
+Requires:
+  - Midi_u16Division is the header division
+
+Promises:
+  - Midi_u32MsPerTick is the Q16 ms length of one tick (rounded)
+*/
+static void MidiSetTempo(u32 u32Tempo_)
+{
+  u64 u64TicksPerUs;
+  u32 u32FramesPerSecond;
+
+  if(Midi_u16Division & MIDI_DIVISION_SMPTE)
+  {
+    /* Upper byte is the negative frame rate, lower byte is ticks per frame */
+    u32FramesPerSecond = (u32)(-(s8)(Midi_u16Division >> 8));
+    u64TicksPerUs = (u64)u32FramesPerSecond * (Midi_u16Division & 0x00FF);
+    u32Tempo_ = 1000000;
+  }
+  else
+  {
+    u64TicksPerUs = Midi_u16Division;
+  }
+
+  /* Q16 ms per tick = (us per quarter / ticks per quarter) / 1000 */
+  u64TicksPerUs *= 1000;
+  if(u64TicksPerUs == 0)
+  {
+    u64TicksPerUs = 1;
+  }
+
+  Midi_u32MsPerTick = (u32)( (((u64)u32Tempo_ << MIDI_MS_Q16_SHIFT) + (u64TicksPerUs / 2)) / u64TicksPerUs );
+
+} /* end MidiSetTempo() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiAdvance
+
+Description:
+Moves the track time forward by a delta time, switching tempo at any conductor track tempo change inside it.
+
+Requires:
+  - Midi_u32MsPerTick is the tempo in effect at Midi_u32Tick
+
+Promises:
+  - Midi_u32Tick and Midi_u32Time are at the end of the delta
+*/
+static void MidiAdvance(u32 u32Ticks_)
+{
+  MidiTempoType* psTempo;
+  u32 u32Step;
+
+  while(Midi_u8TempoNext < Midi_u8TempoCount)
+  {
+    psTempo = &Midi_asTempoMap[Midi_u8TempoNext];
+    if(psTempo->u32Tick > (Midi_u32Tick + u32Ticks_))
+    {
+      break;
+    }
+
+    u32Step = 0;
+    if(psTempo->u32Tick > Midi_u32Tick)
+    {
+      u32Step = psTempo->u32Tick - Midi_u32Tick;
+    }
+
+    MidiAddTime(u32Step);
+    u32Ticks_ -= u32Step;
+    MidiSetTempo(psTempo->u32Tempo);
+    Midi_u8TempoNext++;
+  }
+
+  MidiAddTime(u32Ticks_);
+
+} /* end MidiAdvance() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiAddTime
+
+Description:
+Adds ticks at the current tempo to the track time: one 32 x 32 multiply and a shift, with the fraction of a ms kept
+so rounding never accumulates.
+
+Requires:
+  -
+
+Promises:
+  - Midi_u32Tick, Midi_u32Time and Midi_u32TimeFraction include u32Ticks_
+*/
+static void MidiAddTime(u32 u32Ticks_)
+{
+  u64 u64Time = ((u64)u32Ticks_ * Midi_u32MsPerTick) + Midi_u32TimeFraction;
+
+  Midi_u32Tick += u32Ticks_;
+  Midi_u32Time += (u32)(u64Time >> MIDI_MS_Q16_SHIFT);
+  Midi_u32TimeFraction = (u32)u64Time & MIDI_MS_Q16_MASK;
+
+} /* end MidiAddTime() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiNoteOn
+
+Description:
+Starts a key on the first free voice.  The silence since the voice's last note is handed to the player as a rest.
+
+Requires:
+  - Midi_u32Time is the time of the event
+
+Promises:
+  - The key is sounding on a free voice, or dropped if both voices are busy
+  - In a track after the note track, sets _MIDI_MULTI_TRACK instead
+*/
+static void MidiNoteOn(u8 u8Key_)
+{
+  MidiVoiceType* psVoice;
+
+  if(Midi_bScanning)
+  {
+    G_u32MidiFlags |= _MIDI_MULTI_TRACK;
+    return;
+  }
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Midi_asVoices[i];
+    if(psVoice->u8Key == MIDI_NO_KEY)
+    {
+      if(Midi_u32Time > psVoice->u32EndTime)
+      {
+        MidiPushNote(psVoice, NOTE_INDEX_REST, Midi_u32Time - psVoice->u32EndTime);
+      }
+
+      psVoice->u8Key = u8Key_;
+      psVoice->u32StartTime = Midi_u32Time;
+      Midi_bNoteTrack = TRUE;
+      return;
+    }
+  }
+
+} /* end MidiNoteOn() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiNoteOff
+
+Description:
+Releases a key: now that its length is known the note is handed to the player.
+
+Requires:
+  - Midi_u32Time is the time of the event
+
+Promises:
+  - The voice playing the key (if any) is free and its note is in the voice FIFO
+*/
+static void MidiNoteOff(u8 u8Key_)
+{
+  MidiVoiceType* psVoice;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Midi_asVoices[i];
+    if(psVoice->u8Key == u8Key_)
+    {
+      psVoice->u32EndTime = psVoice->u32StartTime;
+      MidiPushNote(psVoice, MidiKeyToNote(u8Key_), Midi_u32Time - psVoice->u32StartTime);
+      psVoice->u8Key = MIDI_NO_KEY;
+      return;
+    }
+  }
+
+} /* end MidiNoteOff() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiPushNote
+
+Description:
+Adds a note or rest to a voice FIFO.  Notes are held (no articulation gap) since MIDI already has the silence between
+notes.  A note longer than MIDI_MAX_NOTE_TIME takes several entries: the parts that do not fit yet wait in the voice
+and go into the FIFO as the player frees slots.
+
+Requires:
+  - The FIFO has room and no part of an earlier note is waiting (MidiHasRoom())
+  - psVoice_->u32EndTime is the start of this note or rest
+
+Promises:
+  - A note of non-zero length is added in full and psVoice_->u32EndTime is moved to its end
+*/
+static void MidiPushNote(MidiVoiceType* psVoice_, u8 u8NoteIndex_, u32 u32Length_)
+{
+  psVoice_->u8PendingNote = u8NoteIndex_;
+  psVoice_->u32PendingTime = u32Length_;
+  psVoice_->u32EndTime += u32Length_;
+
+  MidiFlushVoice(psVoice_);
+
+} /* end MidiPushNote() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiFlushVoice
+
+Description:
+Moves the waiting part of a note into the voice FIFO, MIDI_MAX_NOTE_TIME at most per entry, while there is room.
+
+Requires:
+  -
+
+Promises:
+  - The FIFO is full or no part of a note is waiting
+*/
+static void MidiFlushVoice(MidiVoiceType* psVoice_)
+{
+  MusicNoteType* psNote;
+  u32 u32Length;
+
+  while( (psVoice_->u32PendingTime != 0) && (((psVoice_->u8Head + 1) % MIDI_NOTE_FIFO_SIZE) != psVoice_->u8Tail) )
+  {
+    u32Length = psVoice_->u32PendingTime;
+    if(u32Length > MIDI_MAX_NOTE_TIME)
+    {
+      u32Length = MIDI_MAX_NOTE_TIME;
+    }
+
+    psNote = &psVoice_->asFifo[psVoice_->u8Head];
+    psNote->u8NoteIndex = psVoice_->u8PendingNote;
+    psNote->u8Articulation = SONG_ARTICULATION_HT;
+    psNote->u16Length = (u16)u32Length;
+    psNote->u16Gap = 0;
+
+    psVoice_->u32PendingTime -= u32Length;
+    psVoice_->u8Head = (psVoice_->u8Head + 1) % MIDI_NOTE_FIFO_SIZE;
+  }
+
+} /* end MidiFlushVoice() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiHasRoom
+
+Description:
+Checks that the next byte can be parsed: one byte completes at most one event, which adds at most one note to each
+voice.  The waiting parts of split notes are moved into the FIFOs first.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if every voice FIFO has a free slot and no part of a note waiting
+*/
+static bool MidiHasRoom(void)
+{
+  MidiVoiceType* psVoice;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Midi_asVoices[i];
+    MidiFlushVoice(psVoice);
+    if( (psVoice->u32PendingTime != 0) || (((psVoice->u8Head + 1) % MIDI_NOTE_FIFO_SIZE) == psVoice->u8Tail) )
+    {
+      return(FALSE);
+    }
+  }
+
+  return(TRUE);
+
+} /* end MidiHasRoom() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MidiKeyToNote
+
+Description:
+Maps a MIDI key to the note table of music.h, moving keys outside C3 - B6 by whole octaves.
+
+Requires:
+  - u8Key_ is 0 - 127
+
+Promises:
+  - Returns a NOTE_INDEX_* value from NOTE_INDEX_C3 to NOTE_INDEX_B6
+*/
+static u8 MidiKeyToNote(u8 u8Key_)
+{
+  while(u8Key_ < MIDI_KEY_C3)
+  {
+    u8Key_ += MUSIC_OCTAVE;
+  }
+
+  while(u8Key_ > MIDI_KEY_B6)
+  {
+    u8Key_ -= MUSIC_OCTAVE;
+  }
+
+  return( (u8)(u8Key_ - MIDI_KEY_C3 + NOTE_INDEX_C3) );
+
+} /* end MidiKeyToNote() */
+
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
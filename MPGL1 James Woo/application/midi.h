@@ -0,0 +1,137 @@
+/**********************************************************************************************************************
+File: midi.h
+
+Description:
+Header file for midi.c: Standard MIDI File (SMF type 0 and 1) parser for the music player.
+
+***********************************************************************************************************************/
+
+#ifndef __MIDI_H
+#define __MIDI_H
+
+/* Sizes used by the type definitions */
+#define MIDI_NOTE_FIFO_SIZE       (u8)16               /* Parsed notes waiting for the player per voice (one slot left empty) */
+#define MIDI_TEMPO_MAP_SIZE       (u8)16               /* Tempo changes kept from the conductor track of a type 1 file */
+#define MIDI_EVENT_DATA_SIZE      (u8)3                /* Largest channel event or tempo meta data */
+
+/**********************************************************************************************************************
+Type Definitions
+**********************************************************************************************************************/
+typedef enum {MIDI_PARSE_HEADER, MIDI_PARSE_HEADER_LENGTH, MIDI_PARSE_HEADER_DATA, MIDI_PARSE_CHUNK,
+              MIDI_PARSE_CHUNK_LENGTH, MIDI_PARSE_DELTA, MIDI_PARSE_STATUS, MIDI_PARSE_DATA, MIDI_PARSE_META_TYPE,
+              MIDI_PARSE_LENGTH, MIDI_PARSE_META_DATA, MIDI_PARSE_SKIP, MIDI_PARSE_DONE} MidiParseStateType;
+
+typedef struct
+{
+  u32 u32Tick;                   /* Track tick of the tempo change */
+  u32 u32Tempo;                  /* New tempo in us per quarter note */
+} MidiTempoType;
+
+typedef struct
+{
+  MusicNoteType asFifo[MIDI_NOTE_FIFO_SIZE];   /* Notes and rests ready for the player */
+  u8 u8Head;                                   /* Next free slot (written by the parser) */
+  u8 u8Tail;                                   /* Next note for the player (written by MidiGetNote()) */
+  u8 u8Key;                                    /* MIDI key sounding on this voice, or MIDI_NO_KEY */
+  u8 u8PendingNote;                            /* Note index of the part of a long note not in the FIFO yet */
+  u32 u32PendingTime;                          /* Time in ms of that part (0 if none) */
+  u32 u32StartTime;                            /* Time in ms the sounding key started */
+  u32 u32EndTime;                              /* Time in ms the last note or rest given to this voice ends */
+} MidiVoiceType;
+
+
+/**********************************************************************************************************************
+Constants / Definitions
+**********************************************************************************************************************/
+/* G_u32MidiFlags */
+#define _MIDI_PLAYING             (u32)0x00000001      /* A MIDI file is being parsed for the player */
+#define _MIDI_DONE                (u32)0x00000002      /* Every note has been parsed; the FIFOs drain to the player */
+#define _MIDI_ERROR               (u32)0x00000004      /* The data is not a type 0 or 1 MIDI file */
+#define _MIDI_MULTI_TRACK         (u32)0x00000008      /* A type 1 file has notes in a second track (not supported) */
+
+#define MIDI_PARSE_BYTES_PER_CALL (u32)64              /* Max bytes MidiFeed() parses per call (bounds the time per loop) */
+#define MIDI_DEFAULT_TEMPO        (u32)500000          /* us per quarter note until a tempo event (120 bpm) */
+#define MIDI_MAX_NOTE_TIME        (u32)60000           /* Longest FIFO entry in ms: longer notes are split */
+#define MIDI_MS_Q16_SHIFT         (u8)16               /* Fraction bits of the ms per tick value */
+#define MIDI_MS_Q16_MASK          (u32)0x0000FFFF
+#define MIDI_VLQ_MAX_BYTES        (u8)4                /* Longest variable length quantity */
+
+#define MIDI_NO_KEY               (u8)0xFF
+#define MIDI_KEY_C3               (u8)48               /* MIDI key of NOTE_INDEX_C3 (middle C = C4 = 60) */
+#define MIDI_KEY_B6               (u8)95               /* MIDI key of NOTE_INDEX_B6 */
+#define MIDI_DRUM_CHANNEL         (u8)9                /* Channel 10 is percussion and is not played */
+
+/* Chunk IDs (big-endian) */
+#define MIDI_HEADER_ID            (u32)0x4D546864      /* "MThd" */
+#define MIDI_TRACK_ID             (u32)0x4D54726B      /* "MTrk" */
+#define MIDI_HEADER_SIZE          (u32)6               /* Format, track count and division */
+
+/* Header division */
+#define MIDI_DIVISION_SMPTE       (u16)0x8000          /* Set: SMPTE frames and ticks per frame instead of ticks per quarter */
+
+/* Status bytes */
+#define MIDI_STATUS_BIT           (u8)0x80
+#define MIDI_STATUS_TYPE_MASK     (u8)0xF0
+#define MIDI_STATUS_CHANNEL_MASK  (u8)0x0F
+#define MIDI_STATUS_NOTE_OFF      (u8)0x80
+#define MIDI_STATUS_NOTE_ON       (u8)0x90
+#define MIDI_STATUS_PROGRAM       (u8)0xC0             /* Program change: one data byte */
+#define MIDI_STATUS_PRESSURE      (u8)0xD0             /* Channel pressure: one data byte */
+#define MIDI_STATUS_SYSTEM        (u8)0xF0             /* System messages: no running status */
+#define MIDI_STATUS_SYSEX         (u8)0xF0
+#define MIDI_STATUS_SYSEX_ESCAPE  (u8)0xF7
+#define MIDI_STATUS_META          (u8)0xFF
+#define MIDI_DATA_MASK            (u8)0x7F
+
+/* Meta events */
+#define MIDI_META_END_OF_TRACK    (u8)0x2F
+#define MIDI_META_TEMPO           (u8)0x51
+#define MIDI_META_TEMPO_SIZE      (u32)3
+
+
+/**********************************************************************************************************************
+Function Declarations
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+bool MidiStart(void);
+u32 MidiFeed(const u8* pu8Data_, u32 u32Size_);
+void MidiEndOfData(void);
+MusicSourceStatusType MidiGetNote(u8 u8Voice_, MusicNoteType* psNote_);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected functions                                                                                                */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static void MidiParseByte(u8 u8Byte_);
+static void MidiParseStatus(u8 u8Byte_);
+static void MidiChannelEvent(void);
+static void MidiMetaEvent(void);
+static void MidiStartTrack(void);
+static void MidiEndTrack(void);
+static void MidiFinish(void);
+static void MidiReleaseKeys(void);
+static void MidiSetTempo(u32 u32Tempo_);
+static void MidiAdvance(u32 u32Ticks_);
+static void MidiAddTime(u32 u32Ticks_);
+static void MidiNoteOn(u8 u8Key_);
+static void MidiNoteOff(u8 u8Key_);
+static void MidiPushNote(MidiVoiceType* psVoice_, u8 u8NoteIndex_, u32 u32Length_);
+static void MidiFlushVoice(MidiVoiceType* psVoice_);
+static bool MidiHasRoom(void);
+static u8 MidiKeyToNote(u8 u8Key_);
+
+
+#endif /* __MIDI_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
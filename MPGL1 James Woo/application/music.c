@@ -0,0 +1,1326 @@
+/**********************************************************************************************************************
+File: music.c
+
+Description:
+Non-blocking music player.  A song is one or two voices, each a const table of packed notes (see SONG_NOTE() in
+music.h) that lives in flash and is decoded one note at a time.  Voice 0 plays on buzzer 1 (PWM channel 0) and
+voice 1 on buzzer 2 (PWM channel 1).  The music state machine converts notes to timer ticks and pre-loads them into
+a small queue per voice.  Both voices share one time base: every TC0 compare lands on the next note boundary of
+either voice, so the two voices can never drift apart and note timing does not depend on the main loop.
+Each note has an articulation (RT/ST/HT) that ends it with a short silent gap, and a volume envelope that steps the
+PWM duty up at the start of a note and down before its gap.
+Tempo and key are player settings applied as each note starts, so they can be changed while a song plays: note
+lengths are scaled with precomputed fixed-point tempo tables and notes are transposed through a remap table.
+The LEDs display a bar graph proportional to the pitch of the current voice 0 note.
+Songs that do not fit in flash are played from a note source callback instead of a table (see MusicStartSource()).
+
+------------------------------------------------------------------------------------------------------------------------
+API:
+
+Public:
+bool MusicStart(const SongType* psSong_)
+Start playing a song from the beginning at the current tempo and transpose.  Any song already playing is stopped.
+
+bool MusicStartSource(MusicNoteSourceType pfNoteSource_)
+Start playing a song whose notes are supplied one at a time by pfNoteSource_ (e.g. streamed from the SD card).
+
+void MusicStop(void)
+Stop the current song and silence the buzzers.
+
+void MusicPause(void)
+Pause the current song.  The remaining time of the current notes is saved.
+
+void MusicResume(void)
+Resume a paused song.
+
+bool MusicIsPlaying(void)
+Returns TRUE if a song is loaded (playing or paused).
+
+void MusicDecodeNote(u16 u16PackedNote_, MusicNoteType* psNote_)
+Unpacks one SONG_NOTE() value into note index, articulation, length and gap in ms.
+
+u16 MusicNoteFrequency(u8 u8NoteIndex_)
+Returns the frequency in Hz of a NOTE_INDEX_* value.
+
+bool MusicSetTempo(u8 u8TempoStep_)
+Selects one of MUSIC_TEMPO_STEPS tempos (MUSIC_TEMPO_NORMAL = 100%).  Takes effect from the next note.
+
+u8 MusicGetTempo(void)
+u16 MusicGetTempoPercent(void)
+Return the current tempo step, or the current tempo in percent of the nominal note lengths.
+
+bool MusicSetTranspose(s8 s8Semitones_)
+Transposes every note by up to +/- MUSIC_TRANSPOSE_MAX semitones.  Takes effect from the next note.
+
+s8 MusicGetTranspose(void)
+Returns the current transpose in semitones.
+
+Protected:
+void MusicInitialize(void)
+Initializes the music player state machine.
+
+**********************************************************************************************************************/
+
+#include "configuration.h"
+#include "music.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/* New variables */
+volatile fnCode_type G_MusicStateMachine;              /* The state machine function pointer */
+volatile u32 G_u32MusicFlags;                          /* Global state flags */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile u32 G_u32SystemFlags;                  /* From main.c */
+extern volatile u32 G_u32ApplicationFlags;             /* From main.c */
+
+extern volatile u32 G_u32SystemTime1ms;                /* From board-specific source file */
+extern volatile u32 G_u32SystemTime1s;                 /* From board-specific source file */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Music_" and be declared as static.
+***********************************************************************************************************************/
+static const SongType* Music_psSong;                   /* Song being played (NULL for a note source) */
+static MusicNoteSourceType Music_pfNoteSource;         /* Note source of the song being played (NULL for a table) */
+static MusicVoiceType Music_asVoices[MUSIC_VOICES];    /* Queues and sequencer state for each voice */
+
+static volatile bool Music_bSequencerRunning;          /* TRUE while the sequencer timer is counting */
+static volatile u16 Music_u16Period;                   /* Ticks loaded in RC for the current timer period */
+
+static u32 Music_u32PauseTime;                         /* System time the song was paused */
+
+static volatile u8 Music_u8TempoStep;                  /* Index into the tempo tables (read by the ISR) */
+static s8 Music_s8Transpose;                           /* Semitones added to every note */
+static u8 Music_au8TransposeMap[NOTE_INDEX_COUNT];     /* Played note index for each song note index */
+
+static u16 Music_u16NotesDisplayed;                    /* Number of voice 0 notes shown on the LEDs */
+static int Music_iLedMax;                              /* Highest LED lit for the current note */
+static int Music_iOldLedMax;                           /* Highest LED lit for the previous note */
+static u16 Music_u16OldFrequency;                      /* Frequency of the previous note shown on the LEDs */
+
+static u8 Music_au8DoneMsg[] = "LED functions ready\n\r";
+static u8* Music_pu8Parser;                            /* Next character of Music_au8DoneMsg to send */
+
+/* PWM channel for each voice */
+static const u32 Music_au32VoiceBuzzer[MUSIC_VOICES] = {AT91C_PWMC_CHID0, AT91C_PWMC_CHID1};
+
+/* Note frequencies in Hz indexed by NOTE_INDEX_* */
+static const u16 Music_au16NoteFrequency[NOTE_INDEX_COUNT] =
+{
+  NONE,
+  NOTE_C3, NOTE_C3_SHARP, NOTE_D3, NOTE_D3_SHARP, NOTE_E3, NOTE_F3, NOTE_F3_SHARP,
+  NOTE_G3, NOTE_G3_SHARP, NOTE_A3, NOTE_A3_SHARP, NOTE_B3,
+  NOTE_C4, NOTE_C4_SHARP, NOTE_D4, NOTE_D4_SHARP, NOTE_E4, NOTE_F4, NOTE_F4_SHARP,
+  NOTE_G4, NOTE_G4_SHARP, NOTE_A4, NOTE_A4_SHARP, NOTE_B4,
+  NOTE_C5, NOTE_C5_SHARP, NOTE_D5, NOTE_D5_SHARP, NOTE_E5, NOTE_F5, NOTE_F5_SHARP,
+  NOTE_G5, NOTE_G5_SHARP, NOTE_A5, NOTE_A5_SHARP, NOTE_B5,
+  NOTE_C6, NOTE_C6_SHARP, NOTE_D6, NOTE_D6_SHARP, NOTE_E6, NOTE_F6, NOTE_F6_SHARP,
+  NOTE_G6, NOTE_G6_SHARP, NOTE_A6, NOTE_A6_SHARP, NOTE_B6
+};
+
+/* Note lengths in ms indexed by SONG_LENGTH_* */
+static const u16 Music_au16NoteLength[SONG_LENGTH_CODES] =
+{
+  SN, EN, EN + SN, QN, QN + EN, HN, HN + QN, FN
+};
+
+/* Articulation gaps in ms indexed by [SONG_ARTICULATION_*][SONG_LENGTH_*] */
+static const u16 Music_au16ArticulationGap[SONG_ARTICULATION_CODES][SONG_LENGTH_CODES] =
+{
+  {MUSIC_GAP(RT, SN), MUSIC_GAP(RT, EN), MUSIC_GAP(RT, EN + SN), MUSIC_GAP(RT, QN),
+   MUSIC_GAP(RT, QN + EN), MUSIC_GAP(RT, HN), MUSIC_GAP(RT, HN + QN), MUSIC_GAP(RT, FN)},
+  {MUSIC_GAP(ST, SN), MUSIC_GAP(ST, EN), MUSIC_GAP(ST, EN + SN), MUSIC_GAP(ST, QN),
+   MUSIC_GAP(ST, QN + EN), MUSIC_GAP(ST, HN), MUSIC_GAP(ST, HN + QN), MUSIC_GAP(ST, FN)},
+  {HT, HT, HT, HT, HT, HT, HT, HT}
+};
+
+/* Tempo of each step in percent of the nominal note lengths */
+static const u16 Music_au16TempoPercent[MUSIC_TEMPO_STEPS] = {50, 63, 75, 88, 100, 125, 150, 175, 200, 250, 300};
+
+/* Q8 real ms per nominal ms for each tempo step */
+static const u16 Music_au16TempoTime[MUSIC_TEMPO_STEPS] =
+{
+  MUSIC_TEMPO_TIME(50),  MUSIC_TEMPO_TIME(63),  MUSIC_TEMPO_TIME(75),  MUSIC_TEMPO_TIME(88),
+  MUSIC_TEMPO_TIME(100), MUSIC_TEMPO_TIME(125), MUSIC_TEMPO_TIME(150), MUSIC_TEMPO_TIME(175),
+  MUSIC_TEMPO_TIME(200), MUSIC_TEMPO_TIME(250), MUSIC_TEMPO_TIME(300)
+};
+
+/* Q8 sequencer ticks per nominal ms for each tempo step */
+static const u32 Music_au32TempoTicks[MUSIC_TEMPO_STEPS] =
+{
+  MUSIC_TEMPO_TICKS(50),  MUSIC_TEMPO_TICKS(63),  MUSIC_TEMPO_TICKS(75),  MUSIC_TEMPO_TICKS(88),
+  MUSIC_TEMPO_TICKS(100), MUSIC_TEMPO_TICKS(125), MUSIC_TEMPO_TICKS(150), MUSIC_TEMPO_TICKS(175),
+  MUSIC_TEMPO_TICKS(200), MUSIC_TEMPO_TICKS(250), MUSIC_TEMPO_TICKS(300)
+};
+
+/* PWM duty shift for each envelope level */
+static const u8 Music_au8EnvelopeShift[MUSIC_ENVELOPE_LEVEL_MAX + 1] = {5, 4, 3, 2, 1};
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicStart
+
+Description:
+Loads a song and starts playing it from the first note at the current tempo and transpose.  If a song is already
+playing it is stopped first.
+
+Requires:
+  - psSong_ points to a song that stays valid for the whole time it is played
+
+Promises:
+  - Returns TRUE and starts the song if voice 0 has at least one note
+  - Returns FALSE if voice 0 is empty
+*/
+bool MusicStart(const SongType* psSong_)
+{
+  if( (psSong_ == NULL) || (psSong_->asVoices[0].u16NoteCount == 0) )
+  {
+    return(FALSE);
+  }
+
+  MusicStop();
+
+  Music_psSong = psSong_;
+  Music_pfNoteSource = NULL;
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    Music_asVoices[i].psVoice = &psSong_->asVoices[i];
+  }
+
+  MusicBegin();
+
+  return(TRUE);
+
+} /* end MusicStart() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicStartSource
+
+Description:
+Starts playing a song whose notes come from a note source instead of a table in flash.  Notes are requested from
+the main loop only as queue space frees up, so the source can produce them from a small buffer (e.g. blocks read
+from the SD card).  If the source has nothing ready when a note is due, the voice rests and keeps its time: the late
+note is cut short, or skipped if it is already over.  The song ends when every voice has returned MUSIC_SOURCE_LAST or
+MUSIC_SOURCE_END.  If a song is already playing it is stopped first.
+
+Requires:
+  - pfNoteSource_ follows MusicNoteSourceType and stays valid for the whole time the song is played
+
+Promises:
+  - Returns TRUE and starts the song
+  - Returns FALSE if pfNoteSource_ is NULL
+*/
+bool MusicStartSource(MusicNoteSourceType pfNoteSource_)
+{
+  if(pfNoteSource_ == NULL)
+  {
+    return(FALSE);
+  }
+
+  MusicStop();
+
+  Music_psSong = NULL;
+  Music_pfNoteSource = pfNoteSource_;
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    Music_asVoices[i].psVoice = NULL;
+  }
+
+  MusicBegin();
+
+  return(TRUE);
+
+} /* end MusicStartSource() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicStop
+
+Description:
+Stops the current song immediately.
+
+Requires:
+  -
+
+Promises:
+  - Sequencer timer is stopped, the note queues are empty, the buzzers and note LEDs are off, and the player is idle
+*/
+void MusicStop(void)
+{
+  MusicVoiceType* psVoice;
+
+  TimerSequencerStop(MUSIC_TIMER);
+  Music_bSequencerRunning = FALSE;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Music_asVoices[i];
+    psVoice->u16NoteIndex = 0;
+    psVoice->bAllQueued = FALSE;
+    psVoice->u8QueueHead = 0;
+    psVoice->u8QueueTail = 0;
+    psVoice->u32TicksRemaining = 0;
+    psVoice->u16NotesStarted = 0;
+    psVoice->u32GapTicks = 0;
+    psVoice->u32LateTicks = 0;
+    psVoice->u16EnvelopeNotes = 0;
+    psVoice->bSounding = FALSE;
+    PWMAudioOff(Music_au32VoiceBuzzer[i]);
+  }
+
+  if(G_u32MusicFlags & _MUSIC_PLAYING)
+  {
+    MusicLedsOff();
+  }
+
+  G_u32MusicFlags &= ~(_MUSIC_PLAYING | _MUSIC_PAUSED);
+  G_MusicStateMachine = MusicSM_Idle;
+
+} /* end MusicStop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicPause
+
+Description:
+Pauses the current song.  The time already spent in the current timer period is taken off every sounding note so
+each note finishes its full length when the song is resumed.
+
+Requires:
+  -
+
+Promises:
+  - If a song is playing, the sequencer is stopped, the buzzers are silenced and the player waits in MusicSM_Paused
+*/
+void MusicPause(void)
+{
+  u32 u32Elapsed;
+  u16 u16Left;
+  MusicVoiceType* psVoice;
+
+  if( !(G_u32MusicFlags & _MUSIC_PLAYING) || (G_u32MusicFlags & _MUSIC_PAUSED) )
+  {
+    return;
+  }
+
+  if(Music_bSequencerRunning)
+  {
+    /* Stop the timer before reading the period: until it stops, the ISR can load the next one */
+    u16Left = TimerSequencerStop(MUSIC_TIMER);
+    u32Elapsed = Music_u16Period - u16Left;
+    Music_bSequencerRunning = FALSE;
+
+    for(u8 i = 0; i < MUSIC_VOICES; i++)
+    {
+      psVoice = &Music_asVoices[i];
+      if(psVoice->bSounding)
+      {
+        if(psVoice->u32TicksRemaining > u32Elapsed)
+        {
+          psVoice->u32TicksRemaining -= u32Elapsed;
+        }
+        else
+        {
+          psVoice->u32TicksRemaining = 0;
+        }
+      }
+    }
+  }
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    PWMAudioOff(Music_au32VoiceBuzzer[i]);
+  }
+
+  Music_u32PauseTime = G_u32SystemTime1ms;
+  G_u32MusicFlags |= _MUSIC_PAUSED;
+  G_MusicStateMachine = MusicSM_Paused;
+
+} /* end MusicPause() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicResume
+
+Description:
+Resumes a paused song with the remaining ticks of the notes that were interrupted.
+
+Requires:
+  -
+
+Promises:
+  - If the player was paused, the current notes sound again and the sequencer is restarted
+*/
+void MusicResume(void)
+{
+  MusicVoiceType* psVoice;
+
+  if( !(G_u32MusicFlags & _MUSIC_PAUSED) )
+  {
+    return;
+  }
+
+  G_u32MusicFlags &= ~_MUSIC_PAUSED;
+  G_MusicStateMachine = MusicSM_Playing;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Music_asVoices[i];
+    if( psVoice->bSounding && (psVoice->u8CurrentNote != NOTE_INDEX_REST) )
+    {
+      PWMAudioOn(Music_au32VoiceBuzzer[i]);
+    }
+
+    /* The envelope does not count the time spent paused */
+    psVoice->u32EnvelopeStart += G_u32SystemTime1ms - Music_u32PauseTime;
+  }
+
+  MusicSequencerStart();
+
+} /* end MusicResume() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicIsPlaying
+
+Description:
+Reports if a song is loaded.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if a song is playing or paused
+*/
+bool MusicIsPlaying(void)
+{
+  return( (bool)((G_u32MusicFlags & _MUSIC_PLAYING) != 0) );
+
+} /* end MusicIsPlaying() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicDecodeNote
+
+Description:
+Unpacks a note stored with SONG_NOTE().
+
+Requires:
+  - u16PackedNote_ was built with SONG_NOTE()
+  - psNote_ points to the structure to fill
+
+Promises:
+  - psNote_ holds the note index, articulation code, note length and articulation gap in ms
+  - An out of range note index decodes as a rest
+*/
+void MusicDecodeNote(u16 u16PackedNote_, MusicNoteType* psNote_)
+{
+  u8 u8LengthCode;
+
+  psNote_->u8NoteIndex = (u8)(u16PackedNote_ & SONG_NOTE_INDEX_MASK);
+  if(psNote_->u8NoteIndex >= NOTE_INDEX_COUNT)
+  {
+    psNote_->u8NoteIndex = NOTE_INDEX_REST;
+  }
+
+  u8LengthCode = (u8)((u16PackedNote_ >> SONG_NOTE_LENGTH_SHIFT) & SONG_NOTE_LENGTH_MASK);
+  psNote_->u16Length = Music_au16NoteLength[u8LengthCode];
+
+  psNote_->u8Articulation = (u8)((u16PackedNote_ >> SONG_NOTE_ARTICULATION_SHIFT) & SONG_NOTE_ARTICULATION_MASK);
+  if(psNote_->u8Articulation >= SONG_ARTICULATION_CODES)
+  {
+    psNote_->u8Articulation = SONG_ARTICULATION_HT;
+  }
+
+  psNote_->u16Gap = Music_au16ArticulationGap[psNote_->u8Articulation][u8LengthCode];
+
+} /* end MusicDecodeNote() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicNoteFrequency
+
+Description:
+Looks up the frequency of a note index.
+
+Requires:
+  -
+
+Promises:
+  - Returns the frequency in Hz, or NONE for a rest or an invalid index
+*/
+u16 MusicNoteFrequency(u8 u8NoteIndex_)
+{
+  if(u8NoteIndex_ >= NOTE_INDEX_COUNT)
+  {
+    return(NONE);
+  }
+
+  return(Music_au16NoteFrequency[u8NoteIndex_]);
+
+} /* end MusicNoteFrequency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicSetTempo
+
+Description:
+Selects the tempo.  Notes already sounding keep their length; every note started afterwards is scaled to the new
+tempo, so the tempo can be changed while a song is playing.
+
+Requires:
+  - u8TempoStep_ is a tempo step from 0 to MUSIC_TEMPO_STEPS - 1 (MUSIC_TEMPO_NORMAL is 100%)
+
+Promises:
+  - Returns TRUE and selects the tempo if u8TempoStep_ is valid
+  - Returns FALSE and leaves the tempo unchanged otherwise
+*/
+bool MusicSetTempo(u8 u8TempoStep_)
+{
+  if(u8TempoStep_ >= MUSIC_TEMPO_STEPS)
+  {
+    return(FALSE);
+  }
+
+  /* A single byte write: the sequencer sees either the old or the new step */
+  Music_u8TempoStep = u8TempoStep_;
+
+  return(TRUE);
+
+} /* end MusicSetTempo() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicGetTempo
+
+Description:
+Reports the tempo step.
+
+Requires:
+  -
+
+Promises:
+  - Returns the current tempo step
+*/
+u8 MusicGetTempo(void)
+{
+  return(Music_u8TempoStep);
+
+} /* end MusicGetTempo() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicGetTempoPercent
+
+Description:
+Reports the tempo as a percentage of the nominal note lengths.
+
+Requires:
+  -
+
+Promises:
+  - Returns the current tempo in percent (100 = nominal, 200 = twice as fast)
+*/
+u16 MusicGetTempoPercent(void)
+{
+  return(Music_au16TempoPercent[Music_u8TempoStep]);
+
+} /* end MusicGetTempoPercent() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicSetTranspose
+
+Description:
+Transposes the music by a number of semitones.  The note remap table is rebuilt here so the sequencer only does a
+lookup.  A note that would leave the note table is moved by whole octaves until it fits.
+
+Requires:
+  - s8Semitones_ is from -MUSIC_TRANSPOSE_MAX to MUSIC_TRANSPOSE_MAX
+
+Promises:
+  - Returns TRUE and applies the transpose from the next note started if s8Semitones_ is in range
+  - Returns FALSE and leaves the transpose unchanged otherwise
+*/
+bool MusicSetTranspose(s8 s8Semitones_)
+{
+  s16 s16Note;
+
+  if( (s8Semitones_ > MUSIC_TRANSPOSE_MAX) || (s8Semitones_ < -MUSIC_TRANSPOSE_MAX) )
+  {
+    return(FALSE);
+  }
+
+  /* The sequencer must not read a half-built table */
+  NVIC_DisableIRQ(MUSIC_TIMER_IRQ);
+
+  Music_s8Transpose = s8Semitones_;
+  Music_au8TransposeMap[NOTE_INDEX_REST] = NOTE_INDEX_REST;
+  for(u8 i = NOTE_INDEX_REST + 1; i < NOTE_INDEX_COUNT; i++)
+  {
+    s16Note = (s16)i + s8Semitones_;
+    while(s16Note < NOTE_INDEX_C3)
+    {
+      s16Note += MUSIC_OCTAVE;
+    }
+
+    while(s16Note >= NOTE_INDEX_COUNT)
+    {
+      s16Note -= MUSIC_OCTAVE;
+    }
+
+    Music_au8TransposeMap[i] = (u8)s16Note;
+  }
+
+  NVIC_EnableIRQ(MUSIC_TIMER_IRQ);
+
+  return(TRUE);
+
+} /* end MusicSetTranspose() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MusicGetTranspose
+
+Description:
+Reports the transpose.
+
+Requires:
+  -
+
+Promises:
+  - Returns the current transpose in semitones
+*/
+s8 MusicGetTranspose(void)
+{
+  return(Music_s8Transpose);
+
+} /* end MusicGetTranspose() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected functions                                                                                                */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicInitialize
+
+Description:
+Initializes the State Machine, its variables and the sequencer timer.
+
+Requires:
+  - PWMSetupAudio() has configured the buzzer channels
+  - InterruptSetup() has already run so the timer interrupt is not disabled again
+
+Promises:
+  - Player is idle with no song loaded, at MUSIC_TEMPO_DEFAULT and not transposed
+  - MUSIC_TIMER is configured and stopped with its interrupt enabled
+*/
+void MusicInitialize(void)
+{
+  Music_psSong = NULL;
+  Music_pfNoteSource = NULL;
+  Music_bSequencerRunning = FALSE;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    Music_asVoices[i].u8QueueHead = 0;
+    Music_asVoices[i].u8QueueTail = 0;
+    Music_asVoices[i].bSounding = FALSE;
+  }
+
+  TimerSequencerSetup(MUSIC_TIMER);
+
+  Music_u8TempoStep = MUSIC_TEMPO_DEFAULT;
+  MusicSetTranspose(0);
+
+  G_u32MusicFlags = 0;
+  G_MusicStateMachine = MusicSM_Idle;
+
+} /* end MusicInitialize() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Interrupt Service Routine: TC0_IrqHandler
+
+Description:
+Note sequencer.  Every RC compare is the end of Music_u16Period ticks for all voices.  Each voice whose note is done
+silences the buzzer for the note's articulation gap (if any), then takes the next note from its queue and the buzzer
+is reprogrammed.  The note is transposed and scaled to the current tempo as it starts.  RC is then loaded with the
+time to the nearest note boundary of any voice (split into slices if longer than the 16-bit timer can count).  Both
+voices count from the same timer, so they stay aligned to the tick no matter how busy the main loop is.
+
+The voices round their note lengths to ticks separately, so boundaries that should coincide can land a few ticks
+apart.  Boundaries that close are merged (see MUSIC_MERGE_TICKS): a period shorter than the interrupt latency would
+make the handler load RC below the count, and the counter would run a whole 16-bit wrap (175 ms) before the next
+compare.
+
+A voice whose next note has not been queued yet (a note source that could not keep up) is starved, not finished: it
+keeps its time as an implicit rest, looking again every MUSIC_STARVED_TICKS, and counts the ticks it is late.  Those
+are cut from the notes it plays next (notes that are over by then are skipped), so a starved voice comes back in step
+with the other voice instead of restarting its song at the other voice's next boundary.
+
+Requires:
+  - Only the RC compare interrupt is enabled
+  - Each voice queue is only written by the main loop between its head and tail
+  - The handler starts less than MUSIC_MERGE_TICKS after the compare
+
+Promises:
+  - Voices with a finished note start their next queued note, shortened by the ticks the voice is late
+  - A voice with an empty queue rests for MUSIC_STARVED_TICKS if it has notes to come, or goes silent
+  - RC is loaded with the ticks to the next note boundary
+  - If no voice is sounding, the timer is stopped
+*/
+void TC0_IrqHandler(void)
+{
+  MusicVoiceType* psVoice;
+  MusicQueuedNoteType* psNote;
+  u32 u32Period = TC_SEQUENCER_MAX_TICKS;
+  u32 u32Early;
+  u32 u32Sound;
+  u32 u32Gap;
+  bool bSounding = FALSE;
+  u8 u8TempoStep = Music_u8TempoStep;
+  u8 u8Note;
+
+  if( !(AT91C_BASE_TC0->TC_SR & AT91C_TC_CPCS) )
+  {
+    return;
+  }
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Music_asVoices[i];
+
+    /* Count the period that just ended.  A boundary due within MUSIC_MERGE_TICKS is taken now and the ticks it is
+    early are added to what the voice plays next, so its later boundaries do not move. */
+    u32Early = 0;
+    if(psVoice->u32TicksRemaining > (Music_u16Period + MUSIC_MERGE_TICKS))
+    {
+      psVoice->u32TicksRemaining -= Music_u16Period;
+    }
+    else
+    {
+      if(psVoice->u32TicksRemaining > Music_u16Period)
+      {
+        u32Early = psVoice->u32TicksRemaining - Music_u16Period;
+      }
+      psVoice->u32TicksRemaining = 0;
+    }
+
+    /* End of the sounding part of a note: play its articulation gap */
+    if( (psVoice->u32TicksRemaining == 0) && (psVoice->u32GapTicks != 0) )
+    {
+      PWMAudioOff(Music_au32VoiceBuzzer[i]);
+      psVoice->u8CurrentNote = NOTE_INDEX_REST;
+      psVoice->u32TicksRemaining = psVoice->u32GapTicks + u32Early;
+      psVoice->u32GapTicks = 0;
+      u32Early = 0;
+    }
+
+    /* Note boundary: start the next note.  The early ticks of a merged boundary first pay off late ticks. */
+    if(psVoice->u32TicksRemaining == 0)
+    {
+      if(psVoice->u32LateTicks > u32Early)
+      {
+        psVoice->u32LateTicks -= u32Early;
+        u32Early = 0;
+      }
+      else
+      {
+        u32Early -= psVoice->u32LateTicks;
+        psVoice->u32LateTicks = 0;
+      }
+    }
+
+    while( (psVoice->u32TicksRemaining == 0) && (psVoice->u8QueueTail != psVoice->u8QueueHead) )
+    {
+      psNote = &psVoice->asQueue[psVoice->u8QueueTail];
+      u8Note = Music_au8TransposeMap[psNote->u8NoteIndex];
+      u32Sound = MusicTempoTicks(psNote->u16SoundTime, u8TempoStep);
+      if(u32Sound == 0)
+      {
+        u32Sound = 1;
+      }
+      u32Gap = MusicTempoTicks(psNote->u16GapTime, u8TempoStep);
+
+      /* A late voice skips a note that is already over, and starts a note in its gap silently */
+      if(psVoice->u32LateTicks >= (u32Sound + u32Gap))
+      {
+        psVoice->u32LateTicks -= u32Sound + u32Gap;
+      }
+      else if(psVoice->u32LateTicks >= u32Sound)
+      {
+        PWMAudioOff(Music_au32VoiceBuzzer[i]);
+        psVoice->u8CurrentNote = NOTE_INDEX_REST;
+        psVoice->u32TicksRemaining = (u32Sound + u32Gap - psVoice->u32LateTicks) + u32Early;
+        psVoice->u32GapTicks = 0;
+        psVoice->u32LateTicks = 0;
+        psVoice->bSounding = TRUE;
+      }
+      else
+      {
+        if(u8Note != NOTE_INDEX_REST)
+        {
+          /* Start quiet; the envelope brings the level up from the main loop */
+          PWMAudioSetNote(Music_au32VoiceBuzzer[i], u8Note);
+          PWMAudioSetNoteDuty(Music_au32VoiceBuzzer[i], u8Note, Music_au8EnvelopeShift[0]);
+          PWMAudioOn(Music_au32VoiceBuzzer[i]);
+        }
+        else
+        {
+          PWMAudioOff(Music_au32VoiceBuzzer[i]);
+        }
+
+        psVoice->u8CurrentNote = u8Note;
+        psVoice->u8StartedNote = u8Note;
+        psVoice->u32TicksRemaining = (u32Sound - psVoice->u32LateTicks) + u32Early;
+        psVoice->u32GapTicks = u32Gap;
+        psVoice->u32SoundTime = ((u32)psNote->u16SoundTime * Music_au16TempoTime[u8TempoStep]) >>
+                                MUSIC_TEMPO_Q8_SHIFT;
+        if(psVoice->u32LateTicks != 0)
+        {
+          psVoice->u32SoundTime = (u32Sound - psVoice->u32LateTicks) / TC_SEQUENCER_TICKS_PER_MS;
+        }
+        psVoice->bRelease = (bool)(u32Gap != 0);
+        psVoice->u32LateTicks = 0;
+        psVoice->u16NotesStarted++;
+        psVoice->bSounding = TRUE;
+      }
+
+      /* Release the slot */
+      psVoice->u8QueueTail = (psVoice->u8QueueTail + 1) % MUSIC_NOTE_QUEUE_SIZE;
+    }
+
+    /* Nothing queued: rest until the next note arrives if the voice has more to come, else go silent */
+    if(psVoice->u32TicksRemaining == 0)
+    {
+      if(!psVoice->bAllQueued)
+      {
+        PWMAudioOff(Music_au32VoiceBuzzer[i]);
+        psVoice->u8CurrentNote = NOTE_INDEX_REST;
+        psVoice->u32TicksRemaining = MUSIC_STARVED_TICKS + u32Early;
+        psVoice->u32LateTicks += MUSIC_STARVED_TICKS;
+        psVoice->bSounding = TRUE;
+      }
+      else if(psVoice->bSounding)
+      {
+        PWMAudioOff(Music_au32VoiceBuzzer[i]);
+        psVoice->bSounding = FALSE;
+      }
+    }
+
+    /* Track the nearest note boundary */
+    if(psVoice->bSounding)
+    {
+      bSounding = TRUE;
+      if(psVoice->u32TicksRemaining < u32Period)
+      {
+        u32Period = psVoice->u32TicksRemaining;
+      }
+    }
+  }
+
+  if(!bSounding)
+  {
+    TimerSequencerStop(MUSIC_TIMER);
+    Music_bSequencerRunning = FALSE;
+    return;
+  }
+
+  Music_u16Period = (u16)u32Period;
+  TimerSequencerSetPeriod(MUSIC_TIMER, Music_u16Period);
+
+} /* end TC0_IrqHandler() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicBegin
+
+Description:
+Starts the song just loaded by MusicStart() or MusicStartSource().
+
+Requires:
+  - The player is stopped and each voice has its psVoice set (NULL for a note source)
+
+Promises:
+  - The buzzer PWM trace is cleared when PWM_AUDIO_TRACE is defined
+  - The player is in MusicSM_Playing with the note queues pre-loaded and the sequencer started
+*/
+static void MusicBegin(void)
+{
+#ifdef PWM_AUDIO_TRACE
+  /* Each song gets its own trace */
+  PWMAudioTraceClear();
+#endif /* PWM_AUDIO_TRACE */
+
+  Music_u16NotesDisplayed = 0;
+  Music_iLedMax = 0;
+  Music_iOldLedMax = 0;
+  Music_u16OldFrequency = NONE;
+
+  G_u32MusicFlags |= _MUSIC_PLAYING;
+  G_MusicStateMachine = MusicSM_Playing;
+
+  /* Pre-load the queues and start the sequencer right away */
+  MusicQueueNotes();
+
+} /* end MusicBegin() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicNextNote
+
+Description:
+Gets the next packed note of a voice from the song table or from the note source.
+
+Requires:
+  - u8Voice_ is a voice that has not returned its last note yet
+
+Promises:
+  - Returns the status of the voice as in MusicNoteSourceType, with the note in *psNote_ if there is one
+*/
+static MusicSourceStatusType MusicNextNote(u8 u8Voice_, MusicNoteType* psNote_)
+{
+  const SongVoiceType* psSongVoice = Music_asVoices[u8Voice_].psVoice;
+  u16 u16Index = Music_asVoices[u8Voice_].u16NoteIndex;
+
+  if(Music_pfNoteSource != NULL)
+  {
+    return( Music_pfNoteSource(u8Voice_, psNote_) );
+  }
+
+  if(u16Index >= psSongVoice->u16NoteCount)
+  {
+    return(MUSIC_SOURCE_END);
+  }
+
+  MusicDecodeNote(psSongVoice->pu16Notes[u16Index], psNote_);
+  if(u16Index == (psSongVoice->u16NoteCount - 1))
+  {
+    return(MUSIC_SOURCE_LAST);
+  }
+
+  return(MUSIC_SOURCE_NOTE);
+
+} /* end MusicNextNote() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicQueueNotes
+
+Description:
+Moves as many notes from each voice as will fit into the sequencer queues.  Each note is split into its nominal
+sounding time and articulation gap; the sequencer applies the tempo when the note starts.  The last note of each voice
+is extended by MUSIC_FINAL_HOLD_TIME (scaled with the tempo like the rest of the note).  If the sequencer is not
+running (start of a song, or the queues ran dry) it is started.
+
+Requires:
+  - Music_psSong or Music_pfNoteSource is loaded
+
+Promises:
+  - Each voice queue holds up to MUSIC_NOTE_QUEUE_SIZE - 1 notes
+  - Each voice u16NoteIndex is the number of notes queued so far, and bAllQueued is set after its last note
+*/
+static void MusicQueueNotes(void)
+{
+  MusicVoiceType* psVoice;
+  MusicQueuedNoteType* psNote;
+  MusicNoteType sNote;
+  MusicSourceStatusType eStatus;
+  u8 u8NextHead;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Music_asVoices[i];
+
+    while(!psVoice->bAllQueued)
+    {
+      u8NextHead = (psVoice->u8QueueHead + 1) % MUSIC_NOTE_QUEUE_SIZE;
+      if(u8NextHead == psVoice->u8QueueTail)
+      {
+        break;
+      }
+
+      eStatus = MusicNextNote(i, &sNote);
+      if(eStatus == MUSIC_SOURCE_WAIT)
+      {
+        break;
+      }
+
+      if(eStatus == MUSIC_SOURCE_END)
+      {
+        psVoice->bAllQueued = TRUE;
+        break;
+      }
+
+      /* A rest has no articulation, and a note source could hand over any index */
+      if(sNote.u8NoteIndex >= NOTE_INDEX_COUNT)
+      {
+        sNote.u8NoteIndex = NOTE_INDEX_REST;
+      }
+
+      if(sNote.u8NoteIndex == NOTE_INDEX_REST)
+      {
+        sNote.u16Gap = 0;
+      }
+
+      psNote = &psVoice->asQueue[psVoice->u8QueueHead];
+      psNote->u8NoteIndex = sNote.u8NoteIndex;
+      psNote->u16SoundTime = sNote.u16Length - sNote.u16Gap;
+      psNote->u16GapTime = sNote.u16Gap;
+
+      if(eStatus == MUSIC_SOURCE_LAST)
+      {
+        psNote->u16SoundTime += MUSIC_FINAL_HOLD_TIME;
+        psVoice->bAllQueued = TRUE;
+      }
+
+      /* Publish the note to the ISR only once it is complete */
+      psVoice->u8QueueHead = u8NextHead;
+      psVoice->u16NoteIndex++;
+    }
+  }
+
+  if( !Music_bSequencerRunning && !(G_u32MusicFlags & _MUSIC_PAUSED) )
+  {
+    MusicSequencerStart();
+  }
+
+} /* end MusicQueueNotes() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicSequencerStart
+
+Description:
+Starts the sequencer timer if there is anything left to play.  The first period runs to the nearest boundary of a
+note that is already sounding (after a pause), or MUSIC_START_TICKS so the ISR loads the first notes almost
+immediately.
+
+Requires:
+  - Sequencer timer is stopped
+
+Promises:
+  - If a note is in progress or queued in any voice, the sequencer is running
+*/
+static void MusicSequencerStart(void)
+{
+  MusicVoiceType* psVoice;
+  u32 u32Period = TC_SEQUENCER_MAX_TICKS;
+  bool bPending = FALSE;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Music_asVoices[i];
+
+    if(psVoice->bSounding)
+    {
+      bPending = TRUE;
+      if(psVoice->u32TicksRemaining < u32Period)
+      {
+        u32Period = psVoice->u32TicksRemaining;
+      }
+    }
+    else if(psVoice->u8QueueTail != psVoice->u8QueueHead)
+    {
+      /* A voice waiting for its next note needs the ISR right away */
+      bPending = TRUE;
+      u32Period = MUSIC_START_TICKS;
+    }
+  }
+
+  if(!bPending)
+  {
+    return;
+  }
+
+  /* A note that ended right at the pause still needs a non-zero period */
+  if(u32Period < MUSIC_START_TICKS)
+  {
+    u32Period = MUSIC_START_TICKS;
+  }
+
+  Music_u16Period = (u16)u32Period;
+  Music_bSequencerRunning = TRUE;
+  TimerSequencerStart(MUSIC_TIMER, Music_u16Period);
+
+} /* end MusicSequencerStart() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicTempoTicks
+
+Description:
+Scales a nominal time to sequencer ticks at a tempo step.  The Q8 ticks-per-ms reciprocal is applied in its integer
+and fraction parts so any u16 time fits in 32 bits without a division.
+
+Requires:
+  - u8TempoStep_ is a valid tempo step
+
+Promises:
+  - Returns u16Time_ in sequencer ticks at the tempo
+*/
+static u32 MusicTempoTicks(u16 u16Time_, u8 u8TempoStep_)
+{
+  u32 u32TicksPerMs = Music_au32TempoTicks[u8TempoStep_];
+
+  return( ((u32)u16Time_ * (u32TicksPerMs >> MUSIC_TEMPO_Q8_SHIFT)) +
+          (((u32)u16Time_ * (u32TicksPerMs & MUSIC_TEMPO_Q8_MASK)) >> MUSIC_TEMPO_Q8_SHIFT) );
+
+} /* end MusicTempoTicks() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicUpdateEnvelopes
+
+Description:
+Steps the volume envelope of each sounding note once per call (every 1ms from the state machine).  A note rises one
+level every MUSIC_ENVELOPE_STEP_TIME after it starts; a note that ends in an articulation gap falls back down over
+its last MUSIC_ENVELOPE_LEVEL_MAX steps.  The PWM duty is written only when the level changes.
+
+Requires:
+  - Called every 1ms while a song is playing
+
+Promises:
+  - The duty of each sounding voice matches its envelope level
+*/
+static void MusicUpdateEnvelopes(void)
+{
+  MusicVoiceType* psVoice;
+  u16 u16NotesStarted;
+  u32 u32Elapsed;
+  u32 u32Level;
+  u32 u32ReleaseLevel;
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psVoice = &Music_asVoices[i];
+
+    /* A new note starts at level 0 (set by the ISR) */
+    u16NotesStarted = psVoice->u16NotesStarted;
+    if(u16NotesStarted != psVoice->u16EnvelopeNotes)
+    {
+      psVoice->u16EnvelopeNotes = u16NotesStarted;
+      psVoice->u32EnvelopeStart = G_u32SystemTime1ms;
+      psVoice->u8EnvelopeLevel = 0;
+    }
+
+    if( !psVoice->bSounding || (psVoice->u8CurrentNote == NOTE_INDEX_REST) )
+    {
+      continue;
+    }
+
+    /* Attack */
+    u32Elapsed = G_u32SystemTime1ms - psVoice->u32EnvelopeStart;
+    u32Level = u32Elapsed / MUSIC_ENVELOPE_STEP_TIME;
+    if(u32Level > MUSIC_ENVELOPE_LEVEL_MAX)
+    {
+      u32Level = MUSIC_ENVELOPE_LEVEL_MAX;
+    }
+
+    /* Release */
+    if(psVoice->bRelease)
+    {
+      u32ReleaseLevel = 0;
+      if(psVoice->u32SoundTime > u32Elapsed)
+      {
+        u32ReleaseLevel = (psVoice->u32SoundTime - u32Elapsed) / MUSIC_ENVELOPE_STEP_TIME;
+      }
+
+      if(u32ReleaseLevel < u32Level)
+      {
+        u32Level = u32ReleaseLevel;
+      }
+    }
+
+    if(u32Level == psVoice->u8EnvelopeLevel)
+    {
+      continue;
+    }
+
+    /* Keep the sequencer from changing the note between the check and the write */
+    NVIC_DisableIRQ(MUSIC_TIMER_IRQ);
+    if( (psVoice->u16NotesStarted == u16NotesStarted) && (psVoice->u8CurrentNote != NOTE_INDEX_REST) )
+    {
+      PWMAudioSetNoteDuty(Music_au32VoiceBuzzer[i], psVoice->u8CurrentNote, Music_au8EnvelopeShift[u32Level]);
+      psVoice->u8EnvelopeLevel = (u8)u32Level;
+    }
+    NVIC_EnableIRQ(MUSIC_TIMER_IRQ);
+  }
+
+} /* end MusicUpdateEnvelopes() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicLedsShowNote
+
+Description:
+Lights a bar of LEDs for a note: the higher the frequency, the more LEDs are displayed (0 to 7).  The display is
+forced to change between notes even if the pitch is close enough to land on the same value.
+
+Requires:
+  - u8NoteIndex_ is the note index being played (after transposing)
+  - Music_iOldLedMax is the highest LED lit for the previous note and Music_u16OldFrequency is its frequency
+
+Promises:
+  - LEDs 0 to Music_iLedMax are on
+*/
+static void MusicLedsShowNote(u8 u8NoteIndex_)
+{
+  u32 u32Note = MusicNoteFrequency(u8NoteIndex_);
+
+  Music_iLedMax = (int)((u32Note - 130) / 55);
+  if(Music_iLedMax > MUSIC_LED_MAX)
+  {
+    Music_iLedMax = MUSIC_LED_MAX;
+  }
+
+  if(Music_u16NotesDisplayed > 1)
+  {
+    if(Music_iLedMax == Music_iOldLedMax)
+    {
+      if(Music_u16OldFrequency > u32Note)
+      {
+        Music_iLedMax--;
+      }
+      else
+      {
+        Music_iLedMax++;
+      }
+    }
+  }
+
+  for(int i = 0; i <= Music_iLedMax; i++)
+  {
+    LedOn((LedNumberType)i);
+  }
+
+  Music_u16OldFrequency = (u16)u32Note;
+
+} /* end MusicLedsShowNote() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: MusicLedsOff
+
+Description:
+Turns off the LEDs lit for the current note.
+
+Requires:
+  - Music_iLedMax is the highest LED that was turned on
+
+Promises:
+  - LEDs 0 to Music_iLedMax are off
+*/
+static void MusicLedsOff(void)
+{
+  for(int i = 0; i <= Music_iLedMax; i++)
+  {
+    LedOff((LedNumberType)i);
+  }
+
+} /* end MusicLedsOff() */
+
+
+/**********************************************************************************************************************
+State Machine Function Definitions
+**********************************************************************************************************************/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Wait for a song to be started */
+static void MusicSM_Idle(void)
+{
+
+} /* end MusicSM_Idle() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Keep the sequencer queues topped up and the LEDs following the voice 0 note that is sounding */
+static void MusicSM_Playing(void)
+{
+  u16 u16NotesStarted = Music_asVoices[0].u16NotesStarted;
+  bool bAllQueued = TRUE;
+
+  MusicQueueNotes();
+  MusicUpdateEnvelopes();
+
+  if(u16NotesStarted != Music_u16NotesDisplayed)
+  {
+    MusicLedsOff();
+    Music_iOldLedMax = Music_iLedMax;
+    Music_u16NotesDisplayed = u16NotesStarted;
+    MusicLedsShowNote(Music_asVoices[0].u8StartedNote);
+  }
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    if(!Music_asVoices[i].bAllQueued)
+    {
+      bAllQueued = FALSE;
+    }
+  }
+
+  /* The sequencer stops itself after the last note of every voice */
+  if( bAllQueued && !Music_bSequencerRunning )
+  {
+    MusicLedsOff();
+    G_u32MusicFlags &= ~_MUSIC_PLAYING;
+
+    Music_pu8Parser = &Music_au8DoneMsg[0];
+    G_MusicStateMachine = MusicSM_Report;
+  }
+
+} /* end MusicSM_Playing() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Song is paused: wait for MusicResume() or MusicStop() */
+static void MusicSM_Paused(void)
+{
+
+} /* end MusicSM_Paused() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Report that the song is done, one character per loop */
+static void MusicSM_Report(void)
+{
+  if(*Music_pu8Parser == '\0')
+  {
+    G_MusicStateMachine = MusicSM_Idle;
+    return;
+  }
+
+  /* Advance only if character has been sent */
+  if( Uart_putc(*Music_pu8Parser) )
+  {
+    Music_pu8Parser++;
+  }
+
+} /* end MusicSM_Report() */
+
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -2,11 +2,116 @@
 File: music.h      
 
 Description:
-Definitions for musical notes
+Definitions for musical notes, the packed song format and the music player.
 
 ***********************************************************************************************************************/
+
+#ifndef __MUSIC_H
+#define __MUSIC_H
+
+/* Player sizes used by the type definitions */
+#define MUSIC_VOICES              (u8)2                /* Voice 0 on buzzer 1 (PWM CH0), voice 1 on buzzer 2 (PWM CH1) */
+#define MUSIC_NOTE_QUEUE_SIZE     (u8)16               /* Sequencer queue slots per voice (one is always left empty) */
+
+/**********************************************************************************************************************
+Type Definitions
+**********************************************************************************************************************/
+typedef struct
+{
+  const u16* pu16Notes;          /* Packed notes built with SONG_NOTE() */
+  u16 u16NoteCount;              /* Number of notes in the voice (0 if the voice is unused) */
+} SongVoiceType;
+
+typedef struct
+{
+  SongVoiceType asVoices[MUSIC_VOICES]; /* Voice 0 is the melody; voice 1 is optional */
+} SongType;
+
+typedef struct
+{
+  u8 u8NoteIndex;                /* NOTE_INDEX_* */
+  u8 u8Articulation;             /* SONG_ARTICULATION_* */
+  u16 u16Length;                 /* Note length in ms */
+  u16 u16Gap;                    /* Silent time in ms at the end of the note for its articulation */
+} MusicNoteType;
+
+/* Result of asking a note source for the next note of a voice */
+typedef enum {MUSIC_SOURCE_NOTE, MUSIC_SOURCE_LAST, MUSIC_SOURCE_WAIT, MUSIC_SOURCE_END} MusicSourceStatusType;
+
+/* Note source for songs that are not const tables (e.g. streamed from the SD card or parsed from MIDI).  Called from
+the main loop with the voice number; on MUSIC_SOURCE_NOTE or MUSIC_SOURCE_LAST (the final note of the voice) *psNote_
+holds the next note with its length and gap in ms, so a source is not limited to the packed note lengths.
+MUSIC_SOURCE_WAIT means no note is available yet; MUSIC_SOURCE_END means the voice has no more notes. */
+typedef MusicSourceStatusType (*MusicNoteSourceType)(u8 u8Voice_, MusicNoteType* psNote_);
+
+typedef struct
+{
+  u8 u8NoteIndex;                /* NOTE_INDEX_* as written in the song (NOTE_INDEX_REST for a rest) */
+  u16 u16SoundTime;              /* Nominal time in ms the note sounds (scaled to the tempo when it starts) */
+  u16 u16GapTime;                /* Nominal silent articulation gap in ms after the note */
+} MusicQueuedNoteType;
+
+typedef struct
+{
+  const SongVoiceType* psVoice;                      /* Notes of this voice in the current song (NULL if streamed) */
+  u16 u16NoteIndex;                                  /* Next note to queue (main loop only) */
+  bool bAllQueued;                                   /* TRUE once the last note of the voice is queued */
+  MusicQueuedNoteType asQueue[MUSIC_NOTE_QUEUE_SIZE]; /* Notes waiting for the sequencer */
+  volatile u8 u8QueueHead;                           /* Next free queue slot (written by the main loop only) */
+  volatile u8 u8QueueTail;                           /* Next queued note to play (written by the ISR only) */
+  volatile bool bSounding;                           /* TRUE while the voice has a note in progress */
+  volatile u8 u8CurrentNote;                         /* Note index in progress (NOTE_INDEX_REST during a gap) */
+  volatile u8 u8StartedNote;                         /* Note index of the note started last (kept through its gap) */
+  volatile u32 u32TicksRemaining;                    /* Ticks left in the note in progress */
+  volatile u16 u16NotesStarted;                      /* Number of notes started by the sequencer */
+  volatile u32 u32GapTicks;                          /* Gap to play when the current note ends */
+  volatile u32 u32LateTicks;                         /* Ticks the next note is late after the queue ran dry */
+  volatile u32 u32SoundTime;                         /* Sounding time in ms of the note in progress at its tempo */
+  volatile bool bRelease;                            /* TRUE if the note in progress fades out before a gap */
+  u16 u16EnvelopeNotes;                              /* Note count the envelope is tracking (main loop only) */
+  u32 u32EnvelopeStart;                              /* System time the tracked note was seen to start */
+  u8 u8EnvelopeLevel;                                /* Current envelope level 0 - MUSIC_ENVELOPE_LEVEL_MAX */
+} MusicVoiceType;
+
+
+/**********************************************************************************************************************
+Constants / Definitions
+**********************************************************************************************************************/
+/* G_u32MusicFlags */
+#define _MUSIC_PLAYING            (u32)0x00000001      /* A song is loaded and playing */
+#define _MUSIC_PAUSED             (u32)0x00000002      /* The current song is paused */
+
+#define MUSIC_FINAL_HOLD_TIME     (u32)200             /* Time in ms the last note is held before the buzzer is shut off */
+#define MUSIC_LED_MAX             (int)7               /* Highest LED used by the note level display */
+
+#define MUSIC_TIMER               (u32)AT91C_ID_TC0    /* Timer counter that sequences notes */
+#define MUSIC_TIMER_IRQ           (IRQn_Type)IRQn_TC0  /* Interrupt of MUSIC_TIMER */
+#define MUSIC_START_TICKS         (u16)1               /* Ticks to the first sequencer interrupt after a start */
+#define MUSIC_STARVED_TICKS       (u32)TC_SEQUENCER_TICKS_PER_MS /* Implicit rest of a voice waiting for a note */
+#define MUSIC_MERGE_TICKS         (u32)(TC_SEQUENCER_TICKS_PER_MS / 10) /* Voice boundaries this close (100 us) are
+                                                                          taken in one sequencer interrupt */
+
+/* Tempo: note lengths in a song are nominal (MEASURE_TIME per full note) and are scaled when each note starts.
+Every tempo step has precomputed Q8 fixed-point reciprocals so the sequencer scales a note with a multiply and a
+shift instead of a division. */
+#define MUSIC_TEMPO_STEPS         (u8)11               /* Entries in the tempo tables */
+#define MUSIC_TEMPO_NORMAL        (u8)4                /* Step for 100%: notes play at their nominal length */
+#define MUSIC_TEMPO_DEFAULT       (u8)8                /* Step for 200%: the speed the songs were written for */
+#define MUSIC_TEMPO_Q8_SHIFT      (u8)8                /* Fraction bits of the tempo reciprocals */
+#define MUSIC_TEMPO_Q8_MASK       (u32)0x000000FF
+
+/* Q8 ms of real time per nominal ms, and Q8 sequencer ticks per nominal ms, at a tempo in percent (rounded) */
+#define MUSIC_TEMPO_TIME(PERCENT)   (u16)( ((100UL << MUSIC_TEMPO_Q8_SHIFT) + ((PERCENT) / 2)) / (PERCENT) )
+#define MUSIC_TEMPO_TICKS(PERCENT)  (u32)( (((TC_SEQUENCER_TICKS_PER_MS * 100UL) << MUSIC_TEMPO_Q8_SHIFT) + \
+                                            ((PERCENT) / 2)) / (PERCENT) )
+
+/* Transpose: semitones added to every note at play time.  Notes pushed past the note table fold back by octaves. */
+#define MUSIC_TRANSPOSE_MAX       (s8)12               /* Largest transpose up or down in semitones */
+#define MUSIC_OCTAVE              (u8)12               /* Semitones per octave */
+
+
 /* Note lengths */
-#define MEASURE_TIME              (u16)2000  /* Time in ms for 1 measure (1 full note) - should be divisible by 8*/
+#define MEASURE_TIME              (u16)2000  /* Time in ms for 1 measure (1 full note) at 100% tempo - should be divisible by 8*/
 #define FULL_NOTE                 (u16)(MEASURE_TIME)
 #define HALF_NOTE                 (u16)(MEASURE_TIME / 2)
 #define QUARTER_NOTE              (u16)(MEASURE_TIME / 4)
@@ -28,6 +133,60 @@ Definitions for musical notes
 #define ST                        STACCATO_NOTE_TIME        
 #define HT                        HOLD_NOTE_TIME            
 
+/* Packed song note format: one u16 per note, stored in flash with SONG_NOTE()
+    15 - 13 [0] Reserved
+    12 - 11     Articulation code (SONG_ARTICULATION_*)
+    10 - 08     Length code (SONG_LENGTH_*)
+    07 - 00     Note index (NOTE_INDEX_*)
+*/
+#define SONG_NOTE_INDEX_MASK           (u16)0x00FF
+#define SONG_NOTE_LENGTH_SHIFT         (u8)8
+#define SONG_NOTE_LENGTH_MASK          (u16)0x0007
+#define SONG_NOTE_ARTICULATION_SHIFT   (u8)11
+#define SONG_NOTE_ARTICULATION_MASK    (u16)0x0003
+
+/* Length codes: only these note lengths can be stored in a packed song */
+#define SONG_LENGTH_SN                 (u16)0   /* SN */
+#define SONG_LENGTH_EN                 (u16)1   /* EN */
+#define SONG_LENGTH_EN_DOTTED          (u16)2   /* EN + SN */
+#define SONG_LENGTH_QN                 (u16)3   /* QN */
+#define SONG_LENGTH_QN_DOTTED          (u16)4   /* QN + EN */
+#define SONG_LENGTH_HN                 (u16)5   /* HN */
+#define SONG_LENGTH_HN_DOTTED          (u16)6   /* HN + QN */
+#define SONG_LENGTH_FN                 (u16)7   /* FN */
+#define SONG_LENGTH_CODES              (u8)8
+
+/* Articulation codes */
+#define SONG_ARTICULATION_RT           (u16)0   /* REGULAR_NOTE_TIME */
+#define SONG_ARTICULATION_ST           (u16)1   /* STACCATO_NOTE_TIME */
+#define SONG_ARTICULATION_HT           (u16)2   /* HOLD_NOTE_TIME */
+#define SONG_ARTICULATION_CODES        (u8)3
+
+/* Compile-time mapping from note lengths and articulation times to their codes */
+#define SONG_LENGTH_CODE(LENGTH)  ( ((LENGTH) == SN)      ? SONG_LENGTH_SN        : \
+                                    ((LENGTH) == EN)      ? SONG_LENGTH_EN        : \
+                                    ((LENGTH) == EN + SN) ? SONG_LENGTH_EN_DOTTED : \
+                                    ((LENGTH) == QN)      ? SONG_LENGTH_QN        : \
+                                    ((LENGTH) == QN + EN) ? SONG_LENGTH_QN_DOTTED : \
+                                    ((LENGTH) == HN)      ? SONG_LENGTH_HN        : \
+                                    ((LENGTH) == HN + QN) ? SONG_LENGTH_HN_DOTTED : SONG_LENGTH_FN )
+
+#define SONG_ARTICULATION_CODE(TIME) ( ((TIME) == RT) ? SONG_ARTICULATION_RT : \
+                                       ((TIME) == ST) ? SONG_ARTICULATION_ST : SONG_ARTICULATION_HT )
+
+/* Articulation gap for a note length: the length adjustment, but never more than half the note */
+#define MUSIC_GAP(TIME, LENGTH)   (u16)( ((TIME) < ((LENGTH) / 2)) ? (TIME) : ((LENGTH) / 2) )
+
+/* Envelope: the buzzer duty steps from quiet to full over the attack, and back down over the release of
+notes that end with a gap.  Level n drives the PWM duty at period >> au8EnvelopeShift[n]. */
+#define MUSIC_ENVELOPE_LEVEL_MAX  (u8)4                /* Full level: 50% duty */
+#define MUSIC_ENVELOPE_STEP_TIME  (u32)4               /* ms per envelope level */
+
+/* Build one packed note, e.g. SONG_NOTE(B4, QN, RT) */
+#define SONG_NOTE(NOTE, LENGTH, TIME)  (u16)( (NOTE) | \
+                                              (SONG_LENGTH_CODE(LENGTH) << SONG_NOTE_LENGTH_SHIFT) | \
+                                              (SONG_ARTICULATION_CODE(TIME) << SONG_NOTE_ARTICULATION_SHIFT) )
+
 /* Musical note definitions */
 #define NOTE_C3                   (u16)131
 #define NOTE_C3_SHARP             (u16)139
@@ -82,53 +241,163 @@ Definitions for musical notes
 #define NOTE_B6                   (u16)1976
 #define NONE                      (u16)0
 
-/* Musical note definitions - short hand */
-#define C3                   (u32)NOTE_C3
-#define C3S                  (u32)NOTE_C3_SHARP
-#define D3                   (u32)NOTE_D3
-#define D3S                  (u32)NOTE_D3_SHARP
-#define E3                   (u32)NOTE_E3
-#define F3                   (u32)NOTE_F3
-#define F3S                  (u32)NOTE_F3_SHARP
-#define G3                   (u32)NOTE_G3
-#define G3S                  (u32)NOTE_G3_SHARP
-#define A3                   (u32)NOTE_A3
-#define A3S                  (u32)NOTE_A3_SHARP
-#define B3                   (u32)NOTE_B3
-#define C4                   (u32)NOTE_C4  /* Middle C */
-#define C4S                  (u32)NOTE_C4_SHARP
-#define D4                   (u32)NOTE_D4
-#define D4S                  (u32)NOTE_D4_SHARP
-#define E4                   (u32)NOTE_E4
-#define F4                   (u32)NOTE_F4
-#define F4S                  (u32)NOTE_F4_SHARP
-#define G4                   (u32)NOTE_G4
-#define G4S                  (u32)NOTE_G4_SHARP
-#define A4                   (u32)NOTE_A4
-#define A4S                  (u32)NOTE_A4_SHARP
-#define B4                   (u32)NOTE_B4
-#define C5                   (u32)NOTE_C5
-#define C5S                  (u32)NOTE_C5_SHARP
-#define D5                   (u32)NOTE_D5
-#define D5S                  (u32)NOTE_D5_SHARP
-#define E5                   (u32)NOTE_E5
-#define F5                   (u32)NOTE_F5
-#define F5S                  (u32)NOTE_F5_SHARP
-#define G5                   (u32)NOTE_G5
-#define G5S                  (u32)NOTE_G5_SHARP
-#define A5                   (u32)NOTE_A5
-#define A5S                  (u32)NOTE_A5_SHARP
-#define B5                   (u32)NOTE_B5
-#define C6                   (u32)NOTE_C6
-#define C6S                  (u32)NOTE_C6_SHARP
-#define D6                   (u32)NOTE_D6
-#define D6S                  (u32)NOTE_D6_SHARP
-#define E6                   (u32)NOTE_E6
-#define F6                   (u32)NOTE_F6
-#define F6S                  (u32)NOTE_F6_SHARP
-#define G6                   (u32)NOTE_G6
-#define G6S                  (u32)NOTE_G6_SHARP
-#define A6                   (u32)NOTE_A6
-#define A6S                  (u32)NOTE_A6_SHARP
-#define B6                   (u32)NOTE_B6
-#define NO                   (u32)NONE
+/* Note indexes used in packed song tables.  Flats share the index of the matching sharp. */
+#define NOTE_INDEX_REST           (u8)0
+#define NOTE_INDEX_C3             (u8)1
+#define NOTE_INDEX_C3_SHARP       (u8)2
+#define NOTE_INDEX_D3             (u8)3
+#define NOTE_INDEX_D3_SHARP       (u8)4
+#define NOTE_INDEX_E3             (u8)5
+#define NOTE_INDEX_F3             (u8)6
+#define NOTE_INDEX_F3_SHARP       (u8)7
+#define NOTE_INDEX_G3             (u8)8
+#define NOTE_INDEX_G3_SHARP       (u8)9
+#define NOTE_INDEX_A3             (u8)10
+#define NOTE_INDEX_A3_SHARP       (u8)11
+#define NOTE_INDEX_B3             (u8)12
+#define NOTE_INDEX_C4             (u8)13
+#define NOTE_INDEX_C4_SHARP       (u8)14
+#define NOTE_INDEX_D4             (u8)15
+#define NOTE_INDEX_D4_SHARP       (u8)16
+#define NOTE_INDEX_E4             (u8)17
+#define NOTE_INDEX_F4             (u8)18
+#define NOTE_INDEX_F4_SHARP       (u8)19
+#define NOTE_INDEX_G4             (u8)20
+#define NOTE_INDEX_G4_SHARP       (u8)21
+#define NOTE_INDEX_A4             (u8)22
+#define NOTE_INDEX_A4_SHARP       (u8)23
+#define NOTE_INDEX_B4             (u8)24
+#define NOTE_INDEX_C5             (u8)25
+#define NOTE_INDEX_C5_SHARP       (u8)26
+#define NOTE_INDEX_D5             (u8)27
+#define NOTE_INDEX_D5_SHARP       (u8)28
+#define NOTE_INDEX_E5             (u8)29
+#define NOTE_INDEX_F5             (u8)30
+#define NOTE_INDEX_F5_SHARP       (u8)31
+#define NOTE_INDEX_G5             (u8)32
+#define NOTE_INDEX_G5_SHARP       (u8)33
+#define NOTE_INDEX_A5             (u8)34
+#define NOTE_INDEX_A5_SHARP       (u8)35
+#define NOTE_INDEX_B5             (u8)36
+#define NOTE_INDEX_C6             (u8)37
+#define NOTE_INDEX_C6_SHARP       (u8)38
+#define NOTE_INDEX_D6             (u8)39
+#define NOTE_INDEX_D6_SHARP       (u8)40
+#define NOTE_INDEX_E6             (u8)41
+#define NOTE_INDEX_F6             (u8)42
+#define NOTE_INDEX_F6_SHARP       (u8)43
+#define NOTE_INDEX_G6             (u8)44
+#define NOTE_INDEX_G6_SHARP       (u8)45
+#define NOTE_INDEX_A6             (u8)46
+#define NOTE_INDEX_A6_SHARP       (u8)47
+#define NOTE_INDEX_B6             (u8)48
+#define NOTE_INDEX_COUNT          (u8)49            /* Number of entries in the note frequency table */
+
+/* Musical note definitions - short hand for packed song tables */
+#define C3                   NOTE_INDEX_C3
+#define C3S                  NOTE_INDEX_C3_SHARP
+#define D3                   NOTE_INDEX_D3
+#define D3S                  NOTE_INDEX_D3_SHARP
+#define E3                   NOTE_INDEX_E3
+#define F3                   NOTE_INDEX_F3
+#define F3S                  NOTE_INDEX_F3_SHARP
+#define G3                   NOTE_INDEX_G3
+#define G3S                  NOTE_INDEX_G3_SHARP
+#define A3                   NOTE_INDEX_A3
+#define A3S                  NOTE_INDEX_A3_SHARP
+#define B3                   NOTE_INDEX_B3
+#define C4                   NOTE_INDEX_C4
+#define C4S                  NOTE_INDEX_C4_SHARP
+#define D4                   NOTE_INDEX_D4
+#define D4S                  NOTE_INDEX_D4_SHARP
+#define E4                   NOTE_INDEX_E4
+#define F4                   NOTE_INDEX_F4
+#define F4S                  NOTE_INDEX_F4_SHARP
+#define G4                   NOTE_INDEX_G4
+#define G4S                  NOTE_INDEX_G4_SHARP
+#define A4                   NOTE_INDEX_A4
+#define A4S                  NOTE_INDEX_A4_SHARP
+#define B4                   NOTE_INDEX_B4
+#define C5                   NOTE_INDEX_C5
+#define C5S                  NOTE_INDEX_C5_SHARP
+#define D5                   NOTE_INDEX_D5
+#define D5S                  NOTE_INDEX_D5_SHARP
+#define E5                   NOTE_INDEX_E5
+#define F5                   NOTE_INDEX_F5
+#define F5S                  NOTE_INDEX_F5_SHARP
+#define G5                   NOTE_INDEX_G5
+#define G5S                  NOTE_INDEX_G5_SHARP
+#define A5                   NOTE_INDEX_A5
+#define A5S                  NOTE_INDEX_A5_SHARP
+#define B5                   NOTE_INDEX_B5
+#define C6                   NOTE_INDEX_C6
+#define C6S                  NOTE_INDEX_C6_SHARP
+#define D6                   NOTE_INDEX_D6
+#define D6S                  NOTE_INDEX_D6_SHARP
+#define E6                   NOTE_INDEX_E6
+#define F6                   NOTE_INDEX_F6
+#define F6S                  NOTE_INDEX_F6_SHARP
+#define G6                   NOTE_INDEX_G6
+#define G6S                  NOTE_INDEX_G6_SHARP
+#define A6                   NOTE_INDEX_A6
+#define A6S                  NOTE_INDEX_A6_SHARP
+#define B6                   NOTE_INDEX_B6
+#define NO                   NOTE_INDEX_REST
+
+
+/**********************************************************************************************************************
+Function Declarations
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+bool MusicStart(const SongType* psSong_);
+bool MusicStartSource(MusicNoteSourceType pfNoteSource_);
+void MusicStop(void);
+void MusicPause(void);
+void MusicResume(void);
+bool MusicIsPlaying(void);
+void MusicDecodeNote(u16 u16PackedNote_, MusicNoteType* psNote_);
+u16 MusicNoteFrequency(u8 u8NoteIndex_);
+bool MusicSetTempo(u8 u8TempoStep_);
+u8 MusicGetTempo(void);
+u16 MusicGetTempoPercent(void);
+bool MusicSetTranspose(s8 s8Semitones_);
+s8 MusicGetTranspose(void);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected functions                                                                                                */
+/*--------------------------------------------------------------------------------------------------------------------*/
+void MusicInitialize(void);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static void MusicBegin(void);
+static MusicSourceStatusType MusicNextNote(u8 u8Voice_, MusicNoteType* psNote_);
+static void MusicQueueNotes(void);
+static void MusicSequencerStart(void);
+static u32 MusicTempoTicks(u16 u16Time_, u8 u8TempoStep_);
+static void MusicLedsShowNote(u8 u8NoteIndex_);
+static void MusicUpdateEnvelopes(void);
+static void MusicLedsOff(void);
+
+
+/***********************************************************************************************************************
+State Machine Declarations
+***********************************************************************************************************************/
+static void MusicSM_Idle(void);
+static void MusicSM_Playing(void);
+static void MusicSM_Paused(void);
+static void MusicSM_Report(void);
+
+
+#endif /* __MUSIC_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,85 @@
+/**********************************************************************************************************************
+File: songs.c
+
+Description:
+Song tables for the music player.  Each note is packed into one u16 with SONG_NOTE() (see music.h) and the tables
+are const so they stay in flash: no song data is copied to RAM.  Notes are held (HT) unless the next note has the
+same pitch, in which case they are played regular (RT) so the repeated notes are heard separately.  A song has up to
+MUSIC_VOICES voices; the voices of a song should add up to the same total length.
+
+The tables can be written by hand or converted from text with tools/host/songconv, and "make check" there validates
+them (note indexes, codes, repeated held notes and voice lengths).
+**********************************************************************************************************************/
+
+#include "configuration.h"
+#include "music.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Songs_" and be declared as static.
+***********************************************************************************************************************/
+/* "Mary had a little lamb" */
+static const u16 Songs_au16MaryHadALittleLamb[] =
+{
+  SONG_NOTE(B4, QN, HT), SONG_NOTE(A4, QN, HT), SONG_NOTE(G4, QN, HT), SONG_NOTE(A4, QN, HT),
+  SONG_NOTE(B4, QN, RT), SONG_NOTE(B4, QN, RT), SONG_NOTE(B4, HN, HT), SONG_NOTE(A4, QN, RT),
+  SONG_NOTE(A4, QN, RT), SONG_NOTE(A4, HN, HT), SONG_NOTE(B4, QN, HT), SONG_NOTE(D4, QN, RT),
+  SONG_NOTE(D4, HN, HT), SONG_NOTE(B4, QN, HT), SONG_NOTE(A4, QN, HT), SONG_NOTE(G4, QN, HT),
+  SONG_NOTE(A4, QN, HT), SONG_NOTE(B4, QN, RT), SONG_NOTE(B4, QN, RT), SONG_NOTE(B4, QN, RT),
+  SONG_NOTE(B4, QN, HT), SONG_NOTE(A4, QN, RT), SONG_NOTE(A4, QN, HT), SONG_NOTE(B4, QN, HT),
+  SONG_NOTE(A4, QN, HT), SONG_NOTE(G4, FN, HT)
+};
+
+/* "Mary had a little lamb" bass line (voice 1): root and fifth of each measure's chord */
+static const u16 Songs_au16MaryHadALittleLambBass[] =
+{
+  SONG_NOTE(G3, HN, HT), SONG_NOTE(D3, HN, HT), SONG_NOTE(G3, HN, HT), SONG_NOTE(D3, HN, RT),
+  SONG_NOTE(D3, HN, HT), SONG_NOTE(A3, HN, HT), SONG_NOTE(G3, HN, HT), SONG_NOTE(D3, HN, HT),
+  SONG_NOTE(G3, HN, HT), SONG_NOTE(D3, HN, HT), SONG_NOTE(G3, HN, HT), SONG_NOTE(D3, HN, RT),
+  SONG_NOTE(D3, HN, HT), SONG_NOTE(A3, HN, HT), SONG_NOTE(G3, FN, HT)
+};
+
+/* "Fur Elise" */
+static const u16 Songs_au16FurElise[] =
+{
+  SONG_NOTE(B4, QN, HT), SONG_NOTE(C4, QN, HT), SONG_NOTE(D4, QN, HT), SONG_NOTE(E4, HN + QN, HT),
+  SONG_NOTE(G3, QN, HT), SONG_NOTE(F4, QN, HT), SONG_NOTE(E4, QN, HT), SONG_NOTE(D4, HN + QN, HT),
+  SONG_NOTE(F3, QN, HT), SONG_NOTE(E4, QN, HT), SONG_NOTE(D4, QN, HT), SONG_NOTE(C4, HN + QN, HT),
+  SONG_NOTE(E3, QN, HT), SONG_NOTE(D4, QN, HT), SONG_NOTE(C4, QN, HT), SONG_NOTE(B4, HN + QN, HT),
+  SONG_NOTE(NO, QN, HT), SONG_NOTE(E4, QN, HT), SONG_NOTE(D4S, QN, HT), SONG_NOTE(E4, QN, HT),
+  SONG_NOTE(D4S, QN, HT), SONG_NOTE(E4, QN, HT), SONG_NOTE(B4, QN, HT), SONG_NOTE(D4, QN, HT),
+  SONG_NOTE(C4, QN, HT), SONG_NOTE(A4, HN + QN, HT), SONG_NOTE(C3, QN, HT), SONG_NOTE(E3, QN, HT),
+  SONG_NOTE(A4, QN, HT), SONG_NOTE(B4, HN + QN, HT), SONG_NOTE(E3, QN, HT), SONG_NOTE(G3S, QN, HT),
+  SONG_NOTE(B4, QN, HT), SONG_NOTE(C4, HN + QN, HT), SONG_NOTE(NO, QN, HT), SONG_NOTE(E4, QN, HT),
+  SONG_NOTE(D4S, QN, HT), SONG_NOTE(E4, QN, HT), SONG_NOTE(D4S, QN, HT), SONG_NOTE(E4, QN, HT),
+  SONG_NOTE(B4, QN, HT), SONG_NOTE(D4, QN, HT), SONG_NOTE(C4, QN, HT), SONG_NOTE(A4, HN + QN, HT),
+  SONG_NOTE(C3, QN, HT), SONG_NOTE(E3, QN, HT), SONG_NOTE(A4, QN, HT), SONG_NOTE(B4, HN + QN, HT),
+  SONG_NOTE(E3, QN, HT), SONG_NOTE(C4, QN, HT), SONG_NOTE(B4, QN, HT), SONG_NOTE(A4, HN + QN, HT)
+};
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/* New variables */
+const SongType G_sSongMaryHadALittleLamb =
+{
+  {
+    {Songs_au16MaryHadALittleLamb,     sizeof(Songs_au16MaryHadALittleLamb) / sizeof(Songs_au16MaryHadALittleLamb[0])},
+    {Songs_au16MaryHadALittleLambBass, sizeof(Songs_au16MaryHadALittleLambBass) / sizeof(Songs_au16MaryHadALittleLambBass[0])}
+  }
+};
+
+const SongType G_sSongFurElise =
+{
+  {
+    {Songs_au16FurElise, sizeof(Songs_au16FurElise) / sizeof(Songs_au16FurElise[0])},
+    {NULL, 0}
+  }
+};
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,466 @@
+/**********************************************************************************************************************
+File: songstream.c
+
+Description:
+Song library on the SD card.  Songs are stored in the packed note format of music.h on a raw card (see the layout
+in songstream.h) and are streamed to the music player block by block, so a song of any length plays from two
+512-byte buffers.  While the notes of one buffer are being queued by the player, the next block of the song is read
+into the other buffer through the sdcard.c block read API (SdReadBlock() / SdGetReadData()).
+
+The streamer only touches the card through SdGetStatus(), SdReadBlock() and SdGetReadData(), and it calls them
+through the SongStreamCardType given to SongStreamSetCard(), so it runs against any block device that provides those
+three functions (for example the file-backed card image of the host tests in tools/host).
+
+The module is built in the MPGL1 project, but sdcard.c is not ported to this board yet, so no card is set and
+SongStreamPlay() returns FALSE.  Once the driver is ported, main() sets a card of SdGetStatus(), SdReadBlock() and
+SdGetReadData() and calls G_SongStreamStateMachine from the super loop along with G_SdCardStateMachine.
+
+------------------------------------------------------------------------------------------------------------------------
+API:
+
+Public:
+void SongStreamSetCard(const SongStreamCardType* psCard_)
+Selects the block device the library is read from (NULL for none).
+
+bool SongStreamPlay(u16 u16Song_)
+Starts playing song u16Song_ of the card library.  The music player starts right away and waits for the first
+block of notes.
+
+MusicSourceStatusType SongStreamGetNote(u8 u8Voice_, MusicNoteType* psNote_)
+Note source given to MusicStartSource() (see MusicNoteSourceType).
+
+Protected:
+void SongStreamInitialize(void)
+Initializes the streamer state machine.
+
+**********************************************************************************************************************/
+
+#include "configuration.h"
+#include "music.h"
+#include "sdcard.h"
+#include "songstream.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/* New variables */
+volatile fnCode_type G_SongStreamStateMachine;         /* The state machine function pointer */
+volatile u32 G_u32SongStreamFlags;                     /* Global state flags */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile u32 G_u32SystemFlags;                  /* From main.c */
+extern volatile u32 G_u32ApplicationFlags;             /* From main.c */
+
+extern volatile u32 G_u32SystemTime1ms;                /* From board-specific source file */
+extern volatile u32 G_u32SystemTime1s;                 /* From board-specific source file */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "SongStream_" and be declared as static.
+***********************************************************************************************************************/
+static SongStreamBufferType SongStream_asBuffers[SONG_STREAM_BUFFERS]; /* Ping-pong block buffers */
+static u8 SongStream_u8PlayBuffer;                     /* Buffer the player takes notes from */
+static u16 SongStream_u16PlayOffset;                   /* Byte offset of the next note in the play buffer */
+static u8 SongStream_u8FillBuffer;                     /* Buffer the next block is read into */
+
+static const SongStreamCardType* SongStream_psCard;    /* Block device of the library (NULL if there is none) */
+static u16 SongStream_u16Song;                         /* Library index of the song being played */
+static u32 SongStream_u32NextBlock;                    /* Next card block to read */
+static u32 SongStream_u32BlocksLeft;                   /* Blocks of the song not read yet */
+static u32 SongStream_u32NotesLeft;                    /* Notes of the song not given to the player yet */
+
+static bool SongStream_bReadPending;                   /* TRUE while a block read is in progress on the card */
+static u32 SongStream_u32PendingBlock;                 /* Block address of the read in progress */
+static u32 SongStream_u32Timeout;                      /* Start time of the read in progress */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongStreamSetCard
+
+Description:
+Selects the block device the song library is read from.
+
+Requires:
+  - No song is being streamed
+  - psCard_ stays valid until it is replaced, and none of its functions is NULL
+
+Promises:
+  - SongStreamPlay() reads from psCard_ from now on; with NULL it returns FALSE
+*/
+void SongStreamSetCard(const SongStreamCardType* psCard_)
+{
+  SongStream_psCard = psCard_;
+
+} /* end SongStreamSetCard() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongStreamPlay
+
+Description:
+Starts streaming a song from the card library.  The directory block is read to find the song, then its first block
+is read for the header and first notes.  The music player is started immediately with SongStreamGetNote() as its
+note source and simply waits until notes are available.
+
+Requires:
+  - The SD card state machine is running and its card is set with SongStreamSetCard()
+  - u16Song_ is the index of a song in the card directory
+
+Promises:
+  - Returns TRUE and starts streaming if a card is ready
+  - Returns FALSE if no card is set, or there is no card in it, or it is in error
+*/
+bool SongStreamPlay(u16 u16Song_)
+{
+  SdCardStateType eCardState;
+
+  if(SongStream_psCard == NULL)
+  {
+    return(FALSE);
+  }
+
+  eCardState = SongStream_psCard->pfGetStatus();
+  if( (eCardState == SD_NO_CARD) || (eCardState == SD_CARD_ERROR) )
+  {
+    return(FALSE);
+  }
+
+  /* A read still pending from a previous song is discarded by SongStreamReadBlock() */
+  for(u8 i = 0; i < SONG_STREAM_BUFFERS; i++)
+  {
+    SongStream_asBuffers[i].bFull = FALSE;
+  }
+
+  SongStream_u8PlayBuffer = 0;
+  SongStream_u16PlayOffset = SONG_STREAM_HEADER_SIZE;
+  SongStream_u8FillBuffer = 0;
+  SongStream_u16Song = u16Song_;
+  SongStream_u32NextBlock = SONG_STREAM_DIRECTORY_BLOCK;
+  SongStream_u32BlocksLeft = 0;
+  SongStream_u32NotesLeft = 0;
+
+  G_u32SongStreamFlags = _SONG_STREAM_PLAYING;
+  G_SongStreamStateMachine = SongStreamSM_ReadDirectory;
+
+  return( MusicStartSource(SongStreamGetNote) );
+
+} /* end SongStreamPlay() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongStreamGetNote
+
+Description:
+Note source for the music player.  Takes the next note from the play buffer; when the last note of a block is
+taken the buffer is handed back to the state machine to be refilled and the player moves to the other buffer.
+
+Requires:
+  - Called from the main loop by the music player (see MusicNoteSourceType)
+
+Promises:
+  - Voice 0: returns MUSIC_SOURCE_NOTE or MUSIC_SOURCE_LAST with the next note decoded into *psNote_,
+    MUSIC_SOURCE_WAIT if the next block has not been read yet, or MUSIC_SOURCE_END if the song is over or failed
+  - Other voices: returns MUSIC_SOURCE_END
+*/
+MusicSourceStatusType SongStreamGetNote(u8 u8Voice_, MusicNoteType* psNote_)
+{
+  SongStreamBufferType* psBuffer = &SongStream_asBuffers[SongStream_u8PlayBuffer];
+  u16 u16PackedNote;
+
+  if( (u8Voice_ != 0) || (G_u32SongStreamFlags & _SONG_STREAM_ERROR) )
+  {
+    return(MUSIC_SOURCE_END);
+  }
+
+  /* Until the header is read the note count is 0, so check the buffer first */
+  if(!psBuffer->bFull)
+  {
+    return(MUSIC_SOURCE_WAIT);
+  }
+
+  if(SongStream_u32NotesLeft == 0)
+  {
+    return(MUSIC_SOURCE_END);
+  }
+
+  u16PackedNote = (u16)psBuffer->au8Data[SongStream_u16PlayOffset] |
+                  ((u16)psBuffer->au8Data[SongStream_u16PlayOffset + 1] << 8);
+  MusicDecodeNote(u16PackedNote, psNote_);
+  SongStream_u16PlayOffset += 2;
+  SongStream_u32NotesLeft--;
+
+  /* Block used up: refill it and move to the other buffer */
+  if(SongStream_u16PlayOffset >= SONG_STREAM_BLOCK_SIZE_BYTES)
+  {
+    psBuffer->bFull = FALSE;
+    SongStream_u8PlayBuffer = (SongStream_u8PlayBuffer + 1) % SONG_STREAM_BUFFERS;
+    SongStream_u16PlayOffset = 0;
+  }
+
+  if(SongStream_u32NotesLeft == 0)
+  {
+    return(MUSIC_SOURCE_LAST);
+  }
+
+  return(MUSIC_SOURCE_NOTE);
+
+} /* end SongStreamGetNote() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected functions                                                                                                */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: SongStreamInitialize
+
+Description:
+Initializes the State Machine and its variables.
+
+Requires:
+  -
+
+Promises:
+  - Streamer is idle with empty buffers and no card
+*/
+void SongStreamInitialize(void)
+{
+  for(u8 i = 0; i < SONG_STREAM_BUFFERS; i++)
+  {
+    SongStream_asBuffers[i].bFull = FALSE;
+  }
+
+  SongStream_psCard = NULL;
+  SongStream_u32NotesLeft = 0;
+  SongStream_bReadPending = FALSE;
+
+  G_u32SongStreamFlags = 0;
+  G_SongStreamStateMachine = SongStreamSM_Idle;
+
+} /* end SongStreamInitialize() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: SongStreamReadBlock
+
+Description:
+Reads card block SongStream_u32NextBlock without blocking: the first call starts the read and later calls collect
+the data once the card has it.  Data for a read started before SongStreamPlay() restarted the stream is thrown
+away.
+
+Requires:
+  - Called every loop from the same state until it returns TRUE
+  - pu8Destination_ points to SONG_STREAM_BLOCK_SIZE_BYTES bytes
+
+Promises:
+  - Returns TRUE when the block is in pu8Destination_; SongStream_u32NextBlock is advanced
+  - Returns FALSE while the read is in progress
+  - A card error or timeout sets _SONG_STREAM_ERROR and moves to SongStreamSM_Error
+*/
+static bool SongStreamReadBlock(u8* pu8Destination_)
+{
+  SdCardStateType eCardState = SD_NO_CARD;
+
+  if(SongStream_psCard != NULL)
+  {
+    eCardState = SongStream_psCard->pfGetStatus();
+  }
+
+  if( (eCardState == SD_NO_CARD) || (eCardState == SD_CARD_ERROR) )
+  {
+    SongStream_bReadPending = FALSE;
+    G_SongStreamStateMachine = SongStreamSM_Error;
+    return(FALSE);
+  }
+
+  /* Start the read when the card is free */
+  if(!SongStream_bReadPending)
+  {
+    if( SongStream_psCard->pfReadBlock(SongStream_u32NextBlock) )
+    {
+      SongStream_bReadPending = TRUE;
+      SongStream_u32PendingBlock = SongStream_u32NextBlock;
+      SongStream_u32Timeout = G_u32SystemTime1ms;
+    }
+
+    return(FALSE);
+  }
+
+  if( SongStream_psCard->pfGetReadData(pu8Destination_) )
+  {
+    SongStream_bReadPending = FALSE;
+
+    /* Stale data from a read started for another song */
+    if(SongStream_u32PendingBlock != SongStream_u32NextBlock)
+    {
+      return(FALSE);
+    }
+
+    SongStream_u32NextBlock++;
+    return(TRUE);
+  }
+
+  if( IsTimeUp(&SongStream_u32Timeout, SONG_STREAM_READ_TIMEOUT_MS) )
+  {
+    SongStream_bReadPending = FALSE;
+    G_SongStreamStateMachine = SongStreamSM_Error;
+  }
+
+  return(FALSE);
+
+} /* end SongStreamReadBlock() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: SongStreamGetWord
+
+Description:
+Reads a little-endian 32-bit value from a card block.
+
+Requires:
+  - pu8Data_ points to at least 4 bytes
+
+Promises:
+  - Returns the value
+*/
+static u32 SongStreamGetWord(const u8* pu8Data_)
+{
+  return( (u32)pu8Data_[0] | ((u32)pu8Data_[1] << 8) | ((u32)pu8Data_[2] << 16) | ((u32)pu8Data_[3] << 24) );
+
+} /* end SongStreamGetWord() */
+
+
+/**********************************************************************************************************************
+State Machine Function Definitions
+**********************************************************************************************************************/
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Nothing to read: wait for SongStreamPlay() */
+static void SongStreamSM_Idle(void)
+{
+
+} /* end SongStreamSM_Idle() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Read the library directory and look up the first block of the song */
+static void SongStreamSM_ReadDirectory(void)
+{
+  u8* pu8Block = &SongStream_asBuffers[0].au8Data[0];
+  u16 u16Songs;
+
+  if( !SongStreamReadBlock(pu8Block) )
+  {
+    return;
+  }
+
+  u16Songs = (u16)pu8Block[SONG_STREAM_DIRECTORY_COUNT] | ((u16)pu8Block[SONG_STREAM_DIRECTORY_COUNT + 1] << 8);
+  if( (SongStreamGetWord(pu8Block) != SONG_STREAM_DIRECTORY_MAGIC) ||
+      (SongStream_u16Song >= u16Songs) || (SongStream_u16Song >= SONG_STREAM_DIRECTORY_MAX) )
+  {
+    G_SongStreamStateMachine = SongStreamSM_Error;
+    return;
+  }
+
+  SongStream_u32NextBlock = SongStreamGetWord(&pu8Block[SONG_STREAM_DIRECTORY_FIRST + (4 * SongStream_u16Song)]);
+  G_SongStreamStateMachine = SongStreamSM_ReadHeader;
+
+} /* end SongStreamSM_ReadDirectory() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Read the first block of the song: the header and the first notes */
+static void SongStreamSM_ReadHeader(void)
+{
+  SongStreamBufferType* psBuffer = &SongStream_asBuffers[0];
+  u32 u32Bytes;
+
+  if( !SongStreamReadBlock(&psBuffer->au8Data[0]) )
+  {
+    return;
+  }
+
+  if( (SongStreamGetWord(&psBuffer->au8Data[0]) != SONG_STREAM_SONG_MAGIC) ||
+      (psBuffer->au8Data[SONG_STREAM_SONG_VERSION] != SONG_STREAM_VERSION) ||
+      (psBuffer->au8Data[SONG_STREAM_SONG_VOICES] != 1) )
+  {
+    G_SongStreamStateMachine = SongStreamSM_Error;
+    return;
+  }
+
+  /* Blocks still to read after this one */
+  SongStream_u32NotesLeft = SongStreamGetWord(&psBuffer->au8Data[SONG_STREAM_SONG_NOTES]);
+  u32Bytes = SONG_STREAM_HEADER_SIZE + (2 * SongStream_u32NotesLeft);
+  SongStream_u32BlocksLeft = (u32Bytes - 1) / SONG_STREAM_BLOCK_SIZE_BYTES;
+
+  /* The player starts on this buffer just past the header */
+  SongStream_u8PlayBuffer = 0;
+  SongStream_u16PlayOffset = SONG_STREAM_HEADER_SIZE;
+  SongStream_u8FillBuffer = 1;
+  psBuffer->bFull = TRUE;
+
+  G_SongStreamStateMachine = SongStreamSM_Streaming;
+
+} /* end SongStreamSM_ReadHeader() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* Keep the buffer the player is not using filled with the next block */
+static void SongStreamSM_Streaming(void)
+{
+  SongStreamBufferType* psBuffer = &SongStream_asBuffers[SongStream_u8FillBuffer];
+
+  /* Every block is read: the player drains the buffers on its own */
+  if(SongStream_u32BlocksLeft == 0)
+  {
+    G_u32SongStreamFlags &= ~_SONG_STREAM_PLAYING;
+    G_SongStreamStateMachine = SongStreamSM_Idle;
+    return;
+  }
+
+  if(psBuffer->bFull)
+  {
+    return;
+  }
+
+  if( SongStreamReadBlock(&psBuffer->au8Data[0]) )
+  {
+    psBuffer->bFull = TRUE;
+    SongStream_u8FillBuffer = (SongStream_u8FillBuffer + 1) % SONG_STREAM_BUFFERS;
+    SongStream_u32BlocksLeft--;
+  }
+
+} /* end SongStreamSM_Streaming() */
+
+
+/*-------------------------------------------------------------------------------------------------------------------*/
+/* The card or the song data failed: the player gets MUSIC_SOURCE_END and finishes the notes it has */
+static void SongStreamSM_Error(void)
+{
+  G_u32SongStreamFlags |= _SONG_STREAM_ERROR;
+  G_u32SongStreamFlags &= ~_SONG_STREAM_PLAYING;
+  G_SongStreamStateMachine = SongStreamSM_Idle;
+
+} /* end SongStreamSM_Error() */
+
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
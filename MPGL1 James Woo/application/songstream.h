@@ -0,0 +1,115 @@
+/**********************************************************************************************************************
+File: songstream.h
+
+Description:
+Header file for songstream.c: SD card song library layout and the song streamer.
+
+***********************************************************************************************************************/
+
+#ifndef __SONGSTREAM_H
+#define __SONGSTREAM_H
+
+/* Sizes used by the type definitions */
+#define SONG_STREAM_BLOCK_SIZE_BYTES   (u16)512             /* Bytes per SD card block */
+
+/**********************************************************************************************************************
+Type Definitions
+**********************************************************************************************************************/
+typedef struct
+{
+  u8 au8Data[SONG_STREAM_BLOCK_SIZE_BYTES];   /* One card block of song data */
+  bool bFull;                                 /* TRUE from the time the block is read until all its notes are used */
+} SongStreamBufferType;
+
+/* Block device the library is read from: the block read API of sdcard.c, or any device with the same three functions
+(e.g. a card image file on a PC) */
+typedef struct
+{
+  SdCardStateType (*pfGetStatus)(void);       /* As SdGetStatus() */
+  bool (*pfReadBlock)(u32 u32Block_);         /* As SdReadBlock() */
+  bool (*pfGetReadData)(u8* pu8Destination_); /* As SdGetReadData() */
+} SongStreamCardType;
+
+
+/**********************************************************************************************************************
+Constants / Definitions
+**********************************************************************************************************************/
+/* G_u32SongStreamFlags */
+#define _SONG_STREAM_PLAYING           (u32)0x00000001      /* A song is being streamed */
+#define _SONG_STREAM_ERROR             (u32)0x00000002      /* The card or the song data failed; the song ends */
+
+#define SONG_STREAM_BUFFERS            (u8)2                /* Ping-pong buffers: one plays while the other fills */
+#define SONG_STREAM_READ_TIMEOUT_MS    (u32)1000            /* Max time in ms for the card to deliver a block */
+
+/* Song library layout on a raw card (no file system).  All multi-byte values are little-endian.
+
+Directory block at SONG_STREAM_DIRECTORY_BLOCK:
+    00 - 03  "MPGD"
+    04 - 05  Number of songs
+    06 - 07  Reserved
+    08 - ..  First block of each song (4 bytes each)
+
+First block of a song:
+    00 - 03  "MPGS"
+    04       Format version (SONG_STREAM_VERSION)
+    05       Number of voices (1: the streamer plays voice 0 only)
+    06 - 07  Reserved
+    08 - 11  Number of notes
+    12 - 15  Reserved
+    16 - ..  Packed notes built like SONG_NOTE() (2 bytes each), continued in the following blocks
+*/
+#define SONG_STREAM_DIRECTORY_BLOCK    (u32)0
+#define SONG_STREAM_DIRECTORY_MAGIC    (u32)0x4447504D      /* "MPGD" read as a little-endian word */
+#define SONG_STREAM_DIRECTORY_COUNT    (u16)4               /* Offset of the number of songs */
+#define SONG_STREAM_DIRECTORY_FIRST    (u16)8               /* Offset of the first song block address */
+#define SONG_STREAM_DIRECTORY_MAX      (u16)((SONG_STREAM_BLOCK_SIZE_BYTES - SONG_STREAM_DIRECTORY_FIRST) / 4)
+
+#define SONG_STREAM_SONG_MAGIC         (u32)0x5347504D      /* "MPGS" read as a little-endian word */
+#define SONG_STREAM_VERSION            (u8)1
+#define SONG_STREAM_SONG_VERSION       (u16)4               /* Offset of the format version */
+#define SONG_STREAM_SONG_VOICES        (u16)5               /* Offset of the number of voices */
+#define SONG_STREAM_SONG_NOTES         (u16)8               /* Offset of the number of notes */
+#define SONG_STREAM_HEADER_SIZE        (u16)16              /* Offset of the first note */
+
+
+/**********************************************************************************************************************
+Function Declarations
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+void SongStreamSetCard(const SongStreamCardType* psCard_);
+bool SongStreamPlay(u16 u16Song_);
+MusicSourceStatusType SongStreamGetNote(u8 u8Voice_, MusicNoteType* psNote_);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Protected functions                                                                                                */
+/*--------------------------------------------------------------------------------------------------------------------*/
+void SongStreamInitialize(void);
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static bool SongStreamReadBlock(u8* pu8Destination_);
+static u32 SongStreamGetWord(const u8* pu8Data_);
+
+
+/***********************************************************************************************************************
+State Machine Declarations
+***********************************************************************************************************************/
+static void SongStreamSM_Idle(void);
+static void SongStreamSM_ReadDirectory(void);
+static void SongStreamSM_ReadHeader(void);
+static void SongStreamSM_Streaming(void);
+static void SongStreamSM_Error(void);
+
+
+#endif /* __SONGSTREAM_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -28,6 +28,7 @@ typedef const long sc32;  /*!< Read Only */
 typedef const short sc16;  /*!< Read Only */
 typedef const char sc8;   /*!< Read Only */
 
+typedef unsigned long long u64;
 typedef ULONG  u32;
 typedef USHORT u16;
 typedef UCHAR  u8;
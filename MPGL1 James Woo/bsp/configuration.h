@@ -24,6 +24,7 @@ Runtime switches
 //#define MPGL2             1         /* Use to activate MPG Level 2 specific code */
 
 #define DEBUG_MODE        1         /* Define to enable certain debugging code */
+//#define PWM_AUDIO_TRACE   1         /* Define to log buzzer PWM changes for the debug trace dump (3 kB RAM) */
 
 
 /**********************************************************************************************************************
@@ -71,6 +72,7 @@ Includes
 #define USART0_US_IER_INIT          DEBUG_US_IER_INIT
 #define USART0_US_IDR_INIT          DEBUG_US_IDR_INIT
 #define USART0_US_BRGR_INIT         DEBUG_US_BRGR_INIT
+#define USART0_US_RTOR_INIT         DEBUG_US_RTOR_INIT
 
 #define DEBUG_UART_IRQHandler       USART0_IRQHandler
 #define DEBUG_UART_PERIPHERAL       AT91C_ID_US0
@@ -224,7 +226,7 @@ Debug is used for the terminal (serial: 38.4k, 8-N-1) debugging interface.
 
 
 /* USART Interrupt Enable Register - Page 741 */
-#define DEBUG_US_IER_INIT (u32)0x00000001
+#define DEBUG_US_IER_INIT (u32)0x00000108
 /*
     31 [0] Reserved
     30 [0] "
@@ -253,18 +255,18 @@ Debug is used for the terminal (serial: 38.4k, 8-N-1) debugging interface.
 
     11 [0] TXBUFE Transmission Buffer Empty (PDC) interrupt not enabled
     10 [0] ITER/UNRE Max number of Repetitions Reached interrupt not enabled
-    09 [0] TXEMPTY Transmitter Empty interrupt not enabled (yet)
-    08 [0] TIMEOUT Receiver Time-out interrupt not enabled
+    09 [0] TXEMPTY Transmitter Empty interrupt not enabled (Uart_putc() enables it)
+    08 [1] TIMEOUT Receiver Time-out interrupt enabled (flushes a partly filled PDC receive buffer)
 
     07 [0] PARE Parity Error interrupt not enabled
     06 [0] FRAME Framing Error interrupt not enabled
     05 [0] OVRE Overrun Error interrupt not enabled
-    04 [0] ENDTX End of Transmitter Transfer (PDC) interrupt enabled
+    04 [0] ENDTX End of Transmitter Transfer (PDC) interrupt not enabled
 
-    03 [0] ENDRX End of Receiver Transfer (PDC) interrupt enabled
+    03 [1] ENDRX End of Receiver Transfer (PDC) interrupt enabled
     02 [0] RXBRK Break Received interrupt not enabled
     01 [0] TXRDY Transmitter Ready interrupt not enabled
-    00 [1] RXRDY Receiver Ready interrupt enabled
+    00 [0] RXRDY Receiver Ready interrupt not enabled (the PDC reads the received bytes)
 */
 
 /* USART Interrupt Disable Register - Page 743 */
@@ -309,6 +311,40 @@ Set FP = 1, CD = 78
     00 [0] "
 */
 
+/* USART Receiver Time-out Register
+The time-out starts counting when a character is received after STTTO and TIMEOUT is set if the line then stays
+idle for TO bit periods.  20 bit periods is two characters (0.5 ms at 38400 baud).
+*/
+#define DEBUG_US_RTOR_INIT (u32)0x00000014
+/*
+    31-20 [0] Reserved
+
+    19 [0] Reserved
+    18 [0] "
+    17 [0] "
+    16 [0] "
+
+    15 [0] TO = 20 = 0x14
+    14 [0] "
+    13 [0] "
+    12 [0] "
+
+    11 [0] "
+    10 [0] "
+    09 [0] "
+    08 [0] "
+
+    07 [0] "
+    06 [0] "
+    05 [0] "
+    04 [1] "
+
+    03 [0] "
+    02 [1] "
+    01 [0] "
+    00 [0] "
+*/
+
 /*--------------------------------------------------------------------------------------------------------------------
 Two Wire Interface setup
 
@@ -6,6 +6,7 @@ This file provides core and GPIO functions for the mpgl1-ehdw-01 board.
 ***********************************************************************************************************************/
 
 #include "configuration.h"
+#include "music.h"
 
 /***********************************************************************************************************************
 Global variable definitions with scope across entire project.
@@ -24,6 +25,28 @@ extern volatile u32 G_u32ApplicationFlags;             /* From main.c */
 Global variable definitions with scope limited to this local application.
 Variable names shall start with "Bsp_" and be declared as static.
 ***********************************************************************************************************************/
+/* PWM period and duty for every note, indexed by NOTE_INDEX_*.  The rest entry is never written to the PWM. */
+static const PwmAudioNoteType Bsp_asPwmAudioNotes[NOTE_INDEX_COUNT] =
+{
+  {0, 0},
+  PWM_AUDIO_NOTE(NOTE_C3), PWM_AUDIO_NOTE(NOTE_C3_SHARP), PWM_AUDIO_NOTE(NOTE_D3), PWM_AUDIO_NOTE(NOTE_D3_SHARP),
+  PWM_AUDIO_NOTE(NOTE_E3), PWM_AUDIO_NOTE(NOTE_F3),       PWM_AUDIO_NOTE(NOTE_F3_SHARP), PWM_AUDIO_NOTE(NOTE_G3),
+  PWM_AUDIO_NOTE(NOTE_G3_SHARP), PWM_AUDIO_NOTE(NOTE_A3), PWM_AUDIO_NOTE(NOTE_A3_SHARP), PWM_AUDIO_NOTE(NOTE_B3),
+  PWM_AUDIO_NOTE(NOTE_C4), PWM_AUDIO_NOTE(NOTE_C4_SHARP), PWM_AUDIO_NOTE(NOTE_D4), PWM_AUDIO_NOTE(NOTE_D4_SHARP),
+  PWM_AUDIO_NOTE(NOTE_E4), PWM_AUDIO_NOTE(NOTE_F4),       PWM_AUDIO_NOTE(NOTE_F4_SHARP), PWM_AUDIO_NOTE(NOTE_G4),
+  PWM_AUDIO_NOTE(NOTE_G4_SHARP), PWM_AUDIO_NOTE(NOTE_A4), PWM_AUDIO_NOTE(NOTE_A4_SHARP), PWM_AUDIO_NOTE(NOTE_B4),
+  PWM_AUDIO_NOTE(NOTE_C5), PWM_AUDIO_NOTE(NOTE_C5_SHARP), PWM_AUDIO_NOTE(NOTE_D5), PWM_AUDIO_NOTE(NOTE_D5_SHARP),
+  PWM_AUDIO_NOTE(NOTE_E5), PWM_AUDIO_NOTE(NOTE_F5),       PWM_AUDIO_NOTE(NOTE_F5_SHARP), PWM_AUDIO_NOTE(NOTE_G5),
+  PWM_AUDIO_NOTE(NOTE_G5_SHARP), PWM_AUDIO_NOTE(NOTE_A5), PWM_AUDIO_NOTE(NOTE_A5_SHARP), PWM_AUDIO_NOTE(NOTE_B5),
+  PWM_AUDIO_NOTE(NOTE_C6), PWM_AUDIO_NOTE(NOTE_C6_SHARP), PWM_AUDIO_NOTE(NOTE_D6), PWM_AUDIO_NOTE(NOTE_D6_SHARP),
+  PWM_AUDIO_NOTE(NOTE_E6), PWM_AUDIO_NOTE(NOTE_F6),       PWM_AUDIO_NOTE(NOTE_F6_SHARP), PWM_AUDIO_NOTE(NOTE_G6),
+  PWM_AUDIO_NOTE(NOTE_G6_SHARP), PWM_AUDIO_NOTE(NOTE_A6), PWM_AUDIO_NOTE(NOTE_A6_SHARP), PWM_AUDIO_NOTE(NOTE_B6)
+};
+
+#ifdef PWM_AUDIO_TRACE
+static PwmAudioTraceType Bsp_asPwmAudioTrace[PWM_AUDIO_TRACE_SIZE]; /* Buzzer PWM changes in time order */
+static u16 Bsp_u16PwmAudioTraceCount;                  /* Entries used; logging stops when the trace is full */
+#endif /* PWM_AUDIO_TRACE */
 
 
 /***********************************************************************************************************************
@@ -281,11 +304,17 @@ Promises:
   - The frequency and duty cycle values for the requested channel are calculated
     and then latched to their respective update registers (CPRDUPDR, CDTYUPDR)
   - If the channel is not valid, nothing happens
+  - If u16Frequency_ is 0, nothing happens (the buzzer keeps its current period)
 */
 void PWMAudioSetFrequency(u32 u32Channel_, u16 u16Frequency_)
 {
   u32 u32ChannelPeriod;
   
+  if(u16Frequency_ == 0)
+  {
+    return;
+  }
+
   u32ChannelPeriod = CPRE_CLCK / u16Frequency_;
   
   if(u32Channel_ == AT91C_PWMC_CHID0)
@@ -305,10 +334,109 @@ void PWMAudioSetFrequency(u32 u32Channel_, u16 u16Frequency_)
     //AT91C_BASE_PWMC_CH1->PWMC_CDTYUPDR = u32ChannelPeriod >> 1; 
   }
 #endif  
+
+#ifdef PWM_AUDIO_TRACE
+  PWMAudioTraceLog(u32Channel_);
+#endif /* PWM_AUDIO_TRACE */
   
 } /* end PWMAudioSetFrequency() */
 
 
+/*----------------------------------------------------------------------------
+Function: PWMAudioSetNote
+
+Description:
+Loads the PWM period and duty for a note from the precomputed table.  This is
+two register stores with no division, so it is safe to call from an ISR.
+
+Requires:
+  - u32Channel_ is the channel of interest - either AT91C_PWMC_CHID0 or AT91C_PWMC_CHID1
+  - u8NoteIndex_ is a NOTE_INDEX_* value from music.h
+  - The PWM peripheral is configured with CPRE_CLCK as the channel clock
+
+Promises:
+  - The period and duty registers for the requested channel are loaded
+  - If the channel is not valid, or the note is a rest or out of range, nothing happens
+*/
+void PWMAudioSetNote(u32 u32Channel_, u8 u8NoteIndex_)
+{
+  const PwmAudioNoteType* psNote;
+  
+  if( (u8NoteIndex_ == NOTE_INDEX_REST) || (u8NoteIndex_ >= NOTE_INDEX_COUNT) )
+  {
+    return;
+  }
+  
+  psNote = &Bsp_asPwmAudioNotes[u8NoteIndex_];
+  
+  if(u32Channel_ == AT91C_PWMC_CHID0)
+  {
+    AT91C_BASE_PWMC_CH0->PWMC_CPRDR = psNote->u16Period;
+    AT91C_BASE_PWMC_CH0->PWMC_CDTYR = psNote->u16Duty;
+  }
+  
+#ifdef MPGL1 
+  else if(u32Channel_ == AT91C_PWMC_CHID1)
+  {
+    AT91C_BASE_PWMC_CH1->PWMC_CPRDR = psNote->u16Period;
+    AT91C_BASE_PWMC_CH1->PWMC_CDTYR = psNote->u16Duty;
+  }
+#endif  
+
+#ifdef PWM_AUDIO_TRACE
+  PWMAudioTraceLog(u32Channel_);
+#endif /* PWM_AUDIO_TRACE */
+  
+} /* end PWMAudioSetNote() */
+
+
+/*----------------------------------------------------------------------------
+Function: PWMAudioSetNoteDuty
+
+Description:
+Changes the duty cycle of a note that is already loaded to period >> u8DutyShift_,
+used to step the volume of a note up or down.  One table read, one shift and one
+register store.
+
+Requires:
+  - u32Channel_ is the channel of interest - either AT91C_PWMC_CHID0 or AT91C_PWMC_CHID1
+  - u8NoteIndex_ is the NOTE_INDEX_* value currently loaded on the channel
+  - u8DutyShift_ is 1 (50% duty, loudest) or more
+
+Promises:
+  - The duty register for the requested channel is loaded
+  - If the channel is not valid, or the note is a rest or out of range, nothing happens
+*/
+void PWMAudioSetNoteDuty(u32 u32Channel_, u8 u8NoteIndex_, u8 u8DutyShift_)
+{
+  u16 u16Duty;
+  
+  if( (u8NoteIndex_ == NOTE_INDEX_REST) || (u8NoteIndex_ >= NOTE_INDEX_COUNT) )
+  {
+    return;
+  }
+  
+  u16Duty = Bsp_asPwmAudioNotes[u8NoteIndex_].u16Period >> u8DutyShift_;
+  
+  if(u32Channel_ == AT91C_PWMC_CHID0)
+  {
+    AT91C_BASE_PWMC_CH0->PWMC_CDTYR = u16Duty;
+  }
+  
+#ifdef MPGL1 
+  else if(u32Channel_ == AT91C_PWMC_CHID1)
+  {
+    AT91C_BASE_PWMC_CH1->PWMC_CDTYR = u16Duty;
+  }
+#endif  
+
+#ifdef PWM_AUDIO_TRACE
+  PWMAudioTraceLog(u32Channel_);
+#endif /* PWM_AUDIO_TRACE */
+  
+} /* end PWMAudioSetNoteDuty() */
+
+
 /*----------------------------------------------------------------------------
 Function: PWMAudioOn
 
@@ -327,6 +455,10 @@ void PWMAudioOn(u32 u32Channel_)
   /* Enable the channel */
   AT91C_BASE_PWMC->PWMC_ENA = u32Channel_;  
 
+#ifdef PWM_AUDIO_TRACE
+  PWMAudioTraceLog(u32Channel_);
+#endif /* PWM_AUDIO_TRACE */
+
 } /* end PWMAudioOn() */
 
 
@@ -347,9 +479,295 @@ void PWMAudioOff(u32 u32Channel_)
   /* Enable the channel */
   AT91C_BASE_PWMC->PWMC_DIS = u32Channel_;  
 
+#ifdef PWM_AUDIO_TRACE
+  PWMAudioTraceLog(u32Channel_);
+#endif /* PWM_AUDIO_TRACE */
+
 } /* end PWMAudioOff() */
 
 
+#ifdef PWM_AUDIO_TRACE
+/*----------------------------------------------------------------------------
+Function: PWMAudioTraceClear
+
+Description:
+Empties the buzzer PWM trace so logging starts again from the next change.
+
+Requires:
+  -
+
+Promises:
+  - The trace is empty
+*/
+void PWMAudioTraceClear(void)
+{
+  Bsp_u16PwmAudioTraceCount = 0;
+
+} /* end PWMAudioTraceClear() */
+
+
+/*----------------------------------------------------------------------------
+Function: PWMAudioTraceCount
+
+Description:
+Returns the number of PWM changes in the trace.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 to PWM_AUDIO_TRACE_SIZE
+*/
+u16 PWMAudioTraceCount(void)
+{
+  return(Bsp_u16PwmAudioTraceCount);
+
+} /* end PWMAudioTraceCount() */
+
+
+/*----------------------------------------------------------------------------
+Function: PWMAudioTraceRead
+
+Description:
+Copies one entry of the buzzer PWM trace.
+
+Requires:
+  - u16Index_ is 0 for the oldest entry
+  - psEntry_ points to space for the entry
+
+Promises:
+  - Returns TRUE with the entry in *psEntry_
+  - Returns FALSE if u16Index_ is not in the trace
+*/
+bool PWMAudioTraceRead(u16 u16Index_, PwmAudioTraceType* psEntry_)
+{
+  if(u16Index_ >= Bsp_u16PwmAudioTraceCount)
+  {
+    return(FALSE);
+  }
+
+  *psEntry_ = Bsp_asPwmAudioTrace[u16Index_];
+  return(TRUE);
+
+} /* end PWMAudioTraceRead() */
+#endif /* PWM_AUDIO_TRACE */
+
+
+/*----------------------------------------------------------------------------
+Function: TimerSequencerSetup
+
+Description:
+Configures a timer counter channel as a note sequencer time base: waveform mode
+counting MCK/128 ticks up to RC, with an interrupt on every RC compare.
+
+Requires:
+  - u32TimerId_ is AT91C_ID_TC0 or AT91C_ID_TC1
+  - The TC peripheral clock is enabled in PMC_PCER
+
+Promises:
+  - The timer is configured and stopped with the RC compare interrupt enabled
+    in the peripheral and NVIC
+  - If the timer is not valid, nothing happens
+*/
+void TimerSequencerSetup(u32 u32TimerId_)
+{
+  AT91PS_TC psTimer = TimerSequencerGetBase(u32TimerId_);
+
+  if(psTimer == NULL)
+  {
+    return;
+  }
+  
+  psTimer->TC_CCR = AT91C_TC_CLKDIS;
+  psTimer->TC_CMR = TC_SEQUENCER_CMR_INIT;
+  psTimer->TC_IDR = TC_IDR_ALL;
+  psTimer->TC_IER = AT91C_TC_CPCS;
+  (void)psTimer->TC_SR;
+
+  NVIC_ClearPendingIRQ( (IRQn_Type)u32TimerId_ );
+  NVIC_EnableIRQ( (IRQn_Type)u32TimerId_ );
+
+} /* end TimerSequencerSetup() */
+
+
+/*----------------------------------------------------------------------------
+Function: TimerSequencerStart
+
+Description:
+Loads the first period and starts a sequencer timer.  The timer interrupt is
+expected to load RC with each following period.
+
+Requires:
+  - TimerSequencerSetup() has been called for u32TimerId_
+  - u16Ticks_ is the time in TC_SEQUENCER_TICKS_PER_MS units to the first interrupt (> 0)
+
+Promises:
+  - Counter is reset and running; the RC compare interrupt fires in u16Ticks_
+*/
+void TimerSequencerStart(u32 u32TimerId_, u16 u16Ticks_)
+{
+  AT91PS_TC psTimer = TimerSequencerGetBase(u32TimerId_);
+
+  if(psTimer == NULL)
+  {
+    return;
+  }
+  
+  psTimer->TC_RC  = u16Ticks_;
+  psTimer->TC_CCR = AT91C_TC_CLKEN | AT91C_TC_SWTRG;
+
+} /* end TimerSequencerStart() */
+
+
+/*----------------------------------------------------------------------------
+Function: TimerSequencerStop
+
+Description:
+Stops a sequencer timer and discards any pending interrupt.
+
+Requires:
+  - u32TimerId_ is AT91C_ID_TC0 or AT91C_ID_TC1
+
+Promises:
+  - Counter clock is disabled
+  - Returns the number of ticks that were left in the current period
+*/
+u16 TimerSequencerStop(u32 u32TimerId_)
+{
+  AT91PS_TC psTimer = TimerSequencerGetBase(u32TimerId_);
+  u32 u32Count;
+  u32 u32Period;
+
+  if(psTimer == NULL)
+  {
+    return(0);
+  }
+  
+  psTimer->TC_CCR = AT91C_TC_CLKDIS;
+  u32Count  = psTimer->TC_CV;
+  u32Period = psTimer->TC_RC;
+  (void)psTimer->TC_SR;
+  NVIC_ClearPendingIRQ( (IRQn_Type)u32TimerId_ );
+
+  if(u32Count >= u32Period)
+  {
+    return(0);
+  }
+  
+  return( (u16)(u32Period - u32Count) );
+
+} /* end TimerSequencerStop() */
+
+
+/*----------------------------------------------------------------------------
+Function: TimerSequencerSetPeriod
+
+Description:
+Sets the period that the running sequencer timer counts after its current RC
+compare.  Meant to be called from the timer interrupt right after the compare,
+so the new value applies to the period that just started.
+
+Requires:
+  - u32TimerId_ is AT91C_ID_TC0 or AT91C_ID_TC1
+  - u16Ticks_ > 0
+
+Promises:
+  - TC_RC is loaded with u16Ticks_
+*/
+void TimerSequencerSetPeriod(u32 u32TimerId_, u16 u16Ticks_)
+{
+  AT91PS_TC psTimer = TimerSequencerGetBase(u32TimerId_);
+
+  if(psTimer != NULL)
+  {
+    psTimer->TC_RC = u16Ticks_;
+  }
+
+} /* end TimerSequencerSetPeriod() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private Functions */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------
+Function: TimerSequencerGetBase
+
+Description:
+Maps a sequencer timer ID to its register block.
+
+Requires:
+  -
+
+Promises:
+  - Returns the TC channel base for AT91C_ID_TC0 or AT91C_ID_TC1, otherwise NULL
+*/
+static AT91PS_TC TimerSequencerGetBase(u32 u32TimerId_)
+{
+  if(u32TimerId_ == AT91C_ID_TC0)
+  {
+    return(AT91C_BASE_TC0);
+  }
+  
+  if(u32TimerId_ == AT91C_ID_TC1)
+  {
+    return(AT91C_BASE_TC1);
+  }
+  
+  return(NULL);
+
+} /* end TimerSequencerGetBase() */
+
+
+#ifdef PWM_AUDIO_TRACE
+/*----------------------------------------------------------------------------
+Function: PWMAudioTraceLog
+
+Description:
+Adds the current period, duty and enable state of a buzzer channel to the trace
+with a microsecond time stamp (the 1ms tick plus the SysTick count into the ms).
+Called from the main loop and from the music sequencer ISR, so the entry is
+claimed with interrupts off.
+
+Requires:
+  - u32Channel_ is AT91C_PWMC_CHID0 or AT91C_PWMC_CHID1
+
+Promises:
+  - One entry is added unless the trace is full
+*/
+static void PWMAudioTraceLog(u32 u32Channel_)
+{
+  PwmAudioTraceType* psEntry;
+  AT91PS_PWMC_CH pChannel = AT91C_BASE_PWMC_CH0;
+  u32 u32PriMask = __get_PRIMASK();
+
+  __disable_irq();
+  if(Bsp_u16PwmAudioTraceCount >= PWM_AUDIO_TRACE_SIZE)
+  {
+    __set_PRIMASK(u32PriMask);
+    return;
+  }
+
+  psEntry = &Bsp_asPwmAudioTrace[Bsp_u16PwmAudioTraceCount++];
+  psEntry->u32Time = G_u32SystemTime1ms;
+  psEntry->u16SysTicks = (u16)(SYSTICK_COUNT - 1 - AT91C_BASE_NVIC->NVIC_STICKCVR);
+  __set_PRIMASK(u32PriMask);
+
+  psEntry->u8Channel = 0;
+  if(u32Channel_ == AT91C_PWMC_CHID1)
+  {
+    pChannel = AT91C_BASE_PWMC_CH1;
+    psEntry->u8Channel = 1;
+  }
+
+  psEntry->u8Enabled = (AT91C_BASE_PWMC->PWMC_SR & u32Channel_) ? 1 : 0;
+  psEntry->u16Period = (u16)pChannel->PWMC_CPRDR;
+  psEntry->u16Duty = (u16)pChannel->PWMC_CDTYR;
+
+} /* end PWMAudioTraceLog() */
+#endif /* PWM_AUDIO_TRACE */
+
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* End of File */
 /*--------------------------------------------------------------------------------------------------------------------*/
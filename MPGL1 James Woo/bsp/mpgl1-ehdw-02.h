@@ -11,6 +11,21 @@
 /***********************************************************************************************************************
 Type Definitions
 ***********************************************************************************************************************/
+typedef struct
+{
+  u16 u16Period;                 /* PWMC_CPRDR value */
+  u16 u16Duty;                   /* PWMC_CDTYR value */
+} PwmAudioNoteType;
+
+typedef struct
+{
+  u32 u32Time;                   /* G_u32SystemTime1ms when the change was made */
+  u16 u16SysTicks;               /* SysTick counts into that ms (SYSTICK_TICKS_PER_US per us) */
+  u8 u8Channel;                  /* PWM channel number (0 or 1) */
+  u8 u8Enabled;                  /* 1 if the channel is enabled after the change */
+  u16 u16Period;                 /* PWMC_CPRDR after the change */
+  u16 u16Duty;                   /* PWMC_CDTYR after the change */
+} PwmAudioTraceType;
 
 /***********************************************************************************************************************
 * Constants
@@ -24,6 +39,7 @@ Type Definitions
 #define PERIPHERAL_DIVIDER        (u32)1
 #define PCLK_VALUE                CCLK_VALUE / PERIPHERAL_DIVIDER           /* 48 MHz */
 #define SYSTICK_DIVIDER           (u32)8
+#define SYSTICK_TICKS_PER_US      (u32)(CCLK_VALUE / SYSTICK_DIVIDER / 1000000)   /* 6 */
 
 
 #define SYSTICK_COUNT             (u32)(0.001 * (CCLK_VALUE / SYSTICK_DIVIDER) )
@@ -39,6 +55,8 @@ Should be 6000 for 48MHz CCLK. */
 #define BUZZER_0                  (u32)AT91C_PWMC_CHID0
 #define BUZZER_1                  (u32)AT91C_PWMC_CHID1
 
+#define PWM_AUDIO_TRACE_SIZE      (u16)256          /* PWM changes kept by the trace (PWM_AUDIO_TRACE) */
+
 
 /***********************************************************************************************************************
 * Macros
@@ -58,8 +76,21 @@ void SystemStatusReport(void);
 void PWMSetupAudio(void);
 void PWMAudioSetFrequency(u32 u32Channel_, u16 u16Frequency_);
 void PWMAudioOn(u32 u32Channel_);
+void PWMAudioSetNote(u32 u32Channel_, u8 u8NoteIndex_);
+void PWMAudioSetNoteDuty(u32 u32Channel_, u8 u8NoteIndex_, u8 u8DutyShift_);
 void PWMAudioOff(u32 u32Channel_);
 
+#ifdef PWM_AUDIO_TRACE
+void PWMAudioTraceClear(void);
+u16 PWMAudioTraceCount(void);
+bool PWMAudioTraceRead(u16 u16Index_, PwmAudioTraceType* psEntry_);
+#endif /* PWM_AUDIO_TRACE */
+
+void TimerSequencerSetup(u32 u32TimerId_);
+void TimerSequencerStart(u32 u32TimerId_, u16 u16Ticks_);
+u16 TimerSequencerStop(u32 u32TimerId_);
+void TimerSequencerSetPeriod(u32 u32TimerId_, u16 u16Ticks_);
+
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected Functions */
@@ -70,6 +101,15 @@ void SystemSleep(void);
 void WatchDogSetup(void);
 void GpioSetup(void);
 
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private Functions */
+/*--------------------------------------------------------------------------------------------------------------------*/
+static AT91PS_TC TimerSequencerGetBase(u32 u32TimerId_);
+#ifdef PWM_AUDIO_TRACE
+static void PWMAudioTraceLog(u32 u32Channel_);
+#endif /* PWM_AUDIO_TRACE */
+
 /***********************************************************************************************************************
 Perihperal Setup Initializations
 
@@ -78,6 +118,7 @@ Bookmarks:
 !!!!! GPIO pin names
 ##### GPIO initial setup values
 $$$$$ PWM setup values
+%%%%% Timer counter setup values
 ***********************************************************************************************************************/
 
 /***********************************************************************************************************************
@@ -2228,6 +2269,66 @@ In general, the period is 6000000 / frequency and duty is always period / 2.
 #define PWM_CDTY0_INIT  (u32)(PWM_CPRD0_INIT << 1)
 #define PWM_CDTY1_INIT  (u32)(PWM_CPRD1_INIT << 1)
 
+/* Register values for a note are computed by the compiler so a note change needs no division:
+the period is CPRE_CLCK / frequency rounded to the nearest tick and the duty is half the period. */
+#define PWM_AUDIO_PERIOD(FREQUENCY)   (u16)( ((CPRE_CLCK) + ((FREQUENCY) / 2)) / (FREQUENCY) )
+#define PWM_AUDIO_NOTE(FREQUENCY)     {PWM_AUDIO_PERIOD(FREQUENCY), (u16)(PWM_AUDIO_PERIOD(FREQUENCY) >> 1)}
+
+
+/***********************************************************************************************************************
+%%%%% Timer counter setup values
+***********************************************************************************************************************/
+#define TC_SEQUENCER_CMR_INIT (u32)0x0000C003
+/*
+    31 [0] BSWTRG no effect on TIOB
+    30 [0] "
+    29 [0] BEEVT no effect on TIOB
+    28 [0] "
+
+    27 [0] BCPC no effect on TIOB
+    26 [0] "
+    25 [0] BCPB no effect on TIOB
+    24 [0] "
+
+    23 [0] ASWTRG no effect on TIOA
+    22 [0] "
+    21 [0] AEEVT no effect on TIOA
+    20 [0] "
+
+    19 [0] ACPC no effect on TIOA
+    18 [0] "
+    17 [0] ACPA no effect on TIOA
+    16 [0] "
+
+    15 [1] WAVE waveform mode
+    14 [1] WAVSEL UP mode with automatic trigger on RC compare
+    13 [0] "
+    12 [0] ENETRG external event has no effect
+
+    11 [0] EEVT XC0 (unused)
+    10 [0] "
+    09 [0] EEVTEDG none
+    08 [0] "
+
+    07 [0] CPCDIS clock not disabled on RC compare
+    06 [0] CPCSTOP clock not stopped on RC compare
+    05 [0] BURST not gated
+    04 [0] "
+
+    03 [0] CLKI rising edge
+    02 [0] TCCLKS TIMER_CLOCK4 = MCK/128
+    01 [1] "
+    00 [1] "
+*/
+
+#define TC_IDR_ALL                (u32)0x000000FF
+
+/* With MCK/128 the timer counts 375 ticks per ms, so 16-bit RC covers up to 174ms per period.
+Longer periods are split into several RC compares by the interrupt handler. */
+#define TC_SEQUENCER_CLOCK_SCALE  (u32)128
+#define TC_SEQUENCER_TICKS_PER_MS (u32)((CCLK_VALUE) / TC_SEQUENCER_CLOCK_SCALE / 1000)
+#define TC_SEQUENCER_MAX_TICKS    (u32)0xFFFF
+
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* End of File */
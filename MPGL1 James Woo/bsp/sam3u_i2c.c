@@ -15,6 +15,9 @@ bool TWI0ReadByte(u8 u8SlaveAddress_, u8* pu8RxBuffer_);
 bool TWI0ReadData(u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_);
 u32 TWIWriteByte(TWIPeripheralType* psTWIPeripheral_, u8 u8Byte_, TWIStopType Send_);
 u32 TWIWriteData(TWIPeripheralType* psTWIPeripheral_, u32 u32Size_, u8* u8Data_, TWIStopType Send_);
+u32 TWI0WriteDataNoCopy(u8 u8SlaveAddress_, u32 u32Size_, const u8* pu8Data_, TWIStopType Send_, 
+                        MessageReleaseType pfRelease_);
+u32 TWI0WriteSegments(u8 u8SlaveAddress_, const MessageSegmentType* pasSegments_, u8 u8Segments_, TWIStopType Send_);
 
 All of these functions return a value that should be checked to ensure the operation will be completed
 
@@ -26,6 +29,10 @@ WriteByte and WriteData have the option to hold the lines low as it waits for mo
 to be queue. If a stop condition is not sent only Writes can follow until a stop condition is
 requested (as the current transmission isn't complete).
 
+The state machine copies the message being sent into a small ring (TWI_TX_RING_SIZE) that the TXRDY interrupt 
+empties, so the interrupt never touches the message queue or the message cursor.  The master holds the clock low
+while THR is empty, so a long message waits on the bus for the next state machine pass to top the ring up.
+
 !!!!! ISSUES: 
     - No Debugging of Read functionality
 
@@ -60,8 +67,12 @@ static u32 TWI_u32Flags;                          /* Application flags for TWI *
 static TWIPeripheralType TWI_Peripheral0;         /* TWI0 peripheral object */
 static TWIPeripheralType* TWI0;
 
-static u32 TWI_u32CurrentBytesRemaining;                        /* Down counter for number of bytes being clocked out */
-static u8* TWI_pu8CurrentTxData;                                /* Pointer to current message being clocked out */
+static u32 TWI_u32CurrentBytesRemaining;                        /* Tx: segment bytes not in the ring; Rx: to receive */
+static u8* TWI_pu8CurrentTxData;                                /* Next message byte to put in the Tx ring */
+static MessageType* TWI_psCurrentTxSegment;                     /* Segment of the current message being clocked out */
+static RingBufferType TWI_sTxRing;                              /* Bytes from the state machine to the TXRDY ISR */
+static u8 TWI_au8TxRingBuffer[TWI_TX_RING_SIZE];                /* Storage for TWI_sTxRing */
+static volatile bool TWI_bTxLastLoaded;                         /* The whole current message is in the Tx ring */
 static TWIMessageQueueType TWI_MessageBuffer[TX_QUEUE_SIZE];    /* A circular buffer that stores queued msgs stop condition */
 static u8 TWI_MessageBufferNextIndex;                           /* A pointer to the next position to place a message */
 static u8 TWI_MessageBufferCurIndex;                            /* A pointer to the current message that is being processed */
@@ -188,7 +199,7 @@ Requires:
   - Initialization of the task
 
 Promises:
-  - Creates a 1-byte message at TWI0->pTransmitBuffer that will be sent by the TWI application
+  - Creates a 1-byte message on TWI0->sTransmitQueue that will be sent by the TWI application
     when it is available.
   - Returns the message token assigned to the message
 */
@@ -202,41 +213,16 @@ u32 TWI0WriteByte(u8 u8SlaveAddress_, u8 u8Byte_, TWIStopType Send_)
     /* TWI Message Task Queue Full */
     return 0;
   }
-  else
-  {
-    /* Queue Message in message system */
-    u32Token = QueueMessage(1, &u8Data, &TWI0->pTransmitBuffer);
-    if(u32Token)
-    {
-      /* Queue Relevant data for TWI register setup */
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].Direction     = WRITE;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].u32Size       = 1;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].u8Address     = u8SlaveAddress_;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].Stop          = Send_;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].u8Attempts    = 0;
-      
-      /* Not used by Transmit */
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].pu8RxBuffer = NULL;
-      
-      /* Update array pointers and size */
-      TWI_MessageBufferNextIndex++;
-      TWI_MessageQueueLength++;
-      if(TWI_MessageBufferNextIndex == TX_QUEUE_SIZE)
-      {
-        TWI_MessageBufferNextIndex = 0;
-      }
 
-      /* If the system is initializing, we want to manually cycle the TWI task through one iteration
-      to send the message */
-      if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
-      {
-        TWIManualMode();
-      }
-    }
-    
-    return(u32Token);
+  /* Queue Message in message system */
+  u32Token = QueueMessage(1, &u8Data, &TWI0->sTransmitQueue);
+  if(u32Token)
+  {
+    TWI0QueueWriteEntry(u8SlaveAddress_, Send_);
   }
   
+  return(u32Token);
+  
 } /* end TWIWriteByte() */
 
 
@@ -252,7 +238,7 @@ Requires:
   - u8Data_ points to the first byte of the data array
 
 Promises:
-  - adds the data message at TWI_Peripheral0->pTransmitBuffer buffer that will be sent by the TWI application
+  - adds the data message on TWI_Peripheral0->sTransmitQueue that will be sent by the TWI application
     when it is available.
   - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
     G_u32MessagingFlags can be checked for the reason
@@ -263,44 +249,100 @@ u32 TWI0WriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* u8Data_, TWIStopType Sen
     
   if(TWI_MessageQueueLength == TX_QUEUE_SIZE)
   {
-    /* Queue Message in message system */
+    /* TWI Message Task Queue Full */
     return 0;
   }
-  else
+
+  /* Queue Message in message system */
+  u32Token = QueueMessage(u32Size_, u8Data_, &TWI0->sTransmitQueue);
+  if(u32Token)
   {
-    /* Queue Message in message system */
-    u32Token = QueueMessage(u32Size_, u8Data_, &TWI0->pTransmitBuffer);
-    if(u32Token)
-    {
-      /* Queue Relevant data for TWI register setup */
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].Direction     = WRITE;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].u32Size       = 1;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].u8Address     = u8SlaveAddress_;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].Stop          = Send_;
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].u8Attempts    = 0;
-      
-      /* Not used by Transmit */
-      TWI_MessageBuffer[TWI_MessageBufferNextIndex].pu8RxBuffer = NULL;
-      
-      /* Update array pointers and size */
-      TWI_MessageBufferNextIndex++;
-      TWI_MessageQueueLength++;
-      if(TWI_MessageBufferNextIndex == TX_QUEUE_SIZE)
-      {
-        TWI_MessageBufferNextIndex = 0;
-      }
+    TWI0QueueWriteEntry(u8SlaveAddress_, Send_);
+  }
+  
+  return(u32Token);
+  
+} /* end TWIWriteData() */
 
-      /* If the system is initializing, manually cycle the TWI task through one iteration to send the message */
-      if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
-      {
-        TWIManualMode();
-      }
-    }
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: TWI0WriteDataNoCopy
+
+Description:
+Queues a data array for transfer on the TWI0 peripheral without copying it into the message pool.  The data goes
+out as one message whatever its length.
+
+Requires:
+  - u32Size_ is the number of bytes in the data array
+  - pu8Data_ points to the first byte of the data array which is const or stays unchanged until pfRelease_ is 
+    called (see QueueMessageNoCopy())
+  - pfRelease_ is called when the TWI is done with the data, or NULL
+
+Promises:
+  - adds the data message on TWI_Peripheral0->sTransmitQueue that will be sent by the TWI application
+    when it is available.
+  - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
+    G_u32MessagingFlags can be checked for the reason
+*/
+u32 TWI0WriteDataNoCopy(u8 u8SlaveAddress_, u32 u32Size_, const u8* pu8Data_, TWIStopType Send_, 
+                        MessageReleaseType pfRelease_)
+{
+  u32 u32Token;
+    
+  if(TWI_MessageQueueLength == TX_QUEUE_SIZE)
+  {
+    /* TWI Message Task Queue Full */
+    return 0;
+  }
+
+  /* Queue Message in message system */
+  u32Token = QueueMessageNoCopy(u32Size_, pu8Data_, pfRelease_, &TWI0->sTransmitQueue);
+  if(u32Token)
+  {
+    TWI0QueueWriteEntry(u8SlaveAddress_, Send_);
+  }
   
-    return(u32Token);
+  return(u32Token);
+  
+} /* end TWI0WriteDataNoCopy() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: TWI0WriteSegments
+
+Description:
+Queues a list of data segments for transfer on the TWI0 peripheral as one write, e.g. a control byte in front of
+the data for a device.
+
+Requires:
+  - pasSegments_ points to u8Segments_ segments in the order they are sent (see QueueMessageSegments())
+
+Promises:
+  - adds the message on TWI_Peripheral0->sTransmitQueue that will be sent by the TWI application
+    when it is available.
+  - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
+    G_u32MessagingFlags can be checked for the reason
+*/
+u32 TWI0WriteSegments(u8 u8SlaveAddress_, const MessageSegmentType* pasSegments_, u8 u8Segments_, TWIStopType Send_)
+{
+  u32 u32Token;
+    
+  if(TWI_MessageQueueLength == TX_QUEUE_SIZE)
+  {
+    /* TWI Message Task Queue Full */
+    return 0;
+  }
+
+  /* Queue Message in message system */
+  u32Token = QueueMessageSegments(pasSegments_, u8Segments_, MSG_PRIORITY_BULK, &TWI0->sTransmitQueue);
+  if(u32Token)
+  {
+    TWI0QueueWriteEntry(u8SlaveAddress_, Send_);
   }
   
-} /* end TWIWriteData() */
+  return(u32Token);
+  
+} /* end TWI0WriteSegments() */
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected Functions */
@@ -333,7 +375,12 @@ void TWIInitialize(void)
   
   /* Initialize the TWI peripheral structures */
   TWI_Peripheral0.pBaseAddress    = AT91C_BASE_TWI0;
-  TWI_Peripheral0.pTransmitBuffer = NULL;
+  TWI_Peripheral0.sTransmitQueue.psHead = NULL;
+  TWI_Peripheral0.sTransmitQueue.psTail = NULL;
+  TWI_Peripheral0.sTransmitQueue.psLastUrgent = NULL;
+  TWI_Peripheral0.sTransmitQueue.bCoalesce = FALSE;  /* Each message has its own entry in TWI_MessageBuffer */
+  TWI_Peripheral0.sTransmitQueue.bExpire = FALSE;
+  MessagingTrackQueue(&TWI_Peripheral0.sTransmitQueue, (const u8*)"TWI0");
   TWI_Peripheral0.pu8RxBuffer     = NULL;
   TWI_Peripheral0.u32Flags        = 0;
 
@@ -355,6 +402,9 @@ void TWIInitialize(void)
 
   TWI_u32CurrentBytesRemaining   = 0;
   TWI_pu8CurrentTxData           = NULL;
+  TWI_psCurrentTxSegment         = NULL;
+  TWI_bTxLastLoaded              = FALSE;
+  RingBufferInitialize(&TWI_sTxRing, &TWI_au8TxRingBuffer[0], TWI_TX_RING_SIZE);
 
   /* Set application pointer */
   G_TWIStateMachine = TWISM_Idle;
@@ -366,54 +416,152 @@ void TWIInitialize(void)
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------------------------------------------------
-Function: TWIFillTxBuffer
+Function: TWI0QueueWriteEntry
+
+Description:
+Adds the TWI register setup of a write to TWI_MessageBuffer.  Every TWI0 writer calls it once its message is on
+TWI0->sTransmitQueue, so the entries and the messages stay in step.
+
+Requires:
+  - TWI_MessageBuffer is not full
+  - The message of the write has just been queued on TWI0->sTransmitQueue
+
+Promises:
+  - The entry is added at TWI_MessageBufferNextIndex; the index and TWI_MessageQueueLength are updated
+  - If the system is initializing, the TWI task is cycled manually to send the message
+*/
+static void TWI0QueueWriteEntry(u8 u8SlaveAddress_, TWIStopType Send_)
+{
+  /* Queue Relevant data for TWI register setup */
+  TWI_MessageBuffer[TWI_MessageBufferNextIndex].Direction     = WRITE;
+  TWI_MessageBuffer[TWI_MessageBufferNextIndex].u32Size       = 1;
+  TWI_MessageBuffer[TWI_MessageBufferNextIndex].u8Address     = u8SlaveAddress_;
+  TWI_MessageBuffer[TWI_MessageBufferNextIndex].Stop          = Send_;
+  TWI_MessageBuffer[TWI_MessageBufferNextIndex].u8Attempts    = 0;
+  
+  /* Not used by Transmit */
+  TWI_MessageBuffer[TWI_MessageBufferNextIndex].pu8RxBuffer = NULL;
+  
+  /* Update array pointers and size */
+  TWI_MessageBufferNextIndex++;
+  TWI_MessageQueueLength++;
+  if(TWI_MessageBufferNextIndex == TX_QUEUE_SIZE)
+  {
+    TWI_MessageBufferNextIndex = 0;
+  }
+
+  /* If the system is initializing, manually cycle the TWI task through one iteration to send the message */
+  if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+  {
+    TWIManualMode();
+  }
+  
+} /* end TWI0QueueWriteEntry() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: TWI0LoadTxRing
+
+Description:
+Copies as much of the message that is sending as fits into the transmit ring and makes sure the TXRDY interrupt is on
+to empty it.  This is the only producer of TWI_sTxRing, so it must only be called from the state machine.
+
+Requires:
+  - TWI_pu8CurrentTxData points to the next byte in the message that is not yet in the ring
+  - TWI_psCurrentTxSegment is the message segment that TWI_pu8CurrentTxData is in
+  - TWI_u32CurrentBytesRemaining has an accurate count of the bytes in the segment not yet in the ring
+  - TWI_bTxLastLoaded is FALSE from the start of the message until this function sets it
+
+Promises:
+  - Message bytes are added to TWI_sTxRing until it is full or the whole message is in it; the cursor globals are
+    advanced past them (on through the segments of a scatter-gather message)
+  - Once the whole message is in the ring, TWI_bTxLastLoaded is set
+  - The TXRDY interrupt is enabled if bytes or the end of the message were added
+*/
+static void TWI0LoadTxRing(void)
+{
+  u32 u32Written;
+  u32 u32Loaded = 0;
+  
+  if(TWI_bTxLastLoaded)
+  {
+    return;
+  }
+  
+  do
+  {
+    u32Written = RingBufferWrite(&TWI_sTxRing, TWI_pu8CurrentTxData, TWI_u32CurrentBytesRemaining);
+    TWI_pu8CurrentTxData += u32Written;
+    TWI_u32CurrentBytesRemaining -= u32Written;
+    u32Loaded += u32Written;
+
+    /* Walk on to the next segment of a scatter-gather message */
+    if( (TWI_u32CurrentBytesRemaining == 0) && TWI_psCurrentTxSegment->bMoreSegments )
+    {
+      TWI_psCurrentTxSegment = TWI_psCurrentTxSegment->psNextMessage;
+      TWI_u32CurrentBytesRemaining = TWI_psCurrentTxSegment->u32Size;
+      TWI_pu8CurrentTxData = TWI_psCurrentTxSegment->pu8Message;
+      u32Written = 1;                                           /* Go on into the new segment */
+    }
+  } while( (u32Written != 0) && (TWI_u32CurrentBytesRemaining != 0) );
+  
+  if( (TWI_u32CurrentBytesRemaining == 0) && !TWI_psCurrentTxSegment->bMoreSegments )
+  {
+    TWI_bTxLastLoaded = TRUE;
+    u32Loaded++;
+  }
+  
+  /* The bytes and the end flag are published before the interrupt is enabled, so an ISR that found the ring empty
+  and switched itself off always runs again to see them */
+  if(u32Loaded != 0)
+  {
+    TWI0->pBaseAddress->TWI_IER = AT91C_TWI_TXRDY_MASTER;
+  }
+  
+} /* end TWI0LoadTxRing() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: TWI0FillTxBuffer
 
 Description:
-Fills the TWI peripheral buffer with bytes from the current messsage that is sending.  
-This function can be called from the TWI ISR!
+Fills the TWI peripheral buffer with bytes from the transmit ring.  This is the only consumer of TWI_sTxRing, so it
+must only be called from the TWI ISR.
 Note: if the implemented processor does not have a FIFO, this function can still be used but will only ever
 add one byte to the transmitter.
 
 Requires:
   - The TxBuffer is empty
-  - TWI_pu8CurrentTxData points to the next byte in the message to be sent
-  - TWI_u32CurrentBytesRemaining has an accurate count of the bytes remaining in the message data to be sent
-  - Transmit interrupts are off
 
 Promises:
-  - Data from *TWI_pu8CurrentTxData is added to the TWI peripheral Tx FIFO until the FIFO is full or there
-    is no more data to send.
+  - Bytes from TWI_sTxRing are added to the TWI peripheral Tx FIFO until the FIFO is full or the ring is empty
+  - If the ring is empty, the TXRDY interrupt is disabled (TWI0LoadTxRing() enables it again); if the whole
+    message has also been loaded and it ends with a stop, the stop is requested
 */
 static void TWI0FillTxBuffer(void)
 {
   u8 u8ByteCount = TWI_TX_FIFO_SIZE;
+  u8 u8Byte;
   
-  /* Use the active global variables to fill up the transmit FIFO */
-  while( (u8ByteCount != 0) && (TWI_u32CurrentBytesRemaining != 0) )
+  /* Move bytes from the ring to the transmit FIFO */
+  while( (u8ByteCount != 0) && RingBufferRead(&TWI_sTxRing, &u8Byte, 1) )
   {
-    TWI0->pBaseAddress->TWI_THR = *TWI_pu8CurrentTxData;
-    TWI_pu8CurrentTxData++;
-    TWI_u32CurrentBytesRemaining--;
+    TWI0->pBaseAddress->TWI_THR = u8Byte;
     u8ByteCount--;
   }
   
-  /* If there are no remaining bytes to load to the TX FIFO, disable the TWI transmit 
-  FIFO empty interrupt */
-  if(TWI_u32CurrentBytesRemaining == 0)
+  /* If there are no bytes left in the ring, disable the TWI transmit FIFO empty interrupt: the clock is held low
+  until the state machine adds more, or the stop ends the message */
+  if(RingBufferUsed(&TWI_sTxRing) == 0)
   {
     TWI0->pBaseAddress->TWI_IDR = AT91C_TWI_TXRDY_MASTER;
-    if(TWI_MessageBuffer[TWI_MessageBufferCurIndex].Stop == STOP)
+    if(TWI_bTxLastLoaded && (TWI_MessageBuffer[TWI_MessageBufferCurIndex].Stop == STOP))
     {
       TWI0->pBaseAddress->TWI_CR |= _TWI_CR_STOP_BIT;
     }
   }
-  /* Otherwise make sure transmit interrupts are enabled */
-  else
-  {
-    TWI0->pBaseAddress->TWI_IER = AT91C_TWI_TXRDY_MASTER;
-  }
   
-} /* end TWIFillTxBuffer() */
+} /* end TWI0FillTxBuffer() */
 
 
 /*----------------------------------------------------------------------------------------------------------------------
@@ -515,16 +663,21 @@ void TWISM_Idle(void)
       /* insert new address */
       TWI0->pBaseAddress->TWI_MMR |= ((TWI_MessageBuffer[TWI_MessageBufferCurIndex].u8Address << _TWI_MMR_ADDRESS_SHIFT));
       
-      /* Set up to transmit the message */
-      TWI_u32CurrentBytesRemaining = TWI0->pTransmitBuffer->u32Size;
-      TWI_pu8CurrentTxData = TWI0->pTransmitBuffer->pu8Message;
-      TWI0FillTxBuffer();    
+      /* Set up to transmit the message: the ISR takes the bytes from the ring */
+      TWI_u32CurrentBytesRemaining = TWI0->sTransmitQueue.psHead->u32Size;
+      TWI_pu8CurrentTxData = TWI0->sTransmitQueue.psHead->pu8Message;
+      TWI_psCurrentTxSegment = TWI0->sTransmitQueue.psHead;
+      TWI_bTxLastLoaded = FALSE;
+      
+      /* The flag goes up first: the ISR only sends while it is set */
+      TWI0->u32Flags |= (_TWI_TRANSMITTING | _TWI_TRANS_NOT_COMP);
+      TWI0LoadTxRing();
       
-      /* Update the message's status */
-      UpdateMessageStatus(TWI0->pTransmitBuffer->u32Token, SENDING);
+      /* Update the message's status; it is now owned by the driver until it is dequeued */
+      TWI0->sTransmitQueue.psHead->bStarted = TRUE;
+      UpdateMessageStatus(TWI0->sTransmitQueue.psHead->u32Token, SENDING);
   
       /* Proceed to next state to let the current message send */
-      TWI0->u32Flags |= (_TWI_TRANSMITTING | _TWI_TRANS_NOT_COMP);
       G_TWIStateMachine = TWISM_Transmitting;
     }
     else if(TWI_MessageBuffer[TWI_MessageBufferCurIndex].Direction == READ)
@@ -563,15 +716,19 @@ void TWISM_Idle(void)
 } /* end TWISM_Idle() */
         
 /*-------------------------------------------------------------------------------------------------------------------*/
-/* Transmit in progress until current bytes have reached 0.  On exit, the transmit message must be dequeued.
+/* Transmit in progress until the whole message has gone through the ring and out of the peripheral.  On exit, the 
+transmit message must be dequeued.
 */
 void TWISM_Transmitting(void)
 {
+  /* Keep the ring topped up with the rest of the message */
+  TWI0LoadTxRing();
+  
   /* Check if a stop condition has been requested */
   if(TWI_MessageBuffer[TWI_MessageBufferCurIndex].Stop == STOP)
   {
     /* Check if all of the message bytes have completely finished sending and transmission complete */
-    if( (TWI_u32CurrentBytesRemaining == 0) && 
+    if( TWI_bTxLastLoaded && (RingBufferUsed(&TWI_sTxRing) == 0) && 
         (TWI0->pBaseAddress->TWI_SR & _TWI_SR_TXRDY) &&
         (TWI0->pBaseAddress->TWI_SR & _TWI_SR_TXCOMP) )
     {
@@ -582,7 +739,7 @@ void TWISM_Transmitting(void)
   else
   {
     /* Check if all of the message bytes have completely finished sending */
-    if( (TWI_u32CurrentBytesRemaining == 0) && 
+    if( TWI_bTxLastLoaded && (RingBufferUsed(&TWI_sTxRing) == 0) && 
         (TWI0->pBaseAddress->TWI_SR & _TWI_SR_TXRDY) )
     { 
       /* Clear flag */
@@ -593,8 +750,8 @@ void TWISM_Transmitting(void)
   if( !(TWI0->u32Flags & _TWI_TRANSMITTING) )
   {
     /* Update the status queue and then dequeue the message */
-    UpdateMessageStatus(TWI0->pTransmitBuffer->u32Token, COMPLETE);
-    DeQueueMessage(&TWI0->pTransmitBuffer);
+    UpdateMessageStatus(TWI0->sTransmitQueue.psHead->u32Token, COMPLETE);
+    DeQueueMessage(&TWI0->sTransmitQueue);
     
     /* Make sure _TWI_INIT_MODE flag is clear in case this was a manual cycle */
     TWI_u32Flags &= ~_TWI_INIT_MODE;
@@ -656,6 +813,10 @@ void TWISM_Receiving(void)
 /* Handle an error */
 void TWISM_Error(void)          
 {
+  /* Stop the transmit ISR before emptying its ring: the message is sent again from the start */
+  TWI0->pBaseAddress->TWI_IDR = AT91C_TWI_TXRDY_MASTER;
+  RingBufferInitialize(&TWI_sTxRing, &TWI_au8TxRingBuffer[0], TWI_TX_RING_SIZE);
+  
   /* NACK recieved */
   if( TWI_u32Flags & _TWI_ERROR_NACK )
   {
@@ -673,8 +834,8 @@ void TWISM_Error(void)
       if( TWI0->u32Flags & _TWI_TRANSMITTING )
       {
         /* Dequeue Msg and Update Status */ 
-        UpdateMessageStatus(TWI0->pTransmitBuffer->u32Token, ABANDONED);
-        DeQueueMessage(&TWI0->pTransmitBuffer);
+        UpdateMessageStatus(TWI0->sTransmitQueue.psHead->u32Token, ABANDONED);
+        DeQueueMessage(&TWI0->sTransmitQueue);
       }
     }
 
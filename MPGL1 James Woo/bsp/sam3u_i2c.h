@@ -19,7 +19,7 @@ typedef enum {WRITE, READ} TWIMessageType;
 typedef struct 
 {
   AT91PS_TWI pBaseAddress;            /* Base address of the associated peripheral */
-  MessageType* pTransmitBuffer;       /* Pointer to the transmit message linked list */
+  MessageQueueType sTransmitQueue;    /* Messages waiting to be sent */
   u8* pu8RxBuffer;                    /* Pointer to receive buffer in user application */
   u32 u32Flags;                       /* Flags for peripheral */
 } TWIPeripheralType;
@@ -60,6 +60,7 @@ Constants / Definitions
 #define MAX_ATTEMPTS                   (u8)3             /* Number of attempts to send TWI msg */
 
 #define TWI_TX_FIFO_SIZE               (u8)1             /* Size of the peripheral's transmit FIFO in bytes */
+#define TWI_TX_RING_SIZE               (u32)64           /* Bytes passed to the transmit ISR at once (a power of 2) */
 #define TWI_RX_FIFO_SIZE               (u8)1             /* Size of the peripheral's receive FIFO in bytes */
 
 #define TWI_INIT_MSG_TIMEOUT           (u32)1000           /* Time in ms for init message to send */
@@ -91,6 +92,9 @@ bool TWI0ReadByte(u8 u8SlaveAddress_, u8* pu8RxBuffer_);
 bool TWI0ReadData(u8 u8SlaveAddress_, u8* pu8RxBuffer_, u32 u32Size_);
 u32 TWI0WriteByte(u8 u8SlaveAddress_, u8 u8Byte_, TWIStopType Send_);
 u32 TWI0WriteData(u8 u8SlaveAddress_, u32 u32Size_, u8* u8Data_, TWIStopType Send_);
+u32 TWI0WriteDataNoCopy(u8 u8SlaveAddress_, u32 u32Size_, const u8* pu8Data_, TWIStopType Send_, 
+                        MessageReleaseType pfRelease_);
+u32 TWI0WriteSegments(u8 u8SlaveAddress_, const MessageSegmentType* pasSegments_, u8 u8Segments_, TWIStopType Send_);
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected functions */
@@ -100,6 +104,8 @@ void TWIInitialize(void);
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
+static void TWI0QueueWriteEntry(u8 u8SlaveAddress_, TWIStopType Send_);
+static void TWI0LoadTxRing(void);
 static void TWI0FillTxBuffer(void);
 static void TWIManualMode(void);
 void TWI0_IRQHandler(void);
@@ -47,6 +47,9 @@ data requested from an SSP slave, call SspReadByte() for a single byte or SspRea
 bytes.  These functions will automatically queue SSP_DUMMY bytes to transmit and activate the clock
 to receive data into your application's receive buffer.
 
+4. The state machine copies the message being sent into a small ring (SSP_TX_RING_SIZE) that the transmit
+interrupt empties into the FIFO, so the interrupt never touches the message queue or the message cursor.
+
 **********************************************************************************************************************/
 
 #include "configuration.h"
@@ -78,8 +81,12 @@ static SspPeripheralType SSP_Peripheral0;        /* SSP0 peripheral object */
 static SspPeripheralType SSP_Peripheral1;        /* SSP1 peripheral object */
 
 static SspPeripheralType* SSP_psCurrentSsp;      /* Current SSP peripheral being processed */
-static u32 SSP_u32CurrentTxBytesRemaining;       /* Down counter for number of bytes being clocked out */
-static u8* SSP_pu8CurrentTxData;                 /* Pointer to current message being clocked out */
+static u32 SSP_u32CurrentTxBytesRemaining;       /* Segment bytes not yet in the Tx ring */
+static u8* SSP_pu8CurrentTxData;                 /* Pointer to the next message byte to put in the Tx ring */
+static MessageType* SSP_psCurrentTxSegment;      /* Segment of the current message being clocked out */
+static RingBufferType SSP_sTxRing;               /* Bytes passed from the state machine to the transmit ISR */
+static u8 SSP_au8TxRingBuffer[SSP_TX_RING_SIZE]; /* Storage for SSP_sTxRing */
+static bool SSP_bTxLastLoaded;                   /* The whole current message is in the Tx ring */
 
 static u8 SSP_au8Dummies[MAX_TX_MESSAGE_LENGTH]; /* Array of dummy bytes sent to receive bytes from a slave */
 
@@ -213,10 +220,10 @@ void SspRelease(SspPeripheralType* psSspPeripheral_)
   psSspPeripheral_->u32Flags        = 0;
 
   /* Empty the transmit buffer if there were leftover messages */
-  while(psSspPeripheral_->pTransmitBuffer != NULL)
+  while(psSspPeripheral_->sTransmitQueue.psHead != NULL)
   {
-    UpdateMessageStatus(psSspPeripheral_->pTransmitBuffer->u32Token, ABANDONED);
-    DeQueueMessage(&psSspPeripheral_->pTransmitBuffer);
+    UpdateMessageStatus(psSspPeripheral_->sTransmitQueue.psHead->u32Token, ABANDONED);
+    DeQueueMessage(&psSspPeripheral_->sTransmitQueue);
   }
   
   /* Ensure the SM is in the Idle state */
@@ -274,7 +281,7 @@ Requires:
   - The chip select line of the SSP device should be asserted
 
 Promises:
-  - Creates a 1-byte message at psSspPeripheral_->pTransmitBuffer that will be sent by the SSP application
+  - Creates a 1-byte message on psSspPeripheral_->sTransmitQueue that will be sent by the SSP application
     when it is available.
   - Returns the message token assigned to the message
 */
@@ -283,7 +290,7 @@ u32 SspWriteByte(SspPeripheralType* psSspPeripheral_, u8 u8Byte_)
   u32 u32Token;
   u8 u8Data = u8Byte_;
   
-  u32Token = QueueMessage(1, &u8Data, &psSspPeripheral_->pTransmitBuffer);
+  u32Token = QueueMessage(1, &u8Data, &psSspPeripheral_->sTransmitQueue);
   if(u32Token)
   {
     /* If the system is initializing, we want to manually cycle the SSP task through one iteration
@@ -313,7 +320,7 @@ Requires:
   - u8Data_ points to the first byte of the data array
 
 Promises:
-  - adds the data message at psSspPeripheral_->pTransmitBuffer that will be sent by the SSP application
+  - adds the data message on psSspPeripheral_->sTransmitQueue that will be sent by the SSP application
     when it is available.
   - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
     G_u32MessagingFlags can be checked for the reason
@@ -331,7 +338,7 @@ u32 SspWriteData(SspPeripheralType* psSspPeripheral_, u32 u32Size_, u8* pu8Data_
   /* Slice up the data to the allowable message size */
   for(u8 i = 0; i < u8FullCycles; i++)
   {
-    u32Token = QueueMessage(MAX_TX_MESSAGE_LENGTH, pu8Data_ + u32Index, &psSspPeripheral_->pTransmitBuffer);
+    u32Token = QueueMessage(MAX_TX_MESSAGE_LENGTH, pu8Data_ + u32Index, &psSspPeripheral_->sTransmitQueue);
     if(!u32Token)
     {
       return(0);
@@ -351,7 +358,7 @@ u32 SspWriteData(SspPeripheralType* psSspPeripheral_, u32 u32Size_, u8* pu8Data_
   }
 
   /* Complete the remaining bytes and assign the token to this message */  
-  u32Token = QueueMessage(u8Remainder, pu8Data_ + u32Index, &psSspPeripheral_->pTransmitBuffer);
+  u32Token = QueueMessage(u8Remainder, pu8Data_ + u32Index, &psSspPeripheral_->sTransmitQueue);
   if(u32Token)
   {
     if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
@@ -377,7 +384,7 @@ Requires:
   - 
 
 Promises:
-  - Creates a message with one SSP_DUMMY_BYTE at psSspPeripheral_->pTransmitBuffer that will be sent by the SSP application
+  - Creates a message with one SSP_DUMMY_BYTE on psSspPeripheral_->sTransmitQueue that will be sent by the SSP application
     when it is available and thus clock in a received byte to the target receive buffer.
   - Returns the Token of the transmitted dummy message used to read data.
 
@@ -402,7 +409,7 @@ Requires:
   - u32Size_ is the number of bytes in the data array
 
 Promises:
-  - Adds a dummy byte message at psSspPeripheral_->pTransmitBuffer that will be sent by the SSP application
+  - Adds a dummy byte message on psSspPeripheral_->sTransmitQueue that will be sent by the SSP application
     when it is available and thus clock in the received bytes to the designated Rx buffer.
   - Returns the message token of the dummy message used to read data
 */
@@ -435,14 +442,24 @@ void SspInitialize(void)
 {
   /* Initialize the SSP peripheral structures */
   SSP_Peripheral0.pBaseAddress    = LPC_SSP0;
-  SSP_Peripheral0.pTransmitBuffer = NULL;
+  SSP_Peripheral0.sTransmitQueue.psHead = NULL;
+  SSP_Peripheral0.sTransmitQueue.psTail = NULL;
+  SSP_Peripheral0.sTransmitQueue.psLastUrgent = NULL;
+  SSP_Peripheral0.sTransmitQueue.bCoalesce = FALSE;
+  SSP_Peripheral0.sTransmitQueue.bExpire = FALSE;
+  MessagingTrackQueue(&SSP_Peripheral0.sTransmitQueue, (const u8*)"SSP0");
   SSP_Peripheral0.pu8RxBuffer     = NULL;
   SSP_Peripheral0.u32RxBufferSize = 0;
   SSP_Peripheral0.pu8RxNextByte   = NULL;
   SSP_Peripheral0.u32Flags        = 0;
   
   SSP_Peripheral1.pBaseAddress    = LPC_SSP1;
-  SSP_Peripheral1.pTransmitBuffer = NULL;
+  SSP_Peripheral1.sTransmitQueue.psHead = NULL;
+  SSP_Peripheral1.sTransmitQueue.psTail = NULL;
+  SSP_Peripheral1.sTransmitQueue.psLastUrgent = NULL;
+  SSP_Peripheral1.sTransmitQueue.bCoalesce = FALSE;
+  SSP_Peripheral1.sTransmitQueue.bExpire = FALSE;
+  MessagingTrackQueue(&SSP_Peripheral1.sTransmitQueue, (const u8*)"SSP1");
   SSP_Peripheral1.pu8RxBuffer     = NULL;
   SSP_Peripheral1.u32RxBufferSize = 0;
   SSP_Peripheral1.pu8RxNextByte  = NULL;
@@ -451,6 +468,9 @@ void SspInitialize(void)
   SSP_psCurrentSsp                = &SSP_Peripheral1;
   SSP_u32CurrentTxBytesRemaining  = 0;
   SSP_pu8CurrentTxData            = NULL;
+  SSP_psCurrentTxSegment          = NULL;
+  SSP_bTxLastLoaded               = FALSE;
+  RingBufferInitialize(&SSP_sTxRing, &SSP_au8TxRingBuffer[0], SSP_TX_RING_SIZE);
   
   /* Fill the dummy array with SSP_DUMMY bytes */
   for (int i = 0; i < MAX_TX_MESSAGE_LENGTH; i++)
@@ -468,43 +488,97 @@ void SspInitialize(void)
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SspLoadTxRing
+
+Description:
+Copies as much of the message that is sending as fits into the transmit ring and makes sure the transmit interrupt
+is on to empty it.  This is the only producer of SSP_sTxRing, so it must only be called from the state machine.
+
+Requires:
+  - psSspPeripheral_ indicates which SSP peripheral being used.  
+  - SSP_pu8CurrentTxData points to the next byte in the message that is not yet in the ring
+  - SSP_psCurrentTxSegment is the message segment that SSP_pu8CurrentTxData is in
+  - SSP_u32CurrentTxBytesRemaining has an accurate count of the bytes in the segment not yet in the ring
+
+Promises:
+  - Message bytes are added to SSP_sTxRing until it is full or the whole message is in it; the cursor globals are
+    advanced past them (on through the segments of a scatter-gather message)
+  - Once the whole message is in the ring, SSP_bTxLastLoaded is set
+  - The transmit interrupt is enabled if any bytes were added
+*/
+static void SspLoadTxRing(SspPeripheralType* psSspPeripheral_)
+{
+  u32 u32Written;
+  u32 u32Loaded = 0;
+  
+  if(SSP_bTxLastLoaded)
+  {
+    return;
+  }
+  
+  do
+  {
+    u32Written = RingBufferWrite(&SSP_sTxRing, SSP_pu8CurrentTxData, SSP_u32CurrentTxBytesRemaining);
+    SSP_pu8CurrentTxData += u32Written;
+    SSP_u32CurrentTxBytesRemaining -= u32Written;
+    u32Loaded += u32Written;
+
+    /* Walk on to the next segment of a scatter-gather message */
+    if( (SSP_u32CurrentTxBytesRemaining == 0) && SSP_psCurrentTxSegment->bMoreSegments )
+    {
+      SSP_psCurrentTxSegment = SSP_psCurrentTxSegment->psNextMessage;
+      SSP_u32CurrentTxBytesRemaining = SSP_psCurrentTxSegment->u32Size;
+      SSP_pu8CurrentTxData = SSP_psCurrentTxSegment->pu8Message;
+      u32Written = 1;                                           /* Go on into the new segment */
+    }
+  } while( (u32Written != 0) && (SSP_u32CurrentTxBytesRemaining != 0) );
+  
+  if( (SSP_u32CurrentTxBytesRemaining == 0) && !SSP_psCurrentTxSegment->bMoreSegments )
+  {
+    SSP_bTxLastLoaded = TRUE;
+  }
+  
+  /* The bytes are published before the interrupt is enabled, so an ISR that found the ring empty and switched
+  itself off always runs again to see them */
+  if(u32Loaded != 0)
+  {
+    psSspPeripheral_->pBaseAddress->IMSC |= _SSP_TXMI_BIT;
+  }
+  
+} /* end SspLoadTxRing() */
+
+
 /*----------------------------------------------------------------------------------------------------------------------
 Function: SspFillTxBuffer
 
 Description:
-Fills the SSP peripheral buffer with bytes from the current messsage that is sending.  
-This function can be called from the SSP ISR!
+Fills the SSP peripheral buffer with bytes from the transmit ring.  This is the only consumer of SSP_sTxRing, so
+it must only be called from the SSP ISR.
 
 Requires:
   - psSspPeripheral_ indicates which SSP peripheral being used.  
-  - SSP_pu8CurrentTxData points to the next byte in the message to be sent
-  - SSP_u32CurrentTxBytesRemaining has an accurate count of the bytes remaining in the message data to be sent
-  - Transmit interrupts are off
 
 Promises:
-  - Data from *SSP_pu8CurrentTxData is added to the SSP peripheral Tx FIFO until the FIFO is full or there
-    is no more data to send.
+  - Bytes from SSP_sTxRing are added to the SSP peripheral Tx FIFO until the FIFO is full or the ring is empty
+  - If the ring is empty, the transmit interrupt is disabled (SspLoadTxRing() enables it again)
 */
 static void SspFillTxBuffer(SspPeripheralType* psSspPeripheral_) 
 {
-  /* Use the active global variables to fill up the transmit FIFO */
-  while( (psSspPeripheral_->pBaseAddress->SR & _SSP_SR_TNF_BIT) && (SSP_u32CurrentTxBytesRemaining != 0) )
+  u8 u8Byte;
+  
+  /* Move bytes from the ring to the transmit FIFO */
+  while( (psSspPeripheral_->pBaseAddress->SR & _SSP_SR_TNF_BIT) && RingBufferRead(&SSP_sTxRing, &u8Byte, 1) )
   {
-    psSspPeripheral_->pBaseAddress->DR = *SSP_pu8CurrentTxData;  // Check for interrupt after this
-    SSP_pu8CurrentTxData++;
-    SSP_u32CurrentTxBytesRemaining--;
+    psSspPeripheral_->pBaseAddress->DR = u8Byte;
   }
     
-  /* Disable the SSP transmit interrupt if there is no additional data to be queued */
-  if(SSP_u32CurrentTxBytesRemaining == 0)
+  /* Disable the SSP transmit interrupt if the ring is empty; the manual SSEL holds the slave until the state 
+  machine adds the rest of the message */
+  if(RingBufferUsed(&SSP_sTxRing) == 0)
   {
     psSspPeripheral_->pBaseAddress->IMSC &= ~_SSP_TXMI_BIT;
   }
-  /* Otherwise make sure transmit interrupts are enabled */
-  else
-  {
-    psSspPeripheral_->pBaseAddress->IMSC |= _SSP_TXMI_BIT;
-  }
   
 } /* end SspFillTxBuffer() */
 
@@ -709,15 +783,18 @@ void SspIdle(void)
   }
 
   /* Check if a message has been queued on the current SSP */
-  if(SSP_psCurrentSsp->pTransmitBuffer != NULL)
+  if(SSP_psCurrentSsp->sTransmitQueue.psHead != NULL)
   {
-    /* Set up to transmit the message */
-    SSP_u32CurrentTxBytesRemaining = SSP_psCurrentSsp->pTransmitBuffer->u32Size;
-    SSP_pu8CurrentTxData = SSP_psCurrentSsp->pTransmitBuffer->pu8Message;
-    SspFillTxBuffer(SSP_psCurrentSsp);
-
-    /* Update the message's status */
-    UpdateMessageStatus(SSP_psCurrentSsp->pTransmitBuffer->u32Token, SENDING);
+    /* Set up to transmit the message: the ISR takes the bytes from the ring */
+    SSP_u32CurrentTxBytesRemaining = SSP_psCurrentSsp->sTransmitQueue.psHead->u32Size;
+    SSP_pu8CurrentTxData = SSP_psCurrentSsp->sTransmitQueue.psHead->pu8Message;
+    SSP_psCurrentTxSegment = SSP_psCurrentSsp->sTransmitQueue.psHead;
+    SSP_bTxLastLoaded = FALSE;
+    SspLoadTxRing(SSP_psCurrentSsp);
+
+    /* Update the message's status; it is now owned by the driver until it is dequeued */
+    SSP_psCurrentSsp->sTransmitQueue.psHead->bStarted = TRUE;
+    UpdateMessageStatus(SSP_psCurrentSsp->sTransmitQueue.psHead->u32Token, SENDING);
     
    /* Proceed to next state to let the current message send */
     G_SspStateMachine = SspTransmitting;
@@ -727,18 +804,21 @@ void SspIdle(void)
 
         
 /*-------------------------------------------------------------------------------------------------------------------*/
-/* Transmit in progress until current bytes have reached 0.  
+/* Transmit in progress until the whole message has gone through the ring and out of the FIFO.  
 Note that received data will be coming in the whole time (may be dummy bytes).
 On exit, the transmit message must be dequeued.*/
 void SspTransmitting(void)
 {
-  if( (SSP_u32CurrentTxBytesRemaining == 0) && 
+  /* Keep the ring topped up with the rest of the message */
+  SspLoadTxRing(SSP_psCurrentSsp);
+  
+  if( SSP_bTxLastLoaded && (RingBufferUsed(&SSP_sTxRing) == 0) && 
       (SSP_psCurrentSsp->pBaseAddress->SR & _SSP_SR_TFE_BIT) &&
       (!(SSP_psCurrentSsp->pBaseAddress->SR & _SSP_SR_RNE_BIT)) )
   {
     /* Update the status queue and then dequeue the message */
-    UpdateMessageStatus(SSP_psCurrentSsp->pTransmitBuffer->u32Token, COMPLETE);
-    DeQueueMessage(&SSP_psCurrentSsp->pTransmitBuffer);
+    UpdateMessageStatus(SSP_psCurrentSsp->sTransmitQueue.psHead->u32Token, COMPLETE);
+    DeQueueMessage(&SSP_psCurrentSsp->sTransmitQueue);
 
     /* Make sure _SSP_INIT_MODE flag is clear in case this was a manual cycle */
     SSP_u32Flags &= ~_SSP_INIT_MODE;
@@ -41,7 +41,7 @@ typedef struct
 typedef struct 
 {
   LPC_SSP_TypeDef* pBaseAddress;      /* Base address of the associated peripheral */
-  MessageType* pTransmitBuffer;       /* Pointer to the transmit message linked list */
+  MessageQueueType sTransmitQueue;    /* Messages waiting to be sent */
   u8* pu8RxBuffer;                    /* Pointer to circular receive buffer in user application */
   u32 u32RxBufferSize;                /* Size of receive buffer in bytes */
   u8** pu8RxNextByte;                 /* Pointer to buffer location where next received byte will be placed */
@@ -69,6 +69,7 @@ Constants / Definitions
 #define SSP_RX_BUFFER_SIZE             (u32)256    /* Size of SSP receive buffer in bytes (4-byte aligned) */
 #define SSP_SENT_TOKEN_LIST_SIZE       (u32)256    /* Size of SSP receive buffer in bytes (4-byte aligned) */
 #define SSP_DUMMY_BYTE                 (u8)0xFF
+#define SSP_TX_RING_SIZE               (u32)64     /* Bytes passed to the transmit ISR at once (a power of 2) */
 
 #define _SSP0_PCONP_BIT                (u32)(1 << 21)
 #define _SSP1_PCONP_BIT                (u32)(1 << 10)
@@ -125,6 +126,7 @@ void SspInitialize(void);
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
+static void SspLoadTxRing(SspPeripheralType* psSspPeripheral_);
 static void SspFillTxBuffer(SspPeripheralType* psSspPeripheral_); 
 static void SspReadRxBuffer(SspPeripheralType* psTargetSsp_);
 
@@ -6,8 +6,9 @@ Provides a driver to use UART peripherals to send and receive data using interru
 This driver covers both the dedicated UART peripheral and the three USART peripherals (assuming they are
 running in asynchronous (UART) mode).
 
-UART0 (38,400 8-N-1) gets special treatment to allow it to run very simply since it is only a debug interface.  The transmit buffer is
-owned by this source file and is accessed through the API.
+UART0 (38,400 8-N-1) gets special treatment to allow it to run very simply since it is only a debug interface.  The 
+transmit buffer is owned by this source file and is accessed through the API: Uart_putc() adds a byte to a ring that
+the TXEMPTY interrupt empties, so it returns immediately unless the ring is full.
 
 
 ------------------------------------------------------------------------------------------------------------------------
@@ -22,6 +23,10 @@ UartPeripheralType* UartRequest(UartConfigurationType* psUartConfig_);
 void UartRelease(UartPeripheralType* psUartPeripheral_);
 u32 UartWriteByte(UartPeripheralType* psUartPeripheral_, u8 u8Byte_);
 u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* u8Data_);
+u32 UartWriteDataNoCopy(UartPeripheralType* psUartPeripheral_, u32 u32Size_, const u8* pu8Data_, 
+                        MessageReleaseType pfRelease_);
+u32 UartWriteSegments(UartPeripheralType* psUartPeripheral_, const MessageSegmentType* pasSegments_, u8 u8Segments_);
+u32 UartWriteDataUrgent(UartPeripheralType* psUartPeripheral_, u32 u32Size_, const u8* pu8Data_);
 All receive functionality is automatic. Incoming bytes are deposited to the 
 buffer specified in psUartConfig_
 
@@ -40,14 +45,21 @@ accessible to your application.
 DATA TRANSFER:
 1. Received bytes on the allocated peripheral will be dropped into the application's designated received
 buffer.  The buffer is written circularly, with no provision to monitor bytes that are overwritten.  The 
-application is responsible for processing all received data.  The application must provide its own parsing
-pointer to read the receive buffer and properly wrap around.  This pointer will not be impacted by the interrupt
-service routine that may add additional characters at any time.
-
-2. Transmitted data is queued using one of two functions, UartWriteByte() and UartWriteData().  Once the data
-is queued, it is sent as soon as possible.  Each UART resource has a transmit queue, but only one UART resource
-will send data at any given time from this state machine.  However, all UART resources may receive data simultaneously
-through their respective interrupt handlers based on interrupt priority.
+application is responsible for processing all received data.  USART0 receives through the PDC into two buffers that
+it fills alternately; the ISR hands the bytes on when a buffer fills or when the line has been idle for the
+receiver time-out (DEBUG_US_RTOR_INIT), so a burst costs one interrupt per U0RX_PDC_BUFFER_SIZE bytes.  The 
+application must provide its own parsing pointer to read the receive buffer and properly wrap around.  This pointer 
+will not be impacted by the interrupt service routine that may add additional characters at any time.
+
+2. Transmitted data is queued using UartWriteByte(), UartWriteData(), UartWriteDataNoCopy() or UartWriteSegments().
+Once the data is queued, it is sent as soon as possible.  UartWriteDataNoCopy() does not copy the data, so use it for
+const strings or buffers that stay unchanged until they are released.  UartWriteSegments() sends several pieces of
+data as one message without gathering them into a buffer first.  UartWriteDataUrgent() queues data ahead of
+everything not yet started (e.g. echo while a long dump is queued).  Each UART resource has a transmit queue, but 
+only one UART resource will send data at any given time from this state machine.  However, all UART resources may 
+receive data simultaneously through their respective interrupt handlers based on interrupt priority.  Transmit 
+uses the peripheral's DMA (PDC) with no interrupts: the state machine loads a message into the PDC, chains the next
+segment or message behind it in the "next" registers and polls the counters to retire them.
 
 **********************************************************************************************************************/
 
@@ -85,18 +97,20 @@ static UartPeripheralType UART_Peripheral1;     /* USART1 peripheral object (use
 static UartPeripheralType UART_Peripheral2;     /* USART2 peripheral object (used as UART) */
 
 static UartPeripheralType* UART_psCurrentUart;  /* Current UART peripheral being processed */
-static u32 UART_u32CurrentTxBytesRemaining;     /* Down counter for number of bytes being clocked out */
-static u8* UART_pu8CurrentTxData;               /* Pointer to current message being clocked out */
+static MessageType* UART_psTxLastLoaded;        /* Last segment handed to the PDC (NULL: start at the queue head) */
+static u8 UART_u8PdcBuffersLoaded;              /* Transmit buffers loaded in the PDC (TPR, then TNPR) */
+static bool UART_abPdcEndsMessage[UART_PDC_BUFFERS]; /* TRUE if the PDC buffer is the last one of a message */
+static bool UART_bMessageStarted;               /* TRUE once a message has been started in this turn of the UART */
 
 static u8 UART_au8U0RxBuffer[U0RX_BUFFER_SIZE]; /* Receive buffer for basic UART0 */
 static u8* UART_pu8U0RxBufferNextChar;          /* Pointer to location where next incoming char should be written */
 static u8* UART_pu8U0RxBufferUnreadChar;        /* Pointer to location of next char that has not yet been read */
+static u8 UART_au8U0RxPdcBuffer[UART_PDC_BUFFERS][U0RX_PDC_BUFFER_SIZE]; /* PDC receive buffers, filled alternately */
+static u8 UART_u8U0RxPdcCurrent;                /* Index of the PDC receive buffer in RPR */
+static u32 UART_u32U0RxPdcRead;                 /* Bytes of the current PDC receive buffer already delivered */
 
-#if 0
 static u8 UART_au8U0TxBuffer[U0TX_BUFFER_SIZE]; /* Transmit buffer for basic UART0 */
-static u8* UART_pu8U0TxBufferNextChar;          /* Pointer to location where next outgoing char should be written */
-static u8* UART_pu8U0TxBufferUnsentChar;        /* Pointer to location of next char that has not yet been sent */
-#endif
+static RingBufferType UART_sU0TxRing;           /* Uart_putc() bytes waiting for the USART0 TXEMPTY interrupt */
 
 /***********************************************************************************************************************
 Function Definitions
@@ -109,30 +123,27 @@ Function Definitions
 Function: Uart_putc
 
 Description:
-Writes a char directly to the debug UART transmit buffer.
+Adds a char to the debug UART transmit buffer.  The USART0 TXEMPTY interrupt sends it when the line is free (after
+any message the PDC is sending).  Only call this from the main loop: it is the only writer of the buffer.
 
 Requires:
   - Debug UART is set up
 
 Promises:
-  - Character is written directly to the UART buffer if transmitter is ready
-  - Returns TRUE if character queued to transmit buffer; else returns FALSE
+  - Returns TRUE if character queued to transmit buffer; else (buffer full) returns FALSE
+  - The TXEMPTY interrupt is enabled
 */
 bool Uart_putc(u8 u8Char_)
 {
-  /* Check if the transmitter is available */
-  if(AT91C_BASE_US0->US_CSR & AT91C_US_TXRDY)
+  if(RingBufferWrite(&UART_sU0TxRing, &u8Char_, 1) == 0)
   {
-    /* Load the character to send it */
-    AT91C_BASE_US0->US_THR = u8Char_;    
-    return TRUE;
-  }
-  else
-  {
-    /* Transmitter not ready: return FALSE */
     return FALSE;
   }
   
+  /* The byte is in the ring before the interrupt is enabled, so the ISR cannot find it empty and switch off */
+  AT91C_BASE_US0->US_IER = AT91C_US_TXEMPTY;
+  return TRUE;
+  
 } /* end Uart_putc() */
 
 
@@ -140,7 +151,7 @@ bool Uart_putc(u8 u8Char_)
 Function: Uart_getc
 
 Description:
-Reads a char directly to the debug UART transmit buffer.
+Reads the oldest char from the debug UART receive buffer.
 Recommended that user first calls UartCheckForNewChar to ensure there is a valid character ready.
 
 Requires:
@@ -321,6 +332,9 @@ UartPeripheralType* UartRequest(UartConfigurationType* psUartConfig_)
   psRequestedUart->pBaseAddress->US_IDR  = u32TargetIDR;
   psRequestedUart->pBaseAddress->US_BRGR = u32TargetBRGR;
   
+  /* Transmit data goes through the PDC */
+  psRequestedUart->pBaseAddress->US_PTCR = AT91C_PDC_TXTEN;
+  
   /* Enable UART interrupts */
   NVIC_ClearPendingIRQ( (IRQn_Type)u32TargetPerpipheralNumber );
   NVIC_EnableIRQ( (IRQn_Type)u32TargetPerpipheralNumber );
@@ -342,6 +356,8 @@ Requires:
 
 Promises:
   - Resets peripheral object's pointers and data to safe values
+  - Messages left in the transmit queue are ABANDONED and dequeued; if they were sending, the PDC bookkeeping is
+    cleared and the state machine is back in UartSM_Idle
   - Peripheral is disabled
   - Peripheral interrupts are disabled.
 */
@@ -368,6 +384,26 @@ void UartRelease(UartPeripheralType* psUartPeripheral_)
 
   NVIC_DisableIRQ( (IRQn_Type)u32TargetPerpipheralNumber );
   NVIC_ClearPendingIRQ( (IRQn_Type)u32TargetPerpipheralNumber );
+
+  /* Forget the buffers loaded in the PDC if this UART is sending */
+  if( (UART_psCurrentUart == psUartPeripheral_) && (G_UartStateMachine == UartSM_Transmitting) )
+  {
+    psUartPeripheral_->pBaseAddress->US_TNCR = 0;
+    psUartPeripheral_->pBaseAddress->US_TCR = 0;
+    UART_psTxLastLoaded = NULL;
+    UART_u8PdcBuffersLoaded = 0;
+    UART_bMessageStarted = FALSE;
+    G_UartStateMachine = UartSM_Idle;
+  }
+  
+  /* Empty the transmit queue if there were leftover messages */
+  while(psUartPeripheral_->sTransmitQueue.psHead != NULL)
+  {
+    UpdateMessageStatus(psUartPeripheral_->sTransmitQueue.psHead->u32Token, ABANDONED);
+    DeQueueMessage(&psUartPeripheral_->sTransmitQueue);
+  }
+  
+  psUartPeripheral_->pBaseAddress->US_PTCR = AT91C_PDC_TXTDIS;
  
   /* Now it's safe to release all of the resources in the target peripheral */
   psUartPeripheral_->pu8RxBuffer     = NULL;
@@ -388,7 +424,7 @@ Requires:
   - psUartPeripheral_ has been requested.
 
 Promises:
-  - Creates a 1-byte message at psUartPeripheral_->pTransmitBuffer that will be sent by the UART application
+  - Creates a 1-byte message on psUartPeripheral_->sTransmitQueue that will be sent by the UART application
     when it is available.
   - Returns the message token assigned to the message
 */
@@ -397,7 +433,7 @@ u32 UartWriteByte(UartPeripheralType* psUartPeripheral_, u8 u8Byte_)
   u32 u32Token;
   u8 u8Data = u8Byte_;
   
-  u32Token = QueueMessage(1, &u8Data, &psUartPeripheral_->pTransmitBuffer);
+  u32Token = QueueMessage(1, &u8Data, &psUartPeripheral_->sTransmitQueue);
   if(u32Token)
   {
     /* If the system is initializing, we want to manually cycle the UART task through one iteration
@@ -426,7 +462,7 @@ Requires:
   - u8Data_ points to the first byte of the data array
 
 Promises:
-  - adds the data message at psUartPeripheral_->pTransmitBuffer that will be sent by the UART application
+  - adds the data message on psUartPeripheral_->sTransmitQueue that will be sent by the UART application
     when it is available.
   - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
     G_u32MessagingFlags can be checked for the reason
@@ -435,7 +471,7 @@ u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* u8Dat
 {
   u32 u32Token;
 
-  u32Token = QueueMessage(u32Size_, u8Data_, &psUartPeripheral_->pTransmitBuffer);
+  u32Token = QueueMessage(u32Size_, u8Data_, &psUartPeripheral_->sTransmitQueue);
   if(u32Token)
   {
     /* If the system is initializing, manually cycle the UART task through one iteration to send the message */
@@ -450,6 +486,115 @@ u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* u8Dat
 } /* end UartWriteData() */
 
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartWriteDataNoCopy
+
+Description:
+Queues a data array for transfer on the target UART peripheral without copying it into the message pool.
+
+Requires:
+  - psUartPeripheral_ has been requested.
+  - u32Size_ is the number of bytes in the data array
+  - pu8Data_ points to the first byte of the data array which is const or stays unchanged until pfRelease_ is 
+    called (see QueueMessageNoCopy())
+  - pfRelease_ is called when the UART is done with the data, or NULL
+
+Promises:
+  - adds the data message on psUartPeripheral_->sTransmitQueue that will be sent by the UART application
+    when it is available.
+  - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
+    G_u32MessagingFlags can be checked for the reason
+*/
+u32 UartWriteDataNoCopy(UartPeripheralType* psUartPeripheral_, u32 u32Size_, const u8* pu8Data_, 
+                        MessageReleaseType pfRelease_)
+{
+  u32 u32Token;
+
+  u32Token = QueueMessageNoCopy(u32Size_, pu8Data_, pfRelease_, &psUartPeripheral_->sTransmitQueue);
+  if(u32Token)
+  {
+    /* If the system is initializing, manually cycle the UART task through one iteration to send the message */
+    if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+    {
+      UartManualMode();
+    }
+  }
+  
+  return(u32Token);
+  
+} /* end UartWriteDataNoCopy() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartWriteSegments
+
+Description:
+Queues a list of data segments for transfer on the target UART peripheral as one message.
+
+Requires:
+  - psUartPeripheral_ has been requested.
+  - pasSegments_ points to u8Segments_ segments in the order they are sent (see QueueMessageSegments())
+
+Promises:
+  - adds the message on psUartPeripheral_->sTransmitQueue that will be sent by the UART application
+    when it is available.
+  - Returns the message token assigned to the message; 0 is returned if the message cannot be queued in which case
+    G_u32MessagingFlags can be checked for the reason
+*/
+u32 UartWriteSegments(UartPeripheralType* psUartPeripheral_, const MessageSegmentType* pasSegments_, u8 u8Segments_)
+{
+  u32 u32Token;
+
+  u32Token = QueueMessageSegments(pasSegments_, u8Segments_, MSG_PRIORITY_BULK, &psUartPeripheral_->sTransmitQueue);
+  if(u32Token)
+  {
+    /* If the system is initializing, manually cycle the UART task through one iteration to send the message */
+    if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+    {
+      UartManualMode();
+    }
+  }
+  
+  return(u32Token);
+  
+} /* end UartWriteSegments() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartWriteDataUrgent
+
+Description:
+Queues a data array as an urgent message: it is sent after the message in progress and earlier urgent messages, 
+ahead of all other waiting messages.  Use it for short interactive output such as echo.
+
+Requires:
+  - psUartPeripheral_ has been requested.
+  - u32Size_ is the number of bytes in the data array
+  - pu8Data_ points to the first byte of the data array
+
+Promises:
+  - adds the data message on psUartPeripheral_->sTransmitQueue ahead of the waiting bulk messages
+  - returns the message token
+*/
+u32 UartWriteDataUrgent(UartPeripheralType* psUartPeripheral_, u32 u32Size_, const u8* pu8Data_)
+{
+  u32 u32Token;
+  
+  u32Token = QueueMessagePriority(u32Size_, pu8Data_, MSG_PRIORITY_URGENT, &psUartPeripheral_->sTransmitQueue);
+  if(u32Token)
+  {
+    /* If the system is initializing, manually cycle the UART task through one iteration to send the message */
+    if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+    {
+      UartManualMode();
+    }
+  }
+  
+  return(u32Token);
+  
+} /* end UartWriteDataUrgent() */
+
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected Functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -485,14 +630,7 @@ void UartInitialize(void)
     UART_au8U0RxBuffer[i] = 0;
   }
 
-#if 0  
-  UART_pu8U0TxBufferNextChar   = &UART_au8U0TxBuffer[0];
-  UART_pu8U0TxBufferUnsentChar = &UART_au8U0TxBuffer[0];
-  for(u16 i = 0; i < U0TX_BUFFER_SIZE; i++)
-  {
-    UART_au8U0TxBuffer[i] = 0;
-  }
-#endif
+  RingBufferInitialize(&UART_sU0TxRing, &UART_au8U0TxBuffer[0], U0TX_BUFFER_SIZE);
   
   /* Activate the US0 clock and set peripheral configuration registers */
   AT91C_BASE_PMC->PMC_PCER |= (1 << AT91C_ID_US0);
@@ -502,12 +640,23 @@ void UartInitialize(void)
   AT91C_BASE_US0->US_IER  = USART0_US_IER_INIT;
   AT91C_BASE_US0->US_IDR  = USART0_US_IDR_INIT;
   AT91C_BASE_US0->US_BRGR = USART0_US_BRGR_INIT;
+  AT91C_BASE_US0->US_RTOR = USART0_US_RTOR_INIT;
+
+  /* Receive through the PDC: buffer 0 is filled first and buffer 1 is chained behind it */
+  UART_u8U0RxPdcCurrent = 0;
+  UART_u32U0RxPdcRead   = 0;
+  AT91C_BASE_US0->US_RPR  = (u32)&UART_au8U0RxPdcBuffer[0][0];
+  AT91C_BASE_US0->US_RCR  = U0RX_PDC_BUFFER_SIZE;
+  AT91C_BASE_US0->US_RNPR = (u32)&UART_au8U0RxPdcBuffer[1][0];
+  AT91C_BASE_US0->US_RNCR = U0RX_PDC_BUFFER_SIZE;
+  AT91C_BASE_US0->US_PTCR = AT91C_PDC_RXTEN;
+  AT91C_BASE_US0->US_CR   = AT91C_US_STTTO;
 
   /* Enable U0 interrupts */
   NVIC_ClearPendingIRQ(IRQn_US0);
   NVIC_EnableIRQ(IRQn_US0);
   
-  /* Print the startup message */
+  /* Queue the startup message (this only waits if the transmit buffer is full) */
   UART_u32Timer = G_u32SystemTime1ms;
   pu8Parser = &au8Uart0StartupMsg[0];
   while(*pu8Parser != NULL)
@@ -526,50 +675,63 @@ void UartInitialize(void)
     }
   }
 
-#if 0
-  DebugPrintf(au8Uart0StartupMsg);
-  while(UART_pu8U0TxBufferUnsentChar != UART_pu8U0TxBufferNextChar)
-  {
-    UartManualMode();
-  }
-#endif
-  
 #endif /* USE_SIMPLE_USART0 */
   
   /* Setup generic UARTs */
   
   /* Initialize the UART peripheral structures */
   UART_Peripheral.pBaseAddress    = (AT91S_USART*)AT91C_BASE_DBGU;
-  UART_Peripheral.pTransmitBuffer = NULL;
+  UART_Peripheral.sTransmitQueue.psHead = NULL;
+  UART_Peripheral.sTransmitQueue.psTail = NULL;
+  UART_Peripheral.sTransmitQueue.psLastUrgent = NULL;
+  UART_Peripheral.sTransmitQueue.bCoalesce = TRUE;
+  UART_Peripheral.sTransmitQueue.bExpire = TRUE;
+  MessagingTrackQueue(&UART_Peripheral.sTransmitQueue, (const u8*)"DBGU");
   UART_Peripheral.pu8RxBuffer     = NULL;
   UART_Peripheral.u32RxBufferSize = 0;
   UART_Peripheral.pu8RxNextByte   = NULL;
   UART_Peripheral.u32Flags        = 0;
 
   UART_Peripheral0.pBaseAddress    = AT91C_BASE_US0;
-  UART_Peripheral0.pTransmitBuffer = NULL;
+  UART_Peripheral0.sTransmitQueue.psHead = NULL;
+  UART_Peripheral0.sTransmitQueue.psTail = NULL;
+  UART_Peripheral0.sTransmitQueue.psLastUrgent = NULL;
+  UART_Peripheral0.sTransmitQueue.bCoalesce = TRUE;
+  UART_Peripheral0.sTransmitQueue.bExpire = TRUE;
+  MessagingTrackQueue(&UART_Peripheral0.sTransmitQueue, (const u8*)"US0");
   UART_Peripheral0.pu8RxBuffer     = NULL;
   UART_Peripheral0.u32RxBufferSize = 0;
   UART_Peripheral0.pu8RxNextByte   = NULL;
   UART_Peripheral0.u32Flags        = 0;
 
   UART_Peripheral1.pBaseAddress    = AT91C_BASE_US1;
-  UART_Peripheral1.pTransmitBuffer = NULL;
+  UART_Peripheral1.sTransmitQueue.psHead = NULL;
+  UART_Peripheral1.sTransmitQueue.psTail = NULL;
+  UART_Peripheral1.sTransmitQueue.psLastUrgent = NULL;
+  UART_Peripheral1.sTransmitQueue.bCoalesce = TRUE;
+  UART_Peripheral1.sTransmitQueue.bExpire = TRUE;
+  MessagingTrackQueue(&UART_Peripheral1.sTransmitQueue, (const u8*)"US1");
   UART_Peripheral1.pu8RxBuffer     = NULL;
   UART_Peripheral1.u32RxBufferSize = 0;
   UART_Peripheral1.pu8RxNextByte   = NULL;
   UART_Peripheral1.u32Flags        = 0;
 
   UART_Peripheral2.pBaseAddress    = AT91C_BASE_US2;
-  UART_Peripheral2.pTransmitBuffer = NULL;
+  UART_Peripheral2.sTransmitQueue.psHead = NULL;
+  UART_Peripheral2.sTransmitQueue.psTail = NULL;
+  UART_Peripheral2.sTransmitQueue.psLastUrgent = NULL;
+  UART_Peripheral2.sTransmitQueue.bCoalesce = TRUE;
+  UART_Peripheral2.sTransmitQueue.bExpire = TRUE;
+  MessagingTrackQueue(&UART_Peripheral2.sTransmitQueue, (const u8*)"US2");
   UART_Peripheral2.pu8RxBuffer     = NULL;
   UART_Peripheral2.u32RxBufferSize = 0;
   UART_Peripheral2.pu8RxNextByte   = NULL;
   UART_Peripheral2.u32Flags        = 0;
   
   UART_psCurrentUart               = &UART_Peripheral;
-  UART_u32CurrentTxBytesRemaining  = 0;
-  UART_pu8CurrentTxData            = NULL;
+  UART_psTxLastLoaded              = NULL;
+  UART_u8PdcBuffersLoaded          = 0;
+  UART_bMessageStarted             = FALSE;
 
   /* Set application pointer */
   G_UartStateMachine = UartSM_Idle;
@@ -582,77 +744,234 @@ void UartInitialize(void)
 /*--------------------------------------------------------------------------------------------------------------------*/
 
 /*----------------------------------------------------------------------------------------------------------------------
-Function: UartFillTxBuffer
+Function: UartPdcLoad
 
 Description:
-Fills the UART peripheral buffer with bytes from the current messsage that is sending.  
-This function can be called from the UART ISR!
-Note: if the implemented processor does not have a FIFO, this function can still be used but will only ever
-add one byte to the transmitter.
+Hands the next segments of the current UART's transmit queue to the PDC until both of its transmit buffers (TPR and
+TNPR) are loaded.  Segments are loaded in queue order, so while one message is sending the next one is chained
+behind it in TNPR and the line does not go idle between messages.  Each message is marked SENDING when its first
+segment is taken.
 
 Requires:
-  - The TxBuffer is empty
-  - psUartPeripheral_ points to the UART peripheral being used.  
-  - UART_pu8CurrentTxData points to the next byte in the message to be sent
-  - UART_u32CurrentTxBytesRemaining has an accurate count of the bytes remaining in the message data to be sent
-  - Transmit interrupts are off
+  - UART_psCurrentUart is the UART that is sending
+  - UART_psTxLastLoaded is the last segment loaded, or NULL to start at the head of the queue
+  - UART_u8PdcBuffersLoaded and UART_abPdcEndsMessage describe the buffers loaded in the PDC
+  - UART_bMessageStarted is TRUE if a message has already been started in this turn of the UART
 
 Promises:
-  - Data from *UART_pu8CurrentTxData is added to the UART peripheral Tx FIFO until the FIFO is full or there
-    is no more data to send.
+  - Up to UART_PDC_BUFFERS buffers are loaded; empty segments are skipped (an empty last segment ends the message with 
+    the buffer loaded before it, or immediately if none of the message is loaded)
+  - After the first message of the turn, a new message is not started if another UART has messages waiting
+  - A new message is not started on USART0 while Uart_putc() bytes are waiting in UART_sU0TxRing
 */
-static void UartFillTxBuffer(UartPeripheralType* psUartPeripheral_)
+static void UartPdcLoad(void)
 {
-  u8 u8ByteCount = UART_TX_FIFO_SIZE;
+  MessageType* psSegment;
+  AT91S_USART* psUsart = UART_psCurrentUart->pBaseAddress;
   
-  /* Use the active global variables to fill up the transmit FIFO */
-  while( (u8ByteCount != 0) && (UART_u32CurrentTxBytesRemaining != 0) )
+  while(UART_u8PdcBuffersLoaded < UART_PDC_BUFFERS)
   {
-    psUartPeripheral_->pBaseAddress->US_THR = *UART_pu8CurrentTxData;
-    UART_pu8CurrentTxData++;
-    UART_u32CurrentTxBytesRemaining--;
-    u8ByteCount--;
+    /* The next segment in queue order follows the last one loaded */
+    if(UART_psTxLastLoaded == NULL)
+    {
+      psSegment = UART_psCurrentUart->sTransmitQueue.psHead;
+    }
+    else
+    {
+      psSegment = UART_psTxLastLoaded->psNextMessage;
+    }
+    
+    if(psSegment == NULL)
+    {
+      return;
+    }
+    
+    /* An empty last segment of a message with nothing in the PDC ends it, which can only happen at the head */
+    if( (psSegment->u32Size == 0) && !psSegment->bMoreSegments && 
+        (UART_u8PdcBuffersLoaded != 0) && UART_abPdcEndsMessage[UART_u8PdcBuffersLoaded - 1] )
+    {
+      return;
+    }
+    
+    /* Check if this segment starts a new message: after the first one, other UARTs with messages go first, and
+    USART0 lets waiting Uart_putc() bytes out before it starts another message so the two do not interleave */
+    if( (UART_psTxLastLoaded == NULL) || !UART_psTxLastLoaded->bMoreSegments )
+    {
+      if(UART_bMessageStarted && UartOtherQueueWaiting())
+      {
+        return;
+      }
+      
+      if( (psUsart == AT91C_BASE_US0) && (RingBufferUsed(&UART_sU0TxRing) != 0) )
+      {
+        return;
+      }
+      
+      /* The PDC reads the payload from here on, so the messaging task must not remove the message */
+      psSegment->bStarted = TRUE;
+      UpdateMessageStatus(psSegment->u32Token, SENDING);
+      UART_bMessageStarted = TRUE;
+    }
+    
+    if(psSegment->u32Size != 0)
+    {
+      /* Load the first free PDC buffer */
+      if(UART_u8PdcBuffersLoaded == 0)
+      {
+        psUsart->US_TPR = (u32)psSegment->pu8Message;
+        psUsart->US_TCR = psSegment->u32Size;
+      }
+      else
+      {
+        psUsart->US_TNPR = (u32)psSegment->pu8Message;
+        psUsart->US_TNCR = psSegment->u32Size;
+      }
+      
+      UART_abPdcEndsMessage[UART_u8PdcBuffersLoaded] = !psSegment->bMoreSegments;
+      UART_u8PdcBuffersLoaded++;
+    }
+    else if(!psSegment->bMoreSegments)
+    {
+      /* An empty last segment: the message ends with its last buffer in the PDC, or now if it has none there */
+      if(UART_u8PdcBuffersLoaded != 0)
+      {
+        UART_abPdcEndsMessage[UART_u8PdcBuffersLoaded - 1] = TRUE;
+      }
+      else
+      {
+        UartCompleteMessage();
+        psSegment = NULL;
+      }
+    }
+    
+    /* After completing a message here, loading starts again at the head */
+    UART_psTxLastLoaded = psSegment;
   }
+  
+} /* end UartPdcLoad() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartPdcRetire
+
+Description:
+Checks the PDC transmit counters of the current UART and retires the buffers it has finished.  When the first buffer
+is done, the PDC moves TNPR/TNCR into TPR/TCR, so TNCR reads 0 while two buffers are loaded.  The last buffer is done
+when TCR reads 0.  A message is COMPLETE and dequeued as soon as the PDC has read its last byte; the payload is no 
+longer needed even though the last byte may still be shifting out.
+
+Requires:
+  - UART_psCurrentUart is the UART that is sending
+  - UART_u8PdcBuffersLoaded and UART_abPdcEndsMessage describe the buffers loaded in the PDC
+
+Promises:
+  - Finished buffers are removed from UART_abPdcEndsMessage and UART_u8PdcBuffersLoaded
+  - Each message whose last buffer is finished is COMPLETE and removed from the queue
+*/
+static void UartPdcRetire(void)
+{
+  AT91S_USART* psUsart = UART_psCurrentUart->pBaseAddress;
+  bool bEndsMessage;
+  
+  /* Read TNCR first: TCR may be reloaded from it at any time */
+  while( ((UART_u8PdcBuffersLoaded == 2) && (psUsart->US_TNCR == 0)) ||
+         ((UART_u8PdcBuffersLoaded == 1) && (psUsart->US_TCR == 0)) )
+  {
+    bEndsMessage = UART_abPdcEndsMessage[0];
+    UART_abPdcEndsMessage[0] = UART_abPdcEndsMessage[1];
+    UART_u8PdcBuffersLoaded--;
     
-  /* If there are no remaining bytes to load to the TX FIFO, disable the UART transmit 
-  FIFO empty interrupt */
-  if(UART_u32CurrentTxBytesRemaining == 0)
+    if(bEndsMessage)
+    {
+      UartCompleteMessage();
+    }
+  }
+  
+} /* end UartPdcRetire() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartCompleteMessage
+
+Description:
+Marks the message at the head of the current UART's queue COMPLETE and dequeues it.
+
+Requires:
+  - The PDC has read every byte of the head message of UART_psCurrentUart
+
+Promises:
+  - The head message is COMPLETE and removed from the queue; nothing is dequeued if the queue is empty
+  - UART_psTxLastLoaded is set to NULL if no buffers are left in the PDC (the last loaded segment was in the message 
+    just removed, so loading starts again at the head)
+*/
+static void UartCompleteMessage(void)
+{
+  MessageType* psHead = UART_psCurrentUart->sTransmitQueue.psHead;
+  
+  /* The message may already be gone if the queue was flushed */
+  if(psHead != NULL)
   {
-    psUartPeripheral_->pBaseAddress->US_IDR = AT91C_US_TXEMPTY;
+    UpdateMessageStatus(psHead->u32Token, COMPLETE);
+    DeQueueMessage(&UART_psCurrentUart->sTransmitQueue);
   }
-  /* Otherwise make sure transmit interrupts are enabled */
-  else
+  
+  if(UART_u8PdcBuffersLoaded == 0)
   {
-    psUartPeripheral_->pBaseAddress->US_IER = AT91C_US_TXEMPTY;
+    UART_psTxLastLoaded = NULL;
   }
   
-} /* end UartFillTxBuffer() */
+} /* end UartCompleteMessage() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartOtherQueueWaiting
+
+Description:
+Checks if a UART other than the one sending has messages waiting.
+
+Requires:
+  - 
+
+Promises:
+  - Returns TRUE if any UART other than UART_psCurrentUart has a message in its transmit queue
+*/
+static bool UartOtherQueueWaiting(void)
+{
+  UartPeripheralType* apsUarts[] = {&UART_Peripheral, &UART_Peripheral0, &UART_Peripheral1, &UART_Peripheral2};
+  
+  for(u8 i = 0; i < (sizeof(apsUarts) / sizeof(UartPeripheralType*)); i++)
+  {
+    if( (apsUarts[i] != UART_psCurrentUart) && (apsUarts[i]->sTransmitQueue.psHead != NULL) )
+    {
+      return(TRUE);
+    }
+  }
+  
+  return(FALSE);
+
+} /* end UartOtherQueueWaiting() */
 
 
 /*----------------------------------------------------------------------------------------------------------------------
 Function: UartReadRxBuffer
 
 Description:
-Reads all bytes from the UART peripheral Rx FIFO and places them in the application receive buffer.  
+Copies received bytes into the application receive buffer.  
 This function is only called from the UART ISR so interrupts will be off.
 
 Requires:
-  - UART_pu8CurrentTxData points to the next byte in the message to be sent
-  - UART_u32CurrentTxBytesRemaining has an accurate count of the bytes remaining in the message data to be sent
-  - Transmit interrupts are off
+  - psTargetUart_ has been requested with a receive buffer
+  - pu8Data_ points to u32Size_ received bytes
 
 Promises:
-  - All bytes currently in the UART Rx FIFO are read out to the application receive circular buffer.
+  - The bytes are written to the application receive circular buffer at *pu8RxNextByte, which is advanced past
+    them; the byte after the last one is zeroed.
 */
-static void UartReadRxBuffer(UartPeripheralType* psTargetUart_) 
+static void UartReadRxBuffer(UartPeripheralType* psTargetUart_, const u8* pu8Data_, u32 u32Size_) 
 {
-  u8 u8Test;
-  
-  /* Read all the bytes in the Rx FIFO */
-  while(psTargetUart_->pBaseAddress->US_CSR & AT91C_US_RXRDY)
+  for(u32 i = 0; i < u32Size_; i++)
   {
-    u8Test = psTargetUart_->pBaseAddress->US_RHR;
-    **(psTargetUart_->pu8RxNextByte) = u8Test; 
+    **(psTargetUart_->pu8RxNextByte) = pu8Data_[i]; 
 
     /* Safely advance the pointer in the circular buffer */
     (*psTargetUart_->pu8RxNextByte)++;
@@ -667,6 +986,99 @@ static void UartReadRxBuffer(UartPeripheralType* psTargetUart_)
 } /* end UartReadRxBuffer() */
 
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartU0RxDeliver
+
+Description:
+Hands bytes received on USART0 to the simple receive buffer read by Uart_getc() and, if USART0 has been requested
+with a receive buffer, to the application receive buffer.  Called from the USART0 ISR only.
+
+Requires:
+  - pu8Data_ points to u32Size_ received bytes
+
+Promises:
+  - Bytes are added to UART_au8U0RxBuffer while it has room; bytes that do not fit are dropped (unread bytes are
+    never overwritten) and _UART_RX_BUFFER_OVERRUN is set in UART_Peripheral0
+  - The bytes are copied to the application receive buffer of UART_Peripheral0 if there is one
+*/
+static void UartU0RxDeliver(const u8* pu8Data_, u32 u32Size_)
+{
+  u8* pu8Next;
+  
+  for(u32 i = 0; i < u32Size_; i++)
+  {
+    pu8Next = UART_pu8U0RxBufferNextChar + 1;
+    if(pu8Next == &UART_au8U0RxBuffer[U0RX_BUFFER_SIZE])
+    {
+      pu8Next = &UART_au8U0RxBuffer[0];
+    }
+
+    /* Full when advancing would make the buffer look empty */
+    if(pu8Next == UART_pu8U0RxBufferUnreadChar)
+    {
+      UART_Peripheral0.u32Flags |= _UART_RX_BUFFER_OVERRUN;
+      break;
+    }
+    
+    *UART_pu8U0RxBufferNextChar = pu8Data_[i];
+    UART_pu8U0RxBufferNextChar = pu8Next;
+  }
+
+  if( (UART_Peripheral0.u32Flags & _UART_PERIPHERAL_BUSY) && (UART_Peripheral0.pu8RxBuffer != NULL) )
+  {
+    UartReadRxBuffer(&UART_Peripheral0, pu8Data_, u32Size_);
+  }
+  
+} /* end UartU0RxDeliver() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartU0RxPdcDrain
+
+Description:
+Delivers everything the PDC has received on USART0 since the last call.  A full buffer is handed back to the PDC 
+as the next buffer (RNPR) so reception continues in the other one; the part of the current buffer received so far 
+is delivered and remembered in UART_u32U0RxPdcRead.  Called from the USART0 ISR only.
+
+Requires:
+  - The USART0 PDC receives into UART_au8U0RxPdcBuffer[UART_u8U0RxPdcCurrent] and then into the other buffer
+
+Promises:
+  - All received bytes are delivered once, in order, with UartU0RxDeliver()
+  - Writing RNCR clears ENDRX
+*/
+static void UartU0RxPdcDrain(void)
+{
+  u8* pu8Start;
+  u32 u32Received;
+
+  /* RPR past the end of (or outside) the current buffer means the PDC has filled it */
+  pu8Start = &UART_au8U0RxPdcBuffer[UART_u8U0RxPdcCurrent][0];
+  u32Received = AT91C_BASE_US0->US_RPR - (u32)pu8Start;
+  while(u32Received >= U0RX_PDC_BUFFER_SIZE)
+  {
+    UartU0RxDeliver(pu8Start + UART_u32U0RxPdcRead, U0RX_PDC_BUFFER_SIZE - UART_u32U0RxPdcRead);
+
+    /* Queue the emptied buffer behind the one the PDC is filling now */
+    AT91C_BASE_US0->US_RNPR = (u32)pu8Start;
+    AT91C_BASE_US0->US_RNCR = U0RX_PDC_BUFFER_SIZE;
+
+    UART_u8U0RxPdcCurrent ^= 1;
+    UART_u32U0RxPdcRead = 0;
+    pu8Start = &UART_au8U0RxPdcBuffer[UART_u8U0RxPdcCurrent][0];
+    u32Received = AT91C_BASE_US0->US_RPR - (u32)pu8Start;
+  }
+
+  /* Deliver the partly filled current buffer */
+  if(u32Received > UART_u32U0RxPdcRead)
+  {
+    UartU0RxDeliver(pu8Start + UART_u32U0RxPdcRead, u32Received - UART_u32U0RxPdcRead);
+    UART_u32U0RxPdcRead = u32Received;
+  }
+  
+} /* end UartU0RxPdcDrain() */
+
+
 /*----------------------------------------------------------------------------------------------------------------------
 Function: UartManualMode
 
@@ -700,63 +1112,68 @@ Interrupt Service Routine: UART0_IRQHandler
 
 Description:
 Handles the enabled UART0 interrupts. 
-Receive: The UART peripheral is always enabled and ready to receive data.  Receive interrupts will occur when a
-new byte has been read by the peripheral. All incoming data is dumped into the circular receive data buffer UART_au8U0RxBuffer.
-No processing is done on the data - it is up to the processing application to parse incoming data to find useful information
-and to manage dummy bytes.
+Receive: The UART peripheral is always enabled and ready to receive data.  The PDC stores incoming bytes in the two
+UART_au8U0RxPdcBuffer buffers.  ENDRX interrupts when one is full and TIMEOUT when the line has been idle for the
+receiver time-out after a byte; either way the received bytes are moved on to UART_au8U0RxBuffer and the application
+buffer.  No processing is done on the data - it is up to the processing application to parse incoming data to find
+useful information and to manage dummy bytes.
 
-Note that if the Rx buffer is not read and U0RX_BUFFER_SIZE characters come in, all data will be lost because of the popinter wrap.
+Note that if the Rx buffer is not read, bytes that arrive while it is full are dropped.
 
-Transmit: All data bytes in the transmit buffer are immediately sent as fast as the interrupt can process them.
+Transmit: Queued messages are sent by the PDC without interrupts (see UartPdcLoad()).  Uart_putc() bytes are loaded
+into THR on TXEMPTY, which Uart_putc() enables and which is disabled once its buffer is empty.  TXEMPTY with the PDC 
+loaded is left alone: the PDC owns THR until its message is out.
 
 Requires:
-  - Only TXEMPTY and RXRDY interrupts are ever enabled
-  - Transmit and receive buffers should be correctly configured 
+  - Only ENDRX, TIMEOUT and TXEMPTY interrupts are ever enabled
+  - The receive PDC and buffers are configured by UartInitialize()
 
 Promises:
-  - If ENDRX interrupt occurs, the received character is deposited in UART_au8U0RxBuffer
-  - If ENDTX interrupt occurs, the transmit buffer is checked to see if another character should be queued to the peripheral
+  - All bytes received so far are delivered with UartU0RxPdcDrain()
+  - TIMEOUT is cleared and re-armed for the next byte; a receiver overrun sets _UART_RX_BUFFER_OVERRUN
+  - If TXEMPTY occurs and the PDC is idle, THR is loaded from UART_sU0TxRing
 */
 
 void USART0_IrqHandler(void)
 {
-  /* Check which interrupt has occurred */
-  if(AT91C_BASE_US0->US_CSR & AT91C_US_RXRDY)
+  u32 u32Status;
+  u8 u8Byte;
+
+  /* Read the status once: the flags are cleared below by the actions that service them */
+  u32Status = AT91C_BASE_US0->US_CSR;
+  
+  /* Re-arm the time-out before draining so a byte that arrives during the drain starts it again */
+  if(u32Status & AT91C_US_TIMEOUT)
   {
-    /* Move the received character into the buffer - clears the RXRDY flag */
-    *UART_pu8U0RxBufferNextChar = (u8)(AT91C_BASE_US0->US_RHR);
-    
-    /* Safely advance the pointer */
-    UART_pu8U0RxBufferNextChar++;
-    if(UART_pu8U0RxBufferNextChar == &UART_au8U0RxBuffer[U0RX_BUFFER_SIZE])
-    {
-      UART_pu8U0RxBufferNextChar = &UART_au8U0RxBuffer[0];
-    }
+    AT91C_BASE_US0->US_CR = AT91C_US_STTTO;
   }
-#if 0
-  if(AT91C_BASE_US0->US_CSR & AT91C_US_TXEMPTY)
+
+  if(u32Status & (AT91C_US_ENDRX | AT91C_US_TIMEOUT))
   {
-    /* If the transmit buffer has more data to send, then queue the next byte */
-    if(UART_pu8U0TxBufferUnsentChar != UART_pu8U0TxBufferNextChar)
-    {
-      /* Queue the next byte */
-      AT91C_BASE_US0->US_THR = *UART_pu8U0TxBufferUnsentChar;
+    UartU0RxPdcDrain();
+  }
 
-      /* Safely advance the pointer */
-      UART_pu8U0TxBufferUnsentChar++;
-      if(UART_pu8U0TxBufferUnsentChar == &UART_au8U0TxBuffer[U0TX_BUFFER_SIZE])
-      {
-        UART_pu8U0TxBufferUnsentChar = &UART_au8U0TxBuffer[0];
-      }
+  if(u32Status & AT91C_US_OVRE)
+  {
+    UART_Peripheral0.u32Flags |= _UART_RX_BUFFER_OVERRUN;
+    AT91C_BASE_US0->US_CR = AT91C_US_RSTSTA;
+  }
+
+  if( (u32Status & AT91C_US_TXEMPTY) && (AT91C_BASE_US0->US_IMR & AT91C_US_TXEMPTY) &&
+      (AT91C_BASE_US0->US_TCR == 0) && (AT91C_BASE_US0->US_TNCR == 0) )
+  {
+    /* Queue the next byte */
+    if( RingBufferRead(&UART_sU0TxRing, &u8Byte, 1) )
+    {
+      AT91C_BASE_US0->US_THR = u8Byte;
     }
-    /* Otherwise all data has been sent */
-    else
+
+    /* All data has been sent */
+    if(RingBufferUsed(&UART_sU0TxRing) == 0)
     {
-      UART_u32Flags &= _UART_U0_SENDING;
-      AT91C_BASE_US0->US_IER = AT91C_US_TXEMPTY;
+      AT91C_BASE_US0->US_IDR = AT91C_US_TXEMPTY;
     }
   }
-#endif
 } /* end UART0_IRQHandler() */
 #endif /* USE_SIMPLE_USART0 */
 
@@ -835,10 +1252,9 @@ send at the same time, though both peripherals will continue to receive simultan
 Since all transmit and receive bytes are transferred using interrupts, the SM does not have to worry about prioritizing.
 
 Transmitting on USART 0:
-When UART_pu8U0TxBufferUnsentChar doesn't match UART_pu8U0TxBufferNextChar, then we know that there is data to send.
-Data transfer is initiated by writing the first byte and setting the _UART_U0_SENDING flag to keep the USART state machine 
-busy sending all of the current data on the USART.  The interrupt service routine will be responsible for clearing the
-bit which will allow the SM to return to Idle.  
+Uart_putc() bytes are sent by the USART0 ISR on its own; the SM only re-enables TXEMPTY if bytes are waiting.
+A queued message for USART0 is not started while Uart_putc() bytes are waiting, and the ISR does not load THR while
+the PDC is sending, so the two never interleave within a message.
 
 Receiving on USART 0:
 Since the UART can only talk to one device, we will hard-code some of the functionality.  Reception of bytes will
@@ -852,39 +1268,26 @@ assume they won't.
 /* Wait for a transmit message to be queued.  Received data is handled in interrupts. */
 void UartSM_Idle(void)
 {
-#if 0 /* Debating to do this for the debug UART, but for now, send characters directly */
-  u8 u8Temp;
-
-  /* Send on the debug UART */
-  if( (UART_pu8U0TxBufferUnsentChar != UART_pu8U0TxBufferNextChar) && !(UART_u32Flags & _UART_U0_SENDING) )
+  /* UartRequest() rewrites IDR, so make sure Uart_putc() bytes keep draining */
+  if(RingBufferUsed(&UART_sU0TxRing) != 0)
   {
-    /* Flag that a send on U0 is in progress */
-    UART_u32Flags |= _UART_U0_SENDING;
-    
-    /* Get a copy of the next byte and safely advance the pointer */
-    u8Temp = *UART_pu8U0TxBufferUnsentChar;
-    UART_pu8U0TxBufferUnsentChar++;
-    if(UART_pu8U0TxBufferUnsentChar == &UART_au8U0TxBuffer[U0TX_BUFFER_SIZE])
-    {
-      UART_pu8U0TxBufferUnsentChar = &UART_au8U0TxBuffer[0];
-    }
-    
-    /* Queue the next byte and enable the Tx interrupt */
-    AT91C_BASE_US0->US_THR = u8Temp;
     AT91C_BASE_US0->US_IER = AT91C_US_TXEMPTY;
   }
-#endif 
   
-  /* Check which peripheral is processed next */
-  if(UART_psCurrentUart->pBaseAddress == (AT91S_USART*)UART_BASE_DBGU)
+  /* Check which peripheral is processed next (by object: UART and USART0 can both have the USART0 base address) */
+  if(UART_psCurrentUart == &UART_Peripheral)
+  {
+    UART_psCurrentUart = &UART_Peripheral0;
+  }
+  else if(UART_psCurrentUart == &UART_Peripheral0)
   {
     UART_psCurrentUart = &UART_Peripheral1;
   }
-  else if(UART_psCurrentUart->pBaseAddress == AT91C_BASE_US1)
+  else if(UART_psCurrentUart == &UART_Peripheral1)
   {
     UART_psCurrentUart = &UART_Peripheral2;
   }
-  else if(UART_psCurrentUart->pBaseAddress == AT91C_BASE_US2)
+  else if(UART_psCurrentUart == &UART_Peripheral2)
   {
     UART_psCurrentUart = &UART_Peripheral;
   }
@@ -893,18 +1296,18 @@ void UartSM_Idle(void)
     UART_u32Flags |= _UART_ERROR_INVALID_UART;
   }
 
-  /* Check if a message has been queued on the current UART */
-  if(UART_psCurrentUart->pTransmitBuffer != NULL)
+  /* Check if a message has been queued on the current UART.  USART0 waits for Uart_putc() output to finish so the
+  two do not interleave. */
+  if( (UART_psCurrentUart->sTransmitQueue.psHead != NULL) &&
+      ( (UART_psCurrentUart->pBaseAddress != AT91C_BASE_US0) || (RingBufferUsed(&UART_sU0TxRing) == 0) ) )
   {
-    /* Set up to transmit the message */
-    UART_u32CurrentTxBytesRemaining = UART_psCurrentUart->pTransmitBuffer->u32Size;
-    UART_pu8CurrentTxData = UART_psCurrentUart->pTransmitBuffer->pu8Message;
-    UartFillTxBuffer(UART_psCurrentUart);
-    
-    /* Update the message's status */
-    UpdateMessageStatus(UART_psCurrentUart->pTransmitBuffer->u32Token, SENDING);
+    /* Hand the message (and the one after it) to the PDC */
+    UART_psTxLastLoaded = NULL;
+    UART_u8PdcBuffersLoaded = 0;
+    UART_bMessageStarted = FALSE;
+    UartPdcLoad();
 
-    /* Proceed to next state to let the current message send */
+    /* Proceed to next state to let the messages send */
     G_UartStateMachine = UartSM_Transmitting;
   }
   
@@ -920,18 +1323,17 @@ void UartSM_Idle(void)
 
         
 /*-------------------------------------------------------------------------------------------------------------------*/
-/* Transmit in progress until current bytes have reached 0.  On exit, the transmit message must be dequeued.
+/* Transmit in progress until the PDC has sent every message it was given.  Messages are dequeued as the PDC finishes 
+them, and the next ones are chained while the PDC is busy.
 */
 void UartSM_Transmitting(void)
 {
-  /* Check if all of the message bytes have completely finished sending */
-  if( (UART_u32CurrentTxBytesRemaining == 0) && 
-      (UART_psCurrentUart->pBaseAddress->US_IER & AT91C_US_TXEMPTY) )
+  UartPdcRetire();
+  UartPdcLoad();
+  
+  /* Check if all of the loaded bytes have completely finished sending */
+  if( (UART_u8PdcBuffersLoaded == 0) && (UART_psCurrentUart->pBaseAddress->US_CSR & AT91C_US_TXEMPTY) )
   {
-    /* Update the status queue and then dequeue the message */
-    UpdateMessageStatus(UART_psCurrentUart->pTransmitBuffer->u32Token, COMPLETE);
-    DeQueueMessage(&UART_psCurrentUart->pTransmitBuffer);
-
     /* Make sure _UART_INIT_MODE flag is clear in case this was a manual cycle */
     UART_u32Flags &= ~_UART_INIT_MODE;
     G_UartStateMachine = UartSM_Idle;
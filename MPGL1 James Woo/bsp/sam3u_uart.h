@@ -26,7 +26,7 @@ typedef struct
 typedef struct 
 {
   AT91S_USART* pBaseAddress;          /* Base address of the associated peripheral */
-  MessageType* pTransmitBuffer;       /* Pointer to the transmit message linked list */
+  MessageQueueType sTransmitQueue;    /* Messages waiting to be sent */
   u8* pu8RxBuffer;                    /* Pointer to circular receive buffer in user application */
   u32 u32RxBufferSize;                /* Size of receive buffer in bytes */
   u8** pu8RxNextByte;                 /* Pointer to buffer location where next received byte will be placed */
@@ -35,7 +35,7 @@ typedef struct
 
 /* UARTx_u32Flags definitions in UartPeripheralType*/
 #define   _UART_PERIPHERAL_BUSY         (u32)0x00000001   /* Set when the peripheral is in use */
-#define   _UART_RX_BUFFER_OVERRUN       (u32)0x00000002   /* Set if the Rx FIFO overruns */
+#define   _UART_RX_BUFFER_OVERRUN       (u32)0x00000002   /* Set if received bytes are lost */
 #define   _UART_STATUS_ERROR            (u32)0x00000004   /* Set if an error is flagged in LSR */
 
 
@@ -44,7 +44,6 @@ Constants / Definitions
 **********************************************************************************************************************/
 /* UART_u32Flags (UART application flags) */
 #define _UART_INIT_MODE                 (u32)0x00000001   /* Set to push a transmit cycle during initialization mode */
-#define _UART_U0_SENDING                (u32)0x00000002   /* Set when the first Tx byte of the simple USART0 is loaded */
 
 #define _UART_ERROR_INVALID_UART        (u32)0x01000000   /* Set if an undefined UART is attempted to be parsed */
 /* end of UART_u32Flags */
@@ -56,6 +55,8 @@ Constants / Definitions
 #define U0TX_BUFFER_SIZE                (u16)256          /* Size of the simple transmit buffer in bytes */
 #define UART_TX_FIFO_SIZE               (u8)1             /* Size of the peripheral's transmit FIFO in bytes */
 #define UART_RX_FIFO_SIZE               (u8)1             /* Size of the peripheral's receive FIFO in bytes */
+#define UART_PDC_BUFFERS                (u8)2             /* PDC buffers: current (TPR/RPR) and next (TNPR/RNPR) */
+#define U0RX_PDC_BUFFER_SIZE            (u16)64           /* Size of each PDC receive buffer of the simple USART0 */
 
 /* The UART peripheral base addresses are essentially re-defined here because the defs in AT91SAM3U4.h can't be
 casted back to integers for comparisons as far as we could tell! */
@@ -90,6 +91,10 @@ void UartRelease(UartPeripheralType* psUartPeripheral_);
 
 u32 UartWriteByte(UartPeripheralType* psUartPeripheral_, u8 u8Byte_);
 u32 UartWriteData(UartPeripheralType* psUartPeripheral_, u32 u32Size_, u8* u8Data_);
+u32 UartWriteDataNoCopy(UartPeripheralType* psUartPeripheral_, u32 u32Size_, const u8* pu8Data_, 
+                        MessageReleaseType pfRelease_);
+u32 UartWriteSegments(UartPeripheralType* psUartPeripheral_, const MessageSegmentType* pasSegments_, u8 u8Segments_);
+u32 UartWriteDataUrgent(UartPeripheralType* psUartPeripheral_, u32 u32Size_, const u8* pu8Data_);
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -101,8 +106,13 @@ void UartInitialize(void);
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
-static void UartFillTxBuffer(UartPeripheralType* UartPeripheral_);
-static void UartReadRxBuffer(UartPeripheralType* psTargetUart_);
+static void UartPdcLoad(void);
+static void UartPdcRetire(void);
+static void UartCompleteMessage(void);
+static bool UartOtherQueueWaiting(void);
+static void UartReadRxBuffer(UartPeripheralType* psTargetUart_, const u8* pu8Data_, u32 u32Size_);
+static void UartU0RxDeliver(const u8* pu8Data_, u32 u32Size_);
+static void UartU0RxPdcDrain(void);
 static void UartManualMode(void);
 
 void UART_IRQHandler(void);
@@ -13,19 +13,65 @@ MessageStateType QueryMessageStatus(u32 u32Token_)
 Queries the current status of the message with u32Token.  If the message has completed or timed out, the query will
 cause the message status to be removed from the status queue.
 
+bool SetMessageCallback(u32 u32Token_, MessageCallbackType pfCallback_)
+bool SetMessageEvent(u32 u32Token_, volatile u32* pu32EventFlags_, u32 u32EventBits_)
+Asks to be told when a queued message is COMPLETE, TIMEOUT or ABANDONED instead of polling QueryMessageStatus(): the
+callback is called or the event bits are set by the transmitting driver as soon as it posts the final status, so a
+state machine that runs after the driver in the main loop sees it in the same pass.  A token has one callback and one
+event: a second registration is refused rather than replacing the first.
+
+void MessagingSnapshot(MessagingSnapshotType* psSnapshot_)
+Copies the pool use and the counters of the registered queues (depth, peak depth, messages queued, writes refused
+and the queued-to-COMPLETE latency histogram) into a snapshot for reports or for a host tool.
+
 Protected:
 void MessagingInitialize(void)
 One-time call to start the messaging application.
 
-u32 QueueMessage(u32 u32MessageSize_, u8* pu8MessageData_, MessageType** pTargetQueue_)
-Adds a message to the correct data queue, assigns a token which is posted to the status queue and returned to the client.
+u32 QueueMessage(u32 u32MessageSize_, u8* pu8MessageData_, MessageQueueType* psTargetQueue_)
+Adds a message to the tail of a transmit queue, assigns a token which is posted to the status queue and returned to the client.
 This function is Protected because tasks that can queue messages should be managed carefully and not granted free reign
-to queue message.
-
-void DeQueueMessage(MessageType** pTargetQueue_)
+to queue message.  On a queue with bCoalesce set, a write that fits in the payload block of the last message is added
+to that message if it is still WAITING and the token of that message is returned, so runs of single bytes share one
+header, block and status entry.  A shared token has one status for all its writers: QueryMessageStatus() clears a
+COMPLETE status on the first read, so only one owner can poll it.  A writer that needs its own result registers a
+callback or event, which stops later writes from being added to its message, or uses a queue without bCoalesce.
+
+u32 QueueMessagePriority(u32 u32MessageSize_, const u8* pu8MessageData_, MessagePriorityType ePriority_, 
+                         MessageQueueType* psTargetQueue_)
+Same as QueueMessage() with a priority.  An urgent message is sent after the message being sent now and any urgent
+messages queued before it, ahead of all waiting bulk messages.  QueueMessage() and QueueMessageNoCopy() queue bulk
+messages.  Drivers that keep their own per-message data in queue order (TWI) only queue bulk messages.
+
+u32 QueueMessageSegments(const MessageSegmentType* pasSegments_, u8 u8Segments_, MessagePriorityType ePriority_,
+                         MessageQueueType* psTargetQueue_)
+Queues a chain of (pointer, length) segments as one message with one token, e.g. a protocol header from flash in front
+of the caller's data.  Each segment is either copied or sent from the caller's memory; the drivers walk the segments
+as they send, so nothing is gathered into a temporary buffer.
+
+u32 QueueMessageNoCopy(u32 u32MessageSize_, const u8* pu8MessageData_, MessageReleaseType pfRelease_, 
+                       MessageQueueType* psTargetQueue_)
+Same as QueueMessage() but the message points at the caller's data instead of copying it.  Use it for const data and
+buffers the caller keeps unchanged until pfRelease_ is called (or the message status is no longer WAITING or SENDING).
+
+void DeQueueMessage(MessageQueueType* psTargetQueue_)
 Removes a message from the message queue (typically since all the bytes have been submitted to the communication peripheral
 which is sending the message.  The message status is updated in the status queue.
 
+void MessagingTrackQueue(MessageQueueType* psQueue_, const u8* pu8Name_)
+Registers a queue by name so its counters are included in a MessagingSnapshot().  Drivers call it for their transmit
+queues during initialization.
+
+Expiry: MessagingIdle() checks each status when it is due using a timing wheel (see MSG_WHEEL_BUCKETS), a few
+entries per call.  A message WAITING longer than MSG_STATUS_WAITING_TIME on a queue with bExpire set is ABANDONED and
+removed once it is at the head, so a dead peripheral does not hold pool slots forever.  On any other queue it stays
+WAITING: its driver will still send it, so no final state is posted for it.  COMPLETE, TIMEOUT and ABANDONED statuses
+are removed after MSG_STATUS_COMPLETE_TIME or MSG_STATUS_TIMEOUT_TIME.
+
+Segments: a message is one or more MessageType headers linked in the queue; bMoreSegments is set on every header but
+the last and all of them carry the same token.  A driver sends u32Size bytes from pu8Message of each header in turn 
+and dequeues the message once, which removes all of its segments.
+
 
 **********************************************************************************************************************/
 
@@ -56,12 +102,40 @@ static u32 Msg_u32Token;                                 /* Incrementing message
 
 static MessageSlot Msg_Pool[TX_QUEUE_SIZE];              /* Array of MessageSlot used for the transmit queue */
 static u8 Msg_u8QueuedMessageCount;                      /* Number of messages slots currently occupied */
+static u8 Msg_u8FreeSlot;                                /* First slot of the free list, or MSG_SLOT_NONE */
+static u8 Msg_u8PeakMessageCount;                        /* Most message slots occupied at once */
+
+/* Payload arena: one array per size class */
+static u8 Msg_au8Payload0[MSG_PAYLOAD_SIZE0 * MSG_PAYLOAD_BLOCKS0];
+static u8 Msg_au8Payload1[MSG_PAYLOAD_SIZE1 * MSG_PAYLOAD_BLOCKS1];
+static u8 Msg_au8Payload2[MSG_PAYLOAD_SIZE2 * MSG_PAYLOAD_BLOCKS2];
+static u8 Msg_au8Payload3[MSG_PAYLOAD_SIZE3 * MSG_PAYLOAD_BLOCKS3];
+
+/* Size classes from smallest to largest */
+static MessagePayloadClassType Msg_asPayloadClasses[MSG_PAYLOAD_CLASSES] = 
+{ 
+  {Msg_au8Payload0, MSG_PAYLOAD_SIZE0, MSG_PAYLOAD_BLOCKS0, 0, 0, 0},
+  {Msg_au8Payload1, MSG_PAYLOAD_SIZE1, MSG_PAYLOAD_BLOCKS1, 0, 0, 0},
+  {Msg_au8Payload2, MSG_PAYLOAD_SIZE2, MSG_PAYLOAD_BLOCKS2, 0, 0, 0},
+  {Msg_au8Payload3, MSG_PAYLOAD_SIZE3, MSG_PAYLOAD_BLOCKS3, 0, 0, 0}
+};
 
 /* A separate status queue needs to be maintained since the message information in Msg_Pool will be lost when the message
 has been dequeued.  Applications must be able to query to determine the status of their message, particularly if
-it has been sent. */
+it has been sent.  Tokens are handed out in order, so the status of a token lives at Msg_StatusQueue[token &
+STATUS_QUEUE_MASK] and is overwritten STATUS_QUEUE_SIZE tokens later; the full token stored in the entry tells a
+current status from an old one. */
 static MessageStatus Msg_StatusQueue[STATUS_QUEUE_SIZE]; /* Array of MessageStatus used to monitor message status */
-static MessageStatus* Msg_pNextStatus;                   /* Pointer to next available message status */
+
+/* Timing wheel of status entries (indexes into Msg_StatusQueue linked by u8WheelNext) */
+static u8 Msg_au8WheelBuckets[MSG_WHEEL_BUCKETS];        /* First entry of each bucket, or MSG_SLOT_NONE */
+static u8 Msg_u8WheelChecks;                             /* Entries taken from the last bucket still to check */
+static u32 Msg_u32WheelTime;                             /* Start time in ms of the next bucket to take */
+
+/* Queues reported in a snapshot */
+static MessageQueueType* Msg_apsTrackedQueues[MSG_STATS_QUEUES]; /* Registered queues */
+static const u8* Msg_apu8QueueNames[MSG_STATS_QUEUES];  /* Name of each registered queue */
+static u8 Msg_u8TrackedQueues;                           /* Number of registered queues */
 
 
 /**********************************************************************************************************************
@@ -77,37 +151,31 @@ Function: QueryMessageStatus()
 
 Description:
 Checks the state of a message.  If the state is COMPLETE or TIMEOUT, the status is deleted from the message queue.
-Since the queue is quite short, most of the time will hold very little entires, and entries are always filled at the front,
-use a simply linear search starting at index 0.
+The token selects the only entry that can hold its status, so no search is needed.
 
 Requires:
   - u32Token_ is the token of the message of interest
 
 Promises:
   - Returns MessageStateType indicating the status of the message
+  - Returns NOT_FOUND if the status was removed or has been overwritten by a newer message
   - if the message is found in COMPLETE or TIMEOUT state, the status is removed from the queue
 */
 MessageStateType QueryMessageStatus(u32 u32Token_)
 {
-  MessageStateType eStatus   = NOT_FOUND;
-  MessageStatus* pListParser = &Msg_StatusQueue[0];
+  MessageStateType eStatus = NOT_FOUND;
+  MessageStatus* psStatus  = &Msg_StatusQueue[u32Token_ & STATUS_QUEUE_MASK];
   
-  /* Search for the token */
-  while( (pListParser->u32Token != u32Token_) && (pListParser != &Msg_StatusQueue[STATUS_QUEUE_SIZE]) )
-  {
-    pListParser++;
-  }
-
-  /* If the token was found, take appropriate action */
-  if(pListParser != &Msg_StatusQueue[STATUS_QUEUE_SIZE])
+  /* If the entry still belongs to the token, take appropriate action */
+  if( (u32Token_ != 0) && (psStatus->u32Token == u32Token_) )
   {
     /* Save the status */
-    eStatus = pListParser->eState;
+    eStatus = psStatus->eState;
 
     if( (eStatus == COMPLETE) || (eStatus == TIMEOUT) )
     {
-      pListParser->u32Token = 0;
-      pListParser->eState = EMPTY;
+      psStatus->u32Token = 0;
+      psStatus->eState = EMPTY;
     }
   }
 
@@ -116,6 +184,156 @@ MessageStateType QueryMessageStatus(u32 u32Token_)
 } /* end QueryMessageStatus() */
 
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SetMessageCallback()
+
+Description:
+Installs a function to be called once when a message is done (COMPLETE, TIMEOUT or ABANDONED).  The callback runs 
+from the transmitting driver's state machine right after the final status is posted and before the message is 
+dequeued: it may queue the next message, but it must be short and must not release the peripheral.
+
+Requires:
+  - u32Token_ is a token returned by a queue function (for a multi-part message, the returned last token)
+  - pfCallback_ is the function to call; NULL removes a callback
+
+Promises:
+  - Returns TRUE and pfCallback_ will be called once with the token and its final state; if the message is already
+    done, pfCallback_ is called before this returns
+  - Returns FALSE if the status of u32Token_ is no longer in the status queue
+  - Returns FALSE and keeps the callback already installed if there is one (a coalesced token can be shared)
+*/
+bool SetMessageCallback(u32 u32Token_, MessageCallbackType pfCallback_)
+{
+  MessageStatus* psStatus = &Msg_StatusQueue[u32Token_ & STATUS_QUEUE_MASK];
+
+  if( (u32Token_ == 0) || (psStatus->u32Token != u32Token_) )
+  {
+    return(FALSE);
+  }
+  
+  if( (pfCallback_ != NULL) && (psStatus->pfCallback != NULL) )
+  {
+    return(FALSE);
+  }
+  
+  psStatus->pfCallback = pfCallback_;
+  
+  /* A message sent during the queue call (e.g. manual mode) is already done */
+  if( IsMessageDone(psStatus->eState) )
+  {
+    NotifyMessageDone(psStatus);
+  }
+  
+  return(TRUE);
+  
+} /* end SetMessageCallback() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SetMessageEvent()
+
+Description:
+Asks for bits to be set in a flags word once when a message is done (COMPLETE, TIMEOUT or ABANDONED).  The caller
+clears the bits when it has handled them.  QueryMessageStatus() tells which final state was reached.
+
+Requires:
+  - u32Token_ is a token returned by a queue function (for a multi-part message, the returned last token)
+  - pu32EventFlags_ points to the flags word of the caller; NULL removes the event
+
+Promises:
+  - Returns TRUE and u32EventBits_ will be set in *pu32EventFlags_; if the message is already done, the bits are set
+    before this returns
+  - Returns FALSE if the status of u32Token_ is no longer in the status queue
+  - Returns FALSE and keeps the event already installed if there is one (a coalesced token can be shared)
+*/
+bool SetMessageEvent(u32 u32Token_, volatile u32* pu32EventFlags_, u32 u32EventBits_)
+{
+  MessageStatus* psStatus = &Msg_StatusQueue[u32Token_ & STATUS_QUEUE_MASK];
+
+  if( (u32Token_ == 0) || (psStatus->u32Token != u32Token_) )
+  {
+    return(FALSE);
+  }
+  
+  if( (pu32EventFlags_ != NULL) && (psStatus->pu32EventFlags != NULL) )
+  {
+    return(FALSE);
+  }
+  
+  psStatus->pu32EventFlags = pu32EventFlags_;
+  psStatus->u32EventBits = u32EventBits_;
+  
+  /* A message sent during the queue call (e.g. manual mode) is already done */
+  if( IsMessageDone(psStatus->eState) )
+  {
+    NotifyMessageDone(psStatus);
+  }
+  
+  return(TRUE);
+  
+} /* end SetMessageEvent() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MessagingSnapshot()
+
+Description:
+Copies the messaging statistics into a snapshot so they can be printed or sent to a host while the counters keep
+running.
+
+Requires:
+  - psSnapshot_ points to space for the snapshot
+
+Promises:
+  - *psSnapshot_ holds the header (magic, version, size, time), the pool and payload block use and the counters of
+    every queue registered with MessagingTrackQueue(); unused queue entries are zero
+*/
+void MessagingSnapshot(MessagingSnapshotType* psSnapshot_)
+{
+  u8* pu8Byte = (u8*)psSnapshot_;
+  const u8* pu8Name;
+  
+  for(u32 i = 0; i < sizeof(MessagingSnapshotType); i++)
+  {
+    *pu8Byte++ = 0;
+  }
+  
+  psSnapshot_->u32Magic   = MSG_SNAPSHOT_MAGIC;
+  psSnapshot_->u16Version = MSG_SNAPSHOT_VERSION;
+  psSnapshot_->u16Size    = sizeof(MessagingSnapshotType);
+  psSnapshot_->u32Time    = G_u32SystemTime1ms;
+  psSnapshot_->u8PoolSize = TX_QUEUE_SIZE;
+  psSnapshot_->u8PoolUsed = Msg_u8QueuedMessageCount;
+  psSnapshot_->u8PoolPeak = Msg_u8PeakMessageCount;
+  psSnapshot_->u8Queues   = Msg_u8TrackedQueues;
+  
+  for(u8 i = 0; i < MSG_PAYLOAD_CLASSES; i++)
+  {
+    psSnapshot_->au8BlocksPeak[i] = Msg_asPayloadClasses[i].u8PeakUsed;
+  }
+  
+  for(u8 i = 0; i < Msg_u8TrackedQueues; i++)
+  {
+    /* Copy the name up to its end and pad it */
+    pu8Name = Msg_apu8QueueNames[i];
+    for(u8 j = 0; j < MSG_QUEUE_NAME_SIZE; j++)
+    {
+      if(*pu8Name != '\0')
+      {
+        psSnapshot_->asQueues[i].au8Name[j] = *pu8Name++;
+      }
+      else
+      {
+        psSnapshot_->asQueues[i].au8Name[j] = ' ';
+      }
+    }
+    
+    psSnapshot_->asQueues[i].sStats = Msg_apsTrackedQueues[i]->sStats;
+  }
+  
+} /* end MessagingSnapshot() */
+
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected Functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -124,109 +342,226 @@ MessageStateType QueryMessageStatus(u32 u32Token_)
 Function: QueueMessage
 
 Description:
-Allocates one of the positions in the message queue.
+Allocates one of the positions in the message queue and copies the data.  Messages longer than MAX_TX_MESSAGE_LENGTH
+are held in several segments, each with the smallest free payload block that holds it.  If the target queue allows 
+it, a write that fits after the last queued message is appended to it instead (see CoalesceMessage()).
 
 Requires:
-  - Msg_Pool is not full 
   - u32MessageSize_ is the size of the message data array in bytes
   - pu8MessageData_ points to the message data array
-  - pTargetQueue_ points to the linked list where the message will be queued
+  - psTargetQueue_ points to the queue where the message will be added
 
 Promises:
-  - The message is inserted into the target list and assigned a token
-  - If the message is created successfully, the message token is returned; otherwise, NULL is returned
+  - The message is inserted into the target list and assigned a token, or appended to the last message in the list 
+    and given its token
+  - If the message is created successfully, the message token is returned; otherwise, NULL is returned and nothing
+    is queued (_MESSAGING_TX_QUEUE_FULL is set)
 */
-u32 QueueMessage(u32 u32MessageSize_, u8* pu8MessageData_, MessageType** pTargetQueue_)
+u32 QueueMessage(u32 u32MessageSize_, u8* pu8MessageData_, MessageQueueType* psTargetQueue_)
 {
-  MessageSlot *psSlotParser;
-  MessageType *psNewMessage;
-  MessageType *psListParser;
-  u32 u32BytesRemaining = u32MessageSize_;
-  u32 u32CurrentMessageSize = 0;
-      
-  /* Check for available space in the message queue */
-  if(Msg_u8QueuedMessageCount == TX_QUEUE_SIZE)
+  return( QueueMessagePriority(u32MessageSize_, pu8MessageData_, MSG_PRIORITY_BULK, psTargetQueue_) );
+  
+} /* end QueueMessage() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: QueueMessagePriority
+
+Description:
+Same as QueueMessage() but the message is queued with ePriority_.  An urgent message overtakes the bulk messages that
+are WAITING; it never interrupts a message that has started sending and stays behind earlier urgent messages.
+
+Requires:
+  - u32MessageSize_ is the size of the message data array in bytes
+  - pu8MessageData_ points to the message data array
+  - ePriority_ is the priority of the message
+  - psTargetQueue_ points to the queue where the message will be added; its driver starts messages in queue order 
+    from psHead and marks each one SENDING as it does (not the TWI queue, see QueueMessageSegments())
+
+Promises:
+  - As QueueMessage(); a small urgent write may be appended to the last waiting urgent message
+*/
+u32 QueueMessagePriority(u32 u32MessageSize_, const u8* pu8MessageData_, MessagePriorityType ePriority_, 
+                         MessageQueueType* psTargetQueue_)
+{
+  MessageSegmentType sSegment;
+  u32 u32Token;
+  
+  u32Token = CoalesceMessage(u32MessageSize_, pu8MessageData_, ePriority_, psTargetQueue_);
+  if(u32Token != 0)
   {
-    G_u32MessagingFlags |= _MESSAGING_TX_QUEUE_FULL;
-    return(0);
+    return(u32Token);
   }
- 
-  /* Space available, so proceed with allocation */
-  while(u32BytesRemaining)
-  {
-    Msg_u8QueuedMessageCount++;
-    
-    /* Find an empty slot: this is non-circular and there must be at least one free slot if we're here */
-    psSlotParser = &Msg_Pool[0];
-    while(!psSlotParser->bFree)
-    {
-      psSlotParser++;
-    }
-    
-    /* Allocate the slot and set the message pointer */
-    psSlotParser->bFree = FALSE;
-    psNewMessage = &(psSlotParser->Message);
   
-    /* Check the message size and split the message up if necessary */
-    if(u32BytesRemaining > MAX_TX_MESSAGE_LENGTH)
-    {
-      u32CurrentMessageSize = MAX_TX_MESSAGE_LENGTH;
-      u32BytesRemaining -= MAX_TX_MESSAGE_LENGTH;
-    }
-    else
-    {
-      u32CurrentMessageSize = u32BytesRemaining;
-      u32BytesRemaining = 0;
-    }
-    
-    /* Copy all the data to the allocated message structure */
-    psNewMessage->u32Token      = Msg_u32Token;
-    psNewMessage->u32Size       = u32CurrentMessageSize;
-    psNewMessage->psNextMessage = NULL;
-    
-    
-    /* Add the data into the payload */
-    for(u32 i = 0; i < psNewMessage->u32Size; i++)
-    {
-      *(psNewMessage->pu8Message + i) = *pu8MessageData_++;
-    }
+  sSegment.pu8Data = pu8MessageData_;
+  sSegment.u32Size = u32MessageSize_;
+  sSegment.bCopy   = TRUE;
   
-    /* Link the new message */
-    /* Handle an empty list */
-    if(*pTargetQueue_ == NULL)
-    {
-      *pTargetQueue_ = psNewMessage;
-    }
+  return( QueueMessageSegments(&sSegment, 1, ePriority_, psTargetQueue_) );
+  
+} /* end QueueMessagePriority() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: QueueMessageSegments
+
+Description:
+Queues a list of segments as one message with one token.  Copied segments take payload blocks (split at 
+MAX_TX_MESSAGE_LENGTH); other segments take only a header and are sent straight from the caller's memory.
+
+Requires:
+  - pasSegments_ points to u8Segments_ segments in the order they are sent; empty segments are skipped
+  - Data of segments with bCopy FALSE is const or stays unchanged until the message is done
+  - ePriority_ is the priority of the message; MSG_PRIORITY_BULK for queues whose driver keeps per-message data in 
+    queue order (TWI)
+  - psTargetQueue_ points to the queue where the message will be added
 
-    /* Add the message to the end of the list */
-    else
+Promises:
+  - The segments are inserted into the target list as one message and the message token is returned
+  - Returns 0 and queues nothing if there are not enough headers or payload blocks (_MESSAGING_TX_QUEUE_FULL is set)
+    or the segments are all empty
+*/
+u32 QueueMessageSegments(const MessageSegmentType* pasSegments_, u8 u8Segments_, MessagePriorityType ePriority_,
+                         MessageQueueType* psTargetQueue_)
+{
+  MessageType *psNewMessage;
+  MessageType *psFirstMessage = NULL;
+  MessageType *psLastMessage = NULL;
+  const u8* pu8Data;
+  u32 u32BytesRemaining;
+  u32 u32CurrentMessageSize;
+      
+  /* Allocate and fill every segment first so a message that does not fit leaves the queues untouched */
+  for(u8 i = 0; i < u8Segments_; i++)
+  {
+    pu8Data = pasSegments_[i].pu8Data;
+    u32BytesRemaining = pasSegments_[i].u32Size;
+    
+    while(u32BytesRemaining)
     {
-      /* Find the last node */
-      psListParser =  *pTargetQueue_;
-      while(psListParser->psNextMessage != NULL)
+      if(pasSegments_[i].bCopy)
       {
-        psListParser = psListParser->psNextMessage;
+        /* Copied data is split up to fit the payload blocks */
+        if(u32BytesRemaining > MAX_TX_MESSAGE_LENGTH)
+        {
+          u32CurrentMessageSize = MAX_TX_MESSAGE_LENGTH;
+        }
+        else
+        {
+          u32CurrentMessageSize = u32BytesRemaining;
+        }
+        
+        psNewMessage = AllocateMessageSlot(u32CurrentMessageSize);
+        if(psNewMessage != NULL)
+        {
+          for(u32 j = 0; j < u32CurrentMessageSize; j++)
+          {
+            *(psNewMessage->pu8Message + j) = *(pu8Data + j);
+          }
+        }
       }
-     
-      /* Found the end: add the new node */
-      psListParser->psNextMessage = psNewMessage;
-    }
+      else
+      {
+        /* The senders only read the payload, so the caller's data can be pointed at directly */
+        u32CurrentMessageSize = u32BytesRemaining;
+        psNewMessage = AllocateMessageHeader();
+        if(psNewMessage != NULL)
+        {
+          psNewMessage->pu8Message = (u8*)pu8Data;
+        }
+      }
+      
+      if(psNewMessage == NULL)
+      {
+        /* Out of headers or payload blocks: give back the segments already taken */
+        FreeMessageChain(psFirstMessage);
+        G_u32MessagingFlags |= _MESSAGING_TX_QUEUE_FULL;
+        psTargetQueue_->sStats.u32Rejected++;
+        return(0);
+      }
+      
+      psNewMessage->u32Size       = u32CurrentMessageSize;
+      psNewMessage->psNextMessage = NULL;
+      psNewMessage->bMoreSegments = TRUE;
+      pu8Data += u32CurrentMessageSize;
+      u32BytesRemaining -= u32CurrentMessageSize;
+
+      /* Chain the segments together */
+      if(psFirstMessage == NULL)
+      {
+        psFirstMessage = psNewMessage;
+      }
+      else
+      {
+        psLastMessage->psNextMessage = psNewMessage;
+      }
+      psLastMessage = psNewMessage;
+      
+    } /* end while */
+  }
+
+  /* Nothing to send */
+  if(psFirstMessage == NULL)
+  {
+    return(0);
+  }
+
+  psLastMessage->bMoreSegments = FALSE;
+  return( LinkMessages(psFirstMessage, psLastMessage, ePriority_, psTargetQueue_) );
+  
+} /* end QueueMessageSegments() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: QueueMessageNoCopy
+
+Description:
+Queues a message whose payload stays in the caller's memory: only a header is taken from Msg_Pool, no payload block
+is used and nothing is copied.  The message is never split since the peripherals send u32Size bytes straight from
+pu8Message, so any length can be sent as one message.
+
+Requires:
+  - u32MessageSize_ is the size of the message data array in bytes
+  - pu8MessageData_ points to the message data array, which is const (e.g. a string in flash) or is left unchanged
+    by the caller until the message is released; the messaging task only reads it
+  - pfRelease_ is called with pu8MessageData_ when the message is dequeued (sent or abandoned); NULL if the caller
+    does not need to know (e.g. const data)
+  - psTargetQueue_ points to the queue where the message will be added
+
+Promises:
+  - The message is inserted into the target list and assigned a token which is returned
+  - Returns 0 if no header is free (_MESSAGING_TX_QUEUE_FULL is set) or u32MessageSize_ is 0; pfRelease_ is not
+    called and the caller still owns the data
+*/
+u32 QueueMessageNoCopy(u32 u32MessageSize_, const u8* pu8MessageData_, MessageReleaseType pfRelease_, 
+                       MessageQueueType* psTargetQueue_)
+{
+  MessageType *psNewMessage;
   
-    /* Update the Public status of the message in the status queue */
-    AddNewMessageStatus(Msg_u32Token);
+  /* Nothing to send */
+  if(u32MessageSize_ == 0)
+  {
+    return(0);
+  }
   
-    /* Increment message token and catch the rollover every 4 billion messages... */
-    if(++Msg_u32Token == 0)
-    {
-      Msg_u32Token = 1;
-    }
+  psNewMessage = AllocateMessageHeader();
+  if(psNewMessage == NULL)
+  {
+    G_u32MessagingFlags |= _MESSAGING_TX_QUEUE_FULL;
+    psTargetQueue_->sStats.u32Rejected++;
+    return(0);
+  }
   
-  } /* end while */
-
-  /* Return only the highest message token, as it will be the last portion to be sent if multi-part */
-  return(psNewMessage->u32Token);
+  /* The senders only read the payload, so the const data can be pointed at directly */
+  psNewMessage->u32Size       = u32MessageSize_;
+  psNewMessage->pu8Message    = (u8*)pu8MessageData_;
+  psNewMessage->pfRelease     = pfRelease_;
+  psNewMessage->psNextMessage = NULL;
+  psNewMessage->bMoreSegments = FALSE;
   
-} /* end QueueMessage() */
+  return( LinkMessages(psNewMessage, psNewMessage, MSG_PRIORITY_BULK, psTargetQueue_) );
+  
+} /* end QueueMessageNoCopy() */
 
 
 /*----------------------------------------------------------------------------------------------------------------------
@@ -241,152 +576,122 @@ Requires:
   - Msg_Pool is not full 
   - u32MessageSize_ is the size of the message data array in bytes
   - pu8MessageData_ points to the message data array
-  - pTargetQueue_ points to the linked list where the message will be queued
+  - psTargetQueue_ points to the queue where the message will be added
 
 Promises:
   - The message is inserted into the target list and assigned a token
   - If the message is created successfully, the message token is returned; otherwise, NULL is returned
 */
-u32 QueueMessageLCD(u32 u32MessageSize_, u8* pu8MessageData_, MessageType** pTargetQueue_)
+u32 QueueMessageLCD(u32 u32MessageSize_, u8* pu8MessageData_, MessageQueueType* psTargetQueue_)
 {
-  MessageSlot *psSlotParser;
-  MessageType *psNewMessage;
-  MessageType *psListParser;
-  u32 u32BytesRemaining = u32MessageSize_;
-  u32 u32CurrentMessageSize = 0;
+  return( QueueMessage(u32MessageSize_, pu8MessageData_, psTargetQueue_) );
+  
+} /* end QueueMessageLCD() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: DeQueueMessage
+
+Description:
+Removes a message (all of its segments) from a message queue and adds it back to the pool.  Each header holds its
+slot index, so this takes the same time whichever slots the message used.
+
+Requires:
+  - psTargetQueue_ points to the queue where the message to be deleted is located
+  - The message that needs to be killed is at the head of the queue
+  - The message to be removed has been completely sent and is no longer in use
+  - New message cannot be added into the list during this function (via interrupts)
+
+Promises:
+  - The first message in the queue is deleted; the queue is hooked back up (psTail is left stale once psHead is NULL)
+  - psLastUrgent is cleared when the last urgent message is deleted
+  - The message space is added back to the available message queue
+*/
+void DeQueueMessage(MessageQueueType* psTargetQueue_)
+{
+  MessageType *psMessage;
+  bool bMoreSegments;
+  u8 u8SlotIndex;
       
-  /* Check for available space in the message queue */
-  if(Msg_u8QueuedMessageCount == TX_QUEUE_SIZE)
+  /* Make sure there is a message to kill */
+  if(psTargetQueue_->psHead == NULL)
   {
-    G_u32MessagingFlags |= _MESSAGING_TX_QUEUE_FULL;
-    return(0);
+    G_u32MessagingFlags |= _DEQUEUE_GOT_NULL;
+    return;
   }
- 
-  /* Space available, so proceed with allocation */
-  while(u32BytesRemaining)
+  
+  do
   {
-    Msg_u8QueuedMessageCount++;
-    
-    /* Find an empty slot: this is non-circular and there must be at least one free slot if we're here */
-    psSlotParser = &Msg_Pool[0];
-    while(!psSlotParser->bFree)
+    /* Each header knows its slot; make sure it really is an allocated message from the pool */
+    u8SlotIndex = psTargetQueue_->psHead->u8SlotIndex;
+    if( (u8SlotIndex >= TX_QUEUE_SIZE) || (&Msg_Pool[u8SlotIndex].Message != psTargetQueue_->psHead) ||
+        Msg_Pool[u8SlotIndex].bFree )
     {
-      psSlotParser++;
+      G_u32MessagingFlags |= _DEQUEUE_MSG_NOT_FOUND;
+      return;
     }
-    
-    /* Allocate the slot and set the message pointer */
-    psSlotParser->bFree = FALSE;
-    psNewMessage = &(psSlotParser->Message);
   
-    /* Check the message size and split the message up if necessary */
-    if(u32BytesRemaining > MAX_TX_MESSAGE_LENGTH)
-    {
-      u32CurrentMessageSize = MAX_TX_MESSAGE_LENGTH;
-      u32BytesRemaining -= MAX_TX_MESSAGE_LENGTH;
-    }
-    else
+    /* Unhook the segment from the current owner's queue and put it back in the pool */
+    psMessage = psTargetQueue_->psHead;
+    bMoreSegments = psMessage->bMoreSegments;
+    psTargetQueue_->psHead = psMessage->psNextMessage;
+    if(psMessage == psTargetQueue_->psLastUrgent)
     {
-      u32CurrentMessageSize = u32BytesRemaining;
-      u32BytesRemaining = 0;
+      psTargetQueue_->psLastUrgent = NULL;
     }
+    FreeMessageSlot(psMessage);
     
-    /* Copy all the data to the allocated message structure */
-    psNewMessage->u32Token      = Msg_u32Token;
-    psNewMessage->u32Size       = u32CurrentMessageSize;
-    psNewMessage->psNextMessage = NULL;
-    
-    
-    /* Add the data into the payload */
-    for(u32 i = 0; i < psNewMessage->u32Size; i++)
-    {
-      *(psNewMessage->pu8Message + i) = *pu8MessageData_++;
-    }
-  
-    /* Link the new message */
-    /* Handle an empty list */
-    if(*pTargetQueue_ == NULL)
-    {
-      *pTargetQueue_ = psNewMessage;
-    }
-
-    /* Add the message to the end of the list */
-    else
-    {
-      /* Find the last node */
-      psListParser =  *pTargetQueue_;
-      while(psListParser->psNextMessage != NULL)
-      {
-        psListParser = psListParser->psNextMessage;
-      }
-     
-      /* Found the end: add the new node */
-      psListParser->psNextMessage = psNewMessage;
-    }
-  
-    /* Update the Public status of the message in the status queue */
-    AddNewMessageStatus(Msg_u32Token);
-  
-    /* Increment message token and catch the rollover every 4 billion messages... */
-    if(++Msg_u32Token == 0)
+    if(!bMoreSegments)
     {
-      Msg_u32Token = 1;
+      psTargetQueue_->sStats.u32Depth--;
     }
+    
+  } while( bMoreSegments && (psTargetQueue_->psHead != NULL) );
   
-  } /* end while */
-
-  /* Return only the highest message token, as it will be the last portion to be sent if multi-part */
-  return(psNewMessage->u32Token);
-  
-} /* end QueueMessageLCD() */
+} /* end DeQueueMessage() */
 
 
 /*----------------------------------------------------------------------------------------------------------------------
-Function: DeQueueMessage
+Function: MessagingTrackQueue
 
 Description:
-Removes a message from a message queue and adds it back to the pool.
+Registers a transmit queue so its counters are reported by MessagingSnapshot().
 
 Requires:
-  - pTargetQueue_ points to the list queue where the message to be deleted is located
-  - pTargetQueue_ is a FIFO linked-list where the message that needs to be killed is at the front of the list
-  - The message to be removed has been completely sent and is no longer in use
-  - New message cannot be added into the list during this function (via interrupts)
+  - MessagingInitialize() has run
+  - psQueue_ is a transmit queue that stays in place (a driver's peripheral object)
+  - pu8Name_ is a constant string; the first MSG_QUEUE_NAME_SIZE characters are reported
 
 Promises:
-  - The first message in the list is deleted; the list is hooked back up
-  - The message space is added back to the available message queue
+  - The counters of the queue are cleared and the queue is registered, if it is not already and there is room
+    (MSG_STATS_QUEUES)
 */
-void DeQueueMessage(MessageType** pTargetQueue_)
+void MessagingTrackQueue(MessageQueueType* psQueue_, const u8* pu8Name_)
 {
-  MessageSlot *psSlotParser;
-      
-  /* Make sure there is a message to kill */
-  if(*pTargetQueue_ == NULL)
+  u8* pu8Byte = (u8*)&psQueue_->sStats;
+  
+  for(u32 i = 0; i < sizeof(MessageQueueStatsType); i++)
   {
-    G_u32MessagingFlags |= _DEQUEUE_GOT_NULL;
-    return;
+    *pu8Byte++ = 0;
   }
   
-  /* Find the message's slot: this message pool is non-circular and the message must be one of the slots */
-  psSlotParser = &Msg_Pool[0];
-  while( (&psSlotParser->Message != *pTargetQueue_) && (psSlotParser != &Msg_Pool[TX_QUEUE_SIZE]) )
+  for(u8 i = 0; i < Msg_u8TrackedQueues; i++)
   {
-    psSlotParser++;
+    if(Msg_apsTrackedQueues[i] == psQueue_)
+    {
+      Msg_apu8QueueNames[i] = pu8Name_;
+      return;
+    }
   }
-
-  /* Make sure the message has been found */
-  if(psSlotParser == &Msg_Pool[TX_QUEUE_SIZE])
+  
+  if(Msg_u8TrackedQueues < MSG_STATS_QUEUES)
   {
-    G_u32MessagingFlags |= _DEQUEUE_MSG_NOT_FOUND;
-    return;
+    Msg_apsTrackedQueues[Msg_u8TrackedQueues] = psQueue_;
+    Msg_apu8QueueNames[Msg_u8TrackedQueues] = pu8Name_;
+    Msg_u8TrackedQueues++;
   }
-
-  /* Unhook the message from the current owner's queue and put it back in the pool */
-  *pTargetQueue_ = (*pTargetQueue_)->psNextMessage;
-  psSlotParser->bFree = TRUE;
-  Msg_u8QueuedMessageCount--;
   
-} /* end DeQueueMessage() */
+} /* end MessagingTrackQueue() */
 
 
 /*--------------------------------------------------------------------------------------------------------------------
@@ -404,14 +709,37 @@ Promises:
 */
 void MessagingInitialize(void)
 {
+  MessagePayloadClassType* psClass;
+  
   /* Inititalize variables */
   Msg_u8QueuedMessageCount = 0;
+  Msg_u8PeakMessageCount = 0;
+  Msg_u8TrackedQueues = 0;
   Msg_u32Token = 1;
 
-  /* Ensure all message slots are deallocated and the message status queue is empty */
+  /* Ensure all message slots are deallocated (linked in order on the free list) and the message status queue is empty */
   for(u16 i = 0; i < TX_QUEUE_SIZE; i++)
   {
     Msg_Pool[i].bFree = TRUE;
+    Msg_Pool[i].u8NextFree = (u8)(i + 1);
+    Msg_Pool[i].Message.u8SlotIndex = (u8)i;
+  }
+  Msg_Pool[TX_QUEUE_SIZE - 1].u8NextFree = MSG_SLOT_NONE;
+  Msg_u8FreeSlot = 0;
+
+  /* Link the blocks of each payload class on its free list */
+  for(u8 i = 0; i < MSG_PAYLOAD_CLASSES; i++)
+  {
+    psClass = &Msg_asPayloadClasses[i];
+    for(u8 j = 0; j < psClass->u8Blocks; j++)
+    {
+      psClass->pu8Blocks[j * psClass->u8BlockSize] = (u8)(j + 1);
+    }
+    
+    psClass->pu8Blocks[(psClass->u8Blocks - 1) * psClass->u8BlockSize] = MSG_SLOT_NONE;
+    psClass->u8FreeBlock = 0;
+    psClass->u8FreeCount = psClass->u8Blocks;
+    psClass->u8PeakUsed = 0;
   }
 
   for(u16 i = 0; i < STATUS_QUEUE_SIZE; i++)
@@ -419,10 +747,19 @@ void MessagingInitialize(void)
     Msg_StatusQueue[i].u32Token = 0;
     Msg_StatusQueue[i].eState = EMPTY;
     Msg_StatusQueue[i].u32Timestamp = 0;
+    Msg_StatusQueue[i].pfCallback = NULL;
+    Msg_StatusQueue[i].pu32EventFlags = NULL;
+    Msg_StatusQueue[i].psQueue = NULL;
+    Msg_StatusQueue[i].bInWheel = FALSE;
   }
 
-  Msg_pNextStatus = &Msg_StatusQueue[0];
-
+  for(u8 i = 0; i < MSG_WHEEL_BUCKETS; i++)
+  {
+    Msg_au8WheelBuckets[i] = MSG_SLOT_NONE;
+  }
+  Msg_u8WheelChecks = MSG_SLOT_NONE;
+  Msg_u32WheelTime = G_u32SystemTime1ms & ~(MSG_WHEEL_SLOT_TIME - 1);
+
   G_u32MessagingFlags = 0;
   G_MessagingStateMachine = MessagingIdle;
 
@@ -433,29 +770,37 @@ void MessagingInitialize(void)
 Function: UpdateMessageStatus()
 
 Description:
-Changes the status of a message in the statue queue.
+Changes the status of a message in the statue queue.  Drivers post the final status before they dequeue the message.
 
 Requires:
   - u32Token_ is message that should be in the status queue
   - eNewState_ is the desired status setting for the message
 
 Promises:
-  - eState of the message is set to eNewState_
+  - eState of the message is set to eNewState_ and u32Timestamp to the current time
+  - The first COMPLETE adds the time since the message was queued to the latency histogram of its queue
+  - If eNewState_ is COMPLETE, TIMEOUT or ABANDONED, the callback and event bits of the message are fired
 */
 void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_)
 {
-  MessageStatus* pListParser = &Msg_StatusQueue[0];
+  MessageStatus* psStatus = &Msg_StatusQueue[u32Token_ & STATUS_QUEUE_MASK];
   
-  /* Search for the token */
-  while( (pListParser->u32Token != u32Token_) && (pListParser != &Msg_StatusQueue[STATUS_QUEUE_SIZE]) )
-  {
-    pListParser++;
-  }
-
-  /* If the token was found, change the status */
-  if(pListParser != &Msg_StatusQueue[STATUS_QUEUE_SIZE])
+  /* If the entry still belongs to the token, change the status */
+  if( (u32Token_ != 0) && (psStatus->u32Token == u32Token_) )
   {
-    pListParser->eState = eNewState_;
+    /* Count the time from queued to sent once */
+    if( (eNewState_ == COMPLETE) && !IsMessageDone(psStatus->eState) )
+    {
+      RecordLatency(&psStatus->psQueue->sStats, G_u32SystemTime1ms - psStatus->u32QueueTime);
+    }
+    
+    psStatus->eState = eNewState_;
+    psStatus->u32Timestamp = G_u32SystemTime1ms;
+    
+    if( IsMessageDone(eNewState_) )
+    {
+      NotifyMessageDone(psStatus);
+    }
   }
   
 } /* end UpdateMessageStatus() */
@@ -465,52 +810,673 @@ void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_)
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AllocateMessageHeader()
+
+Description:
+Takes a message header off the free list without a payload block.  The message is marked MSG_PAYLOAD_BORROWED
+with no release callback until the caller fills it in.
+
+Requires:
+  - 
+
+Promises:
+  - Returns the message marked in use and Msg_u8QueuedMessageCount is incremented
+  - Returns NULL if no header is free
+*/
+static MessageType* AllocateMessageHeader(void)
+{
+  MessageSlot* psSlot;
+
+  if(Msg_u8FreeSlot == MSG_SLOT_NONE)
+  {
+    return(NULL);
+  }
+  
+  psSlot = &Msg_Pool[Msg_u8FreeSlot];
+  Msg_u8FreeSlot = psSlot->u8NextFree;
+  psSlot->bFree = FALSE;
+  Msg_u8QueuedMessageCount++;
+  if(Msg_u8QueuedMessageCount > Msg_u8PeakMessageCount)
+  {
+    Msg_u8PeakMessageCount = Msg_u8QueuedMessageCount;
+  }
+  
+  psSlot->Message.u8PayloadClass = MSG_PAYLOAD_BORROWED;
+  psSlot->Message.bMoreSegments = FALSE;
+  psSlot->Message.bStarted = FALSE;
+  psSlot->Message.pfRelease = NULL;
+
+  return( &psSlot->Message );
+
+} /* end AllocateMessageHeader() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AllocateMessageSlot()
+
+Description:
+Takes a message header off the free list and a payload block from the smallest size class that holds u32Size_ and
+has a free block.  Freed headers and blocks are pushed on the front of their lists by FreeMessageSlot(), so
+allocation never searches the pool.
+
+Requires:
+  - u32Size_ is 1 to MAX_TX_MESSAGE_LENGTH
+
+Promises:
+  - Returns the message with its payload block, marked in use, and Msg_u8QueuedMessageCount is incremented
+  - Returns NULL if no header or no large enough payload block is free
+*/
+static MessageType* AllocateMessageSlot(u32 u32Size_)
+{
+  MessageType* psMessage;
+  MessagePayloadClassType* psClass;
+  u8 u8Class = 0;
+
+  if(Msg_u8FreeSlot == MSG_SLOT_NONE)
+  {
+    return(NULL);
+  }
+  
+  /* Find the smallest class that fits and has a free block */
+  while( (u8Class < MSG_PAYLOAD_CLASSES) && 
+         ((Msg_asPayloadClasses[u8Class].u8BlockSize < u32Size_) || (Msg_asPayloadClasses[u8Class].u8FreeCount == 0)) )
+  {
+    u8Class++;
+  }
+  
+  if(u8Class == MSG_PAYLOAD_CLASSES)
+  {
+    return(NULL);
+  }
+
+  /* Take the header (known to be free) and the payload block */
+  psMessage = AllocateMessageHeader();
+  psClass = &Msg_asPayloadClasses[u8Class];
+  psMessage->u8PayloadClass = u8Class;
+  psMessage->u8PayloadBlock = psClass->u8FreeBlock;
+  psMessage->pu8Message = &psClass->pu8Blocks[psClass->u8FreeBlock * psClass->u8BlockSize];
+  psClass->u8FreeBlock = *psMessage->pu8Message;
+  psClass->u8FreeCount--;
+  if( (psClass->u8Blocks - psClass->u8FreeCount) > psClass->u8PeakUsed )
+  {
+    psClass->u8PeakUsed = psClass->u8Blocks - psClass->u8FreeCount;
+  }
+
+  return(psMessage);
+
+} /* end AllocateMessageSlot() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: FreeMessageSlot()
+
+Description:
+Returns a message header and its payload block to their free lists.  A borrowed payload is handed back to its owner
+instead.
+
+Requires:
+  - psMessage_ was returned by AllocateMessageSlot() or AllocateMessageHeader() and has not been freed since
+  - psMessage_ is no longer linked in any queue
+
+Promises:
+  - The header and payload block are free and Msg_u8QueuedMessageCount is decremented
+  - The release callback of a borrowed payload is called
+*/
+static void FreeMessageSlot(MessageType* psMessage_)
+{
+  MessageSlot* psSlot = &Msg_Pool[psMessage_->u8SlotIndex];
+  MessagePayloadClassType* psClass;
+
+  if(psMessage_->u8PayloadClass == MSG_PAYLOAD_BORROWED)
+  {
+    if(psMessage_->pfRelease != NULL)
+    {
+      psMessage_->pfRelease(psMessage_->pu8Message);
+    }
+  }
+  else
+  {
+    /* Payload block first: its first byte becomes the free list link */
+    psClass = &Msg_asPayloadClasses[psMessage_->u8PayloadClass];
+    *psMessage_->pu8Message = psClass->u8FreeBlock;
+    psClass->u8FreeBlock = psMessage_->u8PayloadBlock;
+    psClass->u8FreeCount++;
+  }
+
+  psSlot->bFree = TRUE;
+  psSlot->u8NextFree = Msg_u8FreeSlot;
+  Msg_u8FreeSlot = psMessage_->u8SlotIndex;
+  Msg_u8QueuedMessageCount--;
+
+} /* end FreeMessageSlot() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: FreeMessageChain()
+
+Description:
+Returns a chain of messages that were allocated but never queued.
+
+Requires:
+  - psFirstMessage_ starts a chain linked by psNextMessage and ending in NULL, or is NULL
+
+Promises:
+  - Every message of the chain is freed
+*/
+static void FreeMessageChain(MessageType* psFirstMessage_)
+{
+  MessageType* psNextMessage;
+  
+  while(psFirstMessage_ != NULL)
+  {
+    psNextMessage = psFirstMessage_->psNextMessage;
+    FreeMessageSlot(psFirstMessage_);
+    psFirstMessage_ = psNextMessage;
+  }
+  
+} /* end FreeMessageChain() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: CoalesceMessage()
+
+Description:
+Appends a small write to the last message of its priority in a coalescing queue (psTail for bulk, psLastUrgent for
+urgent).  That message must still be WAITING and not started (the driver has not read its size) and own a payload
+block with room for the data; borrowed payloads are never written to.  The writer shares the token of that message,
+so its status covers both writes.  A message with a callback or event is never added to: the notification belongs
+to the writer that registered it.  Only one owner can poll a shared token, since the first QueryMessageStatus() that
+sees it COMPLETE removes the status.
+
+Requires:
+  - u32MessageSize_ is the size of the message data array in bytes
+  - pu8MessageData_ points to the message data array
+  - ePriority_ is the priority of the write
+  - psTargetQueue_ points to the queue where the message will be added
+
+Promises:
+  - If the data fits, it is copied after the payload of the last message of ePriority_ and the token of that 
+    message is returned
+  - Otherwise returns 0 and nothing is changed
+*/
+static u32 CoalesceMessage(u32 u32MessageSize_, const u8* pu8MessageData_, MessagePriorityType ePriority_,
+                           MessageQueueType* psTargetQueue_)
+{
+  MessageType* psTail = psTargetQueue_->psTail;
+  MessageStatus* psStatus;
+  
+  if(ePriority_ == MSG_PRIORITY_URGENT)
+  {
+    psTail = psTargetQueue_->psLastUrgent;
+  }
+  
+  /* A bulk write is not added to an urgent message at the end of the queue */
+  if( !psTargetQueue_->bCoalesce || (psTargetQueue_->psHead == NULL) || (u32MessageSize_ == 0) || 
+      (psTail == NULL) || ((ePriority_ == MSG_PRIORITY_BULK) && (psTail == psTargetQueue_->psLastUrgent)) ||
+      (psTail->u8PayloadClass == MSG_PAYLOAD_BORROWED) || psTail->bStarted )
+  {
+    return(0);
+  }
+  
+  if( (psTail->u32Size + u32MessageSize_) > Msg_asPayloadClasses[psTail->u8PayloadClass].u8BlockSize )
+  {
+    return(0);
+  }
+  
+  /* The status entry tells whether the driver has started on the message and whether a writer is waiting on it */
+  psStatus = &Msg_StatusQueue[psTail->u32Token & STATUS_QUEUE_MASK];
+  if( (psStatus->u32Token != psTail->u32Token) || (psStatus->eState != WAITING) ||
+      (psStatus->pfCallback != NULL) || (psStatus->pu32EventFlags != NULL) )
+  {
+    return(0);
+  }
+  
+  for(u32 i = 0; i < u32MessageSize_; i++)
+  {
+    *(psTail->pu8Message + psTail->u32Size + i) = *(pu8MessageData_ + i);
+  }
+  psTail->u32Size += u32MessageSize_;
+  
+  return(psTail->u32Token);
+  
+} /* end CoalesceMessage() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LinkMessages()
+
+Description:
+Gives each message of a chain a token, posts its status and links the chain into a queue.  All the segments of a 
+message get the same token.  Bulk messages go at the tail.  Urgent messages go after the last urgent message; if 
+there is none they go at the front, or right after the messages the driver has started.  They never go ahead of a 
+started message.
+
+Requires:
+  - psFirstMessage_ to psLastMessage_ is a chain of allocated messages linked by psNextMessage and ending in NULL
+  - ePriority_ is the priority of the chain
+  - psTargetQueue_ points to the queue where the messages will be added
+
+Promises:
+  - Every message has a token and a WAITING status and the chain is in psTargetQueue_
+  - Returns the token of psLastMessage_
+*/
+static u32 LinkMessages(MessageType* psFirstMessage_, MessageType* psLastMessage_, MessagePriorityType ePriority_,
+                        MessageQueueType* psTargetQueue_)
+{
+  MessageType* psMessage;
+  MessageType* psAfter;
+  MessageType* psNext;
+  bool bStarted;
+  
+  /* Assign the tokens and post each message to the status queue once its last segment is reached */
+  for(psMessage = psFirstMessage_; psMessage != NULL; psMessage = psMessage->psNextMessage)
+  {
+    psMessage->u32Token = Msg_u32Token;
+    if(!psMessage->bMoreSegments)
+    {
+      AddNewMessageStatus(Msg_u32Token, psTargetQueue_);
+      psTargetQueue_->sStats.u32Queued++;
+      psTargetQueue_->sStats.u32Depth++;
+    
+      /* Increment message token and catch the rollover every 4 billion messages... */
+      if(++Msg_u32Token == 0)
+      {
+        Msg_u32Token = 1;
+      }
+    }
+  }
+  
+  /* Link the parts at the tail of the queue */
+  if(psTargetQueue_->psHead == NULL)
+  {
+    psTargetQueue_->psHead = psFirstMessage_;
+    psTargetQueue_->psTail = psLastMessage_;
+    psTargetQueue_->psLastUrgent = NULL;
+  }
+  else if(ePriority_ == MSG_PRIORITY_BULK)
+  {
+    psTargetQueue_->psTail->psNextMessage = psFirstMessage_;
+    psTargetQueue_->psTail = psLastMessage_;
+  }
+  else
+  {
+    /* Urgent: find the message to follow, or go first if the driver has not started the head */
+    psAfter = psTargetQueue_->psLastUrgent;
+    if(psAfter == NULL)
+    {
+      if(!psTargetQueue_->psHead->bStarted)
+      {
+        psLastMessage_->psNextMessage = psTargetQueue_->psHead;
+        psTargetQueue_->psHead = psFirstMessage_;
+      }
+      else
+      {
+        psAfter = psTargetQueue_->psHead;
+      }
+    }
+    
+    if(psAfter != NULL)
+    {
+      /* Follow the last segment, and any messages after it the driver has already started (a DMA driver chains the
+      next message while one is sending) */
+      do
+      {
+        while(psAfter->bMoreSegments)
+        {
+          psAfter = psAfter->psNextMessage;
+        }
+        
+        psNext = psAfter->psNextMessage;
+        bStarted = (psNext != NULL) && psNext->bStarted;
+        if(bStarted)
+        {
+          psAfter = psNext;
+        }
+      } while(bStarted);
+      
+      psLastMessage_->psNextMessage = psAfter->psNextMessage;
+      psAfter->psNextMessage = psFirstMessage_;
+      if(psAfter == psTargetQueue_->psTail)
+      {
+        psTargetQueue_->psTail = psLastMessage_;
+      }
+    }
+  }
+
+  if(ePriority_ == MSG_PRIORITY_URGENT)
+  {
+    psTargetQueue_->psLastUrgent = psLastMessage_;
+  }
+
+  if(psTargetQueue_->sStats.u32Depth > psTargetQueue_->sStats.u32PeakDepth)
+  {
+    psTargetQueue_->sStats.u32PeakDepth = psTargetQueue_->sStats.u32Depth;
+  }
+
+  /* Return the token of the last message */
+  return(psLastMessage_->u32Token);
+  
+} /* end LinkMessages() */
+
+
 /*----------------------------------------------------------------------------------------------------------------------
 Function: AddNewMessageStatus()
 
 Description:
 Adds a new mesage into the status queue.  Due to the tendancy of applications to forget that they wrote
 a message here, this buffer is circular and will overwite the oldest message if it needs space for a 
-new message.
+new message: the entry used is the token modulo STATUS_QUEUE_SIZE.
 
 Requires:
   - u32Token_ is the message of interest
+  - psQueue_ is the queue the message is added to
 
 Promises:
-  - A new status is created indexed by u32Token_
+  - A new status is created indexed by u32Token_ and is on the timing wheel
 */
-static void AddNewMessageStatus(u32 u32Token_)
+static void AddNewMessageStatus(u32 u32Token_, MessageQueueType* psQueue_)
 {
-  /* Install the new message message */
-  Msg_pNextStatus->u32Token = u32Token_;
-  Msg_pNextStatus->eState = WAITING;
-  Msg_pNextStatus->u32Timestamp = G_u32SystemTime1ms;
+  MessageStatus* psStatus = &Msg_StatusQueue[u32Token_ & STATUS_QUEUE_MASK];
   
-  /* Safely advance the pointer */
-  Msg_pNextStatus++;
-  if(Msg_pNextStatus == &Msg_StatusQueue[STATUS_QUEUE_SIZE])
+  /* Install the new message over whatever status was STATUS_QUEUE_SIZE tokens ago */
+  psStatus->u32Token = u32Token_;
+  psStatus->eState = WAITING;
+  psStatus->u32Timestamp = G_u32SystemTime1ms;
+  psStatus->u32QueueTime = G_u32SystemTime1ms;
+  psStatus->pfCallback = NULL;
+  psStatus->pu32EventFlags = NULL;
+  psStatus->psQueue = psQueue_;
+  
+  /* An entry still on the wheel from its last token is checked against the new status when its bucket comes up */
+  if(!psStatus->bInWheel)
   {
-    Msg_pNextStatus = &Msg_StatusQueue[0];
+    WheelInsertStatus((u8)(u32Token_ & STATUS_QUEUE_MASK), psStatus->u32Timestamp + MSG_STATUS_WAITING_TIME);
   }
   
 } /* end AddNewMessageStatus() */
 
 
+/*----------------------------------------------------------------------------------------------------------------------
+Function: WheelInsertStatus()
+
+Description:
+Adds a status entry to the timing wheel bucket that covers u32CheckTime_.
+
+Requires:
+  - u8Entry_ is the Msg_StatusQueue index of a status that is not in a bucket
+  - u32CheckTime_ is less than the wheel span (MSG_WHEEL_BUCKETS * MSG_WHEEL_SLOT_TIME) after the current time
+
+Promises:
+  - The entry is at the front of its bucket and bInWheel is TRUE
+*/
+static void WheelInsertStatus(u8 u8Entry_, u32 u32CheckTime_)
+{
+  u8 u8Bucket = (u8)((u32CheckTime_ >> MSG_WHEEL_SLOT_SHIFT) & MSG_WHEEL_MASK);
+  
+  Msg_StatusQueue[u8Entry_].u8WheelNext = Msg_au8WheelBuckets[u8Bucket];
+  Msg_StatusQueue[u8Entry_].bInWheel = TRUE;
+  Msg_au8WheelBuckets[u8Bucket] = u8Entry_;
+  
+} /* end WheelInsertStatus() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RemoveOrphanMessages()
+
+Description:
+A message whose status entry has been taken by a token STATUS_QUEUE_SIZE newer is no longer on the timing wheel and 
+cannot expire on its own.  Orphans at the head of an expiring queue are removed when a message behind them is due.
+A message the driver has started is never removed: its payload may still be read by the peripheral (e.g. the PDC),
+and the driver dequeues it when it is done.
+
+Requires:
+  - psQueue_ has bExpire set
+
+Promises:
+  - Up to MSG_WHEEL_CHECKS_PER_CALL head messages without a status are dequeued, stopping at the first message that
+    has a status or has been started
+*/
+static void RemoveOrphanMessages(MessageQueueType* psQueue_)
+{
+  u32 u32Token;
+  
+  for(u8 i = 0; (i < MSG_WHEEL_CHECKS_PER_CALL) && (psQueue_->psHead != NULL); i++)
+  {
+    u32Token = psQueue_->psHead->u32Token;
+    if( (Msg_StatusQueue[u32Token & STATUS_QUEUE_MASK].u32Token == u32Token) || psQueue_->psHead->bStarted )
+    {
+      break;
+    }
+    
+    DeQueueMessage(psQueue_);
+  }
+  
+} /* end RemoveOrphanMessages() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: CheckMessageStatus()
+
+Description:
+Checks a status taken off the timing wheel.  Entries are put in a bucket no later than they are due, so an entry may 
+not be due yet (its status changed since) and is then put back in the bucket of its new time.
+
+Requires:
+  - u8Entry_ is the Msg_StatusQueue index of a status just taken off the wheel
+
+Promises:
+  - A message WAITING for MSG_STATUS_WAITING_TIME on a queue with bExpire set is ABANDONED and dequeued once it is at
+    the head (a message a driver has started is never dequeued here); on any other queue it stays WAITING and is
+    looked at again after MSG_STATUS_WAITING_TIME
+  - A COMPLETE status older than MSG_STATUS_COMPLETE_TIME, or a TIMEOUT or ABANDONED status older than 
+    MSG_STATUS_TIMEOUT_TIME, is removed
+  - Any other status goes back on the wheel at the time it is next due (a message that is SENDING belongs to its
+    driver and is looked at again after MSG_STATUS_WAITING_TIME)
+*/
+static void CheckMessageStatus(u8 u8Entry_)
+{
+  MessageStatus* psStatus = &Msg_StatusQueue[u8Entry_];
+  MessageQueueType* psQueue = psStatus->psQueue;
+  u32 u32Age = G_u32SystemTime1ms - psStatus->u32Timestamp;
+  u32 u32CheckTime;
+  
+  psStatus->bInWheel = FALSE;
+  if(psStatus->u32Token == 0)
+  {
+    return;
+  }
+  
+  switch(psStatus->eState)
+  {
+    case WAITING:
+      if( (u32Age >= MSG_STATUS_WAITING_TIME) && !psQueue->bExpire )
+      {
+        /* The message stays queued and its driver will still send it, so no final state can be posted yet */
+        WheelInsertStatus(u8Entry_, G_u32SystemTime1ms + MSG_STATUS_WAITING_TIME);
+      }
+      else if(u32Age >= MSG_STATUS_WAITING_TIME)
+      {
+        RemoveOrphanMessages(psQueue);
+        
+        /* Only the head can be removed, and only if the driver has not started it; otherwise the message is looked
+        at again in the next bucket */
+        if( (psQueue->psHead != NULL) && 
+            ((psQueue->psHead->u32Token != psStatus->u32Token) || psQueue->psHead->bStarted) )
+        {
+          WheelInsertStatus(u8Entry_, G_u32SystemTime1ms + MSG_WHEEL_SLOT_TIME);
+          break;
+        }
+        
+        /* The driver has not started the message, so it can be taken off the queue */
+        UpdateMessageStatus(psStatus->u32Token, ABANDONED);
+        if(psQueue->psHead != NULL)
+        {
+          DeQueueMessage(psQueue);
+          RemoveOrphanMessages(psQueue);
+        }
+      }
+      break;
+      
+    case COMPLETE:
+      if(u32Age >= MSG_STATUS_COMPLETE_TIME)
+      {
+        psStatus->u32Token = 0;
+        psStatus->eState = EMPTY;
+      }
+      break;
+      
+    case TIMEOUT:
+    case ABANDONED:
+      if(u32Age >= MSG_STATUS_TIMEOUT_TIME)
+      {
+        psStatus->u32Token = 0;
+        psStatus->eState = EMPTY;
+      }
+      break;
+      
+    default:
+      break;
+  } /* end switch */
+  
+  /* Put the entry back on the wheel unless it was removed (a callback may already have reused it) */
+  if( (psStatus->u32Token != 0) && !psStatus->bInWheel )
+  {
+    switch(psStatus->eState)
+    {
+      case WAITING:
+        u32CheckTime = psStatus->u32Timestamp + MSG_STATUS_WAITING_TIME;
+        break;
+        
+      case COMPLETE:
+        u32CheckTime = psStatus->u32Timestamp + MSG_STATUS_COMPLETE_TIME;
+        break;
+        
+      case TIMEOUT:
+      case ABANDONED:
+        u32CheckTime = psStatus->u32Timestamp + MSG_STATUS_TIMEOUT_TIME;
+        break;
+        
+      default:
+        u32CheckTime = G_u32SystemTime1ms + MSG_STATUS_WAITING_TIME;
+        break;
+    } /* end switch */
+    
+    WheelInsertStatus(u8Entry_, u32CheckTime);
+  }
+  
+} /* end CheckMessageStatus() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: IsMessageDone()
+
+Description:
+Checks if a message state is final.
+
+Requires:
+  - 
+
+Promises:
+  - Returns TRUE for COMPLETE, TIMEOUT and ABANDONED
+*/
+static bool IsMessageDone(MessageStateType eState_)
+{
+  return( (eState_ == COMPLETE) || (eState_ == TIMEOUT) || (eState_ == ABANDONED) );
+  
+} /* end IsMessageDone() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: NotifyMessageDone()
+
+Description:
+Sets the event bits and calls the callback of a message that is done.  Both are removed first so each fires only
+once, even if the callback queues or updates messages.
+
+Requires:
+  - psStatus_ is the status entry of a message in a final state
+
+Promises:
+  - The event bits are set and the callback is called, if installed, and both are removed
+*/
+static void NotifyMessageDone(MessageStatus* psStatus_)
+{
+  MessageCallbackType pfCallback = psStatus_->pfCallback;
+  volatile u32* pu32EventFlags = psStatus_->pu32EventFlags;
+
+  psStatus_->pfCallback = NULL;
+  psStatus_->pu32EventFlags = NULL;
+  
+  if(pu32EventFlags != NULL)
+  {
+    *pu32EventFlags |= psStatus_->u32EventBits;
+  }
+  
+  if(pfCallback != NULL)
+  {
+    pfCallback(psStatus_->u32Token, psStatus_->eState);
+  }
+  
+} /* end NotifyMessageDone() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RecordLatency()
+
+Description:
+Counts a queued-to-COMPLETE time in its log2 bucket: bucket n holds 2^(n-1) to 2^n - 1 ms, so the bucket is the 
+number of bits in the time.
+
+Requires:
+  - psStats_ points to the counters of the queue of the message
+  - u32Latency_ is the time in ms
+
+Promises:
+  - The bucket for u32Latency_ (the last bucket for any longer time) is incremented
+*/
+static void RecordLatency(MessageQueueStatsType* psStats_, u32 u32Latency_)
+{
+  u8 u8Bucket = 0;
+  
+  while( (u32Latency_ != 0) && (u8Bucket < (MSG_LATENCY_BUCKETS - 1)) )
+  {
+    u32Latency_ >>= 1;
+    u8Bucket++;
+  }
+  
+  psStats_->au32Latency[u8Bucket]++;
+  
+} /* end RecordLatency() */
+
+
 /**********************************************************************************************************************
 State Machine Function Definitions
 **********************************************************************************************************************/
 
 /*-------------------------------------------------------------------------------------------------------------------*/
-/* Do nothing for now */
+/* Expire stuck messages and old statuses: take the next wheel bucket once its time has passed and check a few of its
+entries each call, so the work per call is bounded however many messages are queued. */
 void MessagingIdle(void)
 {
-  static u32 u32CleaningTime = MSG_STATUS_CLEANING_TIME;
+  u8 u8Entry;
+  u8 u8Bucket;
   
-  if(--u32CleaningTime == 0)
+  /* Empty buckets are passed over in the same call (at most one lap of the wheel) */
+  for(u8 i = 0; (i < MSG_WHEEL_BUCKETS) && (Msg_u8WheelChecks == MSG_SLOT_NONE) && 
+                ((G_u32SystemTime1ms - Msg_u32WheelTime) >= MSG_WHEEL_SLOT_TIME); i++)
   {
-    u32CleaningTime = MSG_STATUS_CLEANING_TIME;
-    
-    /* ??? Probably should add clean of the main message queue to detect any messages that have become stuck */
+    u8Bucket = (u8)((Msg_u32WheelTime >> MSG_WHEEL_SLOT_SHIFT) & MSG_WHEEL_MASK);
+    Msg_u8WheelChecks = Msg_au8WheelBuckets[u8Bucket];
+    Msg_au8WheelBuckets[u8Bucket] = MSG_SLOT_NONE;
+    Msg_u32WheelTime += MSG_WHEEL_SLOT_TIME;
+  }
+  
+  for(u8 i = 0; (i < MSG_WHEEL_CHECKS_PER_CALL) && (Msg_u8WheelChecks != MSG_SLOT_NONE); i++)
+  {
+    u8Entry = Msg_u8WheelChecks;
+    Msg_u8WheelChecks = Msg_StatusQueue[u8Entry].u8WheelNext;
+    CheckMessageStatus(u8Entry);
   }
     
 } /* end MessagingIdle() */
@@ -17,15 +17,45 @@ Constants / Definitions
 #define _DEQUEUE_GOT_NULL               (u32)0x00000002
 #define _DEQUEUE_MSG_NOT_FOUND          (u32)0x00000004
   
-/* Tx buffer allocation: be cognisant of RAM usage when selecting the two parameters below */
-#define TX_QUEUE_SIZE                   (u8)25         /* Number of messages allowed in the queue */
-#define MAX_TX_MESSAGE_LENGTH           (u16)100       /* Max bytes in message payload */
-#define STATUS_QUEUE_SIZE               (u8)50         /* Number of message statusi to maintain */
+/* Tx buffer allocation: be cognisant of RAM usage when selecting the parameters below.  Message headers and payloads
+are allocated separately: each message takes the smallest free payload block that holds it. */
+#define TX_QUEUE_SIZE                   (u8)48         /* Number of messages allowed in the queue */
+#define MAX_TX_MESSAGE_LENGTH           (u16)100       /* Max bytes in message payload (size of the largest class) */
+
+#define MSG_PAYLOAD_CLASSES             (u8)4          /* Number of payload block sizes */
+#define MSG_PAYLOAD_SIZE0               (u8)4          /* Single bytes, echo and short commands */
+#define MSG_PAYLOAD_BLOCKS0             (u8)32
+#define MSG_PAYLOAD_SIZE1               (u8)16         /* Numbers, LCD commands and short strings */
+#define MSG_PAYLOAD_BLOCKS1             (u8)16
+#define MSG_PAYLOAD_SIZE2               (u8)48         /* Text lines */
+#define MSG_PAYLOAD_BLOCKS2             (u8)8
+#define MSG_PAYLOAD_SIZE3               (u8)MAX_TX_MESSAGE_LENGTH  /* Long text and full parts of split messages */
+#define MSG_PAYLOAD_BLOCKS3             (u8)4
+#define STATUS_QUEUE_SIZE               (u8)64         /* Number of message statusi to maintain (must be a power of 2) */
+#define STATUS_QUEUE_MASK               (u32)(STATUS_QUEUE_SIZE - 1)  /* Token bits that select the status entry */
+#define MSG_SLOT_NONE                   (u8)0xFF       /* End of the free slot list */
+#define MSG_PAYLOAD_BORROWED            (u8)0xFF       /* u8PayloadClass of a message that points at the caller's data */
 
 #define MSG_STATUS_COMPLETE_TIME        (u32)1000      /* Max time in ms that a message status can sit in the status queue in a COMPLETE state */
 #define MSG_STATUS_WAITING_TIME         (u32)1000      /* Max time in ms that a message can sit in the queue in a WAITING state */
 #define MSG_STATUS_TIMEOUT_TIME         (u32)1500      /* Max time in ms that a message status can sit in the status queue in a TIMEOUT state */
-#define MSG_STATUS_CLEANING_TIME        (u32)1000      /* Time in ms between cleaning the message queue */
+
+/* Status expiry: each status sits on a timing wheel in the bucket of the time it next needs checking.  A bucket covers
+MSG_WHEEL_SLOT_TIME ms and the wheel spans longer than the longest status time above, so an entry is checked in the 
+first pass after it is due.  The entries of a bucket whose time has passed are checked a few per loop. */
+#define MSG_WHEEL_BUCKETS               (u8)32         /* Buckets on the timing wheel (must be a power of 2) */
+#define MSG_WHEEL_MASK                  (u32)(MSG_WHEEL_BUCKETS - 1)
+#define MSG_WHEEL_SLOT_SHIFT            (u8)6          /* Bucket time is 64 ms, so the wheel spans 2048 ms */
+#define MSG_WHEEL_SLOT_TIME             (u32)(1 << MSG_WHEEL_SLOT_SHIFT)
+#define MSG_WHEEL_CHECKS_PER_CALL       (u8)4          /* Max status entries checked per call of MessagingIdle() */
+
+/* Statistics: every queue counts its messages and latencies; queues registered with MessagingTrackQueue() are
+reported in a MessagingSnapshotType */
+#define MSG_STATS_QUEUES                (u8)8          /* Max queues registered for statistics */
+#define MSG_QUEUE_NAME_SIZE             (u8)4          /* Characters of a queue name in a snapshot */
+#define MSG_LATENCY_BUCKETS             (u8)12         /* Bucket 0: 0 ms, bucket n: 2^(n-1) to 2^n - 1 ms, last: 1024 ms + */
+#define MSG_SNAPSHOT_MAGIC              (u32)0x5347534D /* "MSGS" read as a little-endian word */
+#define MSG_SNAPSHOT_VERSION            (u16)1
 
 
 /**********************************************************************************************************************
@@ -33,28 +63,115 @@ Type Definitions
 **********************************************************************************************************************/
 typedef enum {EMPTY = 0, WAITING, SENDING, COMPLETE, TIMEOUT, ABANDONED, NOT_FOUND = 0xff} MessageStateType;
 
+/* Urgent messages overtake bulk messages that have not started sending */
+typedef enum {MSG_PRIORITY_BULK = 0, MSG_PRIORITY_URGENT} MessagePriorityType;
+
+/* Called when the messaging task is done with a borrowed payload (the message was sent or abandoned) */
+typedef void (*MessageReleaseType)(const u8* pu8Data_);
+
+/* Called when a message reaches COMPLETE, TIMEOUT or ABANDONED */
+typedef void (*MessageCallbackType)(u32 u32Token_, MessageStateType eState_);
+
 /* Message struct for data messages */
 typedef struct
 {
   u32 u32Token;                         /* Unigue token for this message */
   u32 u32Size;                          /* Size of the data payload in bytes */
-  u8 pu8Message[MAX_TX_MESSAGE_LENGTH]; /* Data payload array */
+  u8* pu8Message;                       /* Data payload (a block of payload class u8PayloadClass, or the caller's data) */
   void* psNextMessage;                  /* Pointer to next message */
+  u8 u8SlotIndex;                       /* Index of the Msg_Pool slot holding this message */
+  u8 u8PayloadClass;                    /* Payload size class of pu8Message */
+  u8 u8PayloadBlock;                    /* Block index of pu8Message in its class */
+  bool bMoreSegments;                   /* TRUE if psNextMessage is the next segment of the same message */
+  bool bStarted;                        /* TRUE once a driver has loaded the message (never expired or removed) */
+  MessageReleaseType pfRelease;         /* Owner of a borrowed payload to notify on dequeue, or NULL */
 } MessageType;
 
+/* One piece of a scatter-gather message */
+typedef struct
+{
+  const u8* pu8Data;                    /* First byte of the segment */
+  u32 u32Size;                          /* Number of bytes in the segment */
+  bool bCopy;                           /* TRUE: copied to the pool; FALSE: sent from pu8Data, which is const or left 
+                                           unchanged until the message is done */
+} MessageSegmentType;
+
+/* Counters of a transmit queue (all u32 so a snapshot has no padding) */
+typedef struct
+{
+  u32 u32Depth;                         /* Messages in the queue */
+  u32 u32PeakDepth;                     /* Most messages in the queue at once */
+  u32 u32Queued;                        /* Messages queued (writes added to a waiting message are not counted) */
+  u32 u32Rejected;                      /* Writes refused because the pool was full */
+  u32 au32Latency[MSG_LATENCY_BUCKETS]; /* Messages by ms from queued to COMPLETE, in log2 buckets */
+} MessageQueueStatsType;
+
+/* Transmit queue of a peripheral: messages are added at the tail and sent and removed from the head */
+typedef struct
+{
+  MessageType* psHead;                  /* Next message to send, or NULL if the queue is empty */
+  MessageType* psTail;                  /* Last message queued (only valid when psHead is not NULL) */
+  MessageType* psLastUrgent;            /* Last segment of the last urgent message queued, or NULL if none */
+  bool bCoalesce;                       /* TRUE: QueueMessage() appends to a waiting tail message when it fits */
+  bool bExpire;                         /* TRUE: a head message WAITING longer than MSG_STATUS_WAITING_TIME is 
+                                           abandoned and removed by the messaging task */
+  MessageQueueStatsType sStats;         /* Counters kept by the messaging task */
+} MessageQueueType;
+
 typedef struct
 {
   bool bFree;                           /* TRUE if message slot is available */
+  u8 u8NextFree;                        /* Next slot in the free list (MSG_SLOT_NONE at the end) */
   MessageType Message;                  /* The slot's message */
 } MessageSlot;
 
+/* Payload blocks of one size; a free block holds the index of the next free block in its first byte */
+typedef struct
+{
+  u8* pu8Blocks;                        /* First block of the class */
+  u8 u8BlockSize;                       /* Bytes per block */
+  u8 u8Blocks;                          /* Number of blocks */
+  u8 u8FreeBlock;                       /* First free block, or MSG_SLOT_NONE */
+  u8 u8FreeCount;                       /* Number of free blocks */
+  u8 u8PeakUsed;                        /* Most blocks in use at once */
+} MessagePayloadClassType;
+
 typedef struct
 {
   u32 u32Token;                         /* Unigue token for this message; a token is never 0 */
   MessageStateType eState;              /* State of the message */
   u32 u32Timestamp;                     /* Time the message status was last posted */          
+  u32 u32QueueTime;                     /* Time the message was queued */
+  MessageCallbackType pfCallback;       /* Called once when the message is done, or NULL */
+  volatile u32* pu32EventFlags;         /* Flags word to get u32EventBits when the message is done, or NULL */
+  u32 u32EventBits;                     /* Bits set in *pu32EventFlags */
+  MessageQueueType* psQueue;            /* Queue the message was added to */
+  u8 u8WheelNext;                       /* Next status in the same timing wheel bucket, or MSG_SLOT_NONE */
+  bool bInWheel;                        /* TRUE while the status is in a timing wheel bucket */
 } MessageStatus;
 
+typedef struct
+{
+  u8 au8Name[MSG_QUEUE_NAME_SIZE];      /* Name given to MessagingTrackQueue(), padded with spaces */
+  MessageQueueStatsType sStats;         /* Counters of the queue */
+} MessageQueueSnapshotType;
+
+/* Messaging statistics at one time.  Fields are naturally aligned with no padding, so a host can read the bytes
+(little-endian) from a dump or from RAM with the debugger. */
+typedef struct
+{
+  u32 u32Magic;                         /* MSG_SNAPSHOT_MAGIC */
+  u16 u16Version;                       /* MSG_SNAPSHOT_VERSION */
+  u16 u16Size;                          /* sizeof(MessagingSnapshotType) */
+  u32 u32Time;                          /* G_u32SystemTime1ms when the snapshot was taken */
+  u8 u8PoolSize;                        /* TX_QUEUE_SIZE */
+  u8 u8PoolUsed;                        /* Message headers in use */
+  u8 u8PoolPeak;                        /* Most message headers in use at once */
+  u8 u8Queues;                          /* Entries of asQueues in use */
+  u8 au8BlocksPeak[MSG_PAYLOAD_CLASSES]; /* Most payload blocks of each class in use at once */
+  MessageQueueSnapshotType asQueues[MSG_STATS_QUEUES];
+} MessagingSnapshotType;
+
 
 /**********************************************************************************************************************
 * Function Declarations
@@ -64,6 +181,9 @@ typedef struct
 /* Public functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
 MessageStateType QueryMessageStatus(u32 u32Token_);
+bool SetMessageCallback(u32 u32Token_, MessageCallbackType pfCallback_);
+bool SetMessageEvent(u32 u32Token_, volatile u32* pu32EventFlags_, u32 u32EventBits_);
+void MessagingSnapshot(MessagingSnapshotType* psSnapshot_);
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -71,8 +191,15 @@ MessageStateType QueryMessageStatus(u32 u32Token_);
 /*--------------------------------------------------------------------------------------------------------------------*/
 void MessagingInitialize(void);
 
-u32 QueueMessage(u32 u32MessageSize_, u8* pu8MessageData_, MessageType** pTargetQueue_);
-void DeQueueMessage(MessageType** pTargetQueue_);
+u32 QueueMessage(u32 u32MessageSize_, u8* pu8MessageData_, MessageQueueType* psTargetQueue_);
+u32 QueueMessagePriority(u32 u32MessageSize_, const u8* pu8MessageData_, MessagePriorityType ePriority_, 
+                         MessageQueueType* psTargetQueue_);
+u32 QueueMessageSegments(const MessageSegmentType* pasSegments_, u8 u8Segments_, MessagePriorityType ePriority_,
+                         MessageQueueType* psTargetQueue_);
+u32 QueueMessageNoCopy(u32 u32MessageSize_, const u8* pu8MessageData_, MessageReleaseType pfRelease_, 
+                       MessageQueueType* psTargetQueue_);
+void DeQueueMessage(MessageQueueType* psTargetQueue_);
+void MessagingTrackQueue(MessageQueueType* psQueue_, const u8* pu8Name_);
 
 void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_);
 
@@ -80,7 +207,21 @@ void UpdateMessageStatus(u32 u32Token_, MessageStateType eNewState_);
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Private functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
-static void AddNewMessageStatus(u32 u32Token_);
+static MessageType* AllocateMessageHeader(void);
+static MessageType* AllocateMessageSlot(u32 u32Size_);
+static void FreeMessageSlot(MessageType* psMessage_);
+static void FreeMessageChain(MessageType* psFirstMessage_);
+static u32 CoalesceMessage(u32 u32MessageSize_, const u8* pu8MessageData_, MessagePriorityType ePriority_,
+                           MessageQueueType* psTargetQueue_);
+static u32 LinkMessages(MessageType* psFirstMessage_, MessageType* psLastMessage_, MessagePriorityType ePriority_,
+                        MessageQueueType* psTargetQueue_);
+static void AddNewMessageStatus(u32 u32Token_, MessageQueueType* psQueue_);
+static void WheelInsertStatus(u8 u8Entry_, u32 u32CheckTime_);
+static void RemoveOrphanMessages(MessageQueueType* psQueue_);
+static void CheckMessageStatus(u8 u8Entry_);
+static bool IsMessageDone(MessageStateType eState_);
+static void NotifyMessageDone(MessageStatus* psStatus_);
+static void RecordLatency(MessageQueueStatsType* psStats_, u32 u32Latency_);
 
 
 /***********************************************************************************************************************
@@ -337,7 +337,7 @@ void SdCommand(u8* pau8Command_)
   /* DeAssert the chip select line and queue a dummy read to query the card */
   SspDeAssertCS(SD_Ssp);
   SD_u32Timeout = G_u32SystemTime1ms;
-  SD_u32CurrentMsgToken = SspReadByte(SD_Ssp);
+  SD_u32CurrentMsgToken = SdWatchTransfer( SspReadByte(SD_Ssp) );
   if(SD_u32CurrentMsgToken)
   {
     G_SdCardStateMachine = SdCardWaitReady;
@@ -426,6 +426,70 @@ void FlushSdRxBuffer(void)
 } /* end FlushSdRxBuffer() */
 
 
+/*--------------------------------------------------------------------------------------------------------------------
+Function: SdWatchTransfer
+
+Description:
+Asks messaging to set _SD_TRANSFER_DONE when an SSP message is done so the wait states do not have to poll its 
+status; they check how it ended with SdTransferComplete().  With the SSP task called before this task in the main
+loop, the next transfer is queued in the same pass.
+
+Requires:
+  - u32Token_ is the token returned for the SSP message just queued, or 0 if it failed
+
+Promises:
+  - _SD_TRANSFER_DONE is cleared and will be set when the message is done
+  - Returns u32Token_
+*/
+static u32 SdWatchTransfer(u32 u32Token_)
+{
+  SD_u32Flags &= ~_SD_TRANSFER_DONE;
+  if(u32Token_)
+  {
+    SetMessageEvent(u32Token_, &SD_u32Flags, _SD_TRANSFER_DONE);
+  }
+  
+  return(u32Token_);
+  
+} /* end SdWatchTransfer() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------
+Function: SdTransferComplete
+
+Description:
+Checks whether the SSP message being watched has been sent.  _SD_TRANSFER_DONE is also set when the message ends
+TIMEOUT or ABANDONED (e.g. the SSP was released), and then the response bytes never arrived in the RxBuffer.
+
+Requires:
+  - SD_u32CurrentMsgToken is the message passed to SdWatchTransfer()
+  - pfFailState_ is the state the calling wait state goes to on a timeout
+
+Promises:
+  - Returns TRUE once if the message is COMPLETE; _SD_TRANSFER_DONE is cleared
+  - If the message ended any other way, sets SD_ERROR_TIMEOUT, directs the SM to pfFailState_ and returns FALSE
+  - Returns FALSE while the message is not done
+*/
+static bool SdTransferComplete(fnCode_type pfFailState_)
+{
+  if( !(SD_u32Flags & _SD_TRANSFER_DONE) )
+  {
+    return(FALSE);
+  }
+  
+  SD_u32Flags &= ~_SD_TRANSFER_DONE;
+  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  {
+    return(TRUE);
+  }
+  
+  SD_u8ErrorCode = SD_ERROR_TIMEOUT;
+  G_SdCardStateMachine = pfFailState_;
+  return(FALSE);
+  
+} /* end SdTransferComplete() */
+
+
 /**********************************************************************************************************************
 State Machine Function Definitions
 **********************************************************************************************************************/
@@ -457,7 +521,7 @@ static void SdIdleNoCard(void)
       LedRequest(&SD_CardStatusLed);
 
       /* Queue up a set of dummy transfers to make sure the card is awake; */
-      SD_u32CurrentMsgToken = SspReadData(SD_Ssp, SD_WAKEUP_BYTES);
+      SD_u32CurrentMsgToken = SdWatchTransfer( SspReadData(SD_Ssp, SD_WAKEUP_BYTES) );
       if(SD_u32CurrentMsgToken)
       {
         SspAssertCS(SD_Ssp);
@@ -479,7 +543,7 @@ static void SdIdleNoCard(void)
 /* Send dummies to wake up card */
 static void SdCardDummies(void)
 {
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdError) )
   { 
     /* Advance the buffer parser past the dummy read byte responses since we don't care about them */
     AdvanceSD_pu8RxBufferParser(SD_WAKEUP_BYTES);
@@ -524,7 +588,7 @@ static void SdCardResponseCMD8(void)
   {
     /* Command is good which means the card is at least SDv2 so we can read 4 more bytes of the CMD8 response */
     SD_u32Flags |= _SD_TYPE_SD2;
-    SD_u32CurrentMsgToken = SspReadData(SD_Ssp, 4);
+    SD_u32CurrentMsgToken = SdWatchTransfer( SspReadData(SD_Ssp, 4) );
     if(SD_u32CurrentMsgToken)
     {
       G_SdCardStateMachine = SdCardReadCMD8;
@@ -555,7 +619,7 @@ static void SdCardResponseCMD8(void)
 static void SdCardReadCMD8(void)
 {
   /* Check to see if the SSP peripheral has sent the data request */
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdError) )
   {
     /* Process the four response bytes (only the last two matter) */
     AdvanceSD_pu8RxBufferParser(2);
@@ -658,7 +722,7 @@ static void SdCardResponseCMD58(void)
   if(*SD_pu8RxBufferParser == SD_STATUS_READY)
   {
     /* Command is good so we can read 4 more bytes of the CMD58 response */
-    SD_u32CurrentMsgToken = SspReadData(SD_Ssp, 4);
+    SD_u32CurrentMsgToken = SdWatchTransfer( SspReadData(SD_Ssp, 4) );
     if(SD_u32CurrentMsgToken)
     {
       G_SdCardStateMachine = SdCardReadCMD58;
@@ -717,7 +781,7 @@ static void SdCardResponseCMD16(void)
 static void SdCardReadCMD58(void)
 {
   /* Check to see if the SSP peripheral has sent the command */
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdError) )
   {
     /* Determine card capacity */
     SD_u32Flags &= ~_SD_CARD_HC;
@@ -760,11 +824,11 @@ response byte. */
      
 static void SdCardWaitReady(void)
 {
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdError) )
   {  
     if( *SD_pu8RxBufferParser != 0xFF )
     {
-      SD_u32CurrentMsgToken = SspReadByte(SD_Ssp);
+      SD_u32CurrentMsgToken = SdWatchTransfer( SspReadByte(SD_Ssp) );
       if( !SD_u32CurrentMsgToken )
       {
         /* We didn't get a return token, so abort */
@@ -777,7 +841,7 @@ static void SdCardWaitReady(void)
     /* The card is ready for the command */
     else
     {
-      SD_u32CurrentMsgToken = SspWriteData(SD_Ssp, SD_CMD_SIZE, SD_NextCommand);
+      SD_u32CurrentMsgToken = SdWatchTransfer( SspWriteData(SD_Ssp, SD_CMD_SIZE, SD_NextCommand) );
       
       /* Pre-emptively move RxBufferParser so it will point to command response */
       AdvanceSD_pu8RxBufferParser(SD_CMD_SIZE);
@@ -808,14 +872,14 @@ static void SdCardWaitCommand(void)
   static u8 u8Retries = SD_CMD_RETRIES;
   
   /* Check to see if the SSP peripheral has sent the command */
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdError) )
   {
     /* If no response but retries left, queue another read */
     if( (*SD_pu8RxBufferParser & BIT7) && (u8Retries != 0) )
     {
       u8Retries--;
       
-      SD_u32CurrentMsgToken = SspReadByte(SD_Ssp);
+      SD_u32CurrentMsgToken = SdWatchTransfer( SspReadByte(SD_Ssp) );
       if( !SD_u32CurrentMsgToken )
       {
         /* We didn't get a return token, so abort */
@@ -832,6 +896,11 @@ static void SdCardWaitCommand(void)
       G_SdCardStateMachine = SD_WaitReturnState;
     }
   }
+  else if(G_SdCardStateMachine == SdError)
+  {
+    /* The SSP message was not sent */
+    u8Retries = SD_CMD_RETRIES;
+  }
   
   if( IsTimeUp(&G_u32SystemTime1ms, &SD_u32Timeout, SD_WAIT_TIME, NO_RESET_TARGET_TIMER) )
   {
@@ -924,7 +993,7 @@ static void SdCardResponseCMD17(void)
   if(*SD_pu8RxBufferParser == SD_STATUS_READY)
   {
     /* Queue a read looking to get TOKEN_START_BLOCK back from the card */
-    SD_u32CurrentMsgToken = SspReadByte(SD_Ssp);
+    SD_u32CurrentMsgToken = SdWatchTransfer( SspReadByte(SD_Ssp) );
  
     SD_u32Timeout = G_u32SystemTime1ms;
     G_SdCardStateMachine = SdCardWaitStartToken;
@@ -947,7 +1016,7 @@ static void SdCardResponseCMD17(void)
 static void SdCardWaitStartToken(void)          
 {
   /* Check if the SSP peripheral has sent the data request */
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdFailedDataTransfer) )
   {
     /* Check the response byte */
     if(*SD_pu8RxBufferParser == TOKEN_START_BLOCK)
@@ -957,13 +1026,13 @@ static void SdCardWaitStartToken(void)
       SD_pu8RxBufferParser   = &SD_au8RxBuffer[0];
       
       /* Queue a read for the entire sector plus two checksum bytes */
-      SD_u32CurrentMsgToken = SspReadData(SD_Ssp, 514);    
+      SD_u32CurrentMsgToken = SdWatchTransfer( SspReadData(SD_Ssp, 514) );    
       G_SdCardStateMachine = SdCardDataTransfer;
     }
     else
     {
       /* Queue a read looking to get TOKEN_START_BLOCK back from the card */
-      SD_u32CurrentMsgToken = SspReadByte(SD_Ssp);    
+      SD_u32CurrentMsgToken = SdWatchTransfer( SspReadByte(SD_Ssp) );    
       AdvanceSD_pu8RxBufferParser(1);
     }
   }
@@ -983,7 +1052,7 @@ static void SdCardWaitStartToken(void)
 static void SdCardDataTransfer(void)
 {
   /* Check if the SSP peripheral is finished with the data request */
-  if( QueryMessageStatus(SD_u32CurrentMsgToken) == COMPLETE )
+  if( SdTransferComplete(SdError) )
   {
     SD_CardState = SD_DATA_READY;
 
@@ -25,6 +25,7 @@ Constants / Definitions
 #define _SD_TYPE_SD2		          (u32)0x00000010		   /* SD ver 2 */
 #define _SD_TYPE_MMC		          (u32)0x00000020	     /* SD ver 3 */
 #define _SD_TYPE_BLOCK		        (u32)0x00000040		   /* Block addressing */
+#define _SD_TRANSFER_DONE         (u32)0x00000080      /* Set by messaging when the current SSP message is done */
 
 #define SD_CLEAR_CARD_TYPE_BITS  ~(_SD_CARD_HC | _SD_TYPE_MMC | _SD_TYPE_SD1 | _SD_TYPE_SD2 |_SD_TYPE_BLOCK)
 #define _SD_TYPE_SDC		          (_SD_TYPE_SD1 | _SD_TYPE_SD2)	
@@ -139,6 +140,8 @@ bool SdIsCardInserted(void);
 static void SdCommand(u8* pau8Command_);
 static void AdvanceSD_pu8RxBufferParser(u32 u32NumBytes_);
 static void FlushSdRxBuffer(void);
+static u32 SdWatchTransfer(u32 u32Token_);
+static bool SdTransferComplete(fnCode_type pfFailState_);
 
 
 /***********************************************************************************************************************
@@ -3,6 +3,11 @@ File: utilities.c
 
 Description:
 Various useful functions.
+
+The RingBuffer functions pass bytes between exactly one producer and one consumer (typically the main loop and an
+ISR) without disabling interrupts.  Each side stores only its own free-running index, and a single aligned word store
+is atomic on the Cortex-M3, so neither side can see a half-updated ring.  Data is written before the index that
+publishes it, and read before the index that frees it.
 ***********************************************************************************************************************/
 
 #include "configuration.h"
@@ -12,10 +17,11 @@ Global variable definitions with scope across entire project.
 All Global variable names shall start with "G_"
 ***********************************************************************************************************************/
 /* New variables */
-u8 G_au8MessageOK[]   = MESSAGE_OK;            /* Common "OK" message */
-u8 G_au8MessageFAIL[] = MESSAGE_FAIL;          /* Common "FAIL" message */
-u8 G_au8MessageON[]   = MESSAGE_ON;            /* Common "ON" message */
-u8 G_au8MessageOFF[]  = MESSAGE_OFF;           /* Common "OFF" message */
+/* The common messages are const so they stay in flash and can be queued with the NoCopy write functions */
+const u8 G_au8MessageOK[]   = MESSAGE_OK;      /* Common "OK" message */
+const u8 G_au8MessageFAIL[] = MESSAGE_FAIL;    /* Common "FAIL" message */
+const u8 G_au8MessageON[]   = MESSAGE_ON;      /* Common "ON" message */
+const u8 G_au8MessageOFF[]  = MESSAGE_OFF;     /* Common "OFF" message */
 
 
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -314,6 +320,149 @@ bool SearchString(u8* pu8TargetString_, u8* pu8MatchString_)
 
 } /* end SearchString */
 
+
+/*-----------------------------------------------------------------------------/
+Function: RingBufferInitialize
+
+Description:
+Sets up an empty single-producer / single-consumer ring on the caller's storage.
+
+Requires:
+  - Neither side of the ring is in use
+  - pu8Buffer_ points to u32Size_ bytes that stay allocated as long as the ring is used
+  - u32Size_ is a power of two
+ 
+Promises:
+  - Returns TRUE and the ring is empty if u32Size_ is a non-zero power of two; otherwise returns FALSE
+*/
+bool RingBufferInitialize(RingBufferType* psRing_, u8* pu8Buffer_, u32 u32Size_)
+{
+  if( (u32Size_ == 0) || (u32Size_ & (u32Size_ - 1)) )
+  {
+    return(FALSE);
+  }
+  
+  psRing_->pu8Buffer = pu8Buffer_;
+  psRing_->u32Mask   = u32Size_ - 1;
+  psRing_->u32Head   = 0;
+  psRing_->u32Tail   = 0;
+  
+  return(TRUE);
+
+} /* end RingBufferInitialize() */
+
+
+/*-----------------------------------------------------------------------------/
+Function: RingBufferWrite
+
+Description:
+Adds as many bytes as fit to the ring.  Only the producer side may call this.
+
+Requires:
+  - psRing_ is initialized
+  - The caller is the only producer of psRing_ (it may run in an ISR or the main loop, but not both)
+ 
+Promises:
+  - Up to u32Size_ bytes from pu8Data_ are copied into the ring and then published with one store of u32Head
+  - Returns the number of bytes written (0 if the ring is full)
+*/
+u32 RingBufferWrite(RingBufferType* psRing_, const u8* pu8Data_, u32 u32Size_)
+{
+  u32 u32Head = psRing_->u32Head;
+  u32 u32Free = psRing_->u32Mask + 1 - (u32Head - psRing_->u32Tail);
+  
+  if(u32Size_ > u32Free)
+  {
+    u32Size_ = u32Free;
+  }
+  
+  for(u32 i = 0; i < u32Size_; i++)
+  {
+    psRing_->pu8Buffer[(u32Head + i) & psRing_->u32Mask] = pu8Data_[i];
+  }
+  
+  /* Publish the bytes only after they are in the ring */
+  psRing_->u32Head = u32Head + u32Size_;
+  
+  return(u32Size_);
+
+} /* end RingBufferWrite() */
+
+
+/*-----------------------------------------------------------------------------/
+Function: RingBufferRead
+
+Description:
+Takes up to u32Size_ of the oldest bytes from the ring.  Only the consumer side may call this.
+
+Requires:
+  - psRing_ is initialized
+  - The caller is the only consumer of psRing_ (it may run in an ISR or the main loop, but not both)
+ 
+Promises:
+  - Up to u32Size_ bytes are copied to pu8Data_ and then freed with one store of u32Tail
+  - Returns the number of bytes read (0 if the ring is empty)
+*/
+u32 RingBufferRead(RingBufferType* psRing_, u8* pu8Data_, u32 u32Size_)
+{
+  u32 u32Tail = psRing_->u32Tail;
+  u32 u32Used = psRing_->u32Head - u32Tail;
+  
+  if(u32Size_ > u32Used)
+  {
+    u32Size_ = u32Used;
+  }
+  
+  for(u32 i = 0; i < u32Size_; i++)
+  {
+    pu8Data_[i] = psRing_->pu8Buffer[(u32Tail + i) & psRing_->u32Mask];
+  }
+  
+  /* Free the space only after the bytes are copied out */
+  psRing_->u32Tail = u32Tail + u32Size_;
+  
+  return(u32Size_);
+
+} /* end RingBufferRead() */
+
+
+/*-----------------------------------------------------------------------------/
+Function: RingBufferUsed
+
+Description:
+Returns the number of bytes waiting in the ring.  Either side may call this.
+
+Requires:
+  - psRing_ is initialized
+ 
+Promises:
+  - Returns the bytes waiting when it is called (the other side may change the count at any time)
+*/
+u32 RingBufferUsed(const RingBufferType* psRing_)
+{
+  return(psRing_->u32Head - psRing_->u32Tail);
+
+} /* end RingBufferUsed() */
+
+
+/*-----------------------------------------------------------------------------/
+Function: RingBufferFree
+
+Description:
+Returns the number of bytes that can be written to the ring.  Either side may call this.
+
+Requires:
+  - psRing_ is initialized
+ 
+Promises:
+  - Returns the free space when it is called (the other side may change it at any time)
+*/
+u32 RingBufferFree(const RingBufferType* psRing_)
+{
+  return(psRing_->u32Mask + 1 - (psRing_->u32Head - psRing_->u32Tail));
+
+} /* end RingBufferFree() */
+
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected Functions */
 /*--------------------------------------------------------------------------------------------------------------------*/
@@ -8,6 +8,13 @@ File: utilities.h
 /***********************************************************************************************************************
 Type Definitions
 ***********************************************************************************************************************/
+typedef struct
+{
+  volatile u8* pu8Buffer;             /* Ring storage (volatile so data is stored before the index that publishes it) */
+  u32 u32Mask;                        /* Size of the storage - 1 (the size is a power of two) */
+  volatile u32 u32Head;               /* Free-running count of bytes written; only the producer stores it */
+  volatile u32 u32Tail;               /* Free-running count of bytes read; only the consumer stores it */
+} RingBufferType;
 
 
 /***********************************************************************************************************************
@@ -54,6 +61,12 @@ u8 HexToASCIICharLower(u8 u8Char_);
 u8 NumberToAscii(u32 u32Number_, u8* pu8AsciiString_);
 bool SearchString(u8* pu8TargetString_, u8* pu8MatchString_);
 
+bool RingBufferInitialize(RingBufferType* psRing_, u8* pu8Buffer_, u32 u32Size_);
+u32 RingBufferWrite(RingBufferType* psRing_, const u8* pu8Data_, u32 u32Size_);
+u32 RingBufferRead(RingBufferType* psRing_, u8* pu8Data_, u32 u32Size_);
+u32 RingBufferUsed(const RingBufferType* psRing_);
+u32 RingBufferFree(const RingBufferType* psRing_);
+
 
 /*--------------------------------------------------------------------------------------------------------------------*/
 /* Protected functions */
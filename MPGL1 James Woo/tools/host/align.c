@@ -0,0 +1,376 @@
+/**********************************************************************************************************************
+File: align.c
+
+Description:
+Voice alignment test for the TC0 note sequencer.  "Mary had a little lamb" (two voices) is played from a note source
+that serves the song table but holds back one voice: from note ALIGN_STARVE_NOTE on it answers MUSIC_SOURCE_WAIT
+until ALIGN_STARVE_MS after that note was due, so the voice's queue runs dry in the middle of the song.
+
+A starved voice keeps its time as an implicit rest, so once its notes arrive again it must play them at the times
+the table gives, in step with the other voice: notes that are over by then are skipped and the note in progress is
+cut short.  Every note start (buzzer PWM change) of the voice that is due after it recovers, and every note start of
+the other voice, must be within the handler latency of its ideal start (and no more than MUSIC_MERGE_TICKS early, as
+in jitter.c).  Each voice is starved in turn, with no latency and with the largest latency the sequencer allows.
+
+Usage: align [-v]    (-v lists the error of every note)
+Returns 0 if every run passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../application/music.c"
+#include "../../application/songs.c"
+
+#include <stdio.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define ALIGN_MAX_NOTES           (u16)64              /* Note starts recorded per voice */
+#define ALIGN_TIMEOUT_MS          (u32)60000           /* Longest song run */
+#define ALIGN_STARVE_NOTE         (u16)3               /* First note held back */
+#define ALIGN_STARVE_MS           (u32)1300            /* Time the held note is late */
+
+
+/***********************************************************************************************************************
+Type Definitions
+***********************************************************************************************************************/
+typedef struct
+{
+  u16 u16Count;                  /* Note starts recorded */
+  u64 au64Ticks[ALIGN_MAX_NOTES]; /* Model time of each note start */
+  u16 u16LastPeriod;             /* Last PWM period seen */
+  bool bLastEnabled;             /* Last PWM enable seen */
+} AlignVoiceType;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Align_" and be declared as static.
+***********************************************************************************************************************/
+/* Largest handler latency in ticks for each run */
+static const u32 Align_au32Latency[] = {0, MUSIC_MERGE_TICKS - 1};
+
+static const SongType* Align_psSong = &G_sSongMaryHadALittleLamb; /* Song served by the note source */
+static AlignVoiceType Align_asActual[MUSIC_VOICES];  /* Note starts seen on the buzzers */
+static AlignVoiceType Align_asIdeal[MUSIC_VOICES];   /* Note starts computed from the song */
+static u64 Align_au64Due[MUSIC_VOICES][ALIGN_MAX_NOTES]; /* Ideal start of every note, rests included */
+static u16 Align_au16Served[MUSIC_VOICES];           /* Notes handed to the player per voice */
+static u8 Align_u8Starved;                           /* Voice held back */
+static u64 Align_u64Release;                         /* Model tick the held notes are served again */
+static u32 Align_u32MaxLatency;                      /* Latency bound of the current run */
+static u32 Align_u32Seed;                            /* Latency generator state */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AlignLatency
+
+Description:
+Random handler latency for the model, from 0 to the bound of the run (repeatable, as in jitter.c).
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 - Align_u32MaxLatency ticks
+*/
+static u32 AlignLatency(void)
+{
+  Align_u32Seed = (Align_u32Seed * 1103515245UL) + 12345UL;
+  return( ((Align_u32Seed >> 16) & 0x7FFF) % (Align_u32MaxLatency + 1) );
+
+} /* end AlignLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AlignPwmLog
+
+Description:
+Records a note start each time a buzzer is turned on or changes pitch while on.
+
+Requires:
+  -
+
+Promises:
+  - The model time of the change is added to the channel's note starts
+*/
+static void AlignPwmLog(const ModelPwmEventType* psEvent_)
+{
+  AlignVoiceType* psVoice = &Align_asActual[psEvent_->u8Channel];
+
+  if( psEvent_->bEnabled && (!psVoice->bLastEnabled || (psEvent_->u16Period != psVoice->u16LastPeriod)) &&
+      (psVoice->u16Count < ALIGN_MAX_NOTES) )
+  {
+    psVoice->au64Ticks[psVoice->u16Count++] = ModelTicks();
+  }
+
+  psVoice->bLastEnabled = psEvent_->bEnabled;
+  psVoice->u16LastPeriod = psEvent_->u16Period;
+
+} /* end AlignPwmLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AlignSource
+
+Description:
+Note source for the player: the notes of the song table, except that the starved voice answers MUSIC_SOURCE_WAIT
+from ALIGN_STARVE_NOTE until Align_u64Release.
+
+Requires:
+  - Follows MusicNoteSourceType
+
+Promises:
+  - Returns the next note of the voice, or MUSIC_SOURCE_WAIT while it is held back
+*/
+static MusicSourceStatusType AlignSource(u8 u8Voice_, MusicNoteType* psNote_)
+{
+  const SongVoiceType* psSongVoice = &Align_psSong->asVoices[u8Voice_];
+  u16 u16Index = Align_au16Served[u8Voice_];
+
+  if(u16Index >= psSongVoice->u16NoteCount)
+  {
+    return(MUSIC_SOURCE_END);
+  }
+
+  if( (u8Voice_ == Align_u8Starved) && (u16Index >= ALIGN_STARVE_NOTE) && (ModelTicks() < Align_u64Release) )
+  {
+    return(MUSIC_SOURCE_WAIT);
+  }
+
+  MusicDecodeNote(psSongVoice->pu16Notes[u16Index], psNote_);
+  Align_au16Served[u8Voice_]++;
+
+  return( (u16Index == (psSongVoice->u16NoteCount - 1)) ? MUSIC_SOURCE_LAST : MUSIC_SOURCE_NOTE );
+
+} /* end AlignSource() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AlignIdeal
+
+Description:
+Computes when every note of the song is due, and the start of every sounding note, as jitter.c does.
+
+Requires:
+  - The tempo is the one the song is played at
+
+Promises:
+  - Align_au64Due and Align_asIdeal hold the note times of each voice in model ticks
+*/
+static void AlignIdeal(void)
+{
+  const SongVoiceType* psSongVoice;
+  MusicNoteType sNote;
+  u64 u64Ticks;
+  u32 u32Sound;
+
+  memset(Align_asIdeal, 0, sizeof(Align_asIdeal));
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psSongVoice = &Align_psSong->asVoices[i];
+    u64Ticks = MUSIC_START_TICKS;
+
+    for(u16 j = 0; (j < psSongVoice->u16NoteCount) && (j < ALIGN_MAX_NOTES); j++)
+    {
+      Align_au64Due[i][j] = u64Ticks;
+      MusicDecodeNote(psSongVoice->pu16Notes[j], &sNote);
+      if(j == (psSongVoice->u16NoteCount - 1))
+      {
+        sNote.u16Length += MUSIC_FINAL_HOLD_TIME;
+      }
+
+      if(sNote.u8NoteIndex == NOTE_INDEX_REST)
+      {
+        sNote.u16Gap = 0;
+      }
+      else if(Align_asIdeal[i].u16Count < ALIGN_MAX_NOTES)
+      {
+        Align_asIdeal[i].au64Ticks[Align_asIdeal[i].u16Count++] = u64Ticks;
+      }
+
+      u32Sound = MusicTempoTicks(sNote.u16Length - sNote.u16Gap, Music_u8TempoStep);
+      u64Ticks += ((u32Sound == 0) ? 1 : u32Sound) + MusicTempoTicks(sNote.u16Gap, Music_u8TempoStep);
+    }
+  }
+
+} /* end AlignIdeal() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AlignLoop
+
+Description:
+Main loop pass of the test: only the music state machine runs.
+
+Requires:
+  -
+
+Promises:
+  - G_MusicStateMachine() has run once
+*/
+static void AlignLoop(void)
+{
+  G_MusicStateMachine();
+
+} /* end AlignLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: AlignRun
+
+Description:
+Plays the song with one voice starved and one latency bound, and checks the note starts.
+
+Requires:
+  -
+
+Promises:
+  - Prints one report line (and each note with bVerbose_)
+  - Returns TRUE if the song ended and every checked note started from MUSIC_MERGE_TICKS early to u32MaxLatency_
+    ticks late
+*/
+static bool AlignRun(u8 u8Starved_, u32 u32MaxLatency_, bool bVerbose_)
+{
+  AlignVoiceType* psActual;
+  u64 u64From;
+  s32 s32Error;
+  s32 s32Offset;
+  s32 s32Max = 0;
+  s32 s32Min = 0;
+  u16 u16First;
+  u16 u16Checked;
+  u32 u32Notes = 0;
+  u32 u32Ms = 0;
+  bool bPass = TRUE;
+
+  if(!ModelInitialize())
+  {
+    printf("align: cannot map the peripheral space\n");
+    return(FALSE);
+  }
+
+  memset(Align_asActual, 0, sizeof(Align_asActual));
+  memset(Align_au16Served, 0, sizeof(Align_au16Served));
+  Align_u32MaxLatency = u32MaxLatency_;
+  Align_u32Seed = 1;
+  ModelSetLatency(AlignLatency);
+  ModelSetPwmLog(AlignPwmLog);
+
+  PWMSetupAudio();
+  MusicInitialize();
+  AlignIdeal();
+  Align_u8Starved = u8Starved_;
+  Align_u64Release = Align_au64Due[u8Starved_][ALIGN_STARVE_NOTE] + (ALIGN_STARVE_MS * MODEL_TICKS_PER_MS);
+  MusicStartSource(AlignSource);
+
+  while( (G_u32MusicFlags & _MUSIC_PLAYING) && (u32Ms++ < ALIGN_TIMEOUT_MS) )
+  {
+    ModelRun(1, AlignLoop);
+  }
+
+  if(G_u32MusicFlags & _MUSIC_PLAYING)
+  {
+    printf("align: the song did not end\n");
+    bPass = FALSE;
+  }
+
+  /* Both voices start in the first handler: its latency moves the whole song */
+  s32Offset = (s32)Align_asActual[0].au64Ticks[0] - (s32)Align_asIdeal[0].au64Ticks[0];
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    /* The starved voice is checked from the first note due after the one it was cut into when it recovered */
+    psActual = &Align_asActual[i];
+    u64From = 0;
+    if(i == u8Starved_)
+    {
+      u64From = Align_u64Release + (2 * MUSIC_STARVED_TICKS);
+    }
+
+    u16First = 0;
+    while( (u16First < Align_asIdeal[i].u16Count) && (Align_asIdeal[i].au64Ticks[u16First] < u64From) )
+    {
+      u16First++;
+    }
+
+    u16Checked = Align_asIdeal[i].u16Count - u16First;
+    if(psActual->u16Count < u16Checked)
+    {
+      printf("align: voice %u started %u notes, expected at least %u\n", i, psActual->u16Count, u16Checked);
+      bPass = FALSE;
+      continue;
+    }
+
+    /* Match the last u16Checked starts of the voice with the ideal ones */
+    for(u16 j = 0; j < u16Checked; j++)
+    {
+      s32Error = (s32)psActual->au64Ticks[psActual->u16Count - u16Checked + j] -
+                 (s32)Align_asIdeal[i].au64Ticks[u16First + j] - s32Offset;
+      if(bVerbose_)
+      {
+        printf("  voice %u note %3u ideal %9llu error %4ld\n", i, u16First + j,
+               Align_asIdeal[i].au64Ticks[u16First + j], s32Error);
+      }
+
+      s32Max = (s32Error > s32Max) ? s32Error : s32Max;
+      s32Min = (s32Error < s32Min) ? s32Error : s32Min;
+      u32Notes++;
+    }
+  }
+
+  if( (s32Min < -(s32)MUSIC_MERGE_TICKS) || (s32Max > (s32)u32MaxLatency_) )
+  {
+    bPass = FALSE;
+  }
+
+  printf("%7u %5lu %6lu %8.1f %8.1f %8.1f  %s\n", u8Starved_, u32MaxLatency_, u32Notes,
+         MODEL_TICKS_TO_NS(u32MaxLatency_) / 1000.0, (double)s32Min * 1000.0 / MODEL_TICKS_PER_MS,
+         (double)s32Max * 1000.0 / MODEL_TICKS_PER_MS, bPass ? "ok" : "FAIL");
+
+  return(bPass);
+
+} /* end AlignRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Starves each voice at each latency bound.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every run passed
+*/
+int main(int argc, char* argv[])
+{
+  bool bVerbose = (bool)( (argc > 1) && (strcmp(argv[1], "-v") == 0) );
+  bool bPass = TRUE;
+
+  printf("starved bound  notes bound_us   min_us   max_us\n");
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    for(u8 j = 0; j < (sizeof(Align_au32Latency) / sizeof(Align_au32Latency[0])); j++)
+    {
+      if(!AlignRun(i, Align_au32Latency[j], bVerbose))
+      {
+        bPass = FALSE;
+      }
+    }
+  }
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,40 @@
+/**********************************************************************************************************************
+File: core_cm3.h (host build)
+
+Description:
+Stands in for cmsis/core_cm3.h in the host build (this directory is searched first).  The real header is included
+with its compiler-specific section skipped, since the gcc version of it is Cortex-M3 assembly.  The intrinsics the
+firmware uses are replaced by host versions: there are no interrupts to mask, because the host models call the
+interrupt handlers between main loop calls.
+**********************************************************************************************************************/
+
+#ifndef __HOST_CORE_CM3_H
+#define __HOST_CORE_CM3_H
+
+#include <stdint.h>
+
+#define __ASM                     asm
+#define __INLINE                  inline
+
+static __INLINE void __NOP(void)                  { }
+static __INLINE void __enable_irq(void)           { }
+static __INLINE void __disable_irq(void)          { }
+static __INLINE void __WFI(void)                  { }
+static __INLINE void __ISB(void)                  { }
+static __INLINE void __DSB(void)                  { }
+static __INLINE void __DMB(void)                  { }
+static __INLINE uint32_t __get_PRIMASK(void)      { return(0); }
+static __INLINE void __set_PRIMASK(uint32_t u32PriMask_) { (void)u32PriMask_; }
+
+#pragma push_macro("__GNUC__")
+#undef __GNUC__
+#include "../../cmsis/core_cm3.h"
+#pragma pop_macro("__GNUC__")
+
+
+#endif /* __HOST_CORE_CM3_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,20 @@
+/**********************************************************************************************************************
+File: host.h
+
+Description:
+Forced include of the host build (gcc -include host.h).  Maps the IAR keywords used by the firmware to gcc so the
+firmware sources compile unchanged on Linux.  See the Makefile in this directory.
+**********************************************************************************************************************/
+
+#ifndef __HOST_H
+#define __HOST_H
+
+#define __weak                    __attribute__((weak))
+
+
+#endif /* __HOST_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,316 @@
+/**********************************************************************************************************************
+File: jitter.c
+
+Description:
+Note boundary jitter benchmark for the TC0 note sequencer.  Each song is played through the register model with a
+random delay from every RC compare to its interrupt handler, and the time each note starts (its buzzer PWM change) is
+compared with the ideal start computed from the song table at the same tempo.
+
+Because RC compares restart the counter in hardware, a late handler only delays the buzzer write: the next boundary
+is still counted from the compare.  The error of every note, measured from the start of the song (the first handler
+is late too), must therefore stay within the latency, however long the song is.  A note may also start up to
+MUSIC_MERGE_TICKS early when its boundary is merged with the other voice's.  Any error outside that range
+(accumulated drift, or a counter wrap from a late RC write) or a missed note fails the run.  Latencies go up to the
+limit the sequencer is written for (MUSIC_MERGE_TICKS).
+
+Usage: jitter [-v]    (-v lists the error of every note)
+Returns 0 if every note of every run is within the latency, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../application/music.c"
+#include "../../application/songs.c"
+
+#include <stdio.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define JITTER_MAX_NOTES          (u16)256             /* Note starts recorded per voice */
+#define JITTER_TIMEOUT_MS         (u32)120000          /* Longest song run */
+
+
+/***********************************************************************************************************************
+Type Definitions
+***********************************************************************************************************************/
+typedef struct
+{
+  const char* pcName;            /* Song name printed in the report */
+  const SongType* psSong;        /* Song played */
+} JitterSongType;
+
+typedef struct
+{
+  u16 u16Count;                  /* Note starts recorded */
+  u64 au64Ticks[JITTER_MAX_NOTES]; /* Model time of each note start */
+  u16 u16LastPeriod;             /* Last PWM period seen */
+  bool bLastEnabled;             /* Last PWM enable seen */
+} JitterVoiceType;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Jitter_" and be declared as static.
+***********************************************************************************************************************/
+static const JitterSongType Jitter_asSongs[] =
+{
+  {"mary", &G_sSongMaryHadALittleLamb},
+  {"elise", &G_sSongFurElise}
+};
+
+/* Largest handler latency in ticks for each run (375 ticks per ms) */
+static const u32 Jitter_au32Latency[] = {0, 1, 10, 25, MUSIC_MERGE_TICKS - 1};
+
+static JitterVoiceType Jitter_asActual[MUSIC_VOICES]; /* Note starts seen on the buzzers */
+static JitterVoiceType Jitter_asIdeal[MUSIC_VOICES];  /* Note starts computed from the song */
+static u32 Jitter_u32MaxLatency;                      /* Latency bound of the current run */
+static u32 Jitter_u32Seed;                            /* Latency generator state */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: JitterLatency
+
+Description:
+Random handler latency for the model: uniform from 0 to the bound of the run, from a fixed seed so every run is
+repeatable.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 - Jitter_u32MaxLatency ticks
+*/
+static u32 JitterLatency(void)
+{
+  Jitter_u32Seed = (Jitter_u32Seed * 1103515245UL) + 12345UL;
+  return( ((Jitter_u32Seed >> 16) & 0x7FFF) % (Jitter_u32MaxLatency + 1) );
+
+} /* end JitterLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: JitterPwmLog
+
+Description:
+Records a note start each time a buzzer is turned on or changes pitch while on.
+
+Requires:
+  -
+
+Promises:
+  - The model time of the change is added to the channel's note starts
+*/
+static void JitterPwmLog(const ModelPwmEventType* psEvent_)
+{
+  JitterVoiceType* psVoice = &Jitter_asActual[psEvent_->u8Channel];
+
+  if( psEvent_->bEnabled && (!psVoice->bLastEnabled || (psEvent_->u16Period != psVoice->u16LastPeriod)) &&
+      (psVoice->u16Count < JITTER_MAX_NOTES) )
+  {
+    psVoice->au64Ticks[psVoice->u16Count++] = ModelTicks();
+  }
+
+  psVoice->bLastEnabled = psEvent_->bEnabled;
+  psVoice->u16LastPeriod = psEvent_->u16Period;
+
+} /* end JitterPwmLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: JitterIdeal
+
+Description:
+Computes the start of every sounding note of a song from its table, with the same tempo scaling as the sequencer.
+
+Requires:
+  - The tempo is the one the song is played at
+
+Promises:
+  - Jitter_asIdeal holds the note starts of each voice in model ticks
+*/
+static void JitterIdeal(const SongType* psSong_)
+{
+  const SongVoiceType* psSongVoice;
+  MusicNoteType sNote;
+  u64 u64Ticks;
+  u32 u32Sound;
+
+  memset(Jitter_asIdeal, 0, sizeof(Jitter_asIdeal));
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    psSongVoice = &psSong_->asVoices[i];
+    u64Ticks = MUSIC_START_TICKS;
+
+    for(u16 j = 0; j < psSongVoice->u16NoteCount; j++)
+    {
+      MusicDecodeNote(psSongVoice->pu16Notes[j], &sNote);
+      if(sNote.u8NoteIndex == NOTE_INDEX_REST)
+      {
+        sNote.u16Gap = 0;
+      }
+      else if(Jitter_asIdeal[i].u16Count < JITTER_MAX_NOTES)
+      {
+        Jitter_asIdeal[i].au64Ticks[Jitter_asIdeal[i].u16Count++] = u64Ticks;
+      }
+
+      u32Sound = MusicTempoTicks(sNote.u16Length - sNote.u16Gap, Music_u8TempoStep);
+      u64Ticks += ((u32Sound == 0) ? 1 : u32Sound) + MusicTempoTicks(sNote.u16Gap, Music_u8TempoStep);
+    }
+  }
+
+} /* end JitterIdeal() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: JitterLoop
+
+Description:
+Main loop pass of the benchmark: only the music state machine runs.
+
+Requires:
+  -
+
+Promises:
+  - G_MusicStateMachine() has run once
+*/
+static void JitterLoop(void)
+{
+  G_MusicStateMachine();
+
+} /* end JitterLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: JitterRun
+
+Description:
+Plays a song with one latency bound and checks every note start.
+
+Requires:
+  -
+
+Promises:
+  - Prints one report line (and each note with bVerbose_)
+  - Returns TRUE if both voices started all their notes from MUSIC_MERGE_TICKS early to u32MaxLatency_ ticks late
+*/
+static bool JitterRun(const JitterSongType* psSong_, u32 u32MaxLatency_, bool bVerbose_)
+{
+  s32 s32Error;
+  s32 s32Offset;
+  s32 s32Max = 0;
+  s32 s32Min = 0;
+  s32 s32Sum = 0;
+  s32 s32Last = 0;
+  u32 u32Notes = 0;
+  u32 u32Ms = 0;
+  bool bPass = TRUE;
+
+  if(!ModelInitialize())
+  {
+    printf("jitter: cannot map the peripheral space\n");
+    return(FALSE);
+  }
+
+  memset(Jitter_asActual, 0, sizeof(Jitter_asActual));
+  Jitter_u32MaxLatency = u32MaxLatency_;
+  Jitter_u32Seed = 1;
+  ModelSetLatency(JitterLatency);
+  ModelSetPwmLog(JitterPwmLog);
+
+  PWMSetupAudio();
+  MusicInitialize();
+  JitterIdeal(psSong_->psSong);
+  MusicStart(psSong_->psSong);
+
+  while( (G_u32MusicFlags & _MUSIC_PLAYING) && (u32Ms++ < JITTER_TIMEOUT_MS) )
+  {
+    ModelRun(1, JitterLoop);
+  }
+
+  /* Both voices start in the first handler: its latency moves the whole song */
+  s32Offset = (s32)Jitter_asActual[0].au64Ticks[0] - (s32)Jitter_asIdeal[0].au64Ticks[0];
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    if(Jitter_asActual[i].u16Count != Jitter_asIdeal[i].u16Count)
+    {
+      printf("jitter: %s voice %u started %u notes, expected %u\n", psSong_->pcName, i,
+             Jitter_asActual[i].u16Count, Jitter_asIdeal[i].u16Count);
+      bPass = FALSE;
+    }
+
+    for(u16 j = 0; (j < Jitter_asActual[i].u16Count) && (j < Jitter_asIdeal[i].u16Count); j++)
+    {
+      s32Error = (s32)Jitter_asActual[i].au64Ticks[j] - (s32)Jitter_asIdeal[i].au64Ticks[j] - s32Offset;
+      if(bVerbose_)
+      {
+        printf("  voice %u note %3u ideal %9llu actual %9llu error %4ld\n", i, j,
+               Jitter_asIdeal[i].au64Ticks[j], Jitter_asActual[i].au64Ticks[j], s32Error);
+      }
+
+      s32Max = (s32Error > s32Max) ? s32Error : s32Max;
+      s32Min = (s32Error < s32Min) ? s32Error : s32Min;
+      s32Sum += s32Error;
+      s32Last = s32Error;
+      u32Notes++;
+    }
+  }
+
+  if( (s32Min < -(s32)MUSIC_MERGE_TICKS) || (s32Max > (s32)u32MaxLatency_) )
+  {
+    bPass = FALSE;
+  }
+
+  printf("%-6s %5lu %6lu %8.1f %8.1f %8.1f %8.1f %8.1f  %s\n", psSong_->pcName, u32MaxLatency_, u32Notes,
+         MODEL_TICKS_TO_NS(u32MaxLatency_) / 1000.0, (double)s32Min * 1000.0 / MODEL_TICKS_PER_MS,
+         (double)s32Max * 1000.0 / MODEL_TICKS_PER_MS,
+         (u32Notes != 0) ? ((double)s32Sum * 1000.0 / MODEL_TICKS_PER_MS / u32Notes) : 0.0,
+         (double)s32Last * 1000.0 / MODEL_TICKS_PER_MS, bPass ? "ok" : "FAIL");
+
+  return(bPass);
+
+} /* end JitterRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs every song at every latency bound.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every run passed
+*/
+int main(int argc, char* argv[])
+{
+  bool bVerbose = (bool)( (argc > 1) && (strcmp(argv[1], "-v") == 0) );
+  bool bPass = TRUE;
+
+  printf("song   bound  notes bound_us   min_us   max_us  mean_us  last_us\n");
+  for(u8 i = 0; i < (sizeof(Jitter_asSongs) / sizeof(Jitter_asSongs[0])); i++)
+  {
+    for(u8 j = 0; j < (sizeof(Jitter_au32Latency) / sizeof(Jitter_au32Latency[0])); j++)
+    {
+      if(!JitterRun(&Jitter_asSongs[i], Jitter_au32Latency[j], bVerbose))
+      {
+        bPass = FALSE;
+      }
+    }
+  }
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,332 @@
+/**********************************************************************************************************************
+File: latency.c
+
+Description:
+Super loop latency test for the music player.  The firmware is linked whole (every driver and application in the IAR
+project, main.c with its main() renamed) and the super loop of main() runs once per 1 ms system tick of the register
+model while songs are started, paused, resumed, re-tempoed and stopped.  The test fails if:
+- any loop pass blocks (caught by an alarm: a blocking player would busy-wait for a whole song), or
+- the 99.9th percentile of the loop pass times exceeds the budget, or a song does not play to its end.
+
+Pass times are host times, so the budget is the 1 ms loop period scaled to the host: the default LATENCY_BUDGET_NS
+(50 us) assumes a host core that does at least 20 times the work of the 48 MHz Cortex-M3 per unit of time.  It can be
+changed on the command line.  The percentile is checked rather than the maximum so a host preemption does not fail the
+test; the maximum is reported.
+
+The driver initializations busy-wait on G_u32SystemTime1ms, which SysTick advances on the board.  The test is linked
+with IsTimeUp() wrapped (-Wl,--wrap=IsTimeUp) so that during initialization each poll runs the register model for
+1 ms: the waits end, and the TWI transfers of the LCD setup complete through the model's TWI0 interrupt.
+
+The debug messages go out through the model's USART0 at the debug baud rate, and the LCD messages through its idle
+TWI0 bus.
+
+Usage: latency [budget ns]
+Returns 0 on success, 1 on a failure.
+**********************************************************************************************************************/
+
+#include <signal.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "configuration.h"
+#include "music.h"
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define LATENCY_BUDGET_NS         (u64)50000           /* Default pass budget: 1 ms on the target scaled to the host */
+#define LATENCY_ALARM_S           (unsigned)60         /* Whole test time limit */
+#define LATENCY_MAX_PASSES        (u32)200000          /* Pass times kept */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile fnCode_type G_ButtonStateMachine;      /* From buttons.c */
+extern volatile fnCode_type G_UartStateMachine;        /* From sam3u_uart.c */
+extern volatile fnCode_type G_MessagingStateMachine;   /* From messaging.c */
+extern volatile fnCode_type G_DebugStateMachine;       /* From debug.c */
+extern volatile fnCode_type G_LcdStateMachine;         /* From NHD-C0220BiZ_LCD.c */
+extern volatile fnCode_type G_TWIStateMachine;         /* From sam3u_i2c.c */
+extern volatile fnCode_type G_MusicStateMachine;       /* From music.c */
+extern volatile u32 G_u32MusicFlags;                   /* From music.c */
+extern volatile u32 G_u32SystemFlags;                  /* From main.c */
+
+bool __real_IsTimeUp(u32* pu32SavedTick_, u32 u32Period_); /* From utilities.c, wrapped by the linker */
+
+extern const SongType G_sSongMaryHadALittleLamb;       /* From songs.c */
+extern const SongType G_sSongFurElise;                 /* From songs.c */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Latency_" and be declared as static.
+***********************************************************************************************************************/
+static u64 Latency_au64Pass[LATENCY_MAX_PASSES];       /* Host time of each pass during playback */
+static u32 Latency_u32Passes;                          /* Passes recorded */
+static const char* Latency_pcStep = "initialization";  /* Step running, for the alarm report */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LatencyLoop
+
+Description:
+One pass of the super loop in main().
+
+Requires:
+  - The drivers and applications are initialized
+
+Promises:
+  - Every state machine has run once
+*/
+static void LatencyLoop(void)
+{
+  WATCHDOG_BONE();
+
+  LedUpdate();
+  G_ButtonStateMachine();
+  G_MessagingStateMachine();
+  G_UartStateMachine();
+  G_DebugStateMachine();
+  G_TWIStateMachine();
+
+  G_LcdStateMachine();
+  G_MusicStateMachine();
+
+  SystemSleep();
+
+} /* end LatencyLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LatencyRun
+
+Description:
+Runs the super loop for a number of ms and keeps the time of every pass.
+
+Requires:
+  -
+
+Promises:
+  - u32Ms_ passes have run and their times are appended to Latency_au64Pass
+*/
+static void LatencyRun(u32 u32Ms_)
+{
+  ModelStatsType sStats;
+
+  for(u32 i = 0; i < u32Ms_; i++)
+  {
+    ModelRun(1, LatencyLoop);
+    ModelGetStats(&sStats);
+    if(Latency_u32Passes < LATENCY_MAX_PASSES)
+    {
+      Latency_au64Pass[Latency_u32Passes++] = sStats.u64LoopLastTime;
+    }
+  }
+
+} /* end LatencyRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LatencyPlayToEnd
+
+Description:
+Runs the super loop until the current song ends.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if the song ended within u32MaxMs_
+*/
+static bool LatencyPlayToEnd(u32 u32MaxMs_)
+{
+  for(u32 i = 0; (i < u32MaxMs_) && (G_u32MusicFlags & _MUSIC_PLAYING); i++)
+  {
+    LatencyRun(1);
+  }
+
+  return( (bool)!(G_u32MusicFlags & _MUSIC_PLAYING) );
+
+} /* end LatencyPlayToEnd() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LatencyAlarm
+
+Description:
+SIGALRM handler: a loop pass or the whole test did not return in time.
+
+Requires:
+  -
+
+Promises:
+  - Reports the step and exits with 1
+*/
+static void LatencyAlarm(int iSignal_)
+{
+  (void)iSignal_;
+  fprintf(stderr, "latency: FAIL - the super loop blocked during %s\n", Latency_pcStep);
+  _exit(1);
+
+} /* end LatencyAlarm() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: __wrap_IsTimeUp
+
+Description:
+IsTimeUp() as the firmware calls it.  During initialization, when the board is busy-waiting for SysTick, each poll
+first runs the register model for 1 ms.
+
+Requires:
+  - As IsTimeUp()
+
+Promises:
+  - As IsTimeUp()
+  - With _SYSTEM_INITIALIZING set, G_u32SystemTime1ms has advanced and the model interrupts have run
+*/
+bool __wrap_IsTimeUp(u32* pu32SavedTick_, u32 u32Period_)
+{
+  if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+  {
+    ModelRun(1, NULL);
+  }
+
+  return( __real_IsTimeUp(pu32SavedTick_, u32Period_) );
+
+} /* end __wrap_IsTimeUp() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LatencyCompare
+
+Description:
+qsort() order for pass times.
+
+Requires:
+  -
+
+Promises:
+  - Returns <0, 0 or >0 as *pvA_ is less than, equal to or more than *pvB_
+*/
+static int LatencyCompare(const void* pvA_, const void* pvB_)
+{
+  u64 u64A = *(const u64*)pvA_;
+  u64 u64B = *(const u64*)pvB_;
+
+  return( (u64A > u64B) - (u64A < u64B) );
+
+} /* end LatencyCompare() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Initializes the firmware as main() does (without the clock and pin setup the model does not need) and plays through
+the player API while timing the super loop.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if no pass blocked, the 99.9th percentile is within the budget and every song ended
+*/
+int main(int argc, char* argv[])
+{
+  u64 u64Budget = (argc > 1) ? strtoull(argv[1], NULL, 0) : LATENCY_BUDGET_NS;
+  u64 u64Sum = 0;
+  u64 u64P999;
+  bool bPass = TRUE;
+
+  if(!ModelInitialize())
+  {
+    printf("latency: cannot map the peripheral space\n");
+    return(1);
+  }
+
+  signal(SIGALRM, LatencyAlarm);
+  alarm(LATENCY_ALARM_S);
+
+  /* GpioSetup() sets up the buzzer channels on the board */
+  G_u32SystemFlags |= _SYSTEM_INITIALIZING;
+  PWMSetupAudio();
+  MessagingInitialize();
+  UartInitialize();
+  LedInitialize();
+  ButtonInitialize();
+  TWIInitialize();
+  DebugInitialize();
+  LcdInitialize();
+  MusicInitialize();
+  G_u32SystemFlags &= ~_SYSTEM_INITIALIZING;
+
+  Latency_pcStep = "idle";
+  LatencyRun(100);
+
+  Latency_pcStep = "a song paused and resumed";
+  MusicStart(&G_sSongMaryHadALittleLamb);
+  LatencyRun(1500);
+  MusicPause();
+  LatencyRun(300);
+  MusicResume();
+  if(!LatencyPlayToEnd(30000))
+  {
+    printf("latency: FAIL - the song did not end\n");
+    bPass = FALSE;
+  }
+
+  Latency_pcStep = "a song restarted, re-tempoed and stopped";
+  MusicStart(&G_sSongFurElise);
+  LatencyRun(1000);
+  MusicStart(&G_sSongMaryHadALittleLamb);
+  LatencyRun(500);
+  MusicSetTempo(MUSIC_TEMPO_STEPS - 1);
+  LatencyRun(500);
+  MusicStop();
+  LatencyRun(100);
+
+  Latency_pcStep = "a song at the slowest tempo";
+  MusicSetTempo(0);
+  MusicStart(&G_sSongFurElise);
+  if(!LatencyPlayToEnd(120000))
+  {
+    printf("latency: FAIL - the song did not end\n");
+    bPass = FALSE;
+  }
+
+  alarm(0);
+
+  for(u32 i = 0; i < Latency_u32Passes; i++)
+  {
+    u64Sum += Latency_au64Pass[i];
+  }
+  qsort(Latency_au64Pass, Latency_u32Passes, sizeof(u64), LatencyCompare);
+  u64P999 = Latency_au64Pass[(Latency_u32Passes * 999) / 1000];
+
+  if(u64P999 > u64Budget)
+  {
+    bPass = FALSE;
+  }
+
+  printf("latency: %lu passes, mean %llu ns, 99.9%% %llu ns, max %llu ns, budget %llu ns  %s\n", Latency_u32Passes,
+         (Latency_u32Passes != 0) ? (u64Sum / Latency_u32Passes) : 0, u64P999,
+         Latency_au64Pass[Latency_u32Passes - 1], u64Budget, bPass ? "ok" : "FAIL");
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,750 @@
+/**********************************************************************************************************************
+File: midibench.c
+
+Description:
+MIDI file parser test and benchmark.  Files are built in memory and fed to midi.c the way the main loop does: one
+MidiFeed() per pass with the bytes it has not taken yet (up to a card block), then the notes the parser has ready are
+taken with MidiGetNote().  The music player is started by MidiStart() but its state machine is not run, so the notes
+are taken here as fast as the parser gives them.  The test fails if:
+- a type 1 file with notes in a second track does not play its first note track and set _MIDI_MULTI_TRACK, or a
+  trailing track without notes sets it;
+- notes and rests longer than MIDI_MAX_NOTE_TIME are not split into entries of at most that length whose sum is the
+  exact note time, including when a run of long notes needs more entries than the note FIFOs hold;
+- the total time of a long file (with a tempo change) is off from the exact time by more than MIDIBENCH_MAX_ERROR_PPM.
+
+The benchmark reports the events parsed per second, the worst MidiFeed() call and the worst main loop pass (the
+MidiFeed() call and the MidiGetNote() calls after it) in host time.
+
+Usage: midibench [notes]    (notes in the benchmark file, default MIDIBENCH_NOTES)
+Returns 0 if every case passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../application/music.c"
+#include "../../application/songs.c"
+#include "../../application/midi.c"
+
+#include <stdio.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define MIDIBENCH_FILE_SIZE       (u32)(1UL << 22)     /* Largest file built */
+#define MIDIBENCH_BLOCK_SIZE      (u32)512             /* Most bytes offered per pass (a card block) */
+#define MIDIBENCH_MAX_ENTRIES     (u16)1024            /* FIFO entries recorded per voice */
+#define MIDIBENCH_MAX_PASSES      (u32)10000000        /* Passes before a run is declared stuck */
+#define MIDIBENCH_NOTES           (u32)20000           /* Notes in the benchmark file */
+#define MIDIBENCH_MAX_ERROR_PPM   (u64)10              /* Allowed total time error of the benchmark file */
+
+#define MIDIBENCH_DIVISION        (u16)480             /* Ticks per quarter note of the files built */
+#define MIDIBENCH_TEMPO_FAST      (u32)500000          /* us per quarter note (120 bpm) */
+#define MIDIBENCH_TEMPO_SLOW      (u32)1000000         /* us per quarter note (60 bpm) */
+#define MIDIBENCH_TEMPO_MS        (u32)480000          /* us per quarter note of 1 ms per tick (exact in Q16) */
+#define MIDIBENCH_TEMPO_TICK      (u32)3840            /* Tick of the tempo change in the benchmark file */
+
+#define MIDIBENCH_LONG_NOTES      (u16)( sizeof(MidiBench_asLong) / sizeof(MidiBench_asLong[0]) )
+#define MIDIBENCH_LONG_RUN        (u8)12               /* Long notes after MidiBench_asLong */
+#define MIDIBENCH_LONG_NOTE       (u32)300000          /* ms of each (5 FIFO entries) */
+#define MIDIBENCH_LONG_REST       (u32)100000          /* ms of the rest before each (2 FIFO entries) */
+
+#define MIDIBENCH_KEY_C4          (u8)60
+#define MIDIBENCH_KEY_E4          (u8)64
+#define MIDIBENCH_KEY_G4          (u8)67
+#define MIDIBENCH_VELOCITY        (u8)100
+
+
+/***********************************************************************************************************************
+Type Definitions
+***********************************************************************************************************************/
+typedef struct
+{
+  u8 u8NoteIndex;                /* Note index, or NOTE_INDEX_REST */
+  u32 u32Length;                 /* Length in ms */
+} MidiBenchNoteType;
+
+typedef struct
+{
+  u16 u16Count;                                    /* Entries recorded */
+  MusicNoteType asEntries[MIDIBENCH_MAX_ENTRIES];  /* FIFO entries taken from the parser */
+  u64 u64Total;                                    /* Sum of the lengths of every entry taken */
+  u32 u32Taken;                                    /* Entries taken (also past MIDIBENCH_MAX_ENTRIES) */
+  u16 u16MaxLength;                                /* Longest entry */
+  bool bEnded;                                     /* MUSIC_SOURCE_LAST or MUSIC_SOURCE_END was returned */
+} MidiBenchVoiceType;
+
+typedef struct
+{
+  u32 u32Passes;                 /* Main loop passes */
+  u64 u64Ns;                     /* Host time of every pass */
+  u64 u64FeedMaxNs;              /* Worst MidiFeed() call */
+  u64 u64PassMaxNs;              /* Worst pass */
+} MidiBenchRunType;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "MidiBench_" and be declared as static.
+***********************************************************************************************************************/
+static u8 MidiBench_au8File[MIDIBENCH_FILE_SIZE];      /* File being built */
+static u32 MidiBench_u32Size;                          /* Bytes in the file */
+static u32 MidiBench_u32TrackStart;                    /* Offset of the length of the track being built */
+static u8 MidiBench_u8Status;                          /* Running status of the track being built */
+static MidiBenchVoiceType MidiBench_asVoices[MUSIC_VOICES]; /* Notes taken in the last run */
+
+/* A 150 s note after a 130 s rest, then a short note */
+static const MidiBenchNoteType MidiBench_asLong[] =
+{
+  {NOTE_INDEX_REST, 130000}, {NOTE_INDEX_C4, 150000}, {NOTE_INDEX_REST, 500}, {NOTE_INDEX_E4, 500}
+};
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchByte
+
+Description:
+Appends a byte to the file being built.
+
+Requires:
+  - The file has room
+
+Promises:
+  - The byte is at the end of the file
+*/
+static void MidiBenchByte(u8 u8Byte_)
+{
+  MidiBench_au8File[MidiBench_u32Size++] = u8Byte_;
+
+} /* end MidiBenchByte() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchWord
+
+Description:
+Appends a big-endian 32 bit value.
+
+Requires:
+  - The file has room
+
+Promises:
+  - The four bytes are at the end of the file
+*/
+static void MidiBenchWord(u32 u32Value_)
+{
+  for(s8 i = 24; i >= 0; i -= 8)
+  {
+    MidiBenchByte((u8)(u32Value_ >> i));
+  }
+
+} /* end MidiBenchWord() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchVlq
+
+Description:
+Appends a variable length quantity (7 bits per byte, most significant first, high bit set on all but the last).
+
+Requires:
+  - u32Value_ fits in MIDI_VLQ_MAX_BYTES bytes
+
+Promises:
+  - The quantity is at the end of the file
+*/
+static void MidiBenchVlq(u32 u32Value_)
+{
+  u8 au8Bytes[MIDI_VLQ_MAX_BYTES];
+  u8 u8Count = 0;
+
+  do
+  {
+    au8Bytes[u8Count] = (u8)(u32Value_ & MIDI_DATA_MASK);
+    if(u8Count != 0)
+    {
+      au8Bytes[u8Count] |= MIDI_STATUS_BIT;
+    }
+    u8Count++;
+    u32Value_ >>= 7;
+  } while(u32Value_ != 0);
+
+  while(u8Count != 0)
+  {
+    MidiBenchByte(au8Bytes[--u8Count]);
+  }
+
+} /* end MidiBenchVlq() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchHeader
+
+Description:
+Starts a new file with its header chunk.
+
+Requires:
+  -
+
+Promises:
+  - The file holds the header of a u16Format_ file of u16Tracks_ tracks at MIDIBENCH_DIVISION ticks per quarter
+*/
+static void MidiBenchHeader(u16 u16Format_, u16 u16Tracks_)
+{
+  MidiBench_u32Size = 0;
+  MidiBenchWord(MIDI_HEADER_ID);
+  MidiBenchWord(MIDI_HEADER_SIZE);
+  MidiBenchByte((u8)(u16Format_ >> 8));
+  MidiBenchByte((u8)u16Format_);
+  MidiBenchByte((u8)(u16Tracks_ >> 8));
+  MidiBenchByte((u8)u16Tracks_);
+  MidiBenchByte((u8)(MIDIBENCH_DIVISION >> 8));
+  MidiBenchByte((u8)MIDIBENCH_DIVISION);
+
+} /* end MidiBenchHeader() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchTrack / MidiBenchEndTrack
+
+Description:
+Start a track chunk, and end it with an end of track event and fill in its length.
+
+Requires:
+  - MidiBenchEndTrack(): MidiBenchTrack() started the track
+
+Promises:
+  - The chunk is complete after MidiBenchEndTrack()
+*/
+static void MidiBenchTrack(void)
+{
+  MidiBenchWord(MIDI_TRACK_ID);
+  MidiBench_u32TrackStart = MidiBench_u32Size;
+  MidiBenchWord(0);
+  MidiBench_u8Status = 0;
+
+} /* end MidiBenchTrack() */
+
+static void MidiBenchEndTrack(void)
+{
+  u32 u32End;
+
+  MidiBenchVlq(0);
+  MidiBenchByte(MIDI_STATUS_META);
+  MidiBenchByte(MIDI_META_END_OF_TRACK);
+  MidiBenchByte(0);
+
+  u32End = MidiBench_u32Size;
+  MidiBench_u32Size = MidiBench_u32TrackStart;
+  MidiBenchWord(u32End - MidiBench_u32TrackStart - 4);
+  MidiBench_u32Size = u32End;
+
+} /* end MidiBenchEndTrack() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchTempo
+
+Description:
+Appends a tempo meta event.
+
+Requires:
+  - A track is open
+
+Promises:
+  - The event is at the end of the track, u32Delta_ ticks after the previous one
+*/
+static void MidiBenchTempo(u32 u32Delta_, u32 u32Tempo_)
+{
+  MidiBenchVlq(u32Delta_);
+  MidiBenchByte(MIDI_STATUS_META);
+  MidiBenchByte(MIDI_META_TEMPO);
+  MidiBenchByte((u8)MIDI_META_TEMPO_SIZE);
+  MidiBenchByte((u8)(u32Tempo_ >> 16));
+  MidiBenchByte((u8)(u32Tempo_ >> 8));
+  MidiBenchByte((u8)u32Tempo_);
+
+} /* end MidiBenchTempo() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchKey
+
+Description:
+Appends a note on (u8Velocity_ != 0) or a note on with velocity 0 (note off) on channel 1, using running status.
+
+Requires:
+  - A track is open
+
+Promises:
+  - The event is at the end of the track, u32Delta_ ticks after the previous one
+*/
+static void MidiBenchKey(u32 u32Delta_, u8 u8Key_, u8 u8Velocity_)
+{
+  MidiBenchVlq(u32Delta_);
+  if(MidiBench_u8Status != MIDI_STATUS_NOTE_ON)
+  {
+    MidiBench_u8Status = MIDI_STATUS_NOTE_ON;
+    MidiBenchByte(MIDI_STATUS_NOTE_ON);
+  }
+  MidiBenchByte(u8Key_);
+  MidiBenchByte(u8Velocity_);
+
+} /* end MidiBenchKey() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchText
+
+Description:
+Appends a text meta event (a track with no notes).
+
+Requires:
+  - A track is open
+
+Promises:
+  - The event is at the end of the track
+*/
+static void MidiBenchText(const char* pcText_)
+{
+  u32 u32Length = (u32)strlen(pcText_);
+
+  MidiBenchVlq(0);
+  MidiBenchByte(MIDI_STATUS_META);
+  MidiBenchByte(0x01);
+  MidiBenchVlq(u32Length);
+  for(u32 i = 0; i < u32Length; i++)
+  {
+    MidiBenchByte((u8)pcText_[i]);
+  }
+
+} /* end MidiBenchText() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchRun
+
+Description:
+Plays the file built as the main loop would: each pass offers the parser the next MIDIBENCH_BLOCK_SIZE bytes (or
+fewer at the end of the file), ends the data once every byte is taken, and takes every note ready for each voice.
+The run goes on until the parser is done as well, since it scans the tracks after the note track when the notes
+have all been taken.
+
+Requires:
+  - A file is built
+
+Promises:
+  - MidiBench_asVoices holds the entries taken; psRun_ the pass count and times
+  - Returns TRUE if both voices and the parser ended within MIDIBENCH_MAX_PASSES passes
+*/
+static bool MidiBenchRun(MidiBenchRunType* psRun_)
+{
+  MidiBenchVoiceType* psVoice;
+  MusicSourceStatusType eStatus;
+  MusicNoteType sNote;
+  u32 u32Offset = 0;
+  u32 u32Size;
+  u64 u64Start;
+  u64 u64Fed;
+  u64 u64End;
+
+  memset(psRun_, 0, sizeof(MidiBenchRunType));
+  memset(MidiBench_asVoices, 0, sizeof(MidiBench_asVoices));
+  MidiStart();
+  MusicStop();
+
+  while( !(MidiBench_asVoices[0].bEnded && MidiBench_asVoices[1].bEnded) || (G_u32MidiFlags & _MIDI_PLAYING) )
+  {
+    if(psRun_->u32Passes++ == MIDIBENCH_MAX_PASSES)
+    {
+      return(FALSE);
+    }
+
+    u32Size = MidiBench_u32Size - u32Offset;
+    if(u32Size > MIDIBENCH_BLOCK_SIZE)
+    {
+      u32Size = MIDIBENCH_BLOCK_SIZE;
+    }
+
+    u64Start = ModelHostNs();
+    if(u32Size != 0)
+    {
+      u32Offset += MidiFeed(&MidiBench_au8File[u32Offset], u32Size);
+      if(u32Offset == MidiBench_u32Size)
+      {
+        MidiEndOfData();
+      }
+    }
+    u64Fed = ModelHostNs();
+
+    for(u8 i = 0; i < MUSIC_VOICES; i++)
+    {
+      psVoice = &MidiBench_asVoices[i];
+      while(!psVoice->bEnded)
+      {
+        eStatus = MidiGetNote(i, &sNote);
+        if(eStatus == MUSIC_SOURCE_WAIT)
+        {
+          break;
+        }
+
+        if(eStatus != MUSIC_SOURCE_END)
+        {
+          if(psVoice->u16Count < MIDIBENCH_MAX_ENTRIES)
+          {
+            psVoice->asEntries[psVoice->u16Count++] = sNote;
+          }
+          psVoice->u64Total += sNote.u16Length;
+          psVoice->u32Taken++;
+          if(sNote.u16Length > psVoice->u16MaxLength)
+          {
+            psVoice->u16MaxLength = sNote.u16Length;
+          }
+        }
+
+        psVoice->bEnded = (bool)(eStatus != MUSIC_SOURCE_NOTE);
+      }
+    }
+    u64End = ModelHostNs();
+
+    psRun_->u64Ns += u64End - u64Start;
+    if( (u64Fed - u64Start) > psRun_->u64FeedMaxNs )
+    {
+      psRun_->u64FeedMaxNs = u64Fed - u64Start;
+    }
+    if( (u64End - u64Start) > psRun_->u64PassMaxNs )
+    {
+      psRun_->u64PassMaxNs = u64End - u64Start;
+    }
+  }
+
+  return(TRUE);
+
+} /* end MidiBenchRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchCompare
+
+Description:
+Compares the entries taken for a voice with the notes expected.  Consecutive entries of the same note are the parts
+of one split note, so they are summed before the comparison (the files built never repeat a note without a rest).
+
+Requires:
+  - MidiBenchRun() ran
+
+Promises:
+  - Returns TRUE if the voice played exactly the notes of asExpected_, with no entry over MIDI_MAX_NOTE_TIME
+*/
+static bool MidiBenchCompare(const char* pcCase_, u8 u8Voice_, const MidiBenchNoteType* asExpected_, u16 u16Count_)
+{
+  MidiBenchVoiceType* psVoice = &MidiBench_asVoices[u8Voice_];
+  u16 u16Note = 0;
+  u32 u32Length;
+  u16 i = 0;
+
+  if(psVoice->u16MaxLength > MIDI_MAX_NOTE_TIME)
+  {
+    printf("midibench: %s: voice %u has a %u ms entry  FAIL\n", pcCase_, u8Voice_, psVoice->u16MaxLength);
+    return(FALSE);
+  }
+
+  while(i < psVoice->u16Count)
+  {
+    u32Length = 0;
+    for(u8 u8Index = psVoice->asEntries[i].u8NoteIndex;
+        (i < psVoice->u16Count) && (psVoice->asEntries[i].u8NoteIndex == u8Index); i++)
+    {
+      u32Length += psVoice->asEntries[i].u16Length;
+    }
+
+    if( (u16Note >= u16Count_) || (psVoice->asEntries[i - 1].u8NoteIndex != asExpected_[u16Note].u8NoteIndex) ||
+        (u32Length != asExpected_[u16Note].u32Length) )
+    {
+      printf("midibench: %s: voice %u note %u is %u for %lu ms  FAIL\n", pcCase_, u8Voice_, u16Note,
+             psVoice->asEntries[i - 1].u8NoteIndex, u32Length);
+      return(FALSE);
+    }
+    u16Note++;
+  }
+
+  if(u16Note != u16Count_)
+  {
+    printf("midibench: %s: voice %u played %u of %u notes  FAIL\n", pcCase_, u8Voice_, u16Note, u16Count_);
+    return(FALSE);
+  }
+
+  return(TRUE);
+
+} /* end MidiBenchCompare() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchTracks
+
+Description:
+Type 1 files with a conductor track, a note track and a third track, with and without notes in the third track.
+Only the note track plays; notes in the third track set _MIDI_MULTI_TRACK, a third track without notes does not.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if both files played their note track and set the flags expected
+*/
+static bool MidiBenchTracks(void)
+{
+  static const MidiBenchNoteType asExpected[] = {{NOTE_INDEX_C4, 480}, {NOTE_INDEX_REST, 480}, {NOTE_INDEX_E4, 480}};
+  MidiBenchRunType sRun;
+  bool bPass = TRUE;
+
+  for(u8 u8Notes = 0; u8Notes < 2; u8Notes++)
+  {
+    const char* pcCase = u8Notes ? "second note track" : "trailing track without notes";
+    u32 u32Expected = _MIDI_DONE | (u8Notes ? _MIDI_MULTI_TRACK : 0);
+
+    MidiBenchHeader(1, 3);
+    MidiBenchTrack();
+    MidiBenchTempo(0, MIDIBENCH_TEMPO_MS);
+    MidiBenchEndTrack();
+
+    MidiBenchTrack();
+    MidiBenchKey(0, MIDIBENCH_KEY_C4, MIDIBENCH_VELOCITY);
+    MidiBenchKey(MIDIBENCH_DIVISION, MIDIBENCH_KEY_C4, 0);
+    MidiBenchKey(MIDIBENCH_DIVISION, MIDIBENCH_KEY_E4, MIDIBENCH_VELOCITY);
+    MidiBenchKey(MIDIBENCH_DIVISION, MIDIBENCH_KEY_E4, 0);
+    MidiBenchEndTrack();
+
+    MidiBenchTrack();
+    MidiBenchText("Harmony");
+    if(u8Notes)
+    {
+      MidiBenchKey(0, MIDIBENCH_KEY_G4, MIDIBENCH_VELOCITY);
+      MidiBenchKey(MIDIBENCH_DIVISION, MIDIBENCH_KEY_G4, 0);
+    }
+    MidiBenchEndTrack();
+
+    if(!MidiBenchRun(&sRun))
+    {
+      printf("midibench: %s: the parser stopped  FAIL\n", pcCase);
+      bPass = FALSE;
+      continue;
+    }
+
+    if( !MidiBenchCompare(pcCase, 0, asExpected, sizeof(asExpected) / sizeof(asExpected[0])) ||
+        !MidiBenchCompare(pcCase, 1, NULL, 0) )
+    {
+      bPass = FALSE;
+    }
+    else if( (G_u32MidiFlags & (_MIDI_DONE | _MIDI_ERROR | _MIDI_MULTI_TRACK)) != u32Expected )
+    {
+      printf("midibench: %s: flags 0x%02lx  FAIL\n", pcCase, G_u32MidiFlags);
+      bPass = FALSE;
+    }
+    else
+    {
+      printf("midibench: %s: flags 0x%02lx  ok\n", pcCase, G_u32MidiFlags);
+    }
+  }
+
+  return(bPass);
+
+} /* end MidiBenchTracks() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchLong
+
+Description:
+Long notes and rests: the notes of MidiBench_asLong, then a run of MIDIBENCH_LONG_RUN notes and rests that needs
+more FIFO entries than a note FIFO holds.  Each must come out split into entries of at most MIDI_MAX_NOTE_TIME that
+add up to its exact length.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if every note and rest was played in full
+*/
+static bool MidiBenchLong(void)
+{
+  static MidiBenchNoteType asExpected[MIDIBENCH_LONG_NOTES + (2 * MIDIBENCH_LONG_RUN)];
+  MidiBenchRunType sRun;
+  u16 u16Count = 0;
+  u32 u32Ticks;
+  u8 u8Key;
+
+  MidiBenchHeader(0, 1);
+  MidiBenchTrack();
+  MidiBenchTempo(0, MIDIBENCH_TEMPO_MS);
+
+  /* At MIDIBENCH_TEMPO_MS a tick is a ms */
+  u32Ticks = 0;
+  for(u16 i = 0; i < MIDIBENCH_LONG_NOTES; i++)
+  {
+    asExpected[u16Count++] = MidiBench_asLong[i];
+    if(MidiBench_asLong[i].u8NoteIndex == NOTE_INDEX_REST)
+    {
+      u32Ticks += MidiBench_asLong[i].u32Length;
+      continue;
+    }
+
+    u8Key = (u8)(MIDIBENCH_KEY_C4 + MidiBench_asLong[i].u8NoteIndex - NOTE_INDEX_C4);
+    MidiBenchKey(u32Ticks, u8Key, MIDIBENCH_VELOCITY);
+    MidiBenchKey(MidiBench_asLong[i].u32Length, u8Key, 0);
+    u32Ticks = 0;
+  }
+
+  for(u8 i = 0; i < MIDIBENCH_LONG_RUN; i++)
+  {
+    u8Key = (i % 2) ? MIDIBENCH_KEY_E4 : MIDIBENCH_KEY_C4;
+    asExpected[u16Count].u8NoteIndex = NOTE_INDEX_REST;
+    asExpected[u16Count++].u32Length = MIDIBENCH_LONG_REST;
+    asExpected[u16Count].u8NoteIndex = (u8)(NOTE_INDEX_C4 + u8Key - MIDIBENCH_KEY_C4);
+    asExpected[u16Count++].u32Length = MIDIBENCH_LONG_NOTE;
+    MidiBenchKey(MIDIBENCH_LONG_REST, u8Key, MIDIBENCH_VELOCITY);
+    MidiBenchKey(MIDIBENCH_LONG_NOTE, u8Key, 0);
+  }
+  MidiBenchEndTrack();
+
+  if(!MidiBenchRun(&sRun))
+  {
+    printf("midibench: long notes: the parser stopped  FAIL\n");
+    return(FALSE);
+  }
+
+  if( !MidiBenchCompare("long notes", 0, asExpected, u16Count) || !MidiBenchCompare("long notes", 1, NULL, 0) )
+  {
+    return(FALSE);
+  }
+
+  printf("midibench: long notes: %u notes and rests in %lu entries of at most %u ms  ok\n", u16Count,
+         MidiBench_asVoices[0].u32Taken, MidiBench_asVoices[0].u16MaxLength);
+  return(TRUE);
+
+} /* end MidiBenchLong() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MidiBenchSpeed
+
+Description:
+The benchmark: a type 1 file of u32Notes_ notes a quarter note apart (three eighths on, one eighth off) after a system
+exclusive event, with a conductor track that halves the tempo at MIDIBENCH_TEMPO_TICK.  Its total time is checked
+against the exact time and the parser speed is reported.
+
+Requires:
+  - u32Notes_ notes fit in MIDIBENCH_FILE_SIZE bytes
+
+Promises:
+  - Returns TRUE if the file played in full within MIDIBENCH_MAX_ERROR_PPM of its exact time
+*/
+static bool MidiBenchSpeed(u32 u32Notes_)
+{
+  MidiBenchRunType sRun;
+  u64 u64Ticks = (u64)u32Notes_ * MIDIBENCH_DIVISION;
+  u64 u64ExactUs;
+  u64 u64TotalUs;
+  u64 u64ErrorUs;
+  u64 u64Ppm;
+  bool bPass;
+
+  MidiBenchHeader(1, 2);
+  MidiBenchTrack();
+  MidiBenchTempo(0, MIDIBENCH_TEMPO_FAST);
+  MidiBenchTempo(MIDIBENCH_TEMPO_TICK, MIDIBENCH_TEMPO_SLOW);
+  MidiBenchEndTrack();
+
+  MidiBenchTrack();
+  MidiBenchVlq(0);
+  MidiBenchByte(MIDI_STATUS_SYSEX);
+  MidiBenchVlq(3);
+  MidiBenchByte(0x01);
+  MidiBenchByte(0x02);
+  MidiBenchByte(MIDI_STATUS_SYSEX_ESCAPE);
+  for(u32 i = 0; i < u32Notes_; i++)
+  {
+    u8 u8Key = (u8)(MIDIBENCH_KEY_C4 + (i % 24));
+
+    MidiBenchKey((i != 0) ? (MIDIBENCH_DIVISION / 4) : 0, u8Key, MIDIBENCH_VELOCITY);
+    MidiBenchKey((3 * MIDIBENCH_DIVISION) / 4, u8Key, 0);
+  }
+  MidiBenchEndTrack();
+
+  if(!MidiBenchRun(&sRun))
+  {
+    printf("midibench: speed: the parser stopped  FAIL\n");
+    return(FALSE);
+  }
+
+  /* The last note ends a rest (one eighth) before the last tick */
+  u64Ticks -= MIDIBENCH_DIVISION / 4;
+  u64ExactUs = (MIDIBENCH_TEMPO_TICK * (u64)MIDIBENCH_TEMPO_FAST) / MIDIBENCH_DIVISION;
+  if(u64Ticks > MIDIBENCH_TEMPO_TICK)
+  {
+    u64ExactUs += ((u64Ticks - MIDIBENCH_TEMPO_TICK) * MIDIBENCH_TEMPO_SLOW) / MIDIBENCH_DIVISION;
+  }
+  else
+  {
+    u64ExactUs = (u64Ticks * MIDIBENCH_TEMPO_FAST) / MIDIBENCH_DIVISION;
+  }
+
+  u64TotalUs = MidiBench_asVoices[0].u64Total * 1000;
+  u64ErrorUs = (u64TotalUs > u64ExactUs) ? (u64TotalUs - u64ExactUs) : (u64ExactUs - u64TotalUs);
+  u64Ppm = (u64ErrorUs * 1000000) / u64ExactUs;
+  bPass = (bool)( (u64Ppm <= MIDIBENCH_MAX_ERROR_PPM) && (MidiBench_asVoices[1].u32Taken == 0) &&
+                  !(G_u32MidiFlags & _MIDI_ERROR) );
+
+  printf("midibench: speed: %lu bytes, %lu notes: %llu ms for %llu.%03llu ms exact (%llu ppm)  %s\n",
+         MidiBench_u32Size, u32Notes_, MidiBench_asVoices[0].u64Total, u64ExactUs / 1000, u64ExactUs % 1000, u64Ppm,
+         bPass ? "ok" : "FAIL");
+  printf("midibench: speed: %lu passes, %.2f M events/s, worst MidiFeed() %llu ns, worst pass %llu ns\n",
+         sRun.u32Passes, (2.0 * u32Notes_ * 1000.0) / (double)sRun.u64Ns, sRun.u64FeedMaxNs, sRun.u64PassMaxNs);
+
+  return(bPass);
+
+} /* end MidiBenchSpeed() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs the parser cases and the benchmark.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every case passed
+*/
+int main(int argc, char* argv[])
+{
+  u32 u32Notes = (argc > 1) ? strtoul(argv[1], NULL, 0) : MIDIBENCH_NOTES;
+  bool bPass = TRUE;
+
+  if(!ModelInitialize())
+  {
+    printf("midibench: cannot map the peripheral space\n");
+    return(1);
+  }
+
+  /* The player is started by MidiStart(), so it needs its state */
+  PWMSetupAudio();
+  MusicInitialize();
+
+  bPass &= MidiBenchTracks();
+  bPass &= MidiBenchLong();
+  bPass &= MidiBenchSpeed(u32Notes);
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
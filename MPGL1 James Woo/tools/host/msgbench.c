@@ -0,0 +1,340 @@
+/**********************************************************************************************************************
+File: msgbench.c
+
+Description:
+Messaging benchmark (drivers/messaging.c, included here so the pool can be checked).  Messages are queued on test
+queues without coalescing and dequeued by hand, as a driver would.  Each case reports the host time per operation and
+fails if the messaging task misbehaves while it is timed:
+
+Pool occupancy: a queue and dequeue pair of a 1-byte message, with the pool empty and then with every header but one
+held by messages on another queue.  Allocation and free take the same time however full the pool is, so the two
+times should match.  Fails if a write is refused, the last header is not reused or the held messages change.
+
+Full pool rotation: every header is in use on one queue; each step dequeues the head and queues a new message, so
+the pool stays full.  Fails if a write is refused or a message leaves the queue out of order.
+
+Burst append: a burst of TX_QUEUE_SIZE 4-byte messages is queued on one queue, as a flood of debug output does, and
+then drained.  The first and the last MSGBENCH_GROUP appends of each burst are timed as groups, so the time of an
+append to a short queue and to a long one are compared: an append through the tail pointer does not depend on the
+queue length.  Fails if a write is refused, psTail is not the last message or the drain is out of order.
+
+Usage: msgbench [pairs]    (pairs per case, default MSGBENCH_PAIRS)
+Returns 0 if every case passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../drivers/messaging.c"
+
+#include <stdio.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define MSGBENCH_PAIRS            (u32)20000000        /* Default operations per case */
+#define MSGBENCH_GROUP            (u32)8               /* Appends timed together at each end of a burst */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* New variables (the board and main.c define them on the target; messaging.c refers to them) */
+volatile u32 G_u32SystemTime1ms;
+volatile u32 G_u32SystemTime1s;
+volatile u32 G_u32SystemFlags;
+volatile u32 G_u32ApplicationFlags;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "MsgBench_" and be declared as static.
+***********************************************************************************************************************/
+static MessageQueueType MsgBench_sQueue;               /* Queue the timed messages go on */
+static MessageQueueType MsgBench_sHeld;                /* Queue holding the messages that fill the pool */
+static u32 MsgBench_u32Pairs;                          /* Operations per case */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgBenchStart
+
+Description:
+Starts each case from a freshly initialized messaging task and empty test queues.
+
+Requires:
+  -
+
+Promises:
+  - The pool and status table are empty and both queues are empty without coalescing or expiry
+*/
+static void MsgBenchStart(void)
+{
+  MessageQueueType* apsQueues[] = {&MsgBench_sQueue, &MsgBench_sHeld};
+
+  MessagingInitialize();
+  for(u8 i = 0; i < 2; i++)
+  {
+    apsQueues[i]->psHead = NULL;
+    apsQueues[i]->psTail = NULL;
+    apsQueues[i]->psLastUrgent = NULL;
+    apsQueues[i]->bCoalesce = FALSE;
+    apsQueues[i]->bExpire = FALSE;
+  }
+
+} /* end MsgBenchStart() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgBenchPairs
+
+Description:
+Times queue and dequeue pairs of a 1-byte message on MsgBench_sQueue.
+
+Requires:
+  - MsgBench_sQueue is empty and the pool has a free header
+
+Promises:
+  - Returns the host ns per pair, or 0 if a write was refused
+  - *ppsMessage_ is the header the last pair used
+*/
+static double MsgBenchPairs(MessageType** ppsMessage_)
+{
+  u8 u8Byte = 0x55;
+  u64 u64Start = ModelHostNs();
+
+  for(u32 i = 0; i < MsgBench_u32Pairs; i++)
+  {
+    if(QueueMessage(1, &u8Byte, &MsgBench_sQueue) == 0)
+    {
+      return(0);
+    }
+
+    *ppsMessage_ = MsgBench_sQueue.psHead;
+    DeQueueMessage(&MsgBench_sQueue);
+  }
+
+  return( (double)(ModelHostNs() - u64Start) / MsgBench_u32Pairs );
+
+} /* end MsgBenchPairs() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgBenchOccupancy
+
+Description:
+Queue and dequeue pairs with an empty pool, then with all headers but one held.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if no write was refused, the held messages are unchanged and the last header was the one used
+*/
+static bool MsgBenchOccupancy(void)
+{
+  MessageType* psMessage = NULL;
+  MessageType* psHeld;
+  u8 au8Data[MSG_PAYLOAD_SIZE0] = {1, 2, 3, 4};
+  u32 u32FirstToken;
+  u32 u32Held = 0;
+  double dEmptyNs;
+  double dFullNs;
+  bool bPass;
+
+  MsgBenchStart();
+  dEmptyNs = MsgBenchPairs(&psMessage);
+
+  MsgBenchStart();
+  u32FirstToken = QueueMessage(sizeof(au8Data), au8Data, &MsgBench_sHeld);
+  for(u32 i = 1; i < TX_QUEUE_SIZE - 1; i++)
+  {
+    (void)QueueMessage(sizeof(au8Data), au8Data, &MsgBench_sHeld);
+  }
+  dFullNs = MsgBenchPairs(&psMessage);
+
+  /* The held messages are all there, in order, and the free header was the only one left */
+  psHeld = MsgBench_sHeld.psHead;
+  bPass = (bool)( (dEmptyNs != 0) && (dFullNs != 0) && (Msg_u8QueuedMessageCount == TX_QUEUE_SIZE - 1) &&
+                  (Msg_u8FreeSlot == psMessage->u8SlotIndex) &&
+                  (Msg_Pool[Msg_u8FreeSlot].u8NextFree == MSG_SLOT_NONE) );
+  while(psHeld != NULL)
+  {
+    bPass = bPass && (psHeld->u32Token == u32FirstToken + u32Held) && (psHeld->u32Size == sizeof(au8Data));
+    psHeld = psHeld->psNextMessage;
+    u32Held++;
+  }
+  bPass = bPass && (u32Held == TX_QUEUE_SIZE - 1);
+
+  printf("msgbench: occupancy   queue + dequeue: %5.1f ns per pair with 0 of %u headers held, "
+         "%5.1f ns with %lu  %s\n", dEmptyNs, TX_QUEUE_SIZE, dFullNs, u32Held, bPass ? "ok" : "FAIL");
+
+  return(bPass);
+
+} /* end MsgBenchOccupancy() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgBenchRotation
+
+Description:
+With every header in use on one queue, dequeues the head and queues a new message at the tail.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if no write was refused and every message left the queue in token order
+*/
+static bool MsgBenchRotation(void)
+{
+  u8 u8Byte = 0x55;
+  u32 u32NextToken;
+  u64 u64Start;
+  double dNs;
+  bool bPass = TRUE;
+
+  MsgBenchStart();
+  u32NextToken = QueueMessage(1, &u8Byte, &MsgBench_sQueue);
+  for(u32 i = 1; i < TX_QUEUE_SIZE; i++)
+  {
+    (void)QueueMessage(1, &u8Byte, &MsgBench_sQueue);
+  }
+  bPass = (bool)(Msg_u8FreeSlot == MSG_SLOT_NONE);
+
+  u64Start = ModelHostNs();
+  for(u32 i = 0; bPass && (i < MsgBench_u32Pairs); i++)
+  {
+    bPass = (bool)(MsgBench_sQueue.psHead->u32Token == u32NextToken);
+    DeQueueMessage(&MsgBench_sQueue);
+    bPass = bPass && (QueueMessage(1, &u8Byte, &MsgBench_sQueue) != 0);
+    u32NextToken++;
+  }
+  dNs = (double)(ModelHostNs() - u64Start) / MsgBench_u32Pairs;
+
+  bPass = bPass && (Msg_u8FreeSlot == MSG_SLOT_NONE) && (Msg_u8QueuedMessageCount == TX_QUEUE_SIZE);
+  printf("msgbench: full pool   dequeue + queue: %5.1f ns per pair with %u of %u headers in use  %s\n", dNs,
+         TX_QUEUE_SIZE, TX_QUEUE_SIZE, bPass ? "ok" : "FAIL");
+
+  return(bPass);
+
+} /* end MsgBenchRotation() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgBenchBurst
+
+Description:
+Queues bursts of TX_QUEUE_SIZE 4-byte messages on one queue and drains them.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if no write was refused, psTail was the last message queued and every burst drained in token order
+*/
+static bool MsgBenchBurst(void)
+{
+  u8 au8Data[MSG_PAYLOAD_SIZE0] = {1, 2, 3, 4};
+  u32 u32Bursts = MsgBench_u32Pairs / TX_QUEUE_SIZE;
+  u32 u32Token = 0;
+  u32 u32NextToken = 0;
+  u64 u64Start = 0;
+  u64 u64QueueNs = 0;
+  u64 u64DrainNs = 0;
+  u64 u64ShortNs = 0;
+  u64 u64LongNs = 0;
+  bool bPass = TRUE;
+
+  if(u32Bursts == 0)
+  {
+    u32Bursts = 1;
+  }
+
+  MsgBenchStart();
+  for(u32 i = 0; bPass && (i < u32Bursts); i++)
+  {
+    u64QueueNs -= ModelHostNs();
+    for(u32 j = 0; j < TX_QUEUE_SIZE; j++)
+    {
+      if( (j == 0) || (j == TX_QUEUE_SIZE - MSGBENCH_GROUP) )
+      {
+        u64Start = ModelHostNs();
+      }
+
+      u32Token = QueueMessage(sizeof(au8Data), au8Data, &MsgBench_sQueue);
+      bPass = bPass && (u32Token != 0) && (MsgBench_sQueue.psTail->u32Token == u32Token);
+      if(j == 0)
+      {
+        u32NextToken = u32Token;
+      }
+
+      if(j == MSGBENCH_GROUP - 1)
+      {
+        u64ShortNs += ModelHostNs() - u64Start;
+      }
+      else if(j == TX_QUEUE_SIZE - 1)
+      {
+        u64LongNs += ModelHostNs() - u64Start;
+      }
+    }
+    u64QueueNs += ModelHostNs();
+
+    u64DrainNs -= ModelHostNs();
+    while(MsgBench_sQueue.psHead != NULL)
+    {
+      bPass = bPass && (MsgBench_sQueue.psHead->u32Token == u32NextToken++);
+      DeQueueMessage(&MsgBench_sQueue);
+    }
+    u64DrainNs += ModelHostNs();
+    bPass = bPass && (u32NextToken == u32Token + 1);
+  }
+
+  printf("msgbench: burst       %u x 4-byte messages: append %5.1f ns (%5.1f ns to a queue of 0 to %lu, %5.1f ns "
+         "to %lu to %u), dequeue %5.1f ns  %s\n", TX_QUEUE_SIZE, (double)u64QueueNs / (u32Bursts * TX_QUEUE_SIZE),
+         (double)u64ShortNs / (u32Bursts * MSGBENCH_GROUP), MSGBENCH_GROUP - 1,
+         (double)u64LongNs / (u32Bursts * MSGBENCH_GROUP), TX_QUEUE_SIZE - MSGBENCH_GROUP, TX_QUEUE_SIZE - 1,
+         (double)u64DrainNs / (u32Bursts * TX_QUEUE_SIZE), bPass ? "ok" : "FAIL");
+
+  return(bPass);
+
+} /* end MsgBenchBurst() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs every case.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every case passed
+*/
+int main(int argc, char* argv[])
+{
+  bool bPass = TRUE;
+
+  MsgBench_u32Pairs = (argc > 1) ? strtoul(argv[1], NULL, 0) : MSGBENCH_PAIRS;
+  if(MsgBench_u32Pairs == 0)
+  {
+    MsgBench_u32Pairs = 1;
+  }
+
+  bPass = MsgBenchOccupancy() && bPass;
+  bPass = MsgBenchRotation() && bPass;
+  bPass = MsgBenchBurst() && bPass;
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,538 @@
+/**********************************************************************************************************************
+File: msgreport.c
+
+Description:
+Message pool fragmentation and occupancy report.  The firmware is linked whole, as for the latency test, with
+messaging.c included here so its pool can be read.  A debug session is typed into the model's USART0 at the debug
+baud rate while a song plays: the command list, tempo and transpose commands, the messaging statistics report and
+commands typed while earlier output is still draining.  The traffic is what the firmware queues for that session: the
+echo and command output on the debug UART and the LCD marquee on TWI0.
+
+After every 1 ms main loop pass the pool is sampled and the report gives:
+- headers in use: peak, mean and the share of passes by headers in use;
+- payload blocks in use per size class: peak and mean;
+- internal fragmentation: payload block bytes not used by the messages in them, over all passes and at the pass with
+  the most block bytes allocated;
+- messages in a larger size class than their size needs (the smaller class was full when they were queued);
+- messages queued and writes refused per queue.
+
+The report fails if a write was refused or the session output did not reach the UART line.
+
+Usage: msgreport
+Returns 0 if no write was refused and the session ran, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../drivers/messaging.c"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "music.h"
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define MSGREPORT_ALARM_S         (unsigned)60         /* Whole report time limit */
+#define MSGREPORT_TYPE_GAP_NS     (u64)60000000        /* Time between typed characters */
+#define MSGREPORT_PAUSE_MS        (u32)300             /* Time after a command is typed before the next one */
+#define MSGREPORT_DRAIN_MS        (u32)3000            /* Time at the end for the queues to empty */
+#define MSGREPORT_LINE_SIZE       (u32)65536           /* UART characters kept to check the session output */
+#define MSGREPORT_SHARE_BUCKETS   (u8)((TX_QUEUE_SIZE + 7) / 8 + 1)  /* 0 headers, then groups of 8 */
+
+
+/***********************************************************************************************************************
+Type Definitions
+***********************************************************************************************************************/
+typedef struct
+{
+  const char* pcCommand;         /* Characters typed */
+  bool bWait;                    /* TRUE: wait MSGREPORT_PAUSE_MS after it; FALSE: type the next one at once */
+} MsgReportStepType;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile fnCode_type G_ButtonStateMachine;      /* From buttons.c */
+extern volatile fnCode_type G_UartStateMachine;        /* From sam3u_uart.c */
+extern volatile fnCode_type G_DebugStateMachine;       /* From debug.c */
+extern volatile fnCode_type G_LcdStateMachine;         /* From NHD-C0220BiZ_LCD.c */
+extern volatile fnCode_type G_TWIStateMachine;         /* From sam3u_i2c.c */
+extern volatile fnCode_type G_MusicStateMachine;       /* From music.c */
+
+bool __real_IsTimeUp(u32* pu32SavedTick_, u32 u32Period_); /* From utilities.c, wrapped by the linker */
+
+extern const SongType G_sSongFurElise;                 /* From songs.c */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "MsgReport_" and be declared as static.
+***********************************************************************************************************************/
+/* The debug session: typed with MSGREPORT_TYPE_GAP_NS between characters */
+static const MsgReportStepType MsgReport_asSession[] =
+{
+  {"en+c00\r", TRUE},            /* Command list */
+  {"en+c02\r", FALSE},           /* Tempo faster three times */
+  {"en+c02\r", FALSE},
+  {"en+c02\r", TRUE},
+  {"en+c04\r", TRUE},            /* Transpose up and down */
+  {"en+c05\r", TRUE},
+  {"en+c07\r", TRUE},            /* Messaging statistics */
+  {"en+c00\r", FALSE},           /* Command list, then statistics while it drains */
+  {"en+c07\r", TRUE},
+  {"en+c06\r", TRUE},            /* PWM trace (not built: one message) */
+  {"en+c03\r", FALSE},           /* Tempo slower three times */
+  {"en+c03\r", FALSE},
+  {"en+c03\r", TRUE},
+  {"xyz\r", TRUE},               /* Not a command */
+  {"en+c00\r", TRUE},
+};
+
+static u8 MsgReport_au8Line[MSGREPORT_LINE_SIZE];      /* Characters sent on the UART line */
+static u32 MsgReport_u32LineChars;                     /* Characters sent (also past MSGREPORT_LINE_SIZE) */
+
+static u32 MsgReport_u32Passes;                        /* Passes sampled */
+static u64 MsgReport_u64HeaderSum;                     /* Sum of headers in use over the passes */
+static u8 MsgReport_u8HeaderPeak;                      /* Most headers in use */
+static u32 MsgReport_au32HeaderShare[MSGREPORT_SHARE_BUCKETS]; /* Passes by headers in use */
+static u64 MsgReport_au64BlockSum[MSG_PAYLOAD_CLASSES];  /* Sum of blocks in use per class over the passes */
+static u8 MsgReport_au8BlockPeak[MSG_PAYLOAD_CLASSES]; /* Most blocks in use per class */
+static u64 MsgReport_u64UsedSum;                       /* Sum of payload bytes used over the passes */
+static u64 MsgReport_u64AllocatedSum;                  /* Sum of payload block bytes allocated over the passes */
+static u32 MsgReport_u32PeakUsed;                      /* Payload bytes used at the most bytes allocated */
+static u32 MsgReport_u32PeakAllocated;                 /* Most payload block bytes allocated */
+static u64 MsgReport_u64BorrowedSum;                   /* Sum of borrowed payloads over the passes */
+static u32 MsgReport_u32OversizedPeak;                 /* Most messages in a larger class than needed at once */
+static u32 MsgReport_u32OversizedPasses;               /* Passes with such a message */
+
+static const char* MsgReport_pcStep = "initialization"; /* Step running, for the alarm report */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportLoop
+
+Description:
+One pass of the super loop in main().
+
+Requires:
+  - The drivers and applications are initialized
+
+Promises:
+  - Every state machine has run once
+*/
+static void MsgReportLoop(void)
+{
+  WATCHDOG_BONE();
+
+  LedUpdate();
+  G_ButtonStateMachine();
+  G_MessagingStateMachine();
+  G_UartStateMachine();
+  G_DebugStateMachine();
+  G_TWIStateMachine();
+
+  G_LcdStateMachine();
+  G_MusicStateMachine();
+
+  SystemSleep();
+
+} /* end MsgReportLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportSample
+
+Description:
+Adds the pool use after a pass to the report.
+
+Requires:
+  -
+
+Promises:
+  - The counters of the report include the pool as it is now
+*/
+static void MsgReportSample(void)
+{
+  MessageType* psMessage;
+  u8 u8Needed;
+  u32 u32Used = 0;
+  u32 u32Allocated = 0;
+  u32 u32Oversized = 0;
+  u32 u32Borrowed = 0;
+  u8 u8Blocks;
+
+  MsgReport_u32Passes++;
+  MsgReport_u64HeaderSum += Msg_u8QueuedMessageCount;
+  MsgReport_au32HeaderShare[(Msg_u8QueuedMessageCount + 7) / 8]++;
+  if(Msg_u8QueuedMessageCount > MsgReport_u8HeaderPeak)
+  {
+    MsgReport_u8HeaderPeak = Msg_u8QueuedMessageCount;
+  }
+
+  for(u8 i = 0; i < MSG_PAYLOAD_CLASSES; i++)
+  {
+    u8Blocks = Msg_asPayloadClasses[i].u8Blocks - Msg_asPayloadClasses[i].u8FreeCount;
+    MsgReport_au64BlockSum[i] += u8Blocks;
+    if(u8Blocks > MsgReport_au8BlockPeak[i])
+    {
+      MsgReport_au8BlockPeak[i] = u8Blocks;
+    }
+  }
+
+  for(u8 i = 0; i < TX_QUEUE_SIZE; i++)
+  {
+    if(Msg_Pool[i].bFree)
+    {
+      continue;
+    }
+
+    psMessage = &Msg_Pool[i].Message;
+    if(psMessage->u8PayloadClass == MSG_PAYLOAD_BORROWED)
+    {
+      u32Borrowed++;
+      continue;
+    }
+
+    u32Used += psMessage->u32Size;
+    u32Allocated += Msg_asPayloadClasses[psMessage->u8PayloadClass].u8BlockSize;
+
+    u8Needed = 0;
+    while(Msg_asPayloadClasses[u8Needed].u8BlockSize < psMessage->u32Size)
+    {
+      u8Needed++;
+    }
+    if(psMessage->u8PayloadClass > u8Needed)
+    {
+      u32Oversized++;
+    }
+  }
+
+  MsgReport_u64UsedSum += u32Used;
+  MsgReport_u64AllocatedSum += u32Allocated;
+  MsgReport_u64BorrowedSum += u32Borrowed;
+  if(u32Allocated > MsgReport_u32PeakAllocated)
+  {
+    MsgReport_u32PeakAllocated = u32Allocated;
+    MsgReport_u32PeakUsed = u32Used;
+  }
+
+  if(u32Oversized != 0)
+  {
+    MsgReport_u32OversizedPasses++;
+  }
+  if(u32Oversized > MsgReport_u32OversizedPeak)
+  {
+    MsgReport_u32OversizedPeak = u32Oversized;
+  }
+
+} /* end MsgReportSample() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportRun
+
+Description:
+Runs the super loop for a number of ms and samples the pool after every pass.
+
+Requires:
+  -
+
+Promises:
+  - u32Ms_ passes have run and been sampled
+*/
+static void MsgReportRun(u32 u32Ms_)
+{
+  for(u32 i = 0; i < u32Ms_; i++)
+  {
+    ModelRun(1, MsgReportLoop);
+    MsgReportSample();
+  }
+
+} /* end MsgReportRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportType
+
+Description:
+Types a command on the USART0 receive line and runs the super loop until its last character has arrived.
+
+Requires:
+  - The debug UART is set up
+
+Promises:
+  - The characters of pcCommand_ have been received
+*/
+static void MsgReportType(const char* pcCommand_)
+{
+  (void)ModelUartReceive((const u8*)pcCommand_, strlen(pcCommand_), MSGREPORT_TYPE_GAP_NS);
+  while(ModelTimeNs() < ModelUartReceiveEndNs())
+  {
+    MsgReportRun(1);
+  }
+
+} /* end MsgReportType() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportUartLog
+
+Description:
+Keeps the characters sent on the USART0 line.
+
+Requires:
+  -
+
+Promises:
+  - u8Char_ is added to MsgReport_au8Line if it has room
+*/
+static void MsgReportUartLog(u8 u8Char_, u64 u64TimeNs_)
+{
+  (void)u64TimeNs_;
+  if(MsgReport_u32LineChars < MSGREPORT_LINE_SIZE)
+  {
+    MsgReport_au8Line[MsgReport_u32LineChars] = u8Char_;
+  }
+  MsgReport_u32LineChars++;
+
+} /* end MsgReportUartLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportLineCount
+
+Description:
+Counts a text in the characters sent on the UART line.
+
+Requires:
+  -
+
+Promises:
+  - Returns the number of times pcText_ appears in MsgReport_au8Line
+*/
+static u32 MsgReportLineCount(const char* pcText_)
+{
+  u32 u32Size = strlen(pcText_);
+  u32 u32Kept = (MsgReport_u32LineChars < MSGREPORT_LINE_SIZE) ? MsgReport_u32LineChars : MSGREPORT_LINE_SIZE;
+  u32 u32Count = 0;
+
+  for(u32 i = 0; i + u32Size <= u32Kept; i++)
+  {
+    if(memcmp(&MsgReport_au8Line[i], pcText_, u32Size) == 0)
+    {
+      u32Count++;
+    }
+  }
+
+  return(u32Count);
+
+} /* end MsgReportLineCount() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportAlarm
+
+Description:
+SIGALRM handler: the session did not finish in time.
+
+Requires:
+  -
+
+Promises:
+  - Reports the step and exits with 1
+*/
+static void MsgReportAlarm(int iSignal_)
+{
+  (void)iSignal_;
+  fprintf(stderr, "msgreport: FAIL - the super loop blocked during %s\n", MsgReport_pcStep);
+  _exit(1);
+
+} /* end MsgReportAlarm() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: __wrap_IsTimeUp
+
+Description:
+IsTimeUp() as the firmware calls it.  During initialization, when the board is busy-waiting for SysTick, each poll
+first runs the register model for 1 ms.
+
+Requires:
+  - As IsTimeUp()
+
+Promises:
+  - As IsTimeUp()
+  - With _SYSTEM_INITIALIZING set, G_u32SystemTime1ms has advanced and the model interrupts have run
+*/
+bool __wrap_IsTimeUp(u32* pu32SavedTick_, u32 u32Period_)
+{
+  if(G_u32SystemFlags & _SYSTEM_INITIALIZING)
+  {
+    ModelRun(1, NULL);
+  }
+
+  return( __real_IsTimeUp(pu32SavedTick_, u32Period_) );
+
+} /* end __wrap_IsTimeUp() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgReportPrint
+
+Description:
+Prints the report.
+
+Requires:
+  - At least one pass has been sampled
+
+Promises:
+  - Returns the number of writes refused on the registered queues
+*/
+static u32 MsgReportPrint(void)
+{
+  MessageQueueType* psQueue;
+  u32 u32Refused = 0;
+  u32 u32Low;
+  u32 u32High;
+
+  printf("msgreport: headers    peak %u of %u, mean %.2f; passes by headers in use:", MsgReport_u8HeaderPeak,
+         TX_QUEUE_SIZE, (double)MsgReport_u64HeaderSum / MsgReport_u32Passes);
+  for(u8 i = 0; i < MSGREPORT_SHARE_BUCKETS; i++)
+  {
+    u32Low = (i == 0) ? 0 : (8 * i - 7);
+    u32High = (i == 0) ? 0 : ((8 * i > TX_QUEUE_SIZE) ? TX_QUEUE_SIZE : 8 * i);
+    if(u32Low == u32High)
+    {
+      printf(" %lu: %.1f%%", u32Low, (100.0 * MsgReport_au32HeaderShare[i]) / MsgReport_u32Passes);
+    }
+    else
+    {
+      printf(" %lu-%lu: %.1f%%", u32Low, u32High, (100.0 * MsgReport_au32HeaderShare[i]) / MsgReport_u32Passes);
+    }
+  }
+  printf("\n");
+
+  for(u8 i = 0; i < MSG_PAYLOAD_CLASSES; i++)
+  {
+    printf("msgreport: %3u-byte   blocks peak %2u of %2u, mean %5.2f\n", Msg_asPayloadClasses[i].u8BlockSize,
+           MsgReport_au8BlockPeak[i], Msg_asPayloadClasses[i].u8Blocks,
+           (double)MsgReport_au64BlockSum[i] / MsgReport_u32Passes);
+  }
+
+  printf("msgreport: payload    block bytes unused: %.1f%% over all passes (%llu of %llu byte-passes), "
+         "%.1f%% at the peak (%lu of %lu bytes)\n",
+         (MsgReport_u64AllocatedSum != 0) ?
+           (100.0 * (MsgReport_u64AllocatedSum - MsgReport_u64UsedSum)) / MsgReport_u64AllocatedSum : 0.0,
+         MsgReport_u64AllocatedSum - MsgReport_u64UsedSum, MsgReport_u64AllocatedSum,
+         (MsgReport_u32PeakAllocated != 0) ?
+           (100.0 * (MsgReport_u32PeakAllocated - MsgReport_u32PeakUsed)) / MsgReport_u32PeakAllocated : 0.0,
+         MsgReport_u32PeakAllocated - MsgReport_u32PeakUsed, MsgReport_u32PeakAllocated);
+
+  printf("msgreport: classes    in a larger class than needed: peak %lu at once, in %.1f%% of passes; "
+         "borrowed payloads mean %.2f\n", MsgReport_u32OversizedPeak,
+         (100.0 * MsgReport_u32OversizedPasses) / MsgReport_u32Passes,
+         (double)MsgReport_u64BorrowedSum / MsgReport_u32Passes);
+
+  for(u8 i = 0; i < Msg_u8TrackedQueues; i++)
+  {
+    psQueue = Msg_apsTrackedQueues[i];
+    u32Refused += psQueue->sStats.u32Rejected;
+    printf("msgreport: queue %.4s %5lu messages, peak depth %2lu, %lu writes refused\n",
+           (const char*)Msg_apu8QueueNames[i], psQueue->sStats.u32Queued, psQueue->sStats.u32PeakDepth,
+           psQueue->sStats.u32Rejected);
+  }
+
+  return(u32Refused);
+
+} /* end MsgReportPrint() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Initializes the firmware as main() does (without the clock and pin setup the model does not need), plays a song and
+types the debug session, then prints the report.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if no write was refused and the command list was sent each time it was asked for
+*/
+int main(void)
+{
+  u32 u32Lists = 0;
+  u32 u32Asked = 0;
+  u32 u32Refused;
+  bool bPass;
+
+  if(!ModelInitialize())
+  {
+    printf("msgreport: cannot map the peripheral space\n");
+    return(1);
+  }
+
+  signal(SIGALRM, MsgReportAlarm);
+  alarm(MSGREPORT_ALARM_S);
+  ModelSetUartLog(MsgReportUartLog);
+
+  /* GpioSetup() sets up the buzzer channels on the board */
+  G_u32SystemFlags |= _SYSTEM_INITIALIZING;
+  PWMSetupAudio();
+  MessagingInitialize();
+  UartInitialize();
+  LedInitialize();
+  ButtonInitialize();
+  TWIInitialize();
+  DebugInitialize();
+  LcdInitialize();
+  MusicInitialize();
+  G_u32SystemFlags &= ~_SYSTEM_INITIALIZING;
+
+  MsgReport_pcStep = "the debug session";
+  MusicStart(&G_sSongFurElise);
+  MsgReportRun(100);
+  for(u8 i = 0; i < sizeof(MsgReport_asSession) / sizeof(MsgReport_asSession[0]); i++)
+  {
+    MsgReportType(MsgReport_asSession[i].pcCommand);
+    if(MsgReport_asSession[i].bWait)
+    {
+      MsgReportRun(MSGREPORT_PAUSE_MS);
+    }
+
+    if(strcmp(MsgReport_asSession[i].pcCommand, "en+c00\r") == 0)
+    {
+      u32Asked++;
+    }
+  }
+  MsgReportRun(MSGREPORT_DRAIN_MS);
+  alarm(0);
+
+  u32Lists = MsgReportLineCount(DEBUG_CMD_NAME07);
+  printf("msgreport: session    %lu passes, %lu characters sent on the debug UART, command list sent %lu of %lu "
+         "times\n", MsgReport_u32Passes, MsgReport_u32LineChars, u32Lists, u32Asked);
+  u32Refused = MsgReportPrint();
+
+  bPass = (bool)( (u32Refused == 0) && (u32Lists == u32Asked) && (MsgReport_u32LineChars <= MSGREPORT_LINE_SIZE) );
+  printf("msgreport: %s\n", bPass ? "ok" : "FAIL");
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,541 @@
+/**********************************************************************************************************************
+File: msgtest.c
+
+Description:
+Unit tests of the messaging task (drivers/messaging.c, included here so its statics can be checked).  Messages are
+queued on a test queue and dequeued by hand, as a driver would.  The test fails if, for the status table:
+- a status does not read back WAITING, SENDING and COMPLETE as it is updated, or a COMPLETE status is not removed
+  once it has been read;
+- a status is lost before STATUS_QUEUE_SIZE newer tokens, or survives more;
+- a query or update of an old token reads or changes the status of the token that took its entry (generation check);
+- token 0 reads anything but NOT_FOUND or changes an empty entry, or is issued when the token counter rolls over;
+- a query or update of a token that is not in a full table reads past its end.  This test is built with
+  AddressSanitizer (see the Makefile), which stops it on any read outside Msg_StatusQueue;
+- a message left WAITING past MSG_STATUS_WAITING_TIME on a queue without bExpire gets a final state or fires its
+  event before its driver sends it, or its COMPLETE is then not notified and counted.
+
+For the priorities, a queue is drained MSGTEST_DRAIN_BYTES per ms (the debug UART at 38400 baud) a message at a time,
+as the driver sends it, while MSGTEST_BULK_BACKLOG bulk messages of MSGTEST_BULK_SIZE bytes are kept waiting.  A
+1-byte message is queued every MSGTEST_URGENT_PERIOD_MS, first as bulk and then as urgent, and its time from queued
+to COMPLETE is measured.  The test fails if:
+- the worst urgent latency is over MSGTEST_URGENT_BOUND_MS: the rest of the bulk message being sent, then its own
+  byte;
+- bulk or urgent messages complete out of order among themselves, or a write is refused.
+
+Usage: msgtest
+Returns 0 if every case passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../drivers/messaging.c"
+
+#include <stdio.h>
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define MSGTEST_DRAIN_BYTES       (u32)4               /* Bytes sent per ms */
+#define MSGTEST_BULK_SIZE         (u32)90              /* Bytes per bulk message */
+#define MSGTEST_BULK_BACKLOG      (u32)20              /* Bulk messages kept waiting */
+#define MSGTEST_URGENT_PERIOD_MS  (u32)97              /* Time between 1-byte messages */
+#define MSGTEST_URGENT_RUN_MS     (u32)20000           /* Time the priorities run for */
+#define MSGTEST_URGENT_BOUND_MS   (u32)((MSGTEST_BULK_SIZE + 1 + MSGTEST_DRAIN_BYTES - 1) / MSGTEST_DRAIN_BYTES + 1)
+#define MSGTEST_PROBES            (u32)(MSGTEST_URGENT_RUN_MS / MSGTEST_URGENT_PERIOD_MS + 1)
+#define MSGTEST_STUCK_MS          (u32)(3 * MSG_STATUS_WAITING_TIME) /* Time a message is held back by its driver */
+#define MSGTEST_EVENT_DONE        (u32)0x00000001      /* Event bit of the held back message */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* New variables (the board and main.c define them on the target; messaging.c refers to them) */
+volatile u32 G_u32SystemTime1ms;
+volatile u32 G_u32SystemTime1s;
+volatile u32 G_u32SystemFlags;
+volatile u32 G_u32ApplicationFlags;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "MsgTest_" and be declared as static.
+***********************************************************************************************************************/
+static MessageQueueType MsgTest_sQueue;                /* Queue the test messages go on (bCoalesce clear) */
+static bool MsgTest_bPass = TRUE;                      /* Cleared by any failed check */
+
+static const u8 MsgTest_au8Bulk[MSGTEST_BULK_SIZE];    /* Payload of the bulk messages (sent without a copy) */
+static u32 MsgTest_au32ProbeToken[MSGTEST_PROBES];     /* Token of each 1-byte message */
+static u32 MsgTest_au32ProbeTime[MSGTEST_PROBES];      /* Time each 1-byte message was queued */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestCheck
+
+Description:
+Reports one check of a case.
+
+Requires:
+  - pcCase_ names the case and pcCheck_ what was checked
+
+Promises:
+  - Prints the check with ok or FAIL; MsgTest_bPass is cleared on a failure
+*/
+static void MsgTestCheck(const char* pcCase_, const char* pcCheck_, bool bOk_)
+{
+  printf("msgtest: %-14s %-58s %s\n", pcCase_, pcCheck_, bOk_ ? "ok" : "FAIL");
+  if(!bOk_)
+  {
+    MsgTest_bPass = FALSE;
+  }
+
+} /* end MsgTestCheck() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestStart
+
+Description:
+Starts each case from a freshly initialized messaging task and an empty test queue.
+
+Requires:
+  -
+
+Promises:
+  - The pool and status table are empty and the next token is 1
+*/
+static void MsgTestStart(void)
+{
+  MessagingInitialize();
+  MsgTest_sQueue.psHead = NULL;
+  MsgTest_sQueue.psTail = NULL;
+  MsgTest_sQueue.psLastUrgent = NULL;
+  MsgTest_sQueue.bCoalesce = FALSE;
+  MsgTest_sQueue.bExpire = FALSE;
+
+} /* end MsgTestStart() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestSend
+
+Description:
+Queues a 1-byte message and dequeues it at once, as a driver that has loaded it would.  The status stays in the
+table.
+
+Requires:
+  - The test queue is empty
+
+Promises:
+  - Returns the token of the message, which is WAITING
+*/
+static u32 MsgTestSend(void)
+{
+  u8 u8Byte = 0x55;
+  u32 u32Token = QueueMessage(1, &u8Byte, &MsgTest_sQueue);
+
+  DeQueueMessage(&MsgTest_sQueue);
+  return(u32Token);
+
+} /* end MsgTestSend() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestSequence
+
+Description:
+A status reads back each state a driver posts, and a COMPLETE status is removed by the first read of it.
+
+Requires:
+  -
+
+Promises:
+  - The checks of the case are reported
+*/
+static void MsgTestSequence(void)
+{
+  u32 u32Token;
+
+  MsgTestStart();
+  u32Token = MsgTestSend();
+  MsgTestCheck("sequence", "first token is 1 and reads WAITING",
+               (u32Token == 1) && (QueryMessageStatus(u32Token) == WAITING));
+
+  UpdateMessageStatus(u32Token, SENDING);
+  MsgTestCheck("sequence", "reads SENDING after the update", QueryMessageStatus(u32Token) == SENDING);
+
+  UpdateMessageStatus(u32Token, COMPLETE);
+  MsgTestCheck("sequence", "reads COMPLETE after the update", QueryMessageStatus(u32Token) == COMPLETE);
+  MsgTestCheck("sequence", "reads NOT_FOUND once COMPLETE has been read", QueryMessageStatus(u32Token) == NOT_FOUND);
+  MsgTestCheck("sequence", "entry is empty again",
+               (Msg_StatusQueue[u32Token & STATUS_QUEUE_MASK].u32Token == 0) &&
+               (Msg_StatusQueue[u32Token & STATUS_QUEUE_MASK].eState == EMPTY));
+
+} /* end MsgTestSequence() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestOverwrite
+
+Description:
+A status survives STATUS_QUEUE_SIZE - 1 newer tokens and is overwritten by the next one.  From then on the entry
+belongs to the new token: the old token reads NOT_FOUND and updating it leaves the new status alone.
+
+Requires:
+  -
+
+Promises:
+  - The checks of the case are reported
+*/
+static void MsgTestOverwrite(void)
+{
+  u32 u32Old;
+  u32 u32New;
+
+  MsgTestStart();
+  u32Old = MsgTestSend();
+  UpdateMessageStatus(u32Old, SENDING);
+  for(u32 i = 0; i < STATUS_QUEUE_SIZE - 1; i++)
+  {
+    (void)MsgTestSend();
+  }
+  MsgTestCheck("overwrite", "status kept after 63 newer tokens", QueryMessageStatus(u32Old) == SENDING);
+
+  u32New = MsgTestSend();
+  MsgTestCheck("overwrite", "64th newer token shares the entry",
+               (u32New == u32Old + STATUS_QUEUE_SIZE) &&
+               ((u32New & STATUS_QUEUE_MASK) == (u32Old & STATUS_QUEUE_MASK)));
+  MsgTestCheck("overwrite", "old token reads NOT_FOUND", QueryMessageStatus(u32Old) == NOT_FOUND);
+
+  UpdateMessageStatus(u32Old, COMPLETE);
+  MsgTestCheck("generation", "updating the old token leaves the new one WAITING",
+               QueryMessageStatus(u32New) == WAITING);
+
+  UpdateMessageStatus(u32New, COMPLETE);
+  (void)QueryMessageStatus(u32Old);
+  MsgTestCheck("generation", "reading the old token does not remove the new one",
+               QueryMessageStatus(u32New) == COMPLETE);
+
+  /* A token 64 ahead of any issued yet maps to a live entry but is not in the table */
+  MsgTestCheck("generation", "a token not issued yet reads NOT_FOUND",
+               QueryMessageStatus(u32New + STATUS_QUEUE_SIZE - 1) == NOT_FOUND);
+
+} /* end MsgTestOverwrite() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestTokenZero
+
+Description:
+Token 0 marks an empty entry, so it is never issued and never matches one.
+
+Requires:
+  -
+
+Promises:
+  - The checks of the case are reported
+*/
+static void MsgTestTokenZero(void)
+{
+  u32 u32Token;
+  bool bEmpty = TRUE;
+
+  MsgTestStart();
+  MsgTestCheck("token 0", "reads NOT_FOUND from an empty table", QueryMessageStatus(0) == NOT_FOUND);
+
+  UpdateMessageStatus(0, COMPLETE);
+  for(u32 i = 0; i < STATUS_QUEUE_SIZE; i++)
+  {
+    bEmpty = bEmpty && (Msg_StatusQueue[i].u32Token == 0) && (Msg_StatusQueue[i].eState == EMPTY);
+  }
+  MsgTestCheck("token 0", "updating it leaves every empty entry EMPTY", bEmpty);
+
+  /* The token counter rolls over to 1, not 0 */
+  Msg_u32Token = (u32)0 - 1;
+  u32Token = MsgTestSend();
+  MsgTestCheck("token 0", "last token before the rollover reads WAITING",
+               (u32Token == (u32)0 - 1) && (QueryMessageStatus(u32Token) == WAITING));
+  u32Token = MsgTestSend();
+  MsgTestCheck("token 0", "token after the rollover is 1", u32Token == 1);
+  MsgTestCheck("token 0", "still reads NOT_FOUND after the rollover", QueryMessageStatus(0) == NOT_FOUND);
+
+} /* end MsgTestTokenZero() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestFullTable
+
+Description:
+With every entry holding a live status, tokens that are not in the table are queried and updated.  The search this
+replaced compared Msg_StatusQueue[STATUS_QUEUE_SIZE] before testing for the end; AddressSanitizer stops the test if
+any read falls outside the table.
+
+Requires:
+  -
+
+Promises:
+  - The checks of the case are reported
+*/
+static void MsgTestFullTable(void)
+{
+  u32 u32First;
+  u32 u32Last = 0;
+  bool bOk = TRUE;
+
+  MsgTestStart();
+  u32First = MsgTestSend();
+  for(u32 i = 1; i < STATUS_QUEUE_SIZE; i++)
+  {
+    u32Last = MsgTestSend();
+  }
+
+  for(u32 i = 0; i < 4 * STATUS_QUEUE_SIZE; i++)
+  {
+    bOk = bOk && (QueryMessageStatus(u32Last + 1 + i) == NOT_FOUND);
+    UpdateMessageStatus(u32Last + 1 + i, COMPLETE);
+  }
+  MsgTestCheck("full table", "absent tokens read NOT_FOUND", bOk);
+
+  for(u32 u32Token = u32First; u32Token <= u32Last; u32Token++)
+  {
+    bOk = bOk && (QueryMessageStatus(u32Token) == WAITING);
+  }
+  MsgTestCheck("full table", "every live status is still WAITING", bOk);
+
+} /* end MsgTestFullTable() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestStuck
+
+Description:
+A driver holds a message back for MSGTEST_STUCK_MS on a queue without bExpire while the messaging task runs every ms.
+The message is still on the queue, so it must stay WAITING with its event unset until the driver sends it.
+
+Requires:
+  -
+
+Promises:
+  - The checks of the case are reported
+*/
+static void MsgTestStuck(void)
+{
+  volatile u32 u32Events = 0;
+  u8 u8Byte = 0x55;
+  u32 u32Token;
+  u32 u32Slow = MsgTest_sQueue.sStats.au32Latency[MSG_LATENCY_BUCKETS - 1];
+
+  MsgTestStart();
+  G_u32SystemTime1ms = 0;
+  u32Token = QueueMessage(1, &u8Byte, &MsgTest_sQueue);
+  (void)SetMessageEvent(u32Token, &u32Events, MSGTEST_EVENT_DONE);
+
+  for(u32 i = 0; i < MSGTEST_STUCK_MS; i++)
+  {
+    G_u32SystemTime1ms++;
+    MessagingIdle();
+  }
+  MsgTestCheck("stuck", "still WAITING and queued, event not set",
+               (QueryMessageStatus(u32Token) == WAITING) && (MsgTest_sQueue.psHead != NULL) && (u32Events == 0));
+
+  MsgTest_sQueue.psHead->bStarted = TRUE;
+  UpdateMessageStatus(u32Token, SENDING);
+  UpdateMessageStatus(u32Token, COMPLETE);
+  DeQueueMessage(&MsgTest_sQueue);
+  MsgTestCheck("stuck", "COMPLETE once sent, event set and latency counted",
+               (u32Events == MSGTEST_EVENT_DONE) &&
+               (MsgTest_sQueue.sStats.au32Latency[MSG_LATENCY_BUCKETS - 1] == u32Slow + 1) &&
+               (QueryMessageStatus(u32Token) == COMPLETE));
+
+} /* end MsgTestStuck() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestDrain
+
+Description:
+Sends MSGTEST_DRAIN_BYTES from the head of the test queue as a driver does: a message is started (and can no longer
+be overtaken), sent, posted COMPLETE and dequeued.
+
+Requires:
+  - *pu32Left_ is the number of bytes of the head message not sent yet, if it is started
+
+Promises:
+  - Up to MSGTEST_DRAIN_BYTES bytes are sent; *pu32Left_ is updated
+  - Returns the token of the message completed, or 0 (at most one message has room to complete per call)
+*/
+static u32 MsgTestDrain(u32* pu32Left_)
+{
+  MessageType* psHead = MsgTest_sQueue.psHead;
+  u32 u32Budget = MSGTEST_DRAIN_BYTES;
+  u32 u32Token = 0;
+
+  while( (u32Budget != 0) && (psHead != NULL) && (u32Token == 0) )
+  {
+    if(!psHead->bStarted)
+    {
+      psHead->bStarted = TRUE;
+      UpdateMessageStatus(psHead->u32Token, SENDING);
+      *pu32Left_ = psHead->u32Size;
+    }
+
+    if(*pu32Left_ > u32Budget)
+    {
+      *pu32Left_ -= u32Budget;
+      u32Budget = 0;
+    }
+    else
+    {
+      u32Budget -= *pu32Left_;
+      *pu32Left_ = 0;
+      u32Token = psHead->u32Token;
+      UpdateMessageStatus(u32Token, COMPLETE);
+      DeQueueMessage(&MsgTest_sQueue);
+      psHead = MsgTest_sQueue.psHead;
+    }
+  }
+
+  return(u32Token);
+
+} /* end MsgTestDrain() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestLatency
+
+Description:
+Keeps the bulk backlog queued for MSGTEST_URGENT_RUN_MS while the queue drains, queues a 1-byte message of
+ePriority_ every MSGTEST_URGENT_PERIOD_MS and measures each one from queued to COMPLETE.
+
+Requires:
+  -
+
+Promises:
+  - *pu32Worst_ and *pu32Mean_ are the worst and mean latency in ms of the 1-byte messages
+  - Returns TRUE if no write was refused and the bulk and the 1-byte messages each completed in order
+*/
+static bool MsgTestLatency(MessagePriorityType ePriority_, u32* pu32Worst_, u32* pu32Mean_)
+{
+  u8 u8Byte = 0x55;
+  u32 u32Left = 0;
+  u32 u32Waiting = 0;
+  u32 u32Probes = 0;
+  u32 u32Done = 0;
+  u32 u32LastBulk = 0;
+  u32 u32Token;
+  u32 u32Latency;
+  u64 u64Sum = 0;
+  bool bOk = TRUE;
+
+  MsgTestStart();
+  G_u32SystemTime1ms = 0;
+  *pu32Worst_ = 0;
+
+  /* The queue drains in well under a second after the load stops; a 1-byte message lost out of turn ends the run */
+  while( bOk && (G_u32SystemTime1ms < 2 * MSGTEST_URGENT_RUN_MS) &&
+         ((G_u32SystemTime1ms < MSGTEST_URGENT_RUN_MS) || (u32Done < u32Probes)) )
+  {
+    while( (G_u32SystemTime1ms < MSGTEST_URGENT_RUN_MS) && (u32Waiting < MSGTEST_BULK_BACKLOG) )
+    {
+      bOk = bOk && (QueueMessageNoCopy(MSGTEST_BULK_SIZE, MsgTest_au8Bulk, NULL, &MsgTest_sQueue) != 0);
+      u32Waiting++;
+    }
+
+    if( (G_u32SystemTime1ms < MSGTEST_URGENT_RUN_MS) && ((G_u32SystemTime1ms % MSGTEST_URGENT_PERIOD_MS) == 0) )
+    {
+      MsgTest_au32ProbeToken[u32Probes] = QueueMessagePriority(1, &u8Byte, ePriority_, &MsgTest_sQueue);
+      MsgTest_au32ProbeTime[u32Probes] = G_u32SystemTime1ms;
+      bOk = bOk && (MsgTest_au32ProbeToken[u32Probes] != 0);
+      u32Probes++;
+    }
+
+    G_u32SystemTime1ms++;
+    u32Token = MsgTestDrain(&u32Left);
+    if( (u32Done < u32Probes) && (u32Token == MsgTest_au32ProbeToken[u32Done]) )
+    {
+      u32Latency = G_u32SystemTime1ms - MsgTest_au32ProbeTime[u32Done];
+      u64Sum += u32Latency;
+      if(u32Latency > *pu32Worst_)
+      {
+        *pu32Worst_ = u32Latency;
+      }
+      u32Done++;
+    }
+    else if(u32Token != 0)
+    {
+      /* Bulk messages complete in token order (a 1-byte message out of turn is never counted as done) */
+      bOk = bOk && (u32Token > u32LastBulk);
+      u32LastBulk = u32Token;
+      u32Waiting--;
+    }
+  }
+
+  *pu32Mean_ = (u32Done != 0) ? (u32)(u64Sum / u32Done) : 0;
+  return( (bool)(bOk && (u32Done == u32Probes)) );
+
+} /* end MsgTestLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: MsgTestUrgent
+
+Description:
+Measures the 1-byte messages under the bulk backlog as bulk (plain FIFO) and as urgent.
+
+Requires:
+  -
+
+Promises:
+  - The checks of the case are reported
+*/
+static void MsgTestUrgent(void)
+{
+  char acCheck[80];
+  u32 u32Worst;
+  u32 u32Mean;
+  bool bOk;
+
+  bOk = MsgTestLatency(MSG_PRIORITY_BULK, &u32Worst, &u32Mean);
+  snprintf(acCheck, sizeof(acCheck), "as bulk: worst %lu ms, mean %lu ms, in order", u32Worst, u32Mean);
+  MsgTestCheck("priority", acCheck, bOk);
+
+  bOk = MsgTestLatency(MSG_PRIORITY_URGENT, &u32Worst, &u32Mean);
+  snprintf(acCheck, sizeof(acCheck), "as urgent: worst %lu ms (bound %lu ms), mean %lu ms, in order", u32Worst,
+           MSGTEST_URGENT_BOUND_MS, u32Mean);
+  MsgTestCheck("priority", acCheck, bOk && (u32Worst <= MSGTEST_URGENT_BOUND_MS));
+
+} /* end MsgTestUrgent() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs every case.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every check passed
+*/
+int main(void)
+{
+  MsgTestSequence();
+  MsgTestOverwrite();
+  MsgTestTokenZero();
+  MsgTestFullTable();
+  MsgTestStuck();
+  MsgTestUrgent();
+
+  return(MsgTest_bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
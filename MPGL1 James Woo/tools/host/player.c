@@ -0,0 +1,363 @@
+/**********************************************************************************************************************
+File: player.c
+
+Description:
+Offline renderer of the music player.  A song is played through the register model (sam3u_model.c) exactly as on the
+board, and every buzzer change is written as CSV:
+
+  time_us,channel,period,duty,enabled
+
+time_us is the model time of the change, channel is the PWM channel (voice), period and duty are PWMC_CPRDR and
+PWMC_CDTYR in CPRE_CLCK cycles, and enabled is the channel bit of PWMC_SR.  The CSV only depends on the firmware, so it
+is diffed against the files in expected/ by "make check" to catch any change of pitch or timing.  Optionally the
+buzzers are rendered as square waves into a 16-bit mono WAV file to listen to.
+
+The host time spent in the sequencer interrupt and in the music state machine is reported per note started, as a
+relative measure of the player's CPU cost (it is host time, not Cortex-M3 cycles, and varies from run to run).
+
+Usage: player [-s song] [-t tempo step] [-x semitones] [-l latency ticks] [-o csv file] [-w wav file]
+  -s  mary (default) or elise
+  -t  tempo step 0 - 10 (default MUSIC_TEMPO_DEFAULT)
+  -x  transpose in semitones (default 0)
+  -l  largest random handler latency in TC0 ticks (default 0)
+  -o  CSV output file (default stdout)
+  -w  WAV output file (default none)
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../application/music.c"
+#include "../../application/songs.c"
+
+#include <stdio.h>
+#include <unistd.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define PLAYER_TIMEOUT_MS         (u32)600000          /* Longest song rendered */
+#define PLAYER_WAV_RATE           (u32)44100           /* WAV samples per second */
+#define PLAYER_WAV_LEVEL          (double)8000.0       /* Sample amplitude of one buzzer */
+#define PLAYER_PWM_CLOCK          (double)(CPRE_CLCK)  /* PWM channel clock in Hz */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Player_" and be declared as static.
+***********************************************************************************************************************/
+static FILE* Player_pCsv;                              /* CSV output */
+static ModelPwmEventType* Player_pasEvents;            /* Every buzzer change, for the WAV */
+static u32 Player_u32Events;                           /* Changes in Player_pasEvents */
+static u32 Player_u32EventsSize;                       /* Space in Player_pasEvents */
+static u32 Player_u32MaxLatency;                       /* Largest handler latency */
+static u32 Player_u32Seed = 1;                         /* Latency generator state */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: PlayerLatency
+
+Description:
+Random handler latency, uniform from 0 to -l ticks, repeatable from a fixed seed.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 - Player_u32MaxLatency ticks
+*/
+static u32 PlayerLatency(void)
+{
+  Player_u32Seed = (Player_u32Seed * 1103515245UL) + 12345UL;
+  return( ((Player_u32Seed >> 16) & 0x7FFF) % (Player_u32MaxLatency + 1) );
+
+} /* end PlayerLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: PlayerPwmLog
+
+Description:
+Writes one buzzer change to the CSV and keeps it for the WAV.
+
+Requires:
+  - Player_pCsv is open
+
+Promises:
+  - One CSV line is written and the change is appended to Player_pasEvents
+*/
+static void PlayerPwmLog(const ModelPwmEventType* psEvent_)
+{
+  fprintf(Player_pCsv, "%llu.%03llu,%u,%u,%u,%u\n", psEvent_->u64TimeNs / 1000, psEvent_->u64TimeNs % 1000,
+          psEvent_->u8Channel, psEvent_->u16Period, psEvent_->u16Duty, psEvent_->bEnabled);
+
+  if(Player_u32Events == Player_u32EventsSize)
+  {
+    Player_u32EventsSize = (Player_u32EventsSize == 0) ? 1024 : (Player_u32EventsSize * 2);
+    Player_pasEvents = realloc(Player_pasEvents, Player_u32EventsSize * sizeof(ModelPwmEventType));
+    if(Player_pasEvents == NULL)
+    {
+      fprintf(stderr, "player: out of memory\n");
+      exit(1);
+    }
+  }
+
+  Player_pasEvents[Player_u32Events++] = *psEvent_;
+
+} /* end PlayerPwmLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: PlayerLoop
+
+Description:
+Main loop pass of the renderer: only the music state machine runs.
+
+Requires:
+  -
+
+Promises:
+  - G_MusicStateMachine() has run once
+*/
+static void PlayerLoop(void)
+{
+  G_MusicStateMachine();
+
+} /* end PlayerLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: PlayerWriteU32
+
+Description:
+Writes a little-endian value of 1 to 4 bytes.
+
+Requires:
+  - pFile_ is open for writing
+
+Promises:
+  - u8Bytes_ bytes of u32Value_ are written, lowest first
+*/
+static void PlayerWriteU32(FILE* pFile_, u32 u32Value_, u8 u8Bytes_)
+{
+  for(u8 i = 0; i < u8Bytes_; i++)
+  {
+    fputc((int)((u32Value_ >> (8 * i)) & 0xFF), pFile_);
+  }
+
+} /* end PlayerWriteU32() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: PlayerWriteWav
+
+Description:
+Renders the recorded buzzer changes as square waves into a 16-bit mono WAV file.  Each enabled channel is a pulse wave
+at CPRE_CLCK / period, high for duty / period of each cycle; the channels are added.
+
+Requires:
+  - Player_pasEvents holds the changes in time order
+
+Promises:
+  - Returns TRUE if pcFile_ was written
+*/
+static bool PlayerWriteWav(const char* pcFile_)
+{
+  FILE* pFile = fopen(pcFile_, "wb");
+  ModelPwmEventType asState[MODEL_PWM_CHANNELS];
+  double adPhase[MODEL_PWM_CHANNELS] = {0.0, 0.0};
+  double dSample;
+  u64 u64EndNs;
+  u64 u64TimeNs;
+  u32 u32Samples;
+  u32 u32Next = 0;
+  s16 s16Sample;
+
+  if(pFile == NULL)
+  {
+    return(FALSE);
+  }
+
+  memset(asState, 0, sizeof(asState));
+  u64EndNs = (Player_u32Events != 0) ? Player_pasEvents[Player_u32Events - 1].u64TimeNs : 0;
+  u32Samples = (u32)((u64EndNs * PLAYER_WAV_RATE) / 1000000000ULL) + 1;
+
+  /* RIFF header for PCM, 1 channel, 16 bits */
+  fputs("RIFF", pFile);
+  PlayerWriteU32(pFile, 36 + (u32Samples * 2), 4);
+  fputs("WAVEfmt ", pFile);
+  PlayerWriteU32(pFile, 16, 4);
+  PlayerWriteU32(pFile, 1, 2);
+  PlayerWriteU32(pFile, 1, 2);
+  PlayerWriteU32(pFile, PLAYER_WAV_RATE, 4);
+  PlayerWriteU32(pFile, PLAYER_WAV_RATE * 2, 4);
+  PlayerWriteU32(pFile, 2, 2);
+  PlayerWriteU32(pFile, 16, 2);
+  fputs("data", pFile);
+  PlayerWriteU32(pFile, u32Samples * 2, 4);
+
+  for(u32 i = 0; i < u32Samples; i++)
+  {
+    u64TimeNs = ((u64)i * 1000000000ULL) / PLAYER_WAV_RATE;
+    while( (u32Next < Player_u32Events) && (Player_pasEvents[u32Next].u64TimeNs <= u64TimeNs) )
+    {
+      asState[Player_pasEvents[u32Next].u8Channel] = Player_pasEvents[u32Next];
+      u32Next++;
+    }
+
+    dSample = 0.0;
+    for(u8 j = 0; j < MODEL_PWM_CHANNELS; j++)
+    {
+      if(asState[j].bEnabled && (asState[j].u16Period != 0))
+      {
+        adPhase[j] += (PLAYER_PWM_CLOCK / asState[j].u16Period) / PLAYER_WAV_RATE;
+        adPhase[j] -= (double)(u32)adPhase[j];
+        dSample += (adPhase[j] < ((double)asState[j].u16Duty / asState[j].u16Period)) ?
+                   PLAYER_WAV_LEVEL : -PLAYER_WAV_LEVEL;
+      }
+    }
+
+    s16Sample = (s16)dSample;
+    PlayerWriteU32(pFile, (u16)s16Sample, 2);
+  }
+
+  fclose(pFile);
+  return(TRUE);
+
+} /* end PlayerWriteWav() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Renders one song.
+
+Requires:
+  -
+
+Promises:
+  - Writes the CSV (and WAV) and prints the song length and cost per note to stderr
+  - Returns 0, or 1 on a bad option, an output error or a song that did not finish
+*/
+int main(int argc, char* argv[])
+{
+  const SongType* psSong = &G_sSongMaryHadALittleLamb;
+  const char* pcWav = NULL;
+  ModelStatsType sStats;
+  u8 u8Tempo = MUSIC_TEMPO_DEFAULT;
+  s8 s8Transpose = 0;
+  u32 u32Notes;
+  u32 u32Ms = 0;
+  int iOption;
+
+  Player_pCsv = stdout;
+  while( (iOption = getopt(argc, argv, "s:t:x:l:o:w:")) != -1 )
+  {
+    switch(iOption)
+    {
+      case 's':
+        if(strcmp(optarg, "mary") == 0)
+        {
+          psSong = &G_sSongMaryHadALittleLamb;
+        }
+        else if(strcmp(optarg, "elise") == 0)
+        {
+          psSong = &G_sSongFurElise;
+        }
+        else
+        {
+          fprintf(stderr, "player: unknown song %s\n", optarg);
+          return(1);
+        }
+        break;
+
+      case 't':
+        u8Tempo = (u8)atoi(optarg);
+        break;
+
+      case 'x':
+        s8Transpose = (s8)atoi(optarg);
+        break;
+
+      case 'l':
+        Player_u32MaxLatency = (u32)atoi(optarg);
+        break;
+
+      case 'o':
+        Player_pCsv = fopen(optarg, "w");
+        if(Player_pCsv == NULL)
+        {
+          fprintf(stderr, "player: cannot write %s\n", optarg);
+          return(1);
+        }
+        break;
+
+      case 'w':
+        pcWav = optarg;
+        break;
+
+      default:
+        fprintf(stderr, "usage: player [-s mary|elise] [-t tempo] [-x semitones] [-l ticks] [-o csv] [-w wav]\n");
+        return(1);
+    }
+  }
+
+  if(!ModelInitialize())
+  {
+    fprintf(stderr, "player: cannot map the peripheral space\n");
+    return(1);
+  }
+
+  fprintf(Player_pCsv, "time_us,channel,period,duty,enabled\n");
+  ModelSetPwmLog(PlayerPwmLog);
+  ModelSetLatency(PlayerLatency);
+
+  PWMSetupAudio();
+  MusicInitialize();
+  if( !MusicSetTempo(u8Tempo) || !MusicSetTranspose(s8Transpose) )
+  {
+    fprintf(stderr, "player: tempo or transpose out of range\n");
+    return(1);
+  }
+
+  MusicStart(psSong);
+  while( (G_u32MusicFlags & _MUSIC_PLAYING) && (u32Ms++ < PLAYER_TIMEOUT_MS) )
+  {
+    ModelRun(1, PlayerLoop);
+  }
+
+  if(G_u32MusicFlags & _MUSIC_PLAYING)
+  {
+    fprintf(stderr, "player: the song did not end within %lu ms\n", PLAYER_TIMEOUT_MS);
+    return(1);
+  }
+
+  if(Player_pCsv != stdout)
+  {
+    fclose(Player_pCsv);
+  }
+
+  if( (pcWav != NULL) && !PlayerWriteWav(pcWav) )
+  {
+    fprintf(stderr, "player: cannot write %s\n", pcWav);
+    return(1);
+  }
+
+  ModelGetStats(&sStats);
+  u32Notes = Music_asVoices[0].u16NotesStarted + Music_asVoices[1].u16NotesStarted;
+  fprintf(stderr, "player: %lu ms, %lu notes, %lu interrupts, %.0f ns interrupt + %.0f ns loop per note (host)\n",
+          u32Ms, u32Notes, sStats.u32IsrCalls, (u32Notes != 0) ? ((double)sStats.u64IsrTime / u32Notes) : 0.0,
+          (u32Notes != 0) ? ((double)sStats.u64LoopTime / u32Notes) : 0.0);
+
+  return(0);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,285 @@
+/**********************************************************************************************************************
+File: ringstress.c
+
+Description:
+Two-thread stress test of the RingBuffer functions in utilities.c, which pass bytes from the state machines to the
+transmit ISRs of the TWI and SSP drivers.  A producer thread (the main loop) writes a numbered byte pattern in
+random-sized chunks while a consumer thread (the ISR) reads it back in other random-sized chunks, both running flat
+out on separate cores.  The test fails if:
+- RingBufferInitialize() accepts a size that is not a power of two;
+- the consumer reads a byte that is not the next one in the pattern (lost, repeated or torn);
+- the producer sees more bytes used than the ring holds, or bytes are left in the ring at the end.
+
+The free-running indices start RINGSTRESS_WRAP_START bytes below the wrap of u32, so they overflow during every run
+whatever the width of u32 on the host.
+
+Usage: ringstress [bytes]
+Returns 0 if every ring size passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+#include "configuration.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define RINGSTRESS_BYTES          (u32)20000000        /* Default bytes passed through each ring size */
+#define RINGSTRESS_MAX_CHUNK      (u32)16              /* Largest write or read */
+#define RINGSTRESS_WRAP_START     (u32)4096            /* Indices start this far below the wrap */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* New variables (the board and main.c define them on the target; utilities.c refers to them) */
+volatile u32 G_u32SystemTime1ms;
+volatile u32 G_u32SystemTime1s;
+volatile u32 G_u32SystemFlags;
+volatile u32 G_u32ApplicationFlags;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "RingStress_" and be declared as static.
+***********************************************************************************************************************/
+static RingBufferType RingStress_sRing;                /* Ring under test */
+static u8 RingStress_au8Buffer[64];                    /* Storage for the largest ring size */
+static u32 RingStress_u32Size;                         /* Size of the ring under test */
+static u32 RingStress_u32Bytes;                        /* Bytes to pass through each ring size */
+static volatile bool RingStress_bFail;                 /* Set by either thread on a failure */
+static u32 RingStress_u32EmptyReads;                   /* Reads that found the ring empty */
+static u32 RingStress_u32FullWrites;                   /* Writes that found the ring full */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RingStressPattern
+
+Description:
+The byte at a position in the stream.  The position shifted down is added so a stream that slips by a multiple of
+256 bytes is still caught.
+
+Requires:
+  -
+
+Promises:
+  - Returns the byte at position u32Index_
+*/
+static u8 RingStressPattern(u32 u32Index_)
+{
+  return( (u8)(u32Index_ * 131 + (u32Index_ >> 9)) );
+
+} /* end RingStressPattern() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RingStressRandom
+
+Description:
+Linear congruential generator, kept per thread.
+
+Requires:
+  -
+
+Promises:
+  - *pu32Seed_ is advanced; returns a number from 1 to RINGSTRESS_MAX_CHUNK
+*/
+static u32 RingStressRandom(u32* pu32Seed_)
+{
+  *pu32Seed_ = (u32)(*pu32Seed_ * 1103515245 + 12345);
+  return( 1 + ((*pu32Seed_ >> 16) & 0x7FFF) % RINGSTRESS_MAX_CHUNK );
+
+} /* end RingStressRandom() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RingStressProducer
+
+Description:
+Producer thread: writes the pattern in random-sized chunks, as the state machine loads a message.
+
+Requires:
+  - The ring is initialized and empty
+
+Promises:
+  - RingStress_u32Bytes bytes of the pattern have been written, or RingStress_bFail is set
+*/
+static void* RingStressProducer(void* pvArg_)
+{
+  u8 au8Chunk[RINGSTRESS_MAX_CHUNK];
+  u32 u32Seed = 1;
+  u32 u32Written = 0;
+  u32 u32Size;
+  u32 u32Count;
+
+  (void)pvArg_;
+  while( (u32Written < RingStress_u32Bytes) && !RingStress_bFail )
+  {
+    u32Size = RingStressRandom(&u32Seed);
+    if(u32Size > RingStress_u32Bytes - u32Written)
+    {
+      u32Size = RingStress_u32Bytes - u32Written;
+    }
+
+    for(u32 i = 0; i < u32Size; i++)
+    {
+      au8Chunk[i] = RingStressPattern(u32Written + i);
+    }
+
+    u32Count = RingBufferWrite(&RingStress_sRing, au8Chunk, u32Size);
+    if(RingBufferUsed(&RingStress_sRing) > RingStress_u32Size)
+    {
+      printf("ringstress: FAIL - size %lu: %lu bytes used\n", RingStress_u32Size, RingBufferUsed(&RingStress_sRing));
+      RingStress_bFail = TRUE;
+    }
+
+    u32Written += u32Count;
+    if(u32Count == 0)
+    {
+      RingStress_u32FullWrites++;
+      sched_yield();
+    }
+  }
+
+  return(NULL);
+
+} /* end RingStressProducer() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RingStressConsumer
+
+Description:
+Consumer thread: reads random-sized chunks and checks them against the pattern, as the ISR empties the ring.
+
+Requires:
+  - The ring is initialized and empty
+
+Promises:
+  - RingStress_u32Bytes bytes have been read and matched the pattern, or RingStress_bFail is set
+*/
+static void* RingStressConsumer(void* pvArg_)
+{
+  u8 au8Chunk[RINGSTRESS_MAX_CHUNK];
+  u32 u32Seed = 7;
+  u32 u32Read = 0;
+  u32 u32Count;
+
+  (void)pvArg_;
+  while( (u32Read < RingStress_u32Bytes) && !RingStress_bFail )
+  {
+    u32Count = RingBufferRead(&RingStress_sRing, au8Chunk, RingStressRandom(&u32Seed));
+    for(u32 i = 0; i < u32Count; i++)
+    {
+      if(au8Chunk[i] != RingStressPattern(u32Read + i))
+      {
+        printf("ringstress: FAIL - size %lu: byte %lu is 0x%02X, not 0x%02X\n", RingStress_u32Size, u32Read + i,
+               au8Chunk[i], RingStressPattern(u32Read + i));
+        RingStress_bFail = TRUE;
+        return(NULL);
+      }
+    }
+
+    u32Read += u32Count;
+    if(u32Count == 0)
+    {
+      RingStress_u32EmptyReads++;
+      sched_yield();
+    }
+  }
+
+  return(NULL);
+
+} /* end RingStressConsumer() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: RingStressRun
+
+Description:
+Passes RingStress_u32Bytes through a ring of one size with a producer and a consumer thread.
+
+Requires:
+  - u32Size_ is a power of two no larger than RingStress_au8Buffer
+
+Promises:
+  - Returns TRUE if every byte arrived in order and the ring ended empty
+*/
+static bool RingStressRun(u32 u32Size_)
+{
+  pthread_t sProducer;
+  pthread_t sConsumer;
+
+  RingStress_u32Size = u32Size_;
+  RingStress_u32EmptyReads = 0;
+  RingStress_u32FullWrites = 0;
+  RingBufferInitialize(&RingStress_sRing, RingStress_au8Buffer, u32Size_);
+  RingStress_sRing.u32Head = (u32)0 - RINGSTRESS_WRAP_START;
+  RingStress_sRing.u32Tail = RingStress_sRing.u32Head;
+
+  pthread_create(&sProducer, NULL, RingStressProducer, NULL);
+  pthread_create(&sConsumer, NULL, RingStressConsumer, NULL);
+  pthread_join(sProducer, NULL);
+  pthread_join(sConsumer, NULL);
+
+  if(!RingStress_bFail && (RingBufferUsed(&RingStress_sRing) != 0))
+  {
+    printf("ringstress: FAIL - size %lu: %lu bytes left in the ring\n", u32Size_, RingBufferUsed(&RingStress_sRing));
+    RingStress_bFail = TRUE;
+  }
+
+  printf("ringstress: size %2lu: %lu bytes, %lu full writes, %lu empty reads  %s\n", u32Size_, RingStress_u32Bytes,
+         RingStress_u32FullWrites, RingStress_u32EmptyReads, RingStress_bFail ? "FAIL" : "ok");
+
+  return( (bool)!RingStress_bFail );
+
+} /* end RingStressRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Checks the size checks of RingBufferInitialize(), then runs the stress test on rings of 1, 8 and 64 bytes.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every check passed
+*/
+int main(int argc, char* argv[])
+{
+  static const u32 au32Sizes[] = {1, 8, 64};
+  bool bPass = TRUE;
+
+  RingStress_u32Bytes = (argc > 1) ? strtoul(argv[1], NULL, 0) : RINGSTRESS_BYTES;
+
+  if(RingBufferInitialize(&RingStress_sRing, RingStress_au8Buffer, 0) ||
+     RingBufferInitialize(&RingStress_sRing, RingStress_au8Buffer, 48))
+  {
+    printf("ringstress: FAIL - a size that is not a power of two was accepted\n");
+    bPass = FALSE;
+  }
+
+  for(u32 i = 0; bPass && (i < sizeof(au32Sizes) / sizeof(au32Sizes[0])); i++)
+  {
+    bPass = RingStressRun(au32Sizes[i]);
+  }
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
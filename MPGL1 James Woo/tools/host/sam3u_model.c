@@ -0,0 +1,1160 @@
+/**********************************************************************************************************************
+File: sam3u_model.c
+
+Description:
+Host model of the SAM3U for the music player tests.  The peripheral space (0x40000000 - 0x400FFFFF) and the Cortex-M3
+system control space (0xE000E000) are mapped as memory at their real addresses, so the firmware accesses its
+registers through the AT91C_BASE_* pointers unchanged.  The host build must link with -no-pie so nothing else is
+placed there.
+
+Most registers behave as plain memory.  The pages of the registers with side effects (TC0, TWI0, USART0 and the PWM
+controller) are mapped read-only for the firmware: each write faults, is single-stepped with the page writable, and is
+then applied like the hardware does (TC_CCR, TC_IER/TC_IDR, TWI_IER/TWI_IDR, US_CR, US_IER/US_IDR, US_THR, US_PTCR
+and the PDC counters, PWMC_ENA/PWMC_DIS), so several enables
+written in one handler all take effect.  The model itself reaches the registers through a second, writable mapping
+of the same memory.  Single-stepping uses the x86 trap flag, so the model runs on x86 Linux hosts only.
+
+Model time advances in TC0 ticks (MCK / 128, TC_SEQUENCER_TICKS_PER_MS per ms):
+- TC0 counts up to RC in waveform mode.  When it reaches RC it restarts from 0 and sets CPCS, and TC0_IrqHandler()
+  is called after the latency returned by the ModelSetLatency() callback (0 by default).  TC_SR is cleared when the
+  handler returns, as the hardware does when the handler reads it.  The 16-bit counter wraps if RC is written below
+  the count.
+- Every TC_SEQUENCER_TICKS_PER_MS ticks the system tick advances G_u32SystemTime1ms and G_u32SystemTime1s and the
+  main loop pass given to ModelRun() is called.
+- TWI0 is an idle bus that acknowledges every byte at once: TWI_SR always shows TXRDY and TXCOMP, and
+  TWI0_IrqHandler() is called every tick while an enabled interrupt is set in TWI_SR.
+- USART0 transmits 8-N-1 characters at the rate set in US_BRGR (MCK / (16 * (CD + FP / 8))).  THR and the shift
+  register are modelled, with the transmit PDC (TPR/TCR, then TNPR/TNCR) feeding THR, so characters follow each other
+  without a gap while data is loaded.  US_CSR shows TXRDY, TXEMPTY, ENDTX and TXBUFE, each character is reported to the
+  ModelSetUartLog() callback when its stop bit ends, and USART0_IrqHandler() is called every tick while an enabled
+  interrupt is set in US_CSR (each call is counted), after the latency returned by the ModelSetUartLatency() callback
+  (0 by default).  PDC addresses are 32 bits, so the data must be in the low 4 GB (static data of the -no-pie build,
+  not the host stack).
+- USART0 receives the characters queued with ModelUartReceive(), each at the end of its stop bit.  The receive PDC
+  (RPR/RCR, then RNPR/RNCR) takes each one from RHR; with no PDC buffer left it waits in RHR (RXRDY) and the next one
+  sets OVRE.  ENDRX is set when RCR reaches 0 and cleared by writing RCR or RNCR, RXBUFF shows both counters at 0, and
+  the receiver time-out (US_RTOR bit periods after the last character) sets TIMEOUT once started by STTTO and the
+  next character.  RSTSTA clears OVRE.  RHR reads are not seen, so RXRDY is only cleared by the PDC.
+- The buzzer channel state (PWMC_SR bit, CPRDR and CDTYR) is checked after every handler call and loop pass
+  (ModelSync()) and each change is reported to the ModelSetPwmLog() callback.
+
+The NVIC is plain memory: the handlers only run between main loop passes, never inside one.  The host time spent in
+TC0_IrqHandler() and in the main loop passes is measured with the monotonic clock, less the average cost of the
+trapped writes made in it (calibrated once), since a trap costs far more than the code around it.
+**********************************************************************************************************************/
+
+#define _GNU_SOURCE
+#include <signal.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "configuration.h"
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile u32 G_u32SystemTime1ms;                /* From board-specific source file */
+extern volatile u32 G_u32SystemTime1s;                 /* From board-specific source file */
+
+/* Handlers of the firmware under test (from music.c, sam3u_i2c.c and sam3u_uart.c); the model runs without them for
+other tests */
+__weak void TC0_IrqHandler(void);
+__weak void TWI0_IrqHandler(void);
+__weak void USART0_IrqHandler(void);
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Model_" and be declared as static.
+***********************************************************************************************************************/
+#if !defined(__x86_64__) && !defined(__i386__)
+#error "sam3u_model.c single-steps register writes with the x86 trap flag"
+#endif
+
+#define MODEL_PERIPHERAL_BASE     (uintptr_t)0x40000000  /* Peripheral space */
+#define MODEL_PERIPHERAL_SIZE     (size_t)0x00100000
+#define MODEL_SCS_BASE            (uintptr_t)0xE000E000  /* System control space (NVIC) */
+#define MODEL_SCS_SIZE            (size_t)0x00001000
+#define MODEL_PAGE_SIZE           (uintptr_t)0x00001000
+#define MODEL_TRAP_FLAG           (greg_t)0x00000100   /* EFLAGS.TF */
+#define MODEL_TRAP_CALIBRATION    (u32)1000            /* Writes timed to find the cost of a trap */
+#define MODEL_TWI_SR              (u32)(AT91C_TWI_TXCOMP_MASTER | AT91C_TWI_TXRDY_MASTER) /* Idle bus */
+#define MODEL_MCK_HZ              (u64)48000000        /* Master clock */
+#define MODEL_US_CHAR_BITS        (u64)10              /* 8-N-1: start, 8 data and stop bits */
+#define MODEL_US_BRGR_CD          (u32)0x0000FFFF      /* US_BRGR clock divider */
+#define MODEL_US_BRGR_FP          (u32)0x00070000      /* US_BRGR fractional part (eighths) */
+#define MODEL_US_BRGR_FP_SHIFT    (u8)16
+#define MODEL_US_TX_STATUS        (u32)(AT91C_US_TXRDY | AT91C_US_TXEMPTY | AT91C_US_ENDTX | AT91C_US_TXBUFE)
+#define MODEL_US_RX_STATUS        (u32)(AT91C_US_RXRDY | AT91C_US_OVRE | AT91C_US_TIMEOUT | AT91C_US_ENDRX | \
+                                        AT91C_US_RXBUFF)
+#define MODEL_US_RTOR_TO          (u32)0x0000FFFF      /* US_RTOR time-out in bit periods */
+#define MODEL_US_RX_CHARS         (u32)16384           /* Characters queued on the receive line (a power of 2) */
+
+/* Model view of a firmware register address */
+#define MODEL_ALIAS(ADDRESS)      ( (void*)(Model_pu8Alias + ((uintptr_t)(ADDRESS) - MODEL_PERIPHERAL_BASE)) )
+
+/* Pages whose writes are trapped */
+static const uintptr_t Model_auTrapPages[] = {(uintptr_t)AT91C_BASE_TC0, (uintptr_t)AT91C_BASE_TWI0,
+                                              (uintptr_t)AT91C_BASE_US0, (uintptr_t)AT91C_BASE_PWMC};
+
+static u8* Model_pu8Alias;                             /* Writable model view of the peripheral space */
+static AT91_REG* volatile Model_pu32Write;            /* Register being written by the firmware */
+static u32 Model_u32Writes;                            /* Trapped writes so far */
+static u64 Model_u64TrapNs;                            /* Host time of one trapped write */
+static bool Model_bMapped;                             /* TRUE once the register space is mapped */
+static u64 Model_u64Ticks;                             /* Model time in TC0 ticks */
+static u32 Model_u32TickInMs;                          /* Ticks since the last system tick */
+
+static bool Model_bTcRunning;                          /* TC0 clock enabled */
+static u32 Model_u32TcImr;                             /* TC0 interrupt mask */
+static bool Model_bTcPending;                          /* RC compare interrupt waiting for its handler */
+static u64 Model_u64TcDue;                             /* Tick the pending handler runs */
+
+static u32 Model_u32TwiImr;                            /* TWI0 interrupt mask */
+static u32 Model_u32UsImr;                             /* USART0 interrupt mask */
+static u32 Model_u32UsPdc;                             /* USART0 PDC transfers enabled (US_PTSR) */
+static bool Model_bUsThrFull;                          /* US_THR holds a character */
+static u8 Model_u8UsThr;                               /* Character in US_THR */
+static u64 Model_u64UsThrNs;                           /* Time the character was put in US_THR */
+static u64 Model_u64UsThrFreeNs;                       /* Time US_THR last moved to the shift register */
+static u64 Model_u64UsTxWriteNs;                       /* Time of the last firmware write to the transmitter or PDC */
+static bool Model_bUsShifting;                         /* A character is on the line */
+static u8 Model_u8UsShift;                             /* Character on the line */
+static u64 Model_u64UsLineFreeNs;                      /* Time the character on the line (or the last one) ends */
+static ModelUartLogType Model_pfUartLog;               /* Called for each character sent, or NULL */
+static u8 Model_au8UsRxLine[MODEL_US_RX_CHARS];        /* Characters queued on the receive line */
+static u64 Model_au64UsRxEndNs[MODEL_US_RX_CHARS];     /* End of the stop bit of each queued character */
+static u32 Model_u32UsRxHead;                          /* Receive line queue: next free entry */
+static u32 Model_u32UsRxTail;                          /* Receive line queue: next character to arrive */
+static u64 Model_u64UsRxLineFreeNs;                    /* End of the last character queued on the receive line */
+static bool Model_bUsRhrFull;                          /* US_RHR holds a character (RXRDY) */
+static u8 Model_u8UsRhr;                               /* Character in US_RHR */
+static bool Model_bUsOverrun;                          /* OVRE */
+static bool Model_bUsEndRx;                            /* ENDRX */
+static bool Model_bUsTimeout;                          /* TIMEOUT */
+static bool Model_bUsTimeoutStart;                     /* Time-out started (STTTO): runs from the next character */
+static bool Model_bUsTimeoutRunning;                   /* Time-out counting down */
+static u64 Model_u64UsTimeoutNs;                       /* Time the running time-out ends */
+static ModelLatencyType Model_pfUartLatency;           /* USART0 interrupt latency, or NULL for none */
+static bool Model_bUsIrqPending;                       /* USART0 interrupt waiting for its handler */
+static u64 Model_u64UsIrqDue;                          /* Tick the pending handler runs */
+
+static u32 Model_u32PwmEnabled;                        /* PWMC_SR */
+static ModelPwmEventType Model_asPwm[MODEL_PWM_CHANNELS]; /* Last reported state of each buzzer */
+
+static ModelPwmLogType Model_pfPwmLog;                 /* Called for each buzzer change, or NULL */
+static ModelLatencyType Model_pfLatency;               /* Interrupt latency, or NULL for none */
+static ModelStatsType Model_sStats;                    /* Host time spent in the firmware */
+
+/* Write trap handlers (private functions) */
+static void ModelWriteFault(int iSignal_, siginfo_t* psInfo_, void* pvContext_);
+static void ModelWriteStep(int iSignal_, siginfo_t* psInfo_, void* pvContext_);
+static void ModelApplyWrite(AT91_REG* pu32Register_);
+static bool ModelUsartWrite(AT91_REG* pu32Register_, u32 u32Value_);
+static void ModelUsartUpdate(u64 u64Now_);
+static void ModelUsartReceive(u64 u64Now_);
+static u64 ModelTrapFree(u64 u64Time_, u32 u32Writes_);
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelInitialize
+
+Description:
+Maps the register space and installs the write traps (on the first call), then resets the model.
+
+Requires:
+  - The program is linked with -no-pie
+
+Promises:
+  - Returns TRUE with every register 0 (TWI_SR idle, USART0 transmitter empty), model time 0, the system time 0 and
+    no callbacks
+  - Returns FALSE if the register space could not be mapped at its real address
+*/
+bool ModelInitialize(void)
+{
+  struct sigaction sAction;
+  u64 u64Start;
+  int iFile;
+
+  if(!Model_bMapped)
+  {
+    /* One block of memory seen at the real addresses by the firmware and anywhere by the model */
+    iFile = memfd_create("sam3u", 0);
+    if( (iFile < 0) || (ftruncate(iFile, MODEL_PERIPHERAL_SIZE) != 0) )
+    {
+      return(FALSE);
+    }
+
+    if( mmap((void*)MODEL_PERIPHERAL_BASE, MODEL_PERIPHERAL_SIZE, PROT_READ | PROT_WRITE,
+             MAP_SHARED | MAP_FIXED_NOREPLACE, iFile, 0) != (void*)MODEL_PERIPHERAL_BASE )
+    {
+      return(FALSE);
+    }
+
+    Model_pu8Alias = mmap(NULL, MODEL_PERIPHERAL_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, iFile, 0);
+    close(iFile);
+    if(Model_pu8Alias == MAP_FAILED)
+    {
+      return(FALSE);
+    }
+
+    if( mmap((void*)MODEL_SCS_BASE, MODEL_SCS_SIZE, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void*)MODEL_SCS_BASE )
+    {
+      return(FALSE);
+    }
+
+    memset(&sAction, 0, sizeof(sAction));
+    sAction.sa_flags = SA_SIGINFO;
+    sAction.sa_sigaction = ModelWriteFault;
+    sigaction(SIGSEGV, &sAction, NULL);
+    sAction.sa_sigaction = ModelWriteStep;
+    sigaction(SIGTRAP, &sAction, NULL);
+
+    for(u8 i = 0; i < (sizeof(Model_auTrapPages) / sizeof(Model_auTrapPages[0])); i++)
+    {
+      mprotect((void*)(Model_auTrapPages[i] & ~(MODEL_PAGE_SIZE - 1)), MODEL_PAGE_SIZE, PROT_READ);
+    }
+
+    /* Cost of one trapped write, taken off the firmware times (TC1 RA is on the TC0 page and unused) */
+    u64Start = ModelHostNs();
+    for(u32 i = 0; i < MODEL_TRAP_CALIBRATION; i++)
+    {
+      AT91C_BASE_TC1->TC_RA = i;
+    }
+    Model_u64TrapNs = (ModelHostNs() - u64Start) / MODEL_TRAP_CALIBRATION;
+
+    Model_bMapped = TRUE;
+  }
+
+  memset(Model_pu8Alias, 0, MODEL_PERIPHERAL_SIZE);
+  memset((void*)MODEL_SCS_BASE, 0, MODEL_SCS_SIZE);
+
+  Model_u64Ticks = 0;
+  Model_u32TickInMs = 0;
+  Model_bTcRunning = FALSE;
+  Model_u32TcImr = 0;
+  Model_bTcPending = FALSE;
+  Model_u32TwiImr = 0;
+  ((AT91PS_TWI)MODEL_ALIAS(AT91C_BASE_TWI0))->TWI_SR = MODEL_TWI_SR;
+  Model_u32UsImr = 0;
+  Model_u32UsPdc = 0;
+  Model_bUsThrFull = FALSE;
+  Model_u64UsThrFreeNs = 0;
+  Model_u64UsTxWriteNs = 0;
+  Model_bUsShifting = FALSE;
+  Model_u64UsLineFreeNs = 0;
+  Model_pfUartLog = NULL;
+  Model_u32UsRxHead = 0;
+  Model_u32UsRxTail = 0;
+  Model_u64UsRxLineFreeNs = 0;
+  Model_bUsRhrFull = FALSE;
+  Model_bUsOverrun = FALSE;
+  Model_bUsEndRx = FALSE;
+  Model_bUsTimeout = FALSE;
+  Model_bUsTimeoutStart = FALSE;
+  Model_bUsTimeoutRunning = FALSE;
+  Model_pfUartLatency = NULL;
+  Model_bUsIrqPending = FALSE;
+  ModelUsartUpdate(0);
+  Model_u32PwmEnabled = 0;
+  memset(Model_asPwm, 0, sizeof(Model_asPwm));
+  Model_pfPwmLog = NULL;
+  Model_pfLatency = NULL;
+  ModelClearStats();
+
+  G_u32SystemTime1ms = 0;
+  G_u32SystemTime1s = 0;
+
+  return(TRUE);
+
+} /* end ModelInitialize() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelSetPwmLog
+
+Description:
+Installs the function that receives the buzzer changes.
+
+Requires:
+  -
+
+Promises:
+  - pfLog_ (or nothing if NULL) is called for each change seen from now on
+*/
+void ModelSetPwmLog(ModelPwmLogType pfLog_)
+{
+  Model_pfPwmLog = pfLog_;
+
+} /* end ModelSetPwmLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelSetLatency
+
+Description:
+Installs the function that chooses the delay from each TC0 RC compare to its handler.
+
+Requires:
+  -
+
+Promises:
+  - pfLatency_ is called once per compare from now on; NULL runs every handler at its compare
+*/
+void ModelSetLatency(ModelLatencyType pfLatency_)
+{
+  Model_pfLatency = pfLatency_;
+
+} /* end ModelSetLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelSetUartLog
+
+Description:
+Installs the function that receives the characters USART0 sends.
+
+Requires:
+  -
+
+Promises:
+  - pfLog_ (or nothing if NULL) is called for each character that ends from now on
+*/
+void ModelSetUartLog(ModelUartLogType pfLog_)
+{
+  Model_pfUartLog = pfLog_;
+
+} /* end ModelSetUartLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelSetUartLatency
+
+Description:
+Installs the function that chooses the delay from a USART0 interrupt to its handler.
+
+Requires:
+  -
+
+Promises:
+  - pfLatency_ is called each time an enabled USART0 interrupt is raised with none pending; NULL runs the handler in
+    the tick the interrupt is raised
+*/
+void ModelSetUartLatency(ModelLatencyType pfLatency_)
+{
+  Model_pfUartLatency = pfLatency_;
+
+} /* end ModelSetUartLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelUartReceive
+
+Description:
+Queues characters on the USART0 receive line at the rate set in US_BRGR.  The first starts u64GapNs_ after the later of
+now and the end of the characters already queued, and each of the others u64GapNs_ after the one before it.
+
+Requires:
+  - The baud rate is set
+
+Promises:
+  - Returns TRUE with the characters queued to arrive in order
+  - Returns FALSE with nothing queued if the line queue cannot hold them all
+*/
+bool ModelUartReceive(const u8* pu8Data_, u32 u32Size_, u64 u64GapNs_)
+{
+  u64 u64CharNs = ModelUartCharNs();
+
+  if( (u32Size_ > (MODEL_US_RX_CHARS - 1 - (Model_u32UsRxHead - Model_u32UsRxTail))) || (u64CharNs == 0) )
+  {
+    return(FALSE);
+  }
+
+  if(Model_u64UsRxLineFreeNs < ModelTimeNs())
+  {
+    Model_u64UsRxLineFreeNs = ModelTimeNs();
+  }
+
+  for(u32 i = 0; i < u32Size_; i++)
+  {
+    Model_u64UsRxLineFreeNs += u64GapNs_ + u64CharNs;
+    Model_au8UsRxLine[Model_u32UsRxHead & (MODEL_US_RX_CHARS - 1)] = pu8Data_[i];
+    Model_au64UsRxEndNs[Model_u32UsRxHead & (MODEL_US_RX_CHARS - 1)] = Model_u64UsRxLineFreeNs;
+    Model_u32UsRxHead++;
+  }
+
+  return(TRUE);
+
+} /* end ModelUartReceive() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelUartReceiveEndNs
+
+Description:
+Reports when the receive line is idle.
+
+Requires:
+  -
+
+Promises:
+  - Returns the model time in ns at which the last character queued with ModelUartReceive() ends
+*/
+u64 ModelUartReceiveEndNs(void)
+{
+  return(Model_u64UsRxLineFreeNs);
+
+} /* end ModelUartReceiveEndNs() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelUartCharNs
+
+Description:
+Reports the USART0 character time.
+
+Requires:
+  -
+
+Promises:
+  - Returns the time in ns of one 8-N-1 character at the rate set in US_BRGR, or 0 if the baud rate clock is off
+*/
+u64 ModelUartCharNs(void)
+{
+  AT91PS_USART psUsart = MODEL_ALIAS(AT91C_BASE_US0);
+  u64 u64Eighths = ((u64)(psUsart->US_BRGR & MODEL_US_BRGR_CD) * 8) +
+                   ((psUsart->US_BRGR & MODEL_US_BRGR_FP) >> MODEL_US_BRGR_FP_SHIFT);
+
+  /* 16 clocks per bit, CD + FP / 8 MCK per clock */
+  return( (MODEL_US_CHAR_BITS * 16 * u64Eighths * 1000000000ULL) / (8 * MODEL_MCK_HZ) );
+
+} /* end ModelUartCharNs() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelSync
+
+Description:
+Reports the buzzer changes made since the last call.  Call it after calling the firmware directly (e.g. MusicStart());
+ModelRun() calls it after every handler and loop pass.
+
+Requires:
+  - ModelInitialize() returned TRUE
+
+Promises:
+  - Each buzzer channel that changed is reported once at the current model time
+*/
+void ModelSync(void)
+{
+  AT91PS_PWMC_CH apsChannels[MODEL_PWM_CHANNELS] = {MODEL_ALIAS(AT91C_BASE_PWMC_CH0),
+                                                     MODEL_ALIAS(AT91C_BASE_PWMC_CH1)};
+  ModelPwmEventType sState;
+
+  for(u8 i = 0; i < MODEL_PWM_CHANNELS; i++)
+  {
+    sState.u64TimeNs = ModelTimeNs();
+    sState.u8Channel = i;
+    sState.u16Period = (u16)apsChannels[i]->PWMC_CPRDR;
+    sState.u16Duty = (u16)apsChannels[i]->PWMC_CDTYR;
+    sState.bEnabled = (bool)((Model_u32PwmEnabled & (AT91C_PWMC_CHID0 << i)) != 0);
+
+    if( (sState.u16Period != Model_asPwm[i].u16Period) || (sState.u16Duty != Model_asPwm[i].u16Duty) ||
+        (sState.bEnabled != Model_asPwm[i].bEnabled) )
+    {
+      Model_asPwm[i] = sState;
+      if(Model_pfPwmLog != NULL)
+      {
+        Model_pfPwmLog(&sState);
+      }
+    }
+  }
+
+} /* end ModelSync() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelRun
+
+Description:
+Runs the model for a number of system ticks.
+
+Requires:
+  - ModelInitialize() returned TRUE
+  - pfLoop_ is one main loop pass, or NULL
+
+Promises:
+  - Model time advances by u32Ms_ ms, with TC0_IrqHandler() called for each RC compare, TWI0_IrqHandler() for each
+    tick with an interrupt of TWI0, USART0_IrqHandler() for each tick with an interrupt of USART0 once its latency
+    has passed, and pfLoop_ called after each system tick
+*/
+void ModelRun(u32 u32Ms_, fnCode_type pfLoop_)
+{
+  AT91PS_TC psTimer = MODEL_ALIAS(AT91C_BASE_TC0);
+  AT91PS_TWI psTwi = MODEL_ALIAS(AT91C_BASE_TWI0);
+  AT91PS_USART psUsart = MODEL_ALIAS(AT91C_BASE_US0);
+  u64 u64Start;
+  u64 u64Time;
+  u32 u32Writes;
+
+  ModelSync();
+
+  for(u32 u32Tick = 0; u32Tick < (u32Ms_ * MODEL_TICKS_PER_MS); u32Tick++)
+  {
+    Model_u64Ticks++;
+
+    /* Count; RC compare restarts the count (WAVSEL = UP_RC) and the 16-bit counter wraps */
+    if(Model_bTcRunning)
+    {
+      psTimer->TC_CV = (psTimer->TC_CV + 1) & TC_SEQUENCER_MAX_TICKS;
+      if(psTimer->TC_CV == psTimer->TC_RC)
+      {
+        psTimer->TC_CV = 0;
+        psTimer->TC_SR |= AT91C_TC_CPCS;
+        if( (Model_u32TcImr & AT91C_TC_CPCS) && !Model_bTcPending )
+        {
+          Model_bTcPending = TRUE;
+          Model_u64TcDue = Model_u64Ticks + ((Model_pfLatency != NULL) ? Model_pfLatency() : 0);
+        }
+      }
+    }
+
+    if(Model_bTcPending && (Model_u64Ticks >= Model_u64TcDue))
+    {
+      Model_bTcPending = FALSE;
+      u32Writes = Model_u32Writes;
+      u64Start = ModelHostNs();
+      if(TC0_IrqHandler != NULL)
+      {
+        TC0_IrqHandler();
+      }
+      u64Time = ModelTrapFree(ModelHostNs() - u64Start, Model_u32Writes - u32Writes);
+
+      Model_sStats.u32IsrCalls++;
+      Model_sStats.u64IsrTime += u64Time;
+      if(u64Time > Model_sStats.u64IsrMaxTime)
+      {
+        Model_sStats.u64IsrMaxTime = u64Time;
+      }
+
+      psTimer->TC_SR = 0;
+      ModelSync();
+    }
+
+    if( (Model_u32TwiImr & psTwi->TWI_SR) && (TWI0_IrqHandler != NULL) )
+    {
+      TWI0_IrqHandler();
+    }
+
+    /* A USART0 interrupt raised waits for its latency; the handler runs if it is still raised then */
+    ModelUsartUpdate(ModelTimeNs());
+    if( !Model_bUsIrqPending && (Model_u32UsImr & psUsart->US_CSR) )
+    {
+      Model_bUsIrqPending = TRUE;
+      Model_u64UsIrqDue = Model_u64Ticks + ((Model_pfUartLatency != NULL) ? Model_pfUartLatency() : 0);
+    }
+
+    if(Model_bUsIrqPending && (Model_u64Ticks >= Model_u64UsIrqDue))
+    {
+      Model_bUsIrqPending = FALSE;
+      if( (Model_u32UsImr & psUsart->US_CSR) && (USART0_IrqHandler != NULL) )
+      {
+        u32Writes = Model_u32Writes;
+        u64Start = ModelHostNs();
+        USART0_IrqHandler();
+        u64Time = ModelTrapFree(ModelHostNs() - u64Start, Model_u32Writes - u32Writes);
+
+        Model_sStats.u32UartIsrCalls++;
+        Model_sStats.u64UartIsrTime += u64Time;
+      }
+    }
+
+    /* System tick and main loop pass */
+    if(++Model_u32TickInMs == MODEL_TICKS_PER_MS)
+    {
+      Model_u32TickInMs = 0;
+      G_u32SystemTime1ms++;
+      if( (G_u32SystemTime1ms % 1000) == 0 )
+      {
+        G_u32SystemTime1s++;
+      }
+
+      if(pfLoop_ != NULL)
+      {
+        u32Writes = Model_u32Writes;
+        u64Start = ModelHostNs();
+        pfLoop_();
+        u64Time = ModelTrapFree(ModelHostNs() - u64Start, Model_u32Writes - u32Writes);
+
+        Model_sStats.u32LoopCalls++;
+        Model_sStats.u64LoopTime += u64Time;
+        Model_sStats.u64LoopLastTime = u64Time;
+        if(u64Time > Model_sStats.u64LoopMaxTime)
+        {
+          Model_sStats.u64LoopMaxTime = u64Time;
+        }
+        ModelSync();
+      }
+    }
+  }
+
+} /* end ModelRun() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelTicks
+
+Description:
+Reports the model time.
+
+Requires:
+  -
+
+Promises:
+  - Returns the TC0 ticks since ModelInitialize()
+*/
+u64 ModelTicks(void)
+{
+  return(Model_u64Ticks);
+
+} /* end ModelTicks() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelTimeNs
+
+Description:
+Reports the model time in ns.
+
+Requires:
+  -
+
+Promises:
+  - Returns the time since ModelInitialize() in ns
+*/
+u64 ModelTimeNs(void)
+{
+  return( MODEL_TICKS_TO_NS(Model_u64Ticks) );
+
+} /* end ModelTimeNs() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelGetStats
+
+Description:
+Copies the host time spent in the firmware.
+
+Requires:
+  - psStats_ points to space for the counters
+
+Promises:
+  - *psStats_ holds the counters since ModelInitialize() or ModelClearStats()
+*/
+void ModelGetStats(ModelStatsType* psStats_)
+{
+  *psStats_ = Model_sStats;
+
+} /* end ModelGetStats() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelClearStats
+
+Description:
+Clears the host time counters.
+
+Requires:
+  -
+
+Promises:
+  - All counters are 0
+*/
+void ModelClearStats(void)
+{
+  memset(&Model_sStats, 0, sizeof(Model_sStats));
+
+} /* end ModelClearStats() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelHostNs
+
+Description:
+Reads the host monotonic clock.
+
+Requires:
+  -
+
+Promises:
+  - Returns the host time in ns
+*/
+u64 ModelHostNs(void)
+{
+  struct timespec sTime;
+
+  clock_gettime(CLOCK_MONOTONIC, &sTime);
+  return( ((u64)sTime.tv_sec * 1000000000ULL) + (u64)sTime.tv_nsec );
+
+} /* end ModelHostNs() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Private functions                                                                                                  */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelWriteFault
+
+Description:
+SIGSEGV handler: the firmware wrote to a trapped register page.  The page is made writable and the writing instruction
+is single-stepped; ModelWriteStep() applies the write.
+
+Requires:
+  - Runs as a SA_SIGINFO handler
+
+Promises:
+  - A write to a trapped page completes and traps again right after
+  - Any other fault is re-raised with the default action (the program stops as it would without the model)
+*/
+static void ModelWriteFault(int iSignal_, siginfo_t* psInfo_, void* pvContext_)
+{
+  ucontext_t* psContext = (ucontext_t*)pvContext_;
+  uintptr_t uAddress = (uintptr_t)psInfo_->si_addr;
+
+  for(u8 i = 0; i < (sizeof(Model_auTrapPages) / sizeof(Model_auTrapPages[0])); i++)
+  {
+    if( (uAddress & ~(MODEL_PAGE_SIZE - 1)) == (Model_auTrapPages[i] & ~(MODEL_PAGE_SIZE - 1)) )
+    {
+      Model_pu32Write = (AT91_REG*)(uAddress & ~(uintptr_t)3);
+      mprotect((void*)(uAddress & ~(MODEL_PAGE_SIZE - 1)), MODEL_PAGE_SIZE, PROT_READ | PROT_WRITE);
+      psContext->uc_mcontext.gregs[REG_EFL] |= MODEL_TRAP_FLAG;
+      return;
+    }
+  }
+
+  signal(iSignal_, SIG_DFL);
+
+} /* end ModelWriteFault() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelWriteStep
+
+Description:
+SIGTRAP handler: the trapped write has completed.  The page is protected again and the write is applied.
+
+Requires:
+  - Runs as a SA_SIGINFO handler
+
+Promises:
+  - The register write has its hardware side effects and the page traps writes again
+  - A trap that is not from a register write is re-raised with the default action
+*/
+static void ModelWriteStep(int iSignal_, siginfo_t* psInfo_, void* pvContext_)
+{
+  ucontext_t* psContext = (ucontext_t*)pvContext_;
+  AT91_REG* pu32Register = (AT91_REG*)Model_pu32Write;
+
+  (void)psInfo_;
+  if(pu32Register == NULL)
+  {
+    signal(iSignal_, SIG_DFL);
+    return;
+  }
+
+  psContext->uc_mcontext.gregs[REG_EFL] &= ~MODEL_TRAP_FLAG;
+  mprotect((void*)((uintptr_t)pu32Register & ~(MODEL_PAGE_SIZE - 1)), MODEL_PAGE_SIZE, PROT_READ);
+  Model_pu32Write = NULL;
+  Model_u32Writes++;
+
+  ModelApplyWrite(pu32Register);
+
+} /* end ModelWriteStep() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelApplyWrite
+
+Description:
+Applies the side effects of a firmware write to a TC0 or PWM controller register.
+
+Requires:
+  - pu32Register_ is the firmware address of the register just written
+
+Promises:
+  - TC_CCR: CLKDIS stops the counter and drops a pending compare, else CLKEN starts it; SWTRG restarts the count
+  - TC_IER/TC_IDR update TC_IMR, TWI_IER/TWI_IDR update TWI_IMR; PWMC_ENA/PWMC_DIS update PWMC_SR
+  - USART0 writes are applied by ModelUsartWrite()
+  - The write-only registers read back as 0; any other register keeps the value written
+*/
+static void ModelApplyWrite(AT91_REG* pu32Register_)
+{
+  AT91PS_TC psTimer = MODEL_ALIAS(AT91C_BASE_TC0);
+  AT91PS_TWI psTwi = MODEL_ALIAS(AT91C_BASE_TWI0);
+  AT91PS_PWMC psPwm = MODEL_ALIAS(AT91C_BASE_PWMC);
+  AT91_REG* pu32Alias = MODEL_ALIAS(pu32Register_);
+  u32 u32Value = *pu32Alias;
+
+  if( ((uintptr_t)pu32Register_ & ~(MODEL_PAGE_SIZE - 1)) == (uintptr_t)AT91C_BASE_US0 )
+  {
+    if(ModelUsartWrite(pu32Register_, u32Value))
+    {
+      *pu32Alias = 0;
+    }
+    ModelUsartUpdate(ModelTimeNs());
+    return;
+  }
+
+  if(pu32Register_ == &AT91C_BASE_TC0->TC_CCR)
+  {
+    if(u32Value & AT91C_TC_CLKDIS)
+    {
+      Model_bTcRunning = FALSE;
+      Model_bTcPending = FALSE;
+      psTimer->TC_SR = 0;
+    }
+    else if(u32Value & AT91C_TC_CLKEN)
+    {
+      Model_bTcRunning = TRUE;
+    }
+
+    if(u32Value & AT91C_TC_SWTRG)
+    {
+      psTimer->TC_CV = 0;
+    }
+  }
+  else if(pu32Register_ == &AT91C_BASE_TC0->TC_IER)
+  {
+    Model_u32TcImr |= u32Value;
+  }
+  else if(pu32Register_ == &AT91C_BASE_TC0->TC_IDR)
+  {
+    Model_u32TcImr &= ~u32Value;
+  }
+  else if(pu32Register_ == &AT91C_BASE_TWI0->TWI_IER)
+  {
+    Model_u32TwiImr |= u32Value;
+  }
+  else if(pu32Register_ == &AT91C_BASE_TWI0->TWI_IDR)
+  {
+    Model_u32TwiImr &= ~u32Value;
+  }
+  else if( (pu32Register_ == &AT91C_BASE_TWI0->TWI_CR) || (pu32Register_ == &AT91C_BASE_TWI0->TWI_THR) )
+  {
+    /* Write-only */
+  }
+  else if(pu32Register_ == &AT91C_BASE_PWMC->PWMC_ENA)
+  {
+    Model_u32PwmEnabled |= u32Value;
+  }
+  else if(pu32Register_ == &AT91C_BASE_PWMC->PWMC_DIS)
+  {
+    Model_u32PwmEnabled &= ~u32Value;
+  }
+  else
+  {
+    return;
+  }
+
+  *pu32Alias = 0;
+  psTimer->TC_IMR = Model_u32TcImr;
+  psTwi->TWI_IMR = Model_u32TwiImr;
+  psPwm->PWMC_SR = Model_u32PwmEnabled;
+
+} /* end ModelApplyWrite() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelUsartWrite
+
+Description:
+Applies the side effects of a firmware write to a USART0 register.
+
+Requires:
+  - pu32Register_ is the firmware address of a USART0 register; u32Value_ the value written
+
+Promises:
+  - US_IER/US_IDR update US_IMR; US_PTCR enables or disables the PDC transfers (US_PTSR)
+  - US_CR: RSTSTA clears OVRE; STTTO clears TIMEOUT and starts the time-out at the next character; RETTO restarts it
+  - A non-zero write to US_RCR or US_RNCR clears ENDRX
+  - US_THR takes a character (overwriting one not yet sent, as the hardware does)
+  - A write to the transmitter or its PDC registers is remembered as the time the PDC could start loading
+  - Returns TRUE for a write-only register (it reads back as 0)
+*/
+static bool ModelUsartWrite(AT91_REG* pu32Register_, u32 u32Value_)
+{
+  AT91PS_USART psUsart = MODEL_ALIAS(AT91C_BASE_US0);
+
+  Model_u64UsTxWriteNs = ModelTimeNs();
+
+  if( ((pu32Register_ == &AT91C_BASE_US0->US_RCR) || (pu32Register_ == &AT91C_BASE_US0->US_RNCR)) &&
+      (u32Value_ != 0) )
+  {
+    Model_bUsEndRx = FALSE;
+  }
+
+  if(pu32Register_ == &AT91C_BASE_US0->US_CR)
+  {
+    if(u32Value_ & AT91C_US_RSTSTA)
+    {
+      Model_bUsOverrun = FALSE;
+    }
+
+    if(u32Value_ & AT91C_US_STTTO)
+    {
+      Model_bUsTimeout = FALSE;
+      Model_bUsTimeoutStart = TRUE;
+      Model_bUsTimeoutRunning = FALSE;
+    }
+
+    if(u32Value_ & AT91C_US_RETTO)
+    {
+      Model_bUsTimeoutRunning = TRUE;
+      Model_u64UsTimeoutNs = ModelTimeNs() + ((ModelUartCharNs() * (psUsart->US_RTOR & MODEL_US_RTOR_TO)) /
+                                              MODEL_US_CHAR_BITS);
+    }
+  }
+  else if(pu32Register_ == &AT91C_BASE_US0->US_IER)
+  {
+    Model_u32UsImr |= u32Value_;
+  }
+  else if(pu32Register_ == &AT91C_BASE_US0->US_IDR)
+  {
+    Model_u32UsImr &= ~u32Value_;
+  }
+  else if(pu32Register_ == &AT91C_BASE_US0->US_THR)
+  {
+    Model_u8UsThr = (u8)u32Value_;
+    Model_bUsThrFull = TRUE;
+    Model_u64UsThrNs = Model_u64UsTxWriteNs;
+  }
+  else if(pu32Register_ == &AT91C_BASE_US0->US_PTCR)
+  {
+    Model_u32UsPdc |= u32Value_ & (AT91C_PDC_RXTEN | AT91C_PDC_TXTEN);
+    Model_u32UsPdc &= ~((u32Value_ & (AT91C_PDC_RXTDIS | AT91C_PDC_TXTDIS)) >> 1);
+  }
+  else
+  {
+    return(FALSE);
+  }
+
+  psUsart->US_IMR = Model_u32UsImr;
+  psUsart->US_PTSR = Model_u32UsPdc;
+  return(TRUE);
+
+} /* end ModelUsartWrite() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelUsartUpdate
+
+Description:
+Runs USART0 up to the current time and updates US_CSR.  Transmitter: characters whose stop bit has ended are
+reported, THR moves to the idle shift register, and the PDC refills THR from TPR/TCR (moving TNPR/TNCR into TPR/TCR
+when TCR reaches 0).  A character waiting in THR starts as soon as the line is free, so characters loaded in time
+follow each other with no gap.  The receiver is run by ModelUsartReceive().
+
+Requires:
+  - u64Now_ is the model time in ns, not before the last call
+
+Promises:
+  - The transmitter and receiver state is the one at u64Now_ and US_CSR matches it
+*/
+static void ModelUsartUpdate(u64 u64Now_)
+{
+  AT91PS_USART psUsart = MODEL_ALIAS(AT91C_BASE_US0);
+  u64 u64CharNs = ModelUartCharNs();
+  u64 u64Start;
+  bool bChanged = TRUE;
+
+  while(bChanged)
+  {
+    bChanged = FALSE;
+
+    if( (psUsart->US_TCR == 0) && (psUsart->US_TNCR != 0) )
+    {
+      psUsart->US_TPR = psUsart->US_TNPR;
+      psUsart->US_TCR = psUsart->US_TNCR;
+      psUsart->US_TNCR = 0;
+    }
+
+    /* The PDC loads THR once both are ready (THR empty, the counter loaded and transfers enabled) */
+    if( (Model_u32UsPdc & AT91C_PDC_TXTEN) && !Model_bUsThrFull && (psUsart->US_TCR != 0) )
+    {
+      Model_u8UsThr = *(u8*)(uintptr_t)psUsart->US_TPR;
+      psUsart->US_TPR++;
+      psUsart->US_TCR--;
+      Model_bUsThrFull = TRUE;
+      Model_u64UsThrNs = (Model_u64UsThrFreeNs > Model_u64UsTxWriteNs) ? Model_u64UsThrFreeNs : Model_u64UsTxWriteNs;
+      bChanged = TRUE;
+    }
+
+    if(Model_bUsShifting && (Model_u64UsLineFreeNs <= u64Now_))
+    {
+      Model_bUsShifting = FALSE;
+      if(Model_pfUartLog != NULL)
+      {
+        Model_pfUartLog(Model_u8UsShift, Model_u64UsLineFreeNs);
+      }
+      bChanged = TRUE;
+    }
+
+    if(!Model_bUsShifting && Model_bUsThrFull && (u64CharNs != 0))
+    {
+      u64Start = (Model_u64UsThrNs > Model_u64UsLineFreeNs) ? Model_u64UsThrNs : Model_u64UsLineFreeNs;
+      Model_u8UsShift = Model_u8UsThr;
+      Model_bUsThrFull = FALSE;
+      Model_bUsShifting = TRUE;
+      Model_u64UsThrFreeNs = u64Start;
+      Model_u64UsLineFreeNs = u64Start + u64CharNs;
+      bChanged = TRUE;
+    }
+  }
+
+  ModelUsartReceive(u64Now_);
+
+  psUsart->US_CSR &= ~(MODEL_US_TX_STATUS | MODEL_US_RX_STATUS);
+  if(!Model_bUsThrFull)
+  {
+    psUsart->US_CSR |= AT91C_US_TXRDY;
+    if(!Model_bUsShifting)
+    {
+      psUsart->US_CSR |= AT91C_US_TXEMPTY;
+    }
+  }
+
+  if(psUsart->US_TCR == 0)
+  {
+    psUsart->US_CSR |= AT91C_US_ENDTX;
+    if(psUsart->US_TNCR == 0)
+    {
+      psUsart->US_CSR |= AT91C_US_TXBUFE;
+    }
+  }
+
+  psUsart->US_CSR |= (Model_bUsRhrFull ? AT91C_US_RXRDY : 0) | (Model_bUsOverrun ? AT91C_US_OVRE : 0) |
+                     (Model_bUsTimeout ? AT91C_US_TIMEOUT : 0) | (Model_bUsEndRx ? AT91C_US_ENDRX : 0);
+  if( (psUsart->US_RCR == 0) && (psUsart->US_RNCR == 0) )
+  {
+    psUsart->US_CSR |= AT91C_US_RXBUFF;
+  }
+
+} /* end ModelUsartUpdate() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelUsartReceive
+
+Description:
+Runs the USART0 receiver up to the current time: the characters and time-outs due are taken in time order.  The PDC
+moves each character from RHR to RPR (moving RNPR/RNCR into RPR/RCR when RCR reaches 0); a character arriving with
+RHR still full sets OVRE and replaces it.
+
+Requires:
+  - u64Now_ is the model time in ns, not before the last call
+
+Promises:
+  - The receiver state is the one at u64Now_
+*/
+static void ModelUsartReceive(u64 u64Now_)
+{
+  AT91PS_USART psUsart = MODEL_ALIAS(AT91C_BASE_US0);
+  u64 u64TimeoutNs = (ModelUartCharNs() * (psUsart->US_RTOR & MODEL_US_RTOR_TO)) / MODEL_US_CHAR_BITS;
+  u32 u32Next;
+
+  while(TRUE)
+  {
+    if( (psUsart->US_RCR == 0) && (psUsart->US_RNCR != 0) )
+    {
+      psUsart->US_RPR = psUsart->US_RNPR;
+      psUsart->US_RCR = psUsart->US_RNCR;
+      psUsart->US_RNCR = 0;
+    }
+
+    if( (Model_u32UsPdc & AT91C_PDC_RXTEN) && Model_bUsRhrFull && (psUsart->US_RCR != 0) )
+    {
+      *(u8*)(uintptr_t)psUsart->US_RPR = Model_u8UsRhr;
+      psUsart->US_RPR++;
+      psUsart->US_RCR--;
+      Model_bUsRhrFull = FALSE;
+      if(psUsart->US_RCR == 0)
+      {
+        Model_bUsEndRx = TRUE;
+      }
+      continue;
+    }
+
+    /* The time-out ends first if it is due no later than the next character */
+    u32Next = Model_u32UsRxTail & (MODEL_US_RX_CHARS - 1);
+    if( Model_bUsTimeoutRunning && (Model_u64UsTimeoutNs <= u64Now_) &&
+        ((Model_u32UsRxTail == Model_u32UsRxHead) || (Model_u64UsTimeoutNs <= Model_au64UsRxEndNs[u32Next])) )
+    {
+      Model_bUsTimeoutRunning = FALSE;
+      Model_bUsTimeout = TRUE;
+      continue;
+    }
+
+    if( (Model_u32UsRxTail == Model_u32UsRxHead) || (Model_au64UsRxEndNs[u32Next] > u64Now_) )
+    {
+      break;
+    }
+
+    if(Model_bUsRhrFull)
+    {
+      Model_bUsOverrun = TRUE;
+    }
+    Model_u8UsRhr = Model_au8UsRxLine[u32Next];
+    Model_bUsRhrFull = TRUE;
+    Model_u32UsRxTail++;
+
+    /* Each character restarts a started time-out (RTOR = 0 disables it) */
+    if( (Model_bUsTimeoutStart || Model_bUsTimeoutRunning) && (u64TimeoutNs != 0) )
+    {
+      Model_bUsTimeoutStart = FALSE;
+      Model_bUsTimeoutRunning = TRUE;
+      Model_u64UsTimeoutNs = Model_au64UsRxEndNs[u32Next] + u64TimeoutNs;
+    }
+  }
+
+} /* end ModelUsartReceive() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: ModelTrapFree
+
+Description:
+Takes the cost of the trapped writes off a host time measured around firmware code.
+
+Requires:
+  - Model_u64TrapNs is calibrated
+
+Promises:
+  - Returns u64Time_ less u32Writes_ traps (not below 0)
+*/
+static u64 ModelTrapFree(u64 u64Time_, u32 u32Writes_)
+{
+  u64 u64Traps = (u64)u32Writes_ * Model_u64TrapNs;
+
+  return( (u64Time_ > u64Traps) ? (u64Time_ - u64Traps) : 0 );
+
+} /* end ModelTrapFree() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
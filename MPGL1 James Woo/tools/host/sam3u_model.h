@@ -0,0 +1,84 @@
+/**********************************************************************************************************************
+File: sam3u_model.h
+
+Description:
+Host model of the SAM3U peripheral space, of the TC0 note sequencer timer and buzzer PWM and of USART0.
+See sam3u_model.c.
+**********************************************************************************************************************/
+
+#ifndef __SAM3U_MODEL_H
+#define __SAM3U_MODEL_H
+
+/**********************************************************************************************************************
+Type Definitions
+**********************************************************************************************************************/
+/* One change of a buzzer PWM channel */
+typedef struct
+{
+  u64 u64TimeNs;                 /* Model time of the change */
+  u8 u8Channel;                  /* 0 or 1 */
+  u16 u16Period;                 /* PWMC_CPRDR */
+  u16 u16Duty;                   /* PWMC_CDTYR */
+  bool bEnabled;                 /* Channel bit in PWMC_SR */
+} ModelPwmEventType;
+
+/* Called for every buzzer PWM change */
+typedef void (*ModelPwmLogType)(const ModelPwmEventType* psEvent_);
+
+/* Called for every character USART0 sends, at the end of its stop bit */
+typedef void (*ModelUartLogType)(u8 u8Char_, u64 u64TimeNs_);
+
+/* Returns the TC ticks from an RC compare (or a USART0 interrupt) to the start of its interrupt handler */
+typedef u32 (*ModelLatencyType)(void);
+
+/* Host time spent in the firmware (all times in ns, less the cost of the register write traps) */
+typedef struct
+{
+  u32 u32IsrCalls;               /* TC0_IrqHandler() calls */
+  u64 u64IsrTime;                /* Total time in TC0_IrqHandler() */
+  u64 u64IsrMaxTime;             /* Longest TC0_IrqHandler() call */
+  u32 u32LoopCalls;              /* Main loop passes */
+  u64 u64LoopTime;               /* Total time in the main loop passes */
+  u64 u64LoopMaxTime;            /* Longest main loop pass */
+  u64 u64LoopLastTime;           /* Last main loop pass */
+  u32 u32UartIsrCalls;           /* USART0_IrqHandler() calls */
+  u64 u64UartIsrTime;            /* Total time in USART0_IrqHandler() */
+} ModelStatsType;
+
+
+/**********************************************************************************************************************
+Constants / Definitions
+**********************************************************************************************************************/
+#define MODEL_TICKS_PER_MS        TC_SEQUENCER_TICKS_PER_MS   /* Model time steps are TC0 ticks (MCK / 128) */
+#define MODEL_PWM_CHANNELS        (u8)2
+
+/* Model ticks to ns */
+#define MODEL_TICKS_TO_NS(TICKS)  ( ((u64)(TICKS) * 1000000ULL) / MODEL_TICKS_PER_MS )
+
+
+/**********************************************************************************************************************
+Function Declarations
+**********************************************************************************************************************/
+bool ModelInitialize(void);
+void ModelSetPwmLog(ModelPwmLogType pfLog_);
+void ModelSetLatency(ModelLatencyType pfLatency_);
+void ModelSetUartLog(ModelUartLogType pfLog_);
+void ModelSetUartLatency(ModelLatencyType pfLatency_);
+bool ModelUartReceive(const u8* pu8Data_, u32 u32Size_, u64 u64GapNs_);
+u64 ModelUartReceiveEndNs(void);
+u64 ModelUartCharNs(void);
+void ModelSync(void);
+void ModelRun(u32 u32Ms_, fnCode_type pfLoop_);
+u64 ModelTicks(void);
+u64 ModelTimeNs(void);
+void ModelGetStats(ModelStatsType* psStats_);
+void ModelClearStats(void);
+u64 ModelHostNs(void);
+
+
+#endif /* __SAM3U_MODEL_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
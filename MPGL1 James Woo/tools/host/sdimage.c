@@ -0,0 +1,230 @@
+/**********************************************************************************************************************
+File: sdimage.c
+
+Description:
+Host stand-in for the SD card driver: SdGetStatus(), SdReadBlock() and SdGetReadData() of sdcard.c, backed by a card
+image file instead of the card.  Each block read takes SdImageSetReadTime() ms of system time (G_u32SystemTime1ms)
+from SdReadBlock() to SD_DATA_READY, so the streamer sees a card that is busy for a while as the real one is.  A read
+past the end of the image puts the card in SD_CARD_ERROR; with no image open the card reports SD_NO_CARD.
+
+Block addresses are always in blocks (the image behaves as a high capacity card).
+**********************************************************************************************************************/
+
+#include <stdio.h>
+
+#include "configuration.h"
+#include "sdcard.h"
+#include "sdimage.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Existing variables (defined in other files -- should all contain the "extern" keyword) */
+extern volatile u32 G_u32SystemTime1ms;                /* From board-specific source file */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "SdImage_" and be declared as static.
+***********************************************************************************************************************/
+static FILE* SdImage_pFile;                            /* Card image, or NULL for no card */
+static SdCardStateType SdImage_eState = SD_NO_CARD;   /* Card state as SdGetStatus() reports it */
+static u32 SdImage_u32Block;                           /* Block being read */
+static u32 SdImage_u32ReadStart;                       /* System time the read started */
+static u32 SdImage_u32ReadTime;                        /* ms per block read */
+static u32 SdImage_u32Reads;                           /* Blocks read since the image was opened */
+static u8 SdImage_au8Block[SD_IMAGE_BLOCK_SIZE];       /* Data of the last block read */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdImageOpen
+
+Description:
+Inserts a card: opens a card image file.
+
+Requires:
+  - pcPath_ is a file whose size is a whole number of blocks
+
+Promises:
+  - Returns TRUE with the card SD_IDLE and the read count 0
+  - Returns FALSE (and no card) if the file cannot be opened
+*/
+bool SdImageOpen(const char* pcPath_)
+{
+  SdImageClose();
+
+  SdImage_pFile = fopen(pcPath_, "rb");
+  if(SdImage_pFile == NULL)
+  {
+    return(FALSE);
+  }
+
+  SdImage_eState = SD_IDLE;
+  SdImage_u32Reads = 0;
+  return(TRUE);
+
+} /* end SdImageOpen() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdImageClose
+
+Description:
+Removes the card.
+
+Requires:
+  -
+
+Promises:
+  - The image is closed and the card reports SD_NO_CARD
+*/
+void SdImageClose(void)
+{
+  if(SdImage_pFile != NULL)
+  {
+    fclose(SdImage_pFile);
+    SdImage_pFile = NULL;
+  }
+
+  SdImage_eState = SD_NO_CARD;
+
+} /* end SdImageClose() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdImageSetReadTime
+
+Description:
+Sets how long the card takes to read a block.
+
+Requires:
+  -
+
+Promises:
+  - Reads started from now on are ready u32Ms_ ms after SdReadBlock()
+*/
+void SdImageSetReadTime(u32 u32Ms_)
+{
+  SdImage_u32ReadTime = u32Ms_;
+
+} /* end SdImageSetReadTime() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdImageGetReads
+
+Description:
+Reports the card traffic.
+
+Requires:
+  -
+
+Promises:
+  - Returns the blocks read since the image was opened
+*/
+u32 SdImageGetReads(void)
+{
+  return(SdImage_u32Reads);
+
+} /* end SdImageGetReads() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdGetStatus
+
+Description:
+Reports the card state as sdcard.c does.  A read in progress completes here once its read time is up.
+
+Requires:
+  -
+
+Promises:
+  - A read whose time is up has its block loaded and the state SD_DATA_READY (SD_CARD_ERROR past the image end)
+  - Returns the card state
+*/
+SdCardStateType SdGetStatus(void)
+{
+  if( (SdImage_eState == SD_READING) && ((G_u32SystemTime1ms - SdImage_u32ReadStart) >= SdImage_u32ReadTime) )
+  {
+    SdImage_eState = SD_CARD_ERROR;
+    if( (fseek(SdImage_pFile, (long)SdImage_u32Block * SD_IMAGE_BLOCK_SIZE, SEEK_SET) == 0) &&
+        (fread(SdImage_au8Block, 1, SD_IMAGE_BLOCK_SIZE, SdImage_pFile) == SD_IMAGE_BLOCK_SIZE) )
+    {
+      SdImage_u32Reads++;
+      SdImage_eState = SD_DATA_READY;
+    }
+  }
+
+  return(SdImage_eState);
+
+} /* end SdGetStatus() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdReadBlock
+
+Description:
+Starts reading a block, as sdcard.c does.
+
+Requires:
+  - u32BlockAddress_ is a block number
+
+Promises:
+  - If the card is SD_IDLE, starts the read, changes the state to SD_READING and returns TRUE
+  - Otherwise returns FALSE
+*/
+bool SdReadBlock(u32 u32BlockAddress_)
+{
+  if(SdImage_eState != SD_IDLE)
+  {
+    return(FALSE);
+  }
+
+  SdImage_u32Block = u32BlockAddress_;
+  SdImage_u32ReadStart = G_u32SystemTime1ms;
+  SdImage_eState = SD_READING;
+  return(TRUE);
+
+} /* end SdReadBlock() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SdGetReadData
+
+Description:
+Transfers the block just read, as sdcard.c does.
+
+Requires:
+  - pu8Destination_ points to SD_IMAGE_BLOCK_SIZE bytes
+
+Promises:
+  - If the block is ready, copies it to pu8Destination_, returns the card to SD_IDLE and returns TRUE
+  - Otherwise returns FALSE
+*/
+bool SdGetReadData(u8* pu8Destination_)
+{
+  if(SdGetStatus() != SD_DATA_READY)
+  {
+    return(FALSE);
+  }
+
+  memcpy(pu8Destination_, SdImage_au8Block, SD_IMAGE_BLOCK_SIZE);
+  SdImage_eState = SD_IDLE;
+  return(TRUE);
+
+} /* end SdGetReadData() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,33 @@
+/**********************************************************************************************************************
+File: sdimage.h
+
+Description:
+Header file for sdimage.c: the SD card block read API backed by a card image file.
+**********************************************************************************************************************/
+
+#ifndef __SDIMAGE_H
+#define __SDIMAGE_H
+
+/**********************************************************************************************************************
+Constants / Definitions
+**********************************************************************************************************************/
+#define SD_IMAGE_BLOCK_SIZE       (u16)512             /* Bytes per card block */
+
+
+/**********************************************************************************************************************
+Function Declarations
+**********************************************************************************************************************/
+bool SdImageOpen(const char* pcPath_);
+void SdImageClose(void);
+void SdImageSetReadTime(u32 u32Ms_);
+u32 SdImageGetReads(void);
+
+/* SdGetStatus(), SdReadBlock() and SdGetReadData() are declared in sdcard.h */
+
+
+#endif /* __SDIMAGE_H */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
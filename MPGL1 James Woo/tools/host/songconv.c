@@ -0,0 +1,761 @@
+/**********************************************************************************************************************
+File: songconv.c
+
+Description:
+Song converter and validator for the packed song format of music.h.
+
+Songs are written as text, one note per "NOTE LENGTH ARTICULATION" triple with the short-hand names of music.h:
+
+  # "Mary had a little lamb" (anything after # is a comment)
+  B4 QN HT  A4 QN HT  G4 QN HT  A4 QN HT
+  B4 QN RT  B4 QN RT  B4 HN HT  NO QN HT
+
+  notes         C3 ... B6 with S for sharp (e.g. D4S), NO for a rest
+  lengths       SN EN EN+SN QN QN+EN HN HN+QN FN (the lengths a packed note can hold)
+  articulations RT ST HT
+
+Every note, from a text file or from a table, is checked for:
+- a note index in the note table, a valid articulation code and the reserved bits clear;
+- a repeated pitch that is held (HT) into the next note, which then sounds as one long note (songs.c plays repeated
+  notes RT);
+and every song for an empty melody and for voices of different total lengths.
+
+Usage:
+  songconv -v                 validate the tables of songs.c (and the text round trip of each)
+  songconv -t song            write a table of songs.c as text (mary or elise)
+  songconv -c name [file]     write the text song (default stdin) as a songs.c table Songs_au16<name>[]
+  songconv -i image file...   write the text songs as an SD card song library (see songstream.h)
+Returns 0, or 1 on a bad argument, an invalid song or an output error.
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../application/music.c"
+#include "../../application/songs.c"
+
+#include <ctype.h>
+#include <stdio.h>
+#include "sdcard.h"
+#include "songstream.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define SONGCONV_MAX_NOTES        (u16)0xFFFF          /* Notes a SongVoiceType can hold */
+#define SONGCONV_MAX_TOKEN        (u8)16               /* Longest text token */
+#define SONGCONV_NOTES_PER_LINE   (u8)4                /* SONG_NOTE() entries per line of a table */
+#define SONGCONV_RESERVED_MASK    (u16)0xE000          /* Packed note bits that must be 0 */
+
+
+/***********************************************************************************************************************
+Type Definitions
+***********************************************************************************************************************/
+typedef struct
+{
+  const char* pcName;            /* -t name */
+  const SongType* psSong;        /* Table in songs.c */
+} SongConvSongType;
+
+typedef struct
+{
+  u16* pu16Notes;                /* Packed notes */
+  u32 u32Count;                  /* Notes in pu16Notes */
+  u32 u32Size;                   /* Space in pu16Notes */
+} SongConvVoiceType;
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "SongConv_" and be declared as static.
+***********************************************************************************************************************/
+static FILE* SongConv_pReport;                         /* Output of the song report lines */
+
+/* Tables of songs.c */
+static const SongConvSongType SongConv_asSongs[] =
+{
+  {"mary",  &G_sSongMaryHadALittleLamb},
+  {"elise", &G_sSongFurElise}
+};
+
+/* Text names of the length and articulation codes */
+static const char* const SongConv_apcLength[SONG_LENGTH_CODES] = {"SN", "EN", "EN+SN", "QN", "QN+EN", "HN", "HN+QN",
+                                                                  "FN"};
+static const char* const SongConv_apcArticulation[SONG_ARTICULATION_CODES] = {"RT", "ST", "HT"};
+static const char* const SongConv_apcPitch[MUSIC_OCTAVE] = {"C", "CS", "D", "DS", "E", "F", "FS", "G", "GS", "A",
+                                                            "AS", "B"};
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvNoteName
+
+Description:
+Writes the short-hand name of a note index as music.h defines it.
+
+Requires:
+  - pcName_ has room for 5 characters
+  - u8NoteIndex_ < NOTE_INDEX_COUNT
+
+Promises:
+  - pcName_ holds the name (e.g. "D4S", or "NO" for the rest)
+*/
+static void SongConvNoteName(u8 u8NoteIndex_, char* pcName_)
+{
+  const char* pcPitch;
+  u8 u8Octave;
+
+  if(u8NoteIndex_ == NOTE_INDEX_REST)
+  {
+    strcpy(pcName_, "NO");
+    return;
+  }
+
+  pcPitch = SongConv_apcPitch[(u8NoteIndex_ - NOTE_INDEX_C3) % MUSIC_OCTAVE];
+  u8Octave = (u8)(3 + ((u8NoteIndex_ - NOTE_INDEX_C3) / MUSIC_OCTAVE));
+  sprintf(pcName_, "%c%u%s", pcPitch[0], u8Octave, &pcPitch[1]);
+
+} /* end SongConvNoteName() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvLookup
+
+Description:
+Finds a text token in a table of names.
+
+Requires:
+  -
+
+Promises:
+  - Returns the index of pcToken_ in papcNames_, or u8Count_ if it is not there
+*/
+static u8 SongConvLookup(const char* pcToken_, const char* const* papcNames_, u8 u8Count_)
+{
+  u8 u8Index = 0;
+
+  while( (u8Index < u8Count_) && (strcmp(pcToken_, papcNames_[u8Index]) != 0) )
+  {
+    u8Index++;
+  }
+
+  return(u8Index);
+
+} /* end SongConvLookup() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvParseNote
+
+Description:
+Reads a note name.
+
+Requires:
+  -
+
+Promises:
+  - Returns the note index of pcToken_, or NOTE_INDEX_COUNT if it is not a note of the table
+*/
+static u8 SongConvParseNote(const char* pcToken_)
+{
+  char acName[SONGCONV_MAX_TOKEN];
+
+  for(u8 i = 0; i < NOTE_INDEX_COUNT; i++)
+  {
+    SongConvNoteName(i, acName);
+    if(strcmp(pcToken_, acName) == 0)
+    {
+      return(i);
+    }
+  }
+
+  return(NOTE_INDEX_COUNT);
+
+} /* end SongConvParseNote() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvCheckVoice
+
+Description:
+Validates the packed notes of one voice (see the checks above).
+
+Requires:
+  - pcSong_ names the song in the messages
+
+Promises:
+  - Prints a message for each problem to stderr
+  - Returns the total length of the voice in ms at 100% tempo, or 0 if a note is invalid
+*/
+static u32 SongConvCheckVoice(const char* pcSong_, u8 u8Voice_, const u16* pu16Notes_, u32 u32Count_)
+{
+  MusicNoteType sNote;
+  MusicNoteType sNext;
+  u32 u32Length = 0;
+  bool bValid = TRUE;
+
+  for(u32 i = 0; i < u32Count_; i++)
+  {
+    if( (pu16Notes_[i] & SONGCONV_RESERVED_MASK) ||
+        ((pu16Notes_[i] & SONG_NOTE_INDEX_MASK) >= NOTE_INDEX_COUNT) ||
+        (((pu16Notes_[i] >> SONG_NOTE_ARTICULATION_SHIFT) & SONG_NOTE_ARTICULATION_MASK) >= SONG_ARTICULATION_CODES) )
+    {
+      fprintf(stderr, "songconv: %s voice %u note %lu: 0x%04X is not a valid packed note\n", pcSong_, u8Voice_,
+              i + 1, pu16Notes_[i]);
+      bValid = FALSE;
+      continue;
+    }
+
+    MusicDecodeNote(pu16Notes_[i], &sNote);
+    u32Length += sNote.u16Length;
+
+    if(i + 1 < u32Count_)
+    {
+      MusicDecodeNote(pu16Notes_[i + 1], &sNext);
+      if( (sNote.u8NoteIndex != NOTE_INDEX_REST) && (sNote.u8NoteIndex == sNext.u8NoteIndex) &&
+          (sNote.u8Articulation == SONG_ARTICULATION_HT) )
+      {
+        fprintf(stderr, "songconv: %s voice %u note %lu: repeated note is held into the next (use RT)\n", pcSong_,
+                u8Voice_, i + 1);
+        bValid = FALSE;
+      }
+    }
+  }
+
+  return(bValid ? u32Length : 0);
+
+} /* end SongConvCheckVoice() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvCheckSong
+
+Description:
+Validates every voice of a song and their lengths.
+
+Requires:
+  -
+
+Promises:
+  - Prints one report line to SongConv_pReport and each problem to stderr
+  - Returns TRUE if the song is valid
+*/
+static bool SongConvCheckSong(const char* pcSong_, const SongType* psSong_)
+{
+  u32 au32Length[MUSIC_VOICES];
+  bool bValid = TRUE;
+
+  if(psSong_->asVoices[0].u16NoteCount == 0)
+  {
+    fprintf(stderr, "songconv: %s has no melody\n", pcSong_);
+    return(FALSE);
+  }
+
+  for(u8 i = 0; i < MUSIC_VOICES; i++)
+  {
+    au32Length[i] = SongConvCheckVoice(pcSong_, i, psSong_->asVoices[i].pu16Notes, psSong_->asVoices[i].u16NoteCount);
+    if( (psSong_->asVoices[i].u16NoteCount != 0) && (au32Length[i] == 0) )
+    {
+      bValid = FALSE;
+    }
+  }
+
+  for(u8 i = 1; bValid && (i < MUSIC_VOICES); i++)
+  {
+    if( (psSong_->asVoices[i].u16NoteCount != 0) && (au32Length[i] != au32Length[0]) )
+    {
+      fprintf(stderr, "songconv: %s voice %u is %lu ms long, the melody %lu ms\n", pcSong_, i, au32Length[i],
+              au32Length[0]);
+      bValid = FALSE;
+    }
+  }
+
+  fprintf(SongConv_pReport, "songconv: %-6s %4u + %4u notes, %6lu ms  %s\n", pcSong_,
+          psSong_->asVoices[0].u16NoteCount, psSong_->asVoices[1].u16NoteCount, au32Length[0], bValid ? "ok" : "FAIL");
+
+  return(bValid);
+
+} /* end SongConvCheckSong() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvWriteText
+
+Description:
+Writes packed notes as a text song, four notes per line.
+
+Requires:
+  - The notes are valid
+
+Promises:
+  - The notes are written to pFile_
+*/
+static void SongConvWriteText(FILE* pFile_, const u16* pu16Notes_, u32 u32Count_)
+{
+  char acName[SONGCONV_MAX_TOKEN];
+
+  for(u32 i = 0; i < u32Count_; i++)
+  {
+    SongConvNoteName((u8)(pu16Notes_[i] & SONG_NOTE_INDEX_MASK), acName);
+    fprintf(pFile_, "%s %s %s%s", acName,
+            SongConv_apcLength[(pu16Notes_[i] >> SONG_NOTE_LENGTH_SHIFT) & SONG_NOTE_LENGTH_MASK],
+            SongConv_apcArticulation[(pu16Notes_[i] >> SONG_NOTE_ARTICULATION_SHIFT) & SONG_NOTE_ARTICULATION_MASK],
+            (((i + 1) % SONGCONV_NOTES_PER_LINE) == 0) || (i + 1 == u32Count_) ? "\n" : "  ");
+  }
+
+} /* end SongConvWriteText() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvReadToken
+
+Description:
+Reads the next whitespace separated token of a text song, skipping comments.
+
+Requires:
+  - pu32Line_ counts the lines read so far
+
+Promises:
+  - Returns TRUE with the token in pcToken_ (cut at SONGCONV_MAX_TOKEN - 1 characters), FALSE at the end of the file
+*/
+static bool SongConvReadToken(FILE* pFile_, char* pcToken_, u32* pu32Line_)
+{
+  int iChar = fgetc(pFile_);
+  u8 u8Length = 0;
+
+  /* Whitespace and comments */
+  while( (iChar != EOF) && (isspace(iChar) || (iChar == '#')) )
+  {
+    if(iChar == '#')
+    {
+      while( (iChar != EOF) && (iChar != '\n') )
+      {
+        iChar = fgetc(pFile_);
+      }
+    }
+
+    if(iChar == '\n')
+    {
+      (*pu32Line_)++;
+    }
+
+    iChar = fgetc(pFile_);
+  }
+
+  while( (iChar != EOF) && !isspace(iChar) && (iChar != '#') )
+  {
+    if(u8Length < (SONGCONV_MAX_TOKEN - 1))
+    {
+      pcToken_[u8Length++] = (char)toupper(iChar);
+    }
+
+    iChar = fgetc(pFile_);
+  }
+
+  if(iChar != EOF)
+  {
+    ungetc(iChar, pFile_);
+  }
+
+  pcToken_[u8Length] = '\0';
+  return( (bool)(u8Length != 0) );
+
+} /* end SongConvReadToken() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvReadText
+
+Description:
+Reads a text song into packed notes.
+
+Requires:
+  - psVoice_ is empty (its note space is grown as needed)
+
+Promises:
+  - Prints each error to stderr with the line of the note
+  - Returns TRUE with the notes in psVoice_ if every note was read
+*/
+static bool SongConvReadText(FILE* pFile_, const char* pcFile_, SongConvVoiceType* psVoice_)
+{
+  char aacToken[3][SONGCONV_MAX_TOKEN];
+  u32 u32Line = 1;
+  u32 u32NoteLine;
+  u8 u8Note;
+  u8 u8Length;
+  u8 u8Articulation;
+
+  while( SongConvReadToken(pFile_, aacToken[0], &u32Line) )
+  {
+    u32NoteLine = u32Line;
+    if( !SongConvReadToken(pFile_, aacToken[1], &u32Line) || !SongConvReadToken(pFile_, aacToken[2], &u32Line) )
+    {
+      fprintf(stderr, "songconv: %s:%lu: %s is not followed by a length and an articulation\n", pcFile_, u32NoteLine,
+              aacToken[0]);
+      return(FALSE);
+    }
+
+    u8Note = SongConvParseNote(aacToken[0]);
+    u8Length = SongConvLookup(aacToken[1], SongConv_apcLength, SONG_LENGTH_CODES);
+    u8Articulation = SongConvLookup(aacToken[2], SongConv_apcArticulation, SONG_ARTICULATION_CODES);
+    if( (u8Note == NOTE_INDEX_COUNT) || (u8Length == SONG_LENGTH_CODES) || (u8Articulation == SONG_ARTICULATION_CODES) )
+    {
+      fprintf(stderr, "songconv: %s:%lu: %s %s %s is not a note, length and articulation\n", pcFile_, u32NoteLine,
+              aacToken[0], aacToken[1], aacToken[2]);
+      return(FALSE);
+    }
+
+    if(psVoice_->u32Count == SONGCONV_MAX_NOTES)
+    {
+      fprintf(stderr, "songconv: %s:%lu: more than %u notes\n", pcFile_, u32NoteLine, SONGCONV_MAX_NOTES);
+      return(FALSE);
+    }
+
+    if(psVoice_->u32Count == psVoice_->u32Size)
+    {
+      psVoice_->u32Size = (psVoice_->u32Size == 0) ? 256 : (2 * psVoice_->u32Size);
+      psVoice_->pu16Notes = realloc(psVoice_->pu16Notes, psVoice_->u32Size * sizeof(u16));
+      if(psVoice_->pu16Notes == NULL)
+      {
+        fprintf(stderr, "songconv: out of memory\n");
+        return(FALSE);
+      }
+    }
+
+    psVoice_->pu16Notes[psVoice_->u32Count++] = (u16)( u8Note | ((u16)u8Length << SONG_NOTE_LENGTH_SHIFT) |
+                                                       ((u16)u8Articulation << SONG_NOTE_ARTICULATION_SHIFT) );
+  }
+
+  return(TRUE);
+
+} /* end SongConvReadText() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvReadSong
+
+Description:
+Reads and validates a text song file.
+
+Requires:
+  - psVoice_ is empty
+
+Promises:
+  - Returns TRUE with the notes in psVoice_ if the file is a valid song
+*/
+static bool SongConvReadSong(const char* pcFile_, SongConvVoiceType* psVoice_)
+{
+  SongType sSong = {{{NULL, 0}, {NULL, 0}}};
+  FILE* pFile = (pcFile_ == NULL) ? stdin : fopen(pcFile_, "r");
+  bool bRead;
+
+  if(pFile == NULL)
+  {
+    fprintf(stderr, "songconv: cannot read %s\n", pcFile_);
+    return(FALSE);
+  }
+
+  bRead = SongConvReadText(pFile, (pcFile_ == NULL) ? "stdin" : pcFile_, psVoice_);
+  if(pFile != stdin)
+  {
+    fclose(pFile);
+  }
+
+  if(!bRead)
+  {
+    return(FALSE);
+  }
+
+  sSong.asVoices[0].pu16Notes = psVoice_->pu16Notes;
+  sSong.asVoices[0].u16NoteCount = (u16)psVoice_->u32Count;
+  return( SongConvCheckSong((pcFile_ == NULL) ? "stdin" : pcFile_, &sSong) );
+
+} /* end SongConvReadSong() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvValidate
+
+Description:
+Validates every table of songs.c, and checks that each voice comes back unchanged when it is written as text and
+read again.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if every table is valid and round trips
+*/
+static bool SongConvValidate(void)
+{
+  const SongVoiceType* psSongVoice;
+  SongConvVoiceType sVoice;
+  FILE* pFile;
+  bool bValid = TRUE;
+
+  for(u8 i = 0; i < (sizeof(SongConv_asSongs) / sizeof(SongConv_asSongs[0])); i++)
+  {
+    if(!SongConvCheckSong(SongConv_asSongs[i].pcName, SongConv_asSongs[i].psSong))
+    {
+      bValid = FALSE;
+      continue;
+    }
+
+    for(u8 j = 0; j < MUSIC_VOICES; j++)
+    {
+      psSongVoice = &SongConv_asSongs[i].psSong->asVoices[j];
+      memset(&sVoice, 0, sizeof(sVoice));
+      pFile = tmpfile();
+      if(pFile == NULL)
+      {
+        fprintf(stderr, "songconv: cannot open a temporary file\n");
+        return(FALSE);
+      }
+
+      SongConvWriteText(pFile, psSongVoice->pu16Notes, psSongVoice->u16NoteCount);
+      rewind(pFile);
+      if( !SongConvReadText(pFile, SongConv_asSongs[i].pcName, &sVoice) ||
+          (sVoice.u32Count != psSongVoice->u16NoteCount) ||
+          ((sVoice.u32Count != 0) &&
+           (memcmp(sVoice.pu16Notes, psSongVoice->pu16Notes, sVoice.u32Count * sizeof(u16)) != 0)) )
+      {
+        fprintf(stderr, "songconv: %s voice %u does not round trip through text\n", SongConv_asSongs[i].pcName, j);
+        bValid = FALSE;
+      }
+
+      fclose(pFile);
+      free(sVoice.pu16Notes);
+    }
+  }
+
+  return(bValid);
+
+} /* end SongConvValidate() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvWriteTable
+
+Description:
+Writes packed notes as a songs.c table of SONG_NOTE() entries.
+
+Requires:
+  - The notes are valid
+
+Promises:
+  - The table "static const u16 Songs_au16<pcName_>[]" is written to stdout
+*/
+static void SongConvWriteTable(const char* pcName_, const u16* pu16Notes_, u32 u32Count_)
+{
+  char acName[SONGCONV_MAX_TOKEN];
+  const char* pcLength;
+
+  printf("static const u16 Songs_au16%s[] =\n{\n", pcName_);
+  for(u32 i = 0; i < u32Count_; i++)
+  {
+    SongConvNoteName((u8)(pu16Notes_[i] & SONG_NOTE_INDEX_MASK), acName);
+    pcLength = SongConv_apcLength[(pu16Notes_[i] >> SONG_NOTE_LENGTH_SHIFT) & SONG_NOTE_LENGTH_MASK];
+
+    /* Dotted lengths are written as sums, e.g. HN + QN */
+    printf("%sSONG_NOTE(%s, %.2s%s%s, %s)%s", ((i % SONGCONV_NOTES_PER_LINE) == 0) ? "  " : " ", acName, pcLength,
+           (pcLength[2] == '+') ? " + " : "", (pcLength[2] == '+') ? &pcLength[3] : "",
+           SongConv_apcArticulation[(pu16Notes_[i] >> SONG_NOTE_ARTICULATION_SHIFT) & SONG_NOTE_ARTICULATION_MASK],
+           (i + 1 == u32Count_) ? "\n" : ((((i + 1) % SONGCONV_NOTES_PER_LINE) == 0) ? ",\n" : ","));
+  }
+
+  printf("};\n");
+
+} /* end SongConvWriteTable() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvPutWord
+
+Description:
+Writes a little-endian 32-bit value into a card block.
+
+Requires:
+  - pu8Data_ points to at least 4 bytes
+
+Promises:
+  - The 4 bytes hold u32Value_
+*/
+static void SongConvPutWord(u8* pu8Data_, u32 u32Value_)
+{
+  for(u8 i = 0; i < 4; i++)
+  {
+    pu8Data_[i] = (u8)(u32Value_ >> (8 * i));
+  }
+
+} /* end SongConvPutWord() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: SongConvWriteImage
+
+Description:
+Writes text songs as an SD card song library: the directory block, then each song from a new block.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if every song is valid and pcImage_ holds the library
+*/
+static bool SongConvWriteImage(const char* pcImage_, char* apcFiles_[], u16 u16Songs_)
+{
+  u8 au8Directory[SONG_STREAM_BLOCK_SIZE_BYTES] = {0};
+  u8 au8Block[SONG_STREAM_BLOCK_SIZE_BYTES];
+  SongConvVoiceType sVoice;
+  u32 u32Block = SONG_STREAM_DIRECTORY_BLOCK + 1;
+  u32 u32Offset;
+  FILE* pFile;
+  bool bValid = TRUE;
+
+  if(u16Songs_ > SONG_STREAM_DIRECTORY_MAX)
+  {
+    fprintf(stderr, "songconv: a library holds at most %u songs\n", SONG_STREAM_DIRECTORY_MAX);
+    return(FALSE);
+  }
+
+  pFile = fopen(pcImage_, "wb");
+  if(pFile == NULL)
+  {
+    fprintf(stderr, "songconv: cannot write %s\n", pcImage_);
+    return(FALSE);
+  }
+
+  SongConvPutWord(&au8Directory[0], SONG_STREAM_DIRECTORY_MAGIC);
+  au8Directory[SONG_STREAM_DIRECTORY_COUNT] = (u8)u16Songs_;
+  au8Directory[SONG_STREAM_DIRECTORY_COUNT + 1] = (u8)(u16Songs_ >> 8);
+  fseek(pFile, SONG_STREAM_BLOCK_SIZE_BYTES, SEEK_SET);
+
+  for(u16 i = 0; bValid && (i < u16Songs_); i++)
+  {
+    memset(&sVoice, 0, sizeof(sVoice));
+    if(!SongConvReadSong(apcFiles_[i], &sVoice))
+    {
+      bValid = FALSE;
+      continue;
+    }
+
+    SongConvPutWord(&au8Directory[SONG_STREAM_DIRECTORY_FIRST + (4 * i)], u32Block);
+
+    /* Header, then the notes run on through as many blocks as they need */
+    memset(au8Block, 0, sizeof(au8Block));
+    SongConvPutWord(&au8Block[0], SONG_STREAM_SONG_MAGIC);
+    au8Block[SONG_STREAM_SONG_VERSION] = SONG_STREAM_VERSION;
+    au8Block[SONG_STREAM_SONG_VOICES] = 1;
+    SongConvPutWord(&au8Block[SONG_STREAM_SONG_NOTES], sVoice.u32Count);
+    u32Offset = SONG_STREAM_HEADER_SIZE;
+
+    for(u32 j = 0; j <= sVoice.u32Count; j++)
+    {
+      if( (u32Offset == SONG_STREAM_BLOCK_SIZE_BYTES) || ((j == sVoice.u32Count) && (u32Offset != 0)) )
+      {
+        if(fwrite(au8Block, sizeof(au8Block), 1, pFile) != 1)
+        {
+          bValid = FALSE;
+        }
+
+        memset(au8Block, 0, sizeof(au8Block));
+        u32Offset = 0;
+        u32Block++;
+      }
+
+      if(j < sVoice.u32Count)
+      {
+        au8Block[u32Offset++] = (u8)sVoice.pu16Notes[j];
+        au8Block[u32Offset++] = (u8)(sVoice.pu16Notes[j] >> 8);
+      }
+    }
+
+    free(sVoice.pu16Notes);
+  }
+
+  if(bValid)
+  {
+    fseek(pFile, SONG_STREAM_DIRECTORY_BLOCK * SONG_STREAM_BLOCK_SIZE_BYTES, SEEK_SET);
+    bValid = (bool)(fwrite(au8Directory, sizeof(au8Directory), 1, pFile) == 1);
+  }
+
+  if( (fclose(pFile) != 0) || !bValid )
+  {
+    remove(pcImage_);
+    return(FALSE);
+  }
+
+  printf("songconv: %s: %u songs in %lu blocks\n", pcImage_, u16Songs_, u32Block);
+  return(TRUE);
+
+} /* end SongConvWriteImage() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs the mode given on the command line (see the usage above).
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 on success, 1 on a bad argument, an invalid song or an output error
+*/
+int main(int argc, char* argv[])
+{
+  SongConvVoiceType sVoice = {NULL, 0, 0};
+  const SongType* psSong;
+
+  SongConv_pReport = stdout;
+  if( (argc == 2) && (strcmp(argv[1], "-v") == 0) )
+  {
+    return(SongConvValidate() ? 0 : 1);
+  }
+
+  if( (argc == 3) && (strcmp(argv[1], "-t") == 0) )
+  {
+    for(u8 i = 0; i < (sizeof(SongConv_asSongs) / sizeof(SongConv_asSongs[0])); i++)
+    {
+      if(strcmp(argv[2], SongConv_asSongs[i].pcName) == 0)
+      {
+        psSong = SongConv_asSongs[i].psSong;
+        printf("# %s: the melody (voice 0)\n", argv[2]);
+        SongConvWriteText(stdout, psSong->asVoices[0].pu16Notes, psSong->asVoices[0].u16NoteCount);
+        return(0);
+      }
+    }
+
+    fprintf(stderr, "songconv: unknown song %s\n", argv[2]);
+    return(1);
+  }
+
+  if( ((argc == 3) || (argc == 4)) && (strcmp(argv[1], "-c") == 0) )
+  {
+    /* The report line of the check goes to stderr so stdout is only the table */
+    SongConv_pReport = stderr;
+    if( !SongConvReadSong((argc == 4) ? argv[3] : NULL, &sVoice) )
+    {
+      return(1);
+    }
+
+    SongConvWriteTable(argv[2], sVoice.pu16Notes, sVoice.u32Count);
+    return(0);
+  }
+
+  if( (argc >= 4) && (strcmp(argv[1], "-i") == 0) )
+  {
+    return(SongConvWriteImage(argv[2], &argv[3], (u16)(argc - 3)) ? 0 : 1);
+  }
+
+  fprintf(stderr, "usage: songconv -v | -t song | -c name [file] | -i image file...\n");
+  return(1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,506 @@
+/**********************************************************************************************************************
+File: stream.c
+
+Description:
+SD card song streaming test.  The music player and songstream.c play songs from a card image (sdimage.c) built by
+the test, with G_SongStreamStateMachine and G_MusicStateMachine run from the main loop of the register model:
+- a song streamed from the card must sound exactly as the same notes played from a table in flash (every buzzer PWM
+  change, timed from the first note), both for a one-block song and for a song whose notes end exactly on the second
+  block boundary, read while it plays;
+- an empty song ends without a sound;
+- a bad song header, a song index past the directory, a song past the end of the card and a card slower than
+  SONG_STREAM_READ_TIMEOUT_MS set _SONG_STREAM_ERROR and end the song without a sound;
+- SongStreamPlay() returns FALSE with no card set and with no card in the slot.
+
+Card image layout (see songstream.h):
+    block 0  directory of STREAM_SONGS songs
+    block 1  "Mary had a little lamb" (melody)
+    block 2  STREAM_LONG_NOTES generated notes, ending exactly at the end of block 3
+    block 4  an empty song
+    block 5  a song with a bad magic
+    (song 4 points past the end of the image)
+
+Usage: stream [image file]    (default out/stream.img)
+Returns 0 if every case passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../application/music.c"
+#include "../../application/songs.c"
+#include "../../application/songstream.c"
+
+#include <stdio.h>
+#include "sam3u_model.h"
+#include "sdimage.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define STREAM_IMAGE_BLOCKS       (u32)6               /* Blocks in the card image */
+#define STREAM_SONGS              (u16)5               /* Songs in the directory */
+#define STREAM_SONG_MARY          (u16)0
+#define STREAM_SONG_LONG          (u16)1
+#define STREAM_SONG_EMPTY         (u16)2
+#define STREAM_SONG_BAD_MAGIC     (u16)3
+#define STREAM_SONG_PAST_END      (u16)4
+
+/* Notes that fill the header block and one more block exactly */
+#define STREAM_LONG_NOTES         (u16)( ((2 * SONG_STREAM_BLOCK_SIZE_BYTES) - SONG_STREAM_HEADER_SIZE) / 2 )
+
+#define STREAM_IMAGE              "out/stream.img"     /* Default card image file */
+#define STREAM_READ_TIME_MS       (u32)20              /* Card block read time */
+#define STREAM_TIMEOUT_MS         (u32)120000          /* Longest song run */
+#define STREAM_MAX_EVENTS         (u32)32768           /* Buzzer PWM changes recorded per run */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Stream_" and be declared as static.
+***********************************************************************************************************************/
+static const SongStreamCardType Stream_sCard = {SdGetStatus, SdReadBlock, SdGetReadData}; /* The card image */
+
+static const char* Stream_pcImage;                   /* Card image file */
+static u8 Stream_au8Image[STREAM_IMAGE_BLOCKS][SONG_STREAM_BLOCK_SIZE_BYTES]; /* Card image contents */
+static u16 Stream_au16LongNotes[STREAM_LONG_NOTES];  /* Notes of the generated song */
+
+static ModelPwmEventType Stream_asEvents[2][STREAM_MAX_EVENTS]; /* Buzzer changes of a streamed and a table run */
+static u32 Stream_au32Events[2];                     /* Changes recorded in each run */
+static u8 Stream_u8Run;                              /* Run being recorded */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamPutWord
+
+Description:
+Writes a little-endian 32-bit value into the card image.
+
+Requires:
+  - pu8Data_ points to at least 4 bytes
+
+Promises:
+  - The 4 bytes hold u32Value_
+*/
+static void StreamPutWord(u8* pu8Data_, u32 u32Value_)
+{
+  for(u8 i = 0; i < 4; i++)
+  {
+    pu8Data_[i] = (u8)(u32Value_ >> (8 * i));
+  }
+
+} /* end StreamPutWord() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamPutSong
+
+Description:
+Writes a song header and its notes into the card image from a block on.
+
+Requires:
+  - The notes fit in the image from u32Block_ on
+
+Promises:
+  - The song starts at block u32Block_ with u32Magic_ as its magic
+*/
+static void StreamPutSong(u32 u32Block_, u32 u32Magic_, const u16* pu16Notes_, u16 u16Notes_)
+{
+  u8* pu8Song = &Stream_au8Image[u32Block_][0];
+  u32 u32Offset = SONG_STREAM_HEADER_SIZE;
+
+  StreamPutWord(&pu8Song[0], u32Magic_);
+  pu8Song[SONG_STREAM_SONG_VERSION] = SONG_STREAM_VERSION;
+  pu8Song[SONG_STREAM_SONG_VOICES] = 1;
+  StreamPutWord(&pu8Song[SONG_STREAM_SONG_NOTES], u16Notes_);
+
+  /* The notes run on into the following blocks */
+  for(u16 i = 0; i < u16Notes_; i++)
+  {
+    pu8Song[u32Offset++] = (u8)pu16Notes_[i];
+    pu8Song[u32Offset++] = (u8)(pu16Notes_[i] >> 8);
+  }
+
+} /* end StreamPutSong() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamMakeImage
+
+Description:
+Builds the card image (see the layout above) and writes it to a file.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if pcPath_ holds the image
+*/
+static bool StreamMakeImage(const char* pcPath_)
+{
+  static const u32 au32First[STREAM_SONGS] = {1, 2, 4, 5, STREAM_IMAGE_BLOCKS + 10};
+  u8* pu8Directory = &Stream_au8Image[SONG_STREAM_DIRECTORY_BLOCK][0];
+  FILE* pFile;
+  bool bWritten;
+
+  /* Every note length and articulation, with a rest now and then */
+  for(u16 i = 0; i < STREAM_LONG_NOTES; i++)
+  {
+    Stream_au16LongNotes[i] = (u16)( (((i % 7) == 6) ? NOTE_INDEX_REST : (NOTE_INDEX_C3 + ((i * 5) % 37))) |
+                                     ((i % 2) << SONG_NOTE_LENGTH_SHIFT) |
+                                     (((i / 2) % SONG_ARTICULATION_CODES) << SONG_NOTE_ARTICULATION_SHIFT) );
+  }
+
+  memset(Stream_au8Image, 0, sizeof(Stream_au8Image));
+  StreamPutWord(&pu8Directory[0], SONG_STREAM_DIRECTORY_MAGIC);
+  pu8Directory[SONG_STREAM_DIRECTORY_COUNT] = (u8)STREAM_SONGS;
+  for(u16 i = 0; i < STREAM_SONGS; i++)
+  {
+    StreamPutWord(&pu8Directory[SONG_STREAM_DIRECTORY_FIRST + (4 * i)], au32First[i]);
+  }
+
+  StreamPutSong(au32First[STREAM_SONG_MARY], SONG_STREAM_SONG_MAGIC, Songs_au16MaryHadALittleLamb,
+                sizeof(Songs_au16MaryHadALittleLamb) / sizeof(Songs_au16MaryHadALittleLamb[0]));
+  StreamPutSong(au32First[STREAM_SONG_LONG], SONG_STREAM_SONG_MAGIC, Stream_au16LongNotes, STREAM_LONG_NOTES);
+  StreamPutSong(au32First[STREAM_SONG_EMPTY], SONG_STREAM_SONG_MAGIC, NULL, 0);
+  StreamPutSong(au32First[STREAM_SONG_BAD_MAGIC], SONG_STREAM_DIRECTORY_MAGIC, Songs_au16MaryHadALittleLamb, 4);
+
+  pFile = fopen(pcPath_, "wb");
+  if(pFile == NULL)
+  {
+    return(FALSE);
+  }
+
+  bWritten = (bool)(fwrite(Stream_au8Image, sizeof(Stream_au8Image), 1, pFile) == 1);
+  return( (bool)((fclose(pFile) == 0) && bWritten) );
+
+} /* end StreamMakeImage() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamPwmLog
+
+Description:
+Records every buzzer PWM change of the current run.
+
+Requires:
+  -
+
+Promises:
+  - The change is appended to the events of Stream_u8Run
+*/
+static void StreamPwmLog(const ModelPwmEventType* psEvent_)
+{
+  if(Stream_au32Events[Stream_u8Run] < STREAM_MAX_EVENTS)
+  {
+    Stream_asEvents[Stream_u8Run][Stream_au32Events[Stream_u8Run]++] = *psEvent_;
+  }
+
+} /* end StreamPwmLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamLoop
+
+Description:
+Main loop pass of the test: the streamer and the player.
+
+Requires:
+  -
+
+Promises:
+  - G_SongStreamStateMachine() and G_MusicStateMachine() have run once
+*/
+static void StreamLoop(void)
+{
+  G_SongStreamStateMachine();
+  G_MusicStateMachine();
+
+} /* end StreamLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamBegin
+
+Description:
+Starts a run: fresh model, player and streamer, with the card image in the slot.
+
+Requires:
+  - u8Run_ is 0 (streamed) or 1 (table)
+
+Promises:
+  - Returns TRUE if the model is up; PWM changes are recorded for run u8Run_
+*/
+static bool StreamBegin(u8 u8Run_, u8 u8TempoStep_)
+{
+  if(!ModelInitialize())
+  {
+    printf("stream: cannot map the peripheral space\n");
+    return(FALSE);
+  }
+
+  Stream_u8Run = u8Run_;
+  Stream_au32Events[u8Run_] = 0;
+  ModelSetPwmLog(StreamPwmLog);
+
+  PWMSetupAudio();
+  MusicInitialize();
+  MusicSetTempo(u8TempoStep_);
+  SongStreamInitialize();
+  SongStreamSetCard(&Stream_sCard);
+
+  return(TRUE);
+
+} /* end StreamBegin() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamPlay
+
+Description:
+Runs the main loop until the song and the streamer are both done.
+
+Requires:
+  - A song was started
+
+Promises:
+  - Returns TRUE if both ended within STREAM_TIMEOUT_MS
+*/
+static bool StreamPlay(void)
+{
+  for(u32 i = 0; i < STREAM_TIMEOUT_MS; i++)
+  {
+    if( !(G_u32MusicFlags & _MUSIC_PLAYING) && !(G_u32SongStreamFlags & _SONG_STREAM_PLAYING) )
+    {
+      return(TRUE);
+    }
+
+    ModelRun(1, StreamLoop);
+  }
+
+  return(FALSE);
+
+} /* end StreamPlay() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamFirstSound
+
+Description:
+Finds the first PWM change of a run that turned a buzzer on.
+
+Requires:
+  -
+
+Promises:
+  - Returns the index of the change in the events of run u8Run_, or the number of events if the run was silent
+*/
+static u32 StreamFirstSound(u8 u8Run_)
+{
+  u32 u32Index = 0;
+
+  while( (u32Index < Stream_au32Events[u8Run_]) && !Stream_asEvents[u8Run_][u32Index].bEnabled )
+  {
+    u32Index++;
+  }
+
+  return(u32Index);
+
+} /* end StreamFirstSound() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamCompare
+
+Description:
+Plays a song from the card and the same notes from a table, and compares the buzzer output.
+
+Requires:
+  - The card image is in the slot
+
+Promises:
+  - Prints one report line
+  - Returns TRUE if both runs ended without a streaming error and made the same PWM changes at the same times from
+    their first note, and the card was read u32Reads_ times
+*/
+static bool StreamCompare(const char* pcName_, u16 u16Song_, const u16* pu16Notes_, u16 u16Notes_, u8 u8TempoStep_,
+                          u32 u32Reads_)
+{
+  SongType sSong = {{{pu16Notes_, u16Notes_}, {NULL, 0}}};
+  const ModelPwmEventType* psStream;
+  const ModelPwmEventType* psTable;
+  u32 u32Reads;
+  u32 u32First;
+  u32 u32Mismatch = 0;
+  bool bPass = TRUE;
+
+  if( !StreamBegin(0, u8TempoStep_) || !SdImageOpen(Stream_pcImage) || !SongStreamPlay(u16Song_) || !StreamPlay() )
+  {
+    printf("stream: %-10s FAIL - the streamed song did not play to its end\n", pcName_);
+    return(FALSE);
+  }
+
+  u32Reads = SdImageGetReads();
+  if( (G_u32SongStreamFlags & _SONG_STREAM_ERROR) || (u32Reads != u32Reads_) )
+  {
+    bPass = FALSE;
+  }
+
+  if( !StreamBegin(1, u8TempoStep_) || !MusicStart(&sSong) || !StreamPlay() )
+  {
+    printf("stream: %-10s FAIL - the table song did not play to its end\n", pcName_);
+    return(FALSE);
+  }
+
+  /* The buzzers are switched off the same way before both songs: compare from the first note on */
+  u32First = StreamFirstSound(0);
+  if( (Stream_au32Events[0] != Stream_au32Events[1]) || (u32First != StreamFirstSound(1)) ||
+      (u32First == Stream_au32Events[0]) || (Stream_au32Events[0] == STREAM_MAX_EVENTS) )
+  {
+    bPass = FALSE;
+  }
+
+  for(u32 i = u32First; bPass && (i < Stream_au32Events[0]); i++)
+  {
+    psStream = &Stream_asEvents[0][i];
+    psTable = &Stream_asEvents[1][i];
+    if( ((psStream->u64TimeNs - Stream_asEvents[0][u32First].u64TimeNs) !=
+         (psTable->u64TimeNs - Stream_asEvents[1][u32First].u64TimeNs)) ||
+        (psStream->u8Channel != psTable->u8Channel) || (psStream->u16Period != psTable->u16Period) ||
+        (psStream->u16Duty != psTable->u16Duty) || (psStream->bEnabled != psTable->bEnabled) )
+    {
+      u32Mismatch++;
+    }
+  }
+
+  if(u32Mismatch != 0)
+  {
+    bPass = FALSE;
+  }
+
+  printf("stream: %-10s %4u notes, %lu blocks read, %5lu PWM changes (table %5lu), %lu differ  %s\n", pcName_,
+         u16Notes_, u32Reads, Stream_au32Events[0], Stream_au32Events[1], u32Mismatch, bPass ? "ok" : "FAIL");
+
+  return(bPass);
+
+} /* end StreamCompare() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: StreamSilentSong
+
+Description:
+Plays a song from the card that must end without a sound.
+
+Requires:
+  - The card image is in the slot
+
+Promises:
+  - Prints one report line
+  - Returns TRUE if the song ended silently with _SONG_STREAM_ERROR as bError_
+*/
+static bool StreamSilentSong(const char* pcName_, u16 u16Song_, u32 u32ReadTime_, bool bError_)
+{
+  bool bPass = TRUE;
+
+  if( !StreamBegin(0, MUSIC_TEMPO_DEFAULT) || !SdImageOpen(Stream_pcImage) )
+  {
+    return(FALSE);
+  }
+
+  SdImageSetReadTime(u32ReadTime_);
+  if( !SongStreamPlay(u16Song_) || !StreamPlay() || (StreamFirstSound(0) != Stream_au32Events[0]) ||
+      ((bool)((G_u32SongStreamFlags & _SONG_STREAM_ERROR) != 0) != bError_) )
+  {
+    bPass = FALSE;
+  }
+
+  printf("stream: %-10s %s, %s  %s\n", pcName_, (G_u32MusicFlags & _MUSIC_PLAYING) ? "playing" : "ended",
+         (G_u32SongStreamFlags & _SONG_STREAM_ERROR) ? "error" : "no error", bPass ? "ok" : "FAIL");
+
+  SdImageSetReadTime(STREAM_READ_TIME_MS);
+  return(bPass);
+
+} /* end StreamSilentSong() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Builds the card image and runs every case.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every case passed
+*/
+int main(int argc, char* argv[])
+{
+  bool bPass = TRUE;
+
+  Stream_pcImage = (argc > 1) ? argv[1] : STREAM_IMAGE;
+  if(!StreamMakeImage(Stream_pcImage))
+  {
+    printf("stream: cannot write %s\n", Stream_pcImage);
+    return(1);
+  }
+
+  SdImageSetReadTime(STREAM_READ_TIME_MS);
+
+  /* No card set, then a card set with nothing in the slot */
+  if(!StreamBegin(0, MUSIC_TEMPO_DEFAULT))
+  {
+    return(1);
+  }
+
+  SongStreamSetCard(NULL);
+  if(SongStreamPlay(STREAM_SONG_MARY))
+  {
+    printf("stream: no card set: SongStreamPlay() returned TRUE  FAIL\n");
+    bPass = FALSE;
+  }
+
+  SongStreamSetCard(&Stream_sCard);
+  SdImageClose();
+  if(SongStreamPlay(STREAM_SONG_MARY))
+  {
+    printf("stream: no card: SongStreamPlay() returned TRUE  FAIL\n");
+    bPass = FALSE;
+  }
+
+  /* The directory and the song blocks */
+  if( !StreamCompare("mary", STREAM_SONG_MARY, Songs_au16MaryHadALittleLamb,
+                     sizeof(Songs_au16MaryHadALittleLamb) / sizeof(Songs_au16MaryHadALittleLamb[0]),
+                     MUSIC_TEMPO_DEFAULT, 2) )
+  {
+    bPass = FALSE;
+  }
+
+  if( !StreamCompare("long", STREAM_SONG_LONG, Stream_au16LongNotes, STREAM_LONG_NOTES, MUSIC_TEMPO_STEPS - 1, 3) )
+  {
+    bPass = FALSE;
+  }
+
+  /* Songs that must end without a sound: empty, then the failures */
+  if( !StreamSilentSong("empty", STREAM_SONG_EMPTY, STREAM_READ_TIME_MS, FALSE) ||
+      !StreamSilentSong("bad magic", STREAM_SONG_BAD_MAGIC, STREAM_READ_TIME_MS, TRUE) ||
+      !StreamSilentSong("no song", STREAM_SONGS, STREAM_READ_TIME_MS, TRUE) ||
+      !StreamSilentSong("past end", STREAM_SONG_PAST_END, STREAM_READ_TIME_MS, TRUE) ||
+      !StreamSilentSong("slow card", STREAM_SONG_MARY, SONG_STREAM_READ_TIMEOUT_MS + 500, TRUE) )
+  {
+    bPass = FALSE;
+  }
+
+  SdImageClose();
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
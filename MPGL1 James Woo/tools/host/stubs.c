@@ -0,0 +1,86 @@
+/**********************************************************************************************************************
+File: stubs.c
+
+Description:
+Host stand-ins for the drivers the music player calls but the music tests do not model: the LED driver and the debug
+UART.  Tests that link the real drivers (e.g. the main loop latency test) do not link this file.
+**********************************************************************************************************************/
+
+#include "configuration.h"
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "Stubs_" and be declared as static.
+***********************************************************************************************************************/
+static u32 Stubs_u32Leds;                              /* Bit per LED that is on */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* Public functions                                                                                                   */
+/*--------------------------------------------------------------------------------------------------------------------*/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LedOn
+
+Description:
+Records an LED as on.
+
+Requires:
+  -
+
+Promises:
+  - The LED bit is set
+*/
+void LedOn(LedNumberType eLED_)
+{
+  Stubs_u32Leds |= (1UL << eLED_);
+
+} /* end LedOn() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: LedOff
+
+Description:
+Records an LED as off.
+
+Requires:
+  -
+
+Promises:
+  - The LED bit is cleared
+*/
+void LedOff(LedNumberType eLED_)
+{
+  Stubs_u32Leds &= ~(1UL << eLED_);
+
+} /* end LedOff() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: Uart_putc
+
+Description:
+Accepts a debug character and drops it.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE (the character is always taken)
+*/
+bool Uart_putc(u8 u8Char_)
+{
+  (void)u8Char_;
+  return(TRUE);
+
+} /* end Uart_putc() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
@@ -0,0 +1,571 @@
+/**********************************************************************************************************************
+File: uartrx.c
+
+Description:
+USART0 receive test.  Bursts are fed to the receive line of the register model's USART0 while the UART driver and the
+messaging task run from its main loop.  Each main loop pass reads everything new from both receive paths: Uart_getc()
+and the application receive buffer given to UartRequest().  The test fails if:
+- a burst at 115200 or 921600 baud does not reach both paths whole and in order, or the driver reports a lost byte;
+- random bursts at 115200 baud, some with idle time between their characters, lose a byte;
+- a burst at 921600 baud loses a byte when the USART0 handler runs UARTRX_LATE_US late;
+- a character typed at 38400 baud (the debug rate) is not in the Uart_getc() buffer within the receiver time-out
+  (DEBUG_US_RTOR_INIT bit periods) and UARTRX_TYPED_SLACK_NS of its stop bit;
+- with nobody calling Uart_getc(), the buffer does not keep the first bytes that fit and set _UART_RX_BUFFER_OVERRUN.
+
+The firmware USART0_IrqHandler() is renamed so the test can wrap it and note when a typed character is delivered.
+
+Usage: uartrx
+Returns 0 if every case passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#define USART0_IrqHandler UartRxFirmwareIrqHandler
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../drivers/messaging.c"
+#include "../../bsp/sam3u_uart.c"
+
+#undef USART0_IrqHandler
+
+#include <stdio.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define UARTRX_BURST_SIZE         (u32)5000            /* Characters of the single burst cases */
+#define UARTRX_MAX_CHARS          (u32)40000           /* Characters kept per receive path */
+#define UARTRX_APP_BUFFER_SIZE    (u32)256             /* Application receive buffer given to UartRequest() */
+#define UARTRX_DRAIN_MS           (u32)5               /* Run after the line goes idle for the time-out to flush */
+
+#define UARTRX_BRGR_38400         (u32)0x0001004E      /* CD 78, FP 1 (the debug rate) */
+#define UARTRX_BRGR_115200        (u32)0x0000001A      /* CD 26: 115385 baud */
+#define UARTRX_BRGR_921600        (u32)0x00020003      /* CD 3, FP 2: 923077 baud */
+
+#define UARTRX_RANDOM_BURSTS      (u32)300             /* Bursts of the random case */
+#define UARTRX_RANDOM_MAX_SIZE    (u32)150             /* Largest random burst */
+#define UARTRX_RANDOM_MAX_IDLE_MS (u32)4               /* Longest idle time after a random burst */
+#define UARTRX_RANDOM_SEED        (u32)24
+
+#define UARTRX_LATE_US            (u32)600             /* Handler latency of the late handler case */
+
+#define UARTRX_TYPED_CHARS        (u8)20               /* Characters of the typed case */
+#define UARTRX_TYPED_PERIOD_MS    (u32)50              /* Time between typed characters */
+#define UARTRX_TYPED_SLACK_NS     (u64)10000           /* Allowed on top of the time-out: model ticks */
+
+#define UARTRX_UNREAD_SIZE        (u32)400             /* Characters sent with nobody reading */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/* New variables (from main.c, which the test does not link) */
+volatile u32 G_u32SystemFlags;                         /* Global system flags */
+volatile u32 G_u32ApplicationFlags;                    /* Global applications flags */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "UartRx_" and be declared as static.
+***********************************************************************************************************************/
+static u8 UartRx_au8Data[UARTRX_MAX_CHARS];            /* Characters sent on the line */
+static u32 UartRx_u32Sent;                             /* Characters sent on the line */
+static u8 UartRx_au8Getc[UARTRX_MAX_CHARS];            /* Characters read with Uart_getc() */
+static u32 UartRx_u32Getc;                             /* Characters read with Uart_getc() */
+static u8 UartRx_au8App[UARTRX_MAX_CHARS];             /* Characters read from the application receive buffer */
+static u32 UartRx_u32App;                              /* Characters read from the application receive buffer */
+static bool UartRx_bReading;                           /* The main loop pass reads Uart_getc() */
+
+static u8 UartRx_au8AppBuffer[UARTRX_APP_BUFFER_SIZE]; /* Application receive buffer */
+static u8* UartRx_pu8AppNext;                          /* Next byte the driver writes in the application buffer */
+static u8* UartRx_pu8AppParser;                        /* Next byte the test reads from the application buffer */
+
+static u64 UartRx_u64Delivered;                        /* Model time the Uart_getc() buffer last went from empty */
+static u32 UartRx_u32Latency;                          /* USART0 handler latency in ticks */
+static u32 UartRx_u32Seed;                             /* Random generator state */
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: USART0_IrqHandler
+
+Description:
+The USART0 handler the model calls: the firmware handler, noting when it makes the Uart_getc() buffer non-empty.
+
+Requires:
+  -
+
+Promises:
+  - UartRxFirmwareIrqHandler() has run
+  - UartRx_u64Delivered is the model time if the Uart_getc() buffer was empty before it and is not after
+*/
+void USART0_IrqHandler(void)
+{
+  bool bEmpty = !UartCheckForNewChar();
+
+  UartRxFirmwareIrqHandler();
+  if(bEmpty && UartCheckForNewChar())
+  {
+    UartRx_u64Delivered = ModelTimeNs();
+  }
+
+} /* end USART0_IrqHandler() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxRandom
+
+Description:
+Repeatable random numbers for the random case.
+
+Requires:
+  - u32Limit_ > 0
+
+Promises:
+  - Returns 0 - (u32Limit_ - 1)
+*/
+static u32 UartRxRandom(u32 u32Limit_)
+{
+  UartRx_u32Seed = (UartRx_u32Seed * 1103515245UL) + 12345UL;
+  return( ((UartRx_u32Seed >> 16) & 0x7FFF) % u32Limit_ );
+
+} /* end UartRxRandom() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxLatency
+
+Description:
+USART0 handler latency for the model (ModelLatencyType).
+
+Requires:
+  -
+
+Promises:
+  - Returns UartRx_u32Latency ticks
+*/
+static u32 UartRxLatency(void)
+{
+  return(UartRx_u32Latency);
+
+} /* end UartRxLatency() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxLoop
+
+Description:
+The main loop passes of the tasks under test, and the readers of both receive paths.
+
+Requires:
+  - The messaging task and the UART driver are initialized and USART0 is requested
+
+Promises:
+  - Both state machines have run once
+  - Everything new in the application buffer is appended to UartRx_au8App, and with UartRx_bReading everything in
+    the Uart_getc() buffer to UartRx_au8Getc
+*/
+static void UartRxLoop(void)
+{
+  G_MessagingStateMachine();
+  G_UartStateMachine();
+
+  while(UartRx_bReading && UartCheckForNewChar())
+  {
+    UartRx_au8Getc[UartRx_u32Getc % UARTRX_MAX_CHARS] = Uart_getc();
+    UartRx_u32Getc++;
+  }
+
+  while(UartRx_pu8AppParser != UartRx_pu8AppNext)
+  {
+    UartRx_au8App[UartRx_u32App % UARTRX_MAX_CHARS] = *UartRx_pu8AppParser;
+    UartRx_u32App++;
+    UartRx_pu8AppParser++;
+    if(UartRx_pu8AppParser == &UartRx_au8AppBuffer[UARTRX_APP_BUFFER_SIZE])
+    {
+      UartRx_pu8AppParser = &UartRx_au8AppBuffer[0];
+    }
+  }
+
+} /* end UartRxLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxBegin
+
+Description:
+Starts a case: resets the model, initializes the messaging task and the UART driver, lets the startup message go out,
+requests USART0 with the application buffer and sets the baud rate.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE with USART0 receiving at u32Brgr_, both readers on and nothing recorded
+*/
+static bool UartRxBegin(u32 u32Brgr_)
+{
+  UartConfigurationType sConfig = {USART0, UartRx_au8AppBuffer, UARTRX_APP_BUFFER_SIZE, &UartRx_pu8AppNext};
+
+  if(!ModelInitialize())
+  {
+    printf("uartrx: cannot map the peripheral space\n");
+    return(FALSE);
+  }
+
+  memset(&UART_Peripheral0, 0, sizeof(UART_Peripheral0));
+  UartRx_pu8AppNext = UartRx_au8AppBuffer;
+  UartRx_pu8AppParser = UartRx_au8AppBuffer;
+  MessagingInitialize();
+  UartInitialize();
+  ModelRun(100, NULL);
+  if(UartRequest(&sConfig) == NULL)
+  {
+    printf("uartrx: USART0 cannot be requested\n");
+    return(FALSE);
+  }
+  AT91C_BASE_US0->US_BRGR = u32Brgr_;
+  ModelRun(10, UartRxLoop);
+
+  UartRx_u32Sent = 0;
+  UartRx_u32Getc = 0;
+  UartRx_u32App = 0;
+  UartRx_bReading = TRUE;
+  UartRx_u32Latency = 0;
+  ModelSetUartLatency(UartRxLatency);
+  ModelClearStats();
+  return(TRUE);
+
+} /* end UartRxBegin() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxSend
+
+Description:
+Queues characters on the receive line and records them.
+
+Requires:
+  - UartRx_u32Sent + u32Size_ <= UARTRX_MAX_CHARS
+
+Promises:
+  - Returns TRUE if the model queued the characters
+*/
+static bool UartRxSend(const u8* pu8Data_, u32 u32Size_, u64 u64GapNs_)
+{
+  if(!ModelUartReceive(pu8Data_, u32Size_, u64GapNs_))
+  {
+    return(FALSE);
+  }
+
+  memcpy(&UartRx_au8Data[UartRx_u32Sent], pu8Data_, u32Size_);
+  UartRx_u32Sent += u32Size_;
+  return(TRUE);
+
+} /* end UartRxSend() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxRunIdle
+
+Description:
+Runs the main loop until the receive line has been idle for u32Ms_.
+
+Requires:
+  -
+
+Promises:
+  - Model time is at least u32Ms_ after the end of the last character queued
+*/
+static void UartRxRunIdle(u32 u32Ms_)
+{
+  while(ModelTimeNs() < ModelUartReceiveEndNs())
+  {
+    ModelRun(1, UartRxLoop);
+  }
+  ModelRun(u32Ms_, UartRxLoop);
+
+} /* end UartRxRunIdle() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxCheck
+
+Description:
+Compares both receive paths with the characters sent and reports the case.
+
+Requires:
+  - The line has been idle for the receiver time-out since the last character
+
+Promises:
+  - Returns TRUE if both paths received every character in order and no loss was reported
+*/
+static bool UartRxCheck(const char* pcCase_)
+{
+  ModelStatsType sStats;
+  bool bPass = TRUE;
+
+  ModelGetStats(&sStats);
+  if( (UartRx_u32Getc != UartRx_u32Sent) || (memcmp(UartRx_au8Getc, UartRx_au8Data, UartRx_u32Sent) != 0) )
+  {
+    printf("uartrx: %s: Uart_getc() read %lu of %lu characters, or out of order  FAIL\n", pcCase_, UartRx_u32Getc,
+           UartRx_u32Sent);
+    bPass = FALSE;
+  }
+
+  if( (UartRx_u32App != UartRx_u32Sent) || (memcmp(UartRx_au8App, UartRx_au8Data, UartRx_u32Sent) != 0) )
+  {
+    printf("uartrx: %s: the application buffer got %lu of %lu characters, or out of order  FAIL\n", pcCase_,
+           UartRx_u32App, UartRx_u32Sent);
+    bPass = FALSE;
+  }
+
+  if( (UART_Peripheral0.u32Flags & _UART_RX_BUFFER_OVERRUN) || (AT91C_BASE_US0->US_CSR & AT91C_US_OVRE) )
+  {
+    printf("uartrx: %s: the driver reported lost characters  FAIL\n", pcCase_);
+    bPass = FALSE;
+  }
+
+  printf("uartrx: %-14s %5lu chars at %6llu baud: %3lu interrupts (%.3f per char)  %s\n", pcCase_, UartRx_u32Sent,
+         (10 * 1000000000ULL) / ModelUartCharNs(), sStats.u32UartIsrCalls,
+         (double)sStats.u32UartIsrCalls / UartRx_u32Sent, bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartRxCheck() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxBurst
+
+Description:
+One burst of UARTRX_BURST_SIZE characters with no idle time, with the handler u32LateUs_ late.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if both paths received the burst whole
+*/
+static bool UartRxBurst(const char* pcCase_, u32 u32Brgr_, u32 u32LateUs_)
+{
+  if(!UartRxBegin(u32Brgr_))
+  {
+    return(FALSE);
+  }
+
+  UartRx_u32Latency = (u32LateUs_ * MODEL_TICKS_PER_MS) / 1000;
+  for(u32 i = 0; i < UARTRX_BURST_SIZE; i++)
+  {
+    UartRx_au8Data[i] = (u8)((i * 7) + (i / 256));
+  }
+
+  if(!UartRxSend(UartRx_au8Data, UARTRX_BURST_SIZE, 0))
+  {
+    return(FALSE);
+  }
+
+  UartRxRunIdle(UARTRX_DRAIN_MS);
+  return( UartRxCheck(pcCase_) );
+
+} /* end UartRxBurst() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxRandomBursts
+
+Description:
+UARTRX_RANDOM_BURSTS bursts of random sizes at 115200 baud.  A third of them have an idle time of up to three
+characters before each character, so the receiver time-out expires inside some bursts, and the line is idle for a
+random time after each burst.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if both paths received every burst whole
+*/
+static bool UartRxRandomBursts(void)
+{
+  u8 au8Burst[UARTRX_RANDOM_MAX_SIZE];
+  u32 u32Size;
+  u64 u64GapNs;
+
+  if(!UartRxBegin(UARTRX_BRGR_115200))
+  {
+    return(FALSE);
+  }
+
+  UartRx_u32Seed = UARTRX_RANDOM_SEED;
+  for(u32 i = 0; i < UARTRX_RANDOM_BURSTS; i++)
+  {
+    u32Size = 1 + UartRxRandom(UARTRX_RANDOM_MAX_SIZE);
+    for(u32 j = 0; j < u32Size; j++)
+    {
+      au8Burst[j] = (u8)UartRxRandom(256);
+    }
+
+    u64GapNs = (UartRxRandom(3) == 0) ? ((ModelUartCharNs() * UartRxRandom(31)) / 10) : 0;
+    if(!UartRxSend(au8Burst, u32Size, u64GapNs))
+    {
+      return(FALSE);
+    }
+
+    UartRxRunIdle(UartRxRandom(UARTRX_RANDOM_MAX_IDLE_MS + 1));
+  }
+
+  UartRxRunIdle(UARTRX_DRAIN_MS);
+  return( UartRxCheck("random bursts") );
+
+} /* end UartRxRandomBursts() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxTyped
+
+Description:
+Characters typed one at a time at the debug rate: measures how long after its stop bit each one reaches the Uart_getc()
+buffer.  Only the receiver time-out delivers a lone character.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if every character arrived in order within the time-out and UARTRX_TYPED_SLACK_NS
+*/
+static bool UartRxTyped(void)
+{
+  u64 u64TimeoutNs;
+  u64 u64End;
+  u64 u64Delay;
+  u64 u64MaxDelay = 0;
+  bool bPass = TRUE;
+  u8 u8Char;
+
+  if(!UartRxBegin(UARTRX_BRGR_38400))
+  {
+    return(FALSE);
+  }
+
+  u64TimeoutNs = (ModelUartCharNs() * DEBUG_US_RTOR_INIT) / 10;
+  for(u8 i = 0; i < UARTRX_TYPED_CHARS; i++)
+  {
+    u8Char = (u8)('a' + i);
+    UartRx_u64Delivered = 0;
+    if(!UartRxSend(&u8Char, 1, 0))
+    {
+      return(FALSE);
+    }
+    u64End = ModelUartReceiveEndNs();
+
+    /* The reader only runs after the delivery is noted */
+    UartRx_bReading = FALSE;
+    UartRxRunIdle(2);
+    UartRx_bReading = TRUE;
+    ModelRun(UARTRX_TYPED_PERIOD_MS, UartRxLoop);
+
+    u64Delay = UartRx_u64Delivered - u64End;
+    if( (UartRx_u64Delivered < u64End) || (u64Delay > (u64TimeoutNs + UARTRX_TYPED_SLACK_NS)) )
+    {
+      printf("uartrx: typed: character %u was not delivered within the time-out  FAIL\n", i);
+      bPass = FALSE;
+    }
+    else if(u64Delay > u64MaxDelay)
+    {
+      u64MaxDelay = u64Delay;
+    }
+  }
+
+  bPass = UartRxCheck("typed") && bPass;
+  printf("uartrx: %-14s each in the Uart_getc() buffer at most %llu ns after its stop bit (time-out %llu ns)\n",
+         "typed", u64MaxDelay, u64TimeoutNs);
+  return(bPass);
+
+} /* end UartRxTyped() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartRxUnread
+
+Description:
+A burst that nobody reads with Uart_getc(): the buffer must keep the oldest characters and report the loss.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if the buffer holds the first U0RX_BUFFER_SIZE - 1 characters and _UART_RX_BUFFER_OVERRUN is set
+*/
+static bool UartRxUnread(void)
+{
+  u32 u32Kept = 0;
+  bool bPass;
+
+  if(!UartRxBegin(UARTRX_BRGR_115200))
+  {
+    return(FALSE);
+  }
+
+  UartRx_bReading = FALSE;
+  for(u32 i = 0; i < UARTRX_UNREAD_SIZE; i++)
+  {
+    UartRx_au8Data[i] = (u8)(i + 1);
+  }
+
+  if(!UartRxSend(UartRx_au8Data, UARTRX_UNREAD_SIZE, 0))
+  {
+    return(FALSE);
+  }
+  UartRxRunIdle(UARTRX_DRAIN_MS);
+
+  bPass = (bool)((UART_Peripheral0.u32Flags & _UART_RX_BUFFER_OVERRUN) != 0);
+  while(UartCheckForNewChar())
+  {
+    if(Uart_getc() != UartRx_au8Data[u32Kept++])
+    {
+      bPass = FALSE;
+    }
+  }
+
+  bPass = bPass && (u32Kept == (U0RX_BUFFER_SIZE - 1)) && (UartRx_u32App == UARTRX_UNREAD_SIZE);
+  printf("uartrx: %-14s %5lu chars, %lu kept for Uart_getc(), overrun %s, %lu in the application buffer  %s\n",
+         "unread", UartRx_u32Sent, u32Kept, (UART_Peripheral0.u32Flags & _UART_RX_BUFFER_OVERRUN) ? "set" : "clear",
+         UartRx_u32App, bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartRxUnread() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs every case.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every case passed
+*/
+int main(void)
+{
+  bool bPass = TRUE;
+
+  bPass &= UartRxBurst("burst", UARTRX_BRGR_115200, 0);
+  bPass &= UartRxBurst("burst", UARTRX_BRGR_921600, 0);
+  bPass &= UartRxRandomBursts();
+  bPass &= UartRxBurst("late handler", UARTRX_BRGR_921600, UARTRX_LATE_US);
+  bPass &= UartRxTyped();
+  bPass &= UartRxUnread();
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/
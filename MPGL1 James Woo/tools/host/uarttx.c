@@ -0,0 +1,575 @@
+/**********************************************************************************************************************
+File: uarttx.c
+
+Description:
+USART0 transmit test.  The UART driver and the messaging task run from the main loop of the register model, whose
+USART0 sends every character at the debug baud rate and counts the USART0 interrupts.  Queued messages go out through
+the PDC, so the test fails if:
+- a message does not come out whole and in order, or its token does not end COMPLETE;
+- a message costs more than UARTTX_MAX_IRQS_PER_MESSAGE interrupts;
+- the line goes idle between the characters of a message, or between queued messages (the next one is chained in
+  TNPR while one is sending);
+- an urgent message does not go out after the message sending and the one chained behind it, ahead of the waiting
+  bulk message;
+- UartRelease() while a message is sending leaves the state machine hung or the PDC sending, or a message queued
+  after the UART is requested again does not go out.
+
+For reference it also reports the interrupts per character of the Uart_putc() path (one TXEMPTY interrupt per
+character).
+
+Usage: uarttx
+Returns 0 if every case passed, 1 otherwise.
+**********************************************************************************************************************/
+
+#include "../../bsp/mpgl1-ehdw-02.c"
+#include "../../drivers/messaging.c"
+#include "../../bsp/sam3u_uart.c"
+
+#include <stdio.h>
+#include "sam3u_model.h"
+
+/***********************************************************************************************************************
+Constants / Definitions
+***********************************************************************************************************************/
+#define UARTTX_MAX_CHARS          (u32)4096            /* Characters recorded */
+#define UARTTX_MAX_IRQS_PER_MESSAGE (u32)2             /* Interrupts allowed per queued message */
+#define UARTTX_TIMEOUT_MS         (u32)2000            /* Longest case */
+#define UARTTX_RX_BUFFER_SIZE     (u32)64              /* Receive buffer given to UartRequest() */
+
+#define UARTTX_BURST_MESSAGES     (u8)20               /* Messages queued at once in the burst case */
+#define UARTTX_BURST_SIZE         (u32)30              /* Characters per burst message */
+#define UARTTX_LONG_SIZE          (u32)100             /* Characters of the single message case */
+#define UARTTX_RELEASE_SIZE       (u32)60              /* Characters per message queued before UartRelease() */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope across entire project.
+All Global variable names shall start with "G_"
+***********************************************************************************************************************/
+/* New variables (from main.c, which the test does not link) */
+volatile u32 G_u32SystemFlags;                         /* Global system flags */
+volatile u32 G_u32ApplicationFlags;                    /* Global applications flags */
+
+
+/***********************************************************************************************************************
+Global variable definitions with scope limited to this local application.
+Variable names shall start with "UartTx_" and be declared as static.
+***********************************************************************************************************************/
+static u8 UartTx_au8Line[UARTTX_MAX_CHARS];            /* Characters sent on the line */
+static u64 UartTx_au64Time[UARTTX_MAX_CHARS];          /* End time of each character */
+static u32 UartTx_u32Chars;                            /* Characters recorded */
+
+static u8 UartTx_au8RxBuffer[UARTTX_RX_BUFFER_SIZE];   /* Receive buffer of the requested UART */
+static u8* UartTx_pu8RxNext;                           /* Receive buffer pointer */
+static u8 UartTx_au8Data[UARTTX_BURST_MESSAGES * UARTTX_BURST_SIZE]; /* Data of the messages queued */
+static const u8 UartTx_au8Segment0[] = "segments ";    /* Segments of the segment case (static: PDC addresses) */
+static const u8 UartTx_au8Segment2[] = "and no copy";
+
+
+/**********************************************************************************************************************
+Function Definitions
+**********************************************************************************************************************/
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxLog
+
+Description:
+Records each character the model sends (ModelUartLogType).
+
+Requires:
+  -
+
+Promises:
+  - The character and its time are appended while there is room
+*/
+static void UartTxLog(u8 u8Char_, u64 u64TimeNs_)
+{
+  if(UartTx_u32Chars < UARTTX_MAX_CHARS)
+  {
+    UartTx_au8Line[UartTx_u32Chars] = u8Char_;
+    UartTx_au64Time[UartTx_u32Chars] = u64TimeNs_;
+    UartTx_u32Chars++;
+  }
+
+} /* end UartTxLog() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxLoop
+
+Description:
+The main loop passes of the tasks under test.
+
+Requires:
+  - The messaging task and the UART driver are initialized
+
+Promises:
+  - Both state machines have run once
+*/
+static void UartTxLoop(void)
+{
+  G_MessagingStateMachine();
+  G_UartStateMachine();
+
+} /* end UartTxLoop() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxBegin
+
+Description:
+Starts a case: resets the model, initializes the messaging task and the UART driver, lets the startup message go out
+and requests USART0.
+
+Requires:
+  -
+
+Promises:
+  - Returns the USART0 peripheral object with the line idle and nothing recorded, or NULL on a failure
+*/
+static UartPeripheralType* UartTxBegin(void)
+{
+  UartConfigurationType sConfig = {USART0, UartTx_au8RxBuffer, UARTTX_RX_BUFFER_SIZE, &UartTx_pu8RxNext};
+  UartPeripheralType* psUart;
+
+  if(!ModelInitialize())
+  {
+    printf("uarttx: cannot map the peripheral space\n");
+    return(NULL);
+  }
+  ModelSetUartLog(UartTxLog);
+
+  memset(&UART_Peripheral0, 0, sizeof(UART_Peripheral0));
+  UartTx_pu8RxNext = UartTx_au8RxBuffer;
+  MessagingInitialize();
+  UartInitialize();
+
+  /* The startup message is sent with Uart_putc() */
+  ModelRun(100, UartTxLoop);
+  psUart = UartRequest(&sConfig);
+  ModelRun(10, UartTxLoop);
+
+  UartTx_u32Chars = 0;
+  ModelClearStats();
+  return(psUart);
+
+} /* end UartTxBegin() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxWait
+
+Description:
+Runs the main loop until the line has been idle for a few characters with nothing queued.
+
+Requires:
+  - psUart_ is the UART under test
+
+Promises:
+  - Returns TRUE if the UART finished within UARTTX_TIMEOUT_MS
+*/
+static bool UartTxWait(UartPeripheralType* psUart_)
+{
+  for(u32 i = 0; i < UARTTX_TIMEOUT_MS; i++)
+  {
+    ModelRun(1, UartTxLoop);
+    if( (psUart_->sTransmitQueue.psHead == NULL) && (G_UartStateMachine == UartSM_Idle) &&
+        (AT91C_BASE_US0->US_CSR & AT91C_US_TXEMPTY) )
+    {
+      ModelRun(2, UartTxLoop);
+      return(TRUE);
+    }
+  }
+
+  return(FALSE);
+
+} /* end UartTxWait() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxCheckLine
+
+Description:
+Compares the characters sent with the data expected and measures the gaps between them.
+
+Requires:
+  - UartTx_au8Line holds the characters sent since the case started
+
+Promises:
+  - Returns TRUE if exactly the u32Size_ bytes of pu8Expected_ were sent, with no idle time between them if
+    bBackToBack_
+  - *pu64MaxGap_ is the longest time between the ends of two characters, in ns
+*/
+static bool UartTxCheckLine(const char* pcCase_, const u8* pu8Expected_, u32 u32Size_, bool bBackToBack_,
+                            u64* pu64MaxGap_)
+{
+  u64 u64CharNs = ModelUartCharNs();
+
+  *pu64MaxGap_ = 0;
+  if( (UartTx_u32Chars != u32Size_) || (memcmp(UartTx_au8Line, pu8Expected_, u32Size_) != 0) )
+  {
+    printf("uarttx: %s: %lu of %lu characters sent, or out of order  FAIL\n", pcCase_, UartTx_u32Chars, u32Size_);
+    return(FALSE);
+  }
+
+  for(u32 i = 1; i < UartTx_u32Chars; i++)
+  {
+    if( (UartTx_au64Time[i] - UartTx_au64Time[i - 1]) > *pu64MaxGap_ )
+    {
+      *pu64MaxGap_ = UartTx_au64Time[i] - UartTx_au64Time[i - 1];
+    }
+  }
+
+  if(bBackToBack_ && (*pu64MaxGap_ > u64CharNs))
+  {
+    printf("uarttx: %s: the line was idle for %llu ns between characters (%llu ns each)  FAIL\n", pcCase_,
+           *pu64MaxGap_ - u64CharNs, u64CharNs);
+    return(FALSE);
+  }
+
+  return(TRUE);
+
+} /* end UartTxCheckLine() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxMessages
+
+Description:
+Queues messages of u32Size_ characters, lets them go out and checks the line, the tokens and the interrupt count.
+
+Requires:
+  - u8Messages_ * u32Size_ fits in UartTx_au8Data
+
+Promises:
+  - Returns TRUE if the case passed
+*/
+static bool UartTxMessages(const char* pcCase_, u8 u8Messages_, u32 u32Size_)
+{
+  UartPeripheralType* psUart = UartTxBegin();
+  u32 au32Tokens[UARTTX_BURST_MESSAGES];
+  ModelStatsType sStats;
+  u64 u64Start;
+  u64 u64MaxGap;
+  bool bPass;
+
+  if(psUart == NULL)
+  {
+    return(FALSE);
+  }
+
+  u64Start = ModelTimeNs();
+  for(u32 i = 0; i < (u8Messages_ * u32Size_); i++)
+  {
+    UartTx_au8Data[i] = (u8)('a' + ((i / u32Size_) % 26));
+    if( (i % u32Size_) == (u32Size_ - 1) )
+    {
+      UartTx_au8Data[i] = '\n';
+    }
+  }
+
+  for(u8 i = 0; i < u8Messages_; i++)
+  {
+    au32Tokens[i] = UartWriteData(psUart, u32Size_, &UartTx_au8Data[i * u32Size_]);
+  }
+
+  bPass = UartTxWait(psUart);
+  ModelGetStats(&sStats);
+  if(!bPass)
+  {
+    printf("uarttx: %s: the messages did not finish  FAIL\n", pcCase_);
+    return(FALSE);
+  }
+
+  /* Writes added to the message before them share its token, whose COMPLETE status is cleared on the first read */
+  bPass = UartTxCheckLine(pcCase_, UartTx_au8Data, u8Messages_ * u32Size_, TRUE, &u64MaxGap);
+  for(u8 i = 0; i < u8Messages_; i++)
+  {
+    if( ((i == 0) || (au32Tokens[i] != au32Tokens[i - 1])) && (QueryMessageStatus(au32Tokens[i]) != COMPLETE) )
+    {
+      printf("uarttx: %s: message %u is not COMPLETE  FAIL\n", pcCase_, i);
+      bPass = FALSE;
+    }
+  }
+
+  if(sStats.u32UartIsrCalls > (u8Messages_ * UARTTX_MAX_IRQS_PER_MESSAGE))
+  {
+    bPass = FALSE;
+  }
+
+  printf("uarttx: %-14s %2u x %3lu chars: %lu interrupts (%.3f per char), longest gap %llu ns, "
+         "%.2f ms for %.2f ms of line time  %s\n", pcCase_, u8Messages_, u32Size_, sStats.u32UartIsrCalls,
+         (double)sStats.u32UartIsrCalls / UartTx_u32Chars, u64MaxGap,
+         (double)(UartTx_au64Time[UartTx_u32Chars - 1] - u64Start) / 1e6,
+         (double)(UartTx_u32Chars * ModelUartCharNs()) / 1e6, bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartTxMessages() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxSegments
+
+Description:
+A message of three segments (the middle one empty) followed by a message that is not copied.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if both messages went out whole and COMPLETE
+*/
+static bool UartTxSegments(void)
+{
+  static const u8 au8Expected[] = "segments and no copy";
+  const MessageSegmentType asSegments[] = {{UartTx_au8Segment0, sizeof(UartTx_au8Segment0) - 1, TRUE},
+                                           {UartTx_au8Segment0, 0, FALSE},
+                                           {UartTx_au8Segment2, 6, FALSE}};
+  UartPeripheralType* psUart = UartTxBegin();
+  ModelStatsType sStats;
+  u32 u32Segments;
+  u32 u32NoCopy;
+  u64 u64MaxGap;
+  bool bPass;
+
+  if(psUart == NULL)
+  {
+    return(FALSE);
+  }
+
+  u32Segments = UartWriteSegments(psUart, asSegments, sizeof(asSegments) / sizeof(asSegments[0]));
+  u32NoCopy = UartWriteDataNoCopy(psUart, sizeof(UartTx_au8Segment2) - 1 - 6, &UartTx_au8Segment2[6], NULL);
+
+  bPass = UartTxWait(psUart);
+  ModelGetStats(&sStats);
+  bPass = bPass && UartTxCheckLine("segments", au8Expected, sizeof(au8Expected) - 1, TRUE, &u64MaxGap);
+  if( (QueryMessageStatus(u32Segments) != COMPLETE) || (QueryMessageStatus(u32NoCopy) != COMPLETE) )
+  {
+    printf("uarttx: segments: a message is not COMPLETE  FAIL\n");
+    bPass = FALSE;
+  }
+
+  printf("uarttx: %-14s  2 messages, %2lu chars: %lu interrupts, longest gap %llu ns  %s\n", "segments",
+         UartTx_u32Chars, sStats.u32UartIsrCalls, u64MaxGap, bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartTxSegments() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxUrgent
+
+Description:
+Queues an urgent message while message A is sending, B is chained in TNPR and C is waiting.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if the line carried A, B, the urgent message and C in that order, each COMPLETE
+*/
+static bool UartTxUrgent(void)
+{
+  static const u8 au8Expected[] = "AAAAAAAAAAAAAAAAAAAABBBBBBBBBBuCCCCCCCCCC";
+  UartPeripheralType* psUart = UartTxBegin();
+  u32 au32Tokens[4];
+  u64 u64MaxGap;
+  bool bPass;
+
+  if(psUart == NULL)
+  {
+    return(FALSE);
+  }
+
+  /* Each write waits for the one before it to start so none is added to another message */
+  memcpy(UartTx_au8Data, au8Expected, sizeof(au8Expected) - 1);
+  au32Tokens[0] = UartWriteData(psUart, 20, &UartTx_au8Data[0]);
+  for(u8 i = 0; (i < 10) && (AT91C_BASE_US0->US_TCR == 0); i++)
+  {
+    ModelRun(1, UartTxLoop);
+  }
+  au32Tokens[1] = UartWriteData(psUart, 10, &UartTx_au8Data[20]);
+  for(u8 i = 0; (i < 10) && (AT91C_BASE_US0->US_TNCR == 0); i++)
+  {
+    ModelRun(1, UartTxLoop);
+  }
+  if(AT91C_BASE_US0->US_TNCR == 0)
+  {
+    printf("uarttx: urgent: B is not chained behind A  FAIL\n");
+    return(FALSE);
+  }
+  au32Tokens[2] = UartWriteData(psUart, 10, &UartTx_au8Data[31]);
+  au32Tokens[3] = UartWriteDataUrgent(psUart, 1, &UartTx_au8Data[30]);
+
+  bPass = UartTxWait(psUart) && UartTxCheckLine("urgent", au8Expected, sizeof(au8Expected) - 1, TRUE, &u64MaxGap);
+  for(u8 i = 0; i < 4; i++)
+  {
+    if(QueryMessageStatus(au32Tokens[i]) != COMPLETE)
+    {
+      printf("uarttx: urgent: message %u is not COMPLETE  FAIL\n", i);
+      bPass = FALSE;
+    }
+  }
+
+  printf("uarttx: %-14s  A B u C: \"%.*s\"  %s\n", "urgent", (int)UartTx_u32Chars, UartTx_au8Line,
+         bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartTxUrgent() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxRelease
+
+Description:
+Releases USART0 while the PDC is sending the first of three queued messages, then requests it again and sends one
+more message.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if the release abandoned the queued messages, stopped the PDC and left the state machine idle, and
+    the message after the new request went out whole
+*/
+static bool UartTxRelease(void)
+{
+  UartConfigurationType sConfig = {USART0, UartTx_au8RxBuffer, UARTTX_RX_BUFFER_SIZE, &UartTx_pu8RxNext};
+  UartPeripheralType* psUart = UartTxBegin();
+  u32 au32Tokens[3];
+  u32 u32Token;
+  u32 u32Chars;
+  u64 u64MaxGap;
+  bool bPass = TRUE;
+
+  if(psUart == NULL)
+  {
+    return(FALSE);
+  }
+
+  memset(UartTx_au8Data, 'r', sizeof(UartTx_au8Data));
+  for(u8 i = 0; i < 3; i++)
+  {
+    au32Tokens[i] = UartWriteData(psUart, UARTTX_RELEASE_SIZE, UartTx_au8Data);
+  }
+  ModelRun(10, UartTxLoop);
+
+  UartRelease(psUart);
+  if( (G_UartStateMachine != UartSM_Idle) || (psUart->sTransmitQueue.psHead != NULL) ||
+      (AT91C_BASE_US0->US_PTSR & AT91C_PDC_TXTEN) )
+  {
+    printf("uarttx: release: the UART is still sending  FAIL\n");
+    bPass = FALSE;
+  }
+
+  for(u8 i = 0; i < 3; i++)
+  {
+    if(QueryMessageStatus(au32Tokens[i]) != ABANDONED)
+    {
+      printf("uarttx: release: message %u is not ABANDONED  FAIL\n", i);
+      bPass = FALSE;
+    }
+  }
+
+  /* Let the character in the shift register end */
+  ModelRun(10, UartTxLoop);
+  u32Chars = UartTx_u32Chars;
+  UartTx_u32Chars = 0;
+
+  psUart = UartRequest(&sConfig);
+  if(psUart == NULL)
+  {
+    printf("uarttx: release: USART0 cannot be requested again  FAIL\n");
+    return(FALSE);
+  }
+
+  memcpy(UartTx_au8Data, "after release\n", 14);
+  u32Token = UartWriteData(psUart, 14, UartTx_au8Data);
+  if( !UartTxWait(psUart) || !UartTxCheckLine("release", UartTx_au8Data, 14, TRUE, &u64MaxGap) ||
+      (QueryMessageStatus(u32Token) != COMPLETE) )
+  {
+    printf("uarttx: release: the message after the new request did not go out  FAIL\n");
+    bPass = FALSE;
+  }
+
+  printf("uarttx: %-14s  %lu chars sent before the release, then %lu  %s\n", "release", u32Chars, UartTx_u32Chars,
+         bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartTxRelease() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: UartTxPutc
+
+Description:
+Reports the cost of the Uart_putc() path for comparison: each character is loaded into THR by a TXEMPTY interrupt,
+so the line is idle for the interrupt latency between characters.
+
+Requires:
+  -
+
+Promises:
+  - Returns TRUE if every character went out in order
+*/
+static bool UartTxPutc(void)
+{
+  static const u8 au8Text[] = "Uart_putc() characters go out one interrupt at a time\n";
+  UartPeripheralType* psUart = UartTxBegin();
+  ModelStatsType sStats;
+  u64 u64MaxGap;
+  bool bPass = TRUE;
+
+  if(psUart == NULL)
+  {
+    return(FALSE);
+  }
+
+  for(u32 i = 0; i < (sizeof(au8Text) - 1); i++)
+  {
+    bPass &= Uart_putc(au8Text[i]);
+  }
+
+  bPass = bPass && UartTxWait(psUart);
+  ModelGetStats(&sStats);
+  bPass = bPass && UartTxCheckLine("putc", au8Text, sizeof(au8Text) - 1, FALSE, &u64MaxGap);
+
+  printf("uarttx: %-14s  1 x %3lu chars: %lu interrupts (%.3f per char), longest gap %llu ns  %s\n", "Uart_putc()",
+         UartTx_u32Chars, sStats.u32UartIsrCalls, (double)sStats.u32UartIsrCalls / UartTx_u32Chars, u64MaxGap,
+         bPass ? "ok" : "FAIL");
+  return(bPass);
+
+} /* end UartTxPutc() */
+
+
+/*----------------------------------------------------------------------------------------------------------------------
+Function: main
+
+Description:
+Runs every case.
+
+Requires:
+  -
+
+Promises:
+  - Returns 0 if every case passed
+*/
+int main(void)
+{
+  bool bPass = TRUE;
+
+  bPass &= UartTxMessages("one message", 1, UARTTX_LONG_SIZE);
+  bPass &= UartTxMessages("burst", UARTTX_BURST_MESSAGES, UARTTX_BURST_SIZE);
+  bPass &= UartTxSegments();
+  bPass &= UartTxUrgent();
+  bPass &= UartTxRelease();
+  bPass &= UartTxPutc();
+
+  return(bPass ? 0 : 1);
+
+} /* end main() */
+
+
+/*--------------------------------------------------------------------------------------------------------------------*/
+/* End of File                                                                                                        */
+/*--------------------------------------------------------------------------------------------------------------------*/